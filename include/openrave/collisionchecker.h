@@ -50,6 +50,11 @@ enum CollisionAction
     CA_Ignore = 1, ///< do nothing
 };
 
+/// \brief Transient per-query link enable masks of bodies.
+///
+/// Each entry holds a body and a mask with the same layout as KinBody::GetLinkEnableStatesMasks(). A link of a listed body takes part in the query only if it is enabled and its bit in the mask is set. Bodies that are not listed use their current enable states.
+typedef std::vector< std::pair<KinBodyConstPtr, std::vector<uint64_t> > > LinkEnableStatesMaskOverrides;
+
 /// \brief Holds information about a particular collision that occured.
 class OPENRAVE_API CollisionReport
 {
@@ -180,6 +185,14 @@ public:
     /// \brief checks collision of a body and a scene. Attached bodies are respected. If CO_ActiveDOFs is set, will only check affected links of pbody.
     virtual bool CheckCollision(KinBodyConstPtr pbody, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<KinBody::LinkConstPtr>& vlinkexcluded, CollisionReportPtr report = CollisionReportPtr())=0;
 
+    /// \brief checks collision of a body and a scene while masking out links for this query only. Attached bodies are respected. If CO_ActiveDOFs is set, will only check affected links of pbody.
+    ///
+    /// Unlike calling KinBody::Link::Enable, the bodies are not modified, so no update stamps are changed and no callbacks are fired. The default implementation converts the masks into excluded links and bodies and calls CheckCollision(KinBodyConstPtr,const std::vector<KinBodyConstPtr>&,const std::vector<KinBody::LinkConstPtr>&,CollisionReportPtr).
+    /// \param pbody the body to check
+    /// \param vLinkEnableStatesMaskOverrides masks that can only disable links of the listed bodies, see \ref LinkEnableStatesMaskOverrides
+    /// \param[out] report [optional] collision report to be filled with data about the collision.
+    virtual bool CheckCollision(KinBodyConstPtr pbody, const LinkEnableStatesMaskOverrides& vLinkEnableStatesMaskOverrides, CollisionReportPtr report = CollisionReportPtr());
+
     /// \brief Check collision with a link and a ray with a specified length. CO_ActiveDOFs option is ignored.
     ///
     /// \param ray holds the origin and direction. The length of the ray is the length of the direction.
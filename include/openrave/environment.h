@@ -139,6 +139,9 @@ public:
     /// \see CollisionCheckerBase::CheckCollision(KinBodyConstPtr,const std::vector<KinBodyConstPtr>&,const std::vector<KinBody::LinkConstPtr>&,CollisionReportPtr)
     virtual bool CheckCollision(KinBodyConstPtr pbody, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<KinBody::LinkConstPtr>& vlinkexcluded, CollisionReportPtr report = CollisionReportPtr())=0;
 
+    /// \see CollisionCheckerBase::CheckCollision(KinBodyConstPtr,const LinkEnableStatesMaskOverrides&,CollisionReportPtr)
+    virtual bool CheckCollision(KinBodyConstPtr pbody, const LinkEnableStatesMaskOverrides& vLinkEnableStatesMaskOverrides, CollisionReportPtr report = CollisionReportPtr())=0;
+
     /// \see CollisionCheckerBase::CheckCollision(const RAY&,KinBody::LinkConstPtr,CollisionReportPtr)
     virtual bool CheckCollision(const RAY& ray, KinBody::LinkConstPtr plink, CollisionReportPtr report = CollisionReportPtr()) = 0;
 
@@ -506,37 +509,42 @@ public:
 
     /// \brief Retrieve published bodies, completes even if environment is locked. <b>[multi-thread safe]</b>
     ///
-    /// A separate **interface mutex** is locked for reading the modules.
+    /// Reads the latest snapshot of \ref GetPublishedBodiesSnapshot without locking any mutex.
     /// Note that the pbody pointer might become invalid as soon as GetPublishedBodies returns.
-    /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
-    /// \throw openrave_exception with ORE_Timeout error code
+    /// \param timeout not used, kept for compatibility
     virtual void GetPublishedBodies(std::vector<KinBody::BodyState>& vbodies, uint64_t timeout=0) = 0;
 
+    typedef boost::shared_ptr< std::vector<KinBody::BodyState> const > PublishedBodiesConstPtr;
+
+    /// \brief Retrieve the latest published bodies without copying them, never blocks. <b>[multi-thread safe]</b>
+    ///
+    /// The returned snapshot is immutable and stays valid for as long as the caller holds it, UpdatePublishedBodies publishes new snapshots instead of modifying it.
+    /// Note that the pbody pointers should only be used when the environment is locked.
+    /// \return the snapshot, empty if no bodies have been published yet
+    virtual PublishedBodiesConstPtr GetPublishedBodiesSnapshot() const = 0;
+
     /// \brief Retrieve published body of specified name, completes even if environment is locked. <b>[multi-thread safe]</b>
     ///
-    /// A separate **interface mutex** is locked for reading the modules.
+    /// Reads the latest snapshot of \ref GetPublishedBodiesSnapshot without locking any mutex.
     /// Note that the pbody pointer might become invalid as soon as GetPublishedBody returns.
-    /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
-    /// \throw openrave_exception with ORE_Timeout error code
+    /// \param timeout not used, kept for compatibility
     /// \return true if name matches to a published body
     virtual bool GetPublishedBody(const std::string& name, KinBody::BodyState& bodystate, uint64_t timeout=0) = 0;
 
     /// \brief Retrieve joint values of published body of specified name, completes even if environment is locked. <b>[multi-thread safe]</b>
     ///
-    /// A separate **interface mutex** is locked for reading the modules.
+    /// Reads the latest snapshot of \ref GetPublishedBodiesSnapshot without locking any mutex.
     /// Note that the pbody pointer might become invalid as soon as GetPublishedBodyJointValues returns.
-    /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
-    /// \throw openrave_exception with ORE_Timeout error code
+    /// \param timeout not used, kept for compatibility
     /// \return true if name matches to a published body
     virtual bool GetPublishedBodyJointValues(const std::string& name, std::vector<dReal> &jointValues, uint64_t timeout=0) = 0;
 
     /// \brief Retrieve body transform of all published bodies whose name matches prefix, completes even if environment is locked. <b>[multi-thread safe]</b>
     ///
-    /// A separate **interface mutex** is locked for reading the modules.
+    /// Reads the latest snapshot of \ref GetPublishedBodiesSnapshot without locking any mutex.
     /// Note that the pbody pointer might become invalid as soon as GetPublishedBody returns.
     /// \param prefix the prefix to match to the target names.
-    /// \param timeout microseconds to wait before throwing an exception, if 0, will block indefinitely.
-    /// \throw openrave_exception with ORE_Timeout error code
+    /// \param timeout not used, kept for compatibility
     virtual void GetPublishedBodyTransformsMatchingPrefix(const std::string& prefix, std::vector<std::pair<std::string, Transform> >& nameTransfPairs, uint64_t timeout = 0) = 0;
 
     /// \brief Updates the published bodies that viewers and other programs listening in on the environment see.
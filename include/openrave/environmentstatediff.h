@@ -0,0 +1,161 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 OpenRAVE contributors
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+/** \file environmentstatediff.h
+    \brief Compact binary change stream of the body states of an environment, used to mirror an environment in another process.
+
+    The stream only carries state (transforms, dof values, link enable states, grabbed bodies). The mirror environment
+    has to already contain bodies with the same names, for example by loading the same scene or by applying the
+    environment infos through \ref EnvironmentBase::UpdateFromInfo.
+
+    This file is optional and not automatically included with openrave.h
+ */
+#ifndef OPENRAVE_ENVIRONMENTSTATEDIFF_H
+#define OPENRAVE_ENVIRONMENTSTATEDIFF_H
+
+#include <openrave/openrave.h>
+
+namespace OpenRAVE {
+
+/// \brief the type of a record in an environment state diff frame
+enum EnvironmentStateDiffRecordType
+{
+    ESDR_End = 0, ///< end of the frame
+    ESDR_BodyAdded = 1, ///< maps an environment body index of the source environment to a body name
+    ESDR_BodyRemoved = 2, ///< the body at the environment body index was removed from the source environment
+    ESDR_BodyState = 3, ///< changed state of a body, the fields present are given by a mask of \ref EnvironmentStateDiffField
+};
+
+/// \brief the body state fields that can be present in an \ref ESDR_BodyState record
+enum EnvironmentStateDiffField
+{
+    ESDF_Transform = 1, ///< the transform of the base link
+    ESDF_DOFValues = 2, ///< the dof values
+    ESDF_LinkEnableStates = 4, ///< the link enable state masks, \see KinBody::GetLinkEnableStatesMasks
+    ESDF_Grabbed = 8, ///< the grabbed bodies, \see KinBody::GetGrabbedInfo
+    ESDF_All = 0xf,
+};
+
+/** \brief Generates frames of the body state changes of an environment.
+
+    Every call to \ref WriteDiff produces one frame containing only the bodies whose state changed since the previous frame.
+    Bodies are skipped by comparing their update stamps, and change callbacks on \ref KinBody::Prop_LinkTransforms,
+    \ref KinBody::Prop_LinkEnable, and \ref KinBody::Prop_RobotGrabbed narrow down which fields have to be compared against the
+    previously sent values. Bodies are referenced by their environment body index, the name is only sent once when a body
+    is first seen.
+
+    Values are written in the native byte order with the size of dReal stored in the frame header, so the applier
+    has to run on a machine with the same endianness.
+ */
+class OPENRAVE_API EnvironmentStateDiffWriter
+{
+public:
+    EnvironmentStateDiffWriter(EnvironmentBasePtr penv);
+    virtual ~EnvironmentStateDiffWriter();
+
+    /// \brief locks the environment and appends one frame of the changes since the previous call to vdata.
+    ///
+    /// The first frame and the first frame after \ref Reset contain the full state of every body.
+    /// \param[inout] vdata the frame is appended to the existing data
+    /// \return true if the frame contains any changes. Frames without changes are still written so that the sequence numbers stay continuous.
+    virtual bool WriteDiff(std::vector<uint8_t>& vdata);
+
+    /// \brief forces the next frame to contain the full state, for example when a new mirror connects or a mirror lost frames.
+    virtual void Reset();
+
+    /// \brief the sequence number of the next frame that will be written
+    inline uint32_t GetNextSequence() const {
+        return _nSequence;
+    }
+
+    class BodyTracker;
+    typedef boost::shared_ptr<BodyTracker> BodyTrackerPtr;
+
+protected:
+    EnvironmentBasePtr _penv;
+    std::vector<BodyTrackerPtr> _vTrackers; ///< indexed by environment body index
+    std::vector<KinBodyPtr> _vBodiesCache; ///< cache for the current bodies of the environment
+    std::vector<KinBody::GrabbedInfo> _vGrabbedInfosCache;
+    uint32_t _nSequence; ///< sequence number of the next frame
+    bool _bFullFrame; ///< if true, the next frame contains the full state
+};
+
+typedef boost::shared_ptr<EnvironmentStateDiffWriter> EnvironmentStateDiffWriterPtr;
+
+/** \brief Applies frames generated by \ref EnvironmentStateDiffWriter to a mirror environment.
+
+    Bodies are looked up in the mirror environment by the names received with \ref ESDR_BodyAdded records.
+    Records for bodies that do not exist in the mirror are skipped.
+ */
+class OPENRAVE_API EnvironmentStateDiffApplier
+{
+public:
+    EnvironmentStateDiffApplier(EnvironmentBasePtr penv);
+    virtual ~EnvironmentStateDiffApplier();
+
+    /// \brief locks the environment and applies all frames in the data.
+    ///
+    /// Throws ORE_InvalidState if a frame was lost (sequence numbers are not continuous), in which case the writer
+    /// should be \ref EnvironmentStateDiffWriter::Reset "reset" so that the next frame contains the full state.
+    /// Throws ORE_InvalidArguments if the data is malformed. Every frame is parsed completely before it is applied, so a malformed
+    /// frame does not change the mirror, and the frames before it in the data stay applied.
+    /// \return the number of body states that were applied
+    virtual int ApplyDiff(const uint8_t* pdata, size_t size);
+
+    inline int ApplyDiff(const std::vector<uint8_t>& vdata) {
+        return ApplyDiff(vdata.data(), vdata.size());
+    }
+
+protected:
+    class Reader;
+
+    /// \brief a parsed record of a frame
+    struct Record
+    {
+        Record() : recordtype(ESDR_End), envBodyIndex(0), fields(0), numlinks(0) {
+        }
+        uint8_t recordtype; ///< \ref EnvironmentStateDiffRecordType
+        int envBodyIndex;
+        std::string name; ///< for \ref ESDR_BodyAdded
+        uint8_t fields; ///< for \ref ESDR_BodyState, mask of \ref EnvironmentStateDiffField
+        Transform t;
+        std::vector<dReal> vDOFValues;
+        uint32_t numlinks;
+        std::vector<uint64_t> vLinkEnableStatesMasks;
+        std::vector<KinBody::GrabbedInfoConstPtr> vGrabbedInfos;
+    };
+
+    /// \brief applies the frame starting at the current position of the reader
+    int _ApplyFrame(Reader& reader);
+
+    /// \brief returns the mirrored body of the source environment body index, or empty if it does not exist in the mirror
+    KinBodyPtr _GetMirrorBody(int envBodyIndex);
+
+    EnvironmentBasePtr _penv;
+    std::vector<std::string> _vBodyNames; ///< indexed by the environment body index of the source environment
+    std::vector<KinBodyWeakPtr> _vMirrorBodies; ///< indexed by the environment body index of the source environment
+    std::vector<Record> _vRecords; ///< records of the frame being applied
+    std::vector<std::pair<KinBodyPtr, std::vector<KinBody::GrabbedInfoConstPtr> > > _vPendingGrabs; ///< grabs are applied after all transforms of the frame are set
+    uint32_t _nNextSequence; ///< expected sequence number of the next frame
+    bool _bReceivedFullFrame; ///< true if a full frame was received and incremental frames can be applied
+};
+
+typedef boost::shared_ptr<EnvironmentStateDiffApplier> EnvironmentStateDiffApplierPtr;
+
+} // end namespace OpenRAVE
+
+#endif
@@ -282,6 +282,17 @@ public:
      */
     virtual bool SolveAll(const IkParameterization& param, const std::vector<dReal>& vFreeParameters, int filteroptions, std::vector<IkReturnPtr>& ikreturns);
 
+    /** \brief Return all joint configurations for a batch of end effector poses.
+
+        Meant for searches that evaluate many candidate poses (grasps, placements) at once. Solvers can set up the robot state and collision filters once for the whole batch and visit the poses in any order, the returned table is always indexed by the original pose order.
+        \param[in] vparams the poses the end effector has to achieve in the manipulator base's coordinate system.
+        \param[in] filteroptions A bitmask of \ref IkFilterOptions values controlling what is checked for each ik solution.
+        \param[out] vsolutions The solutions of all the poses packed one after another, each solution is of size RobotBase::Manipulator::GetArmIndices().size().
+        \param[out] vposesolutionoffsets Of size vparams.size()+1. The solutions of vparams[i] are the solutions with indices [vposesolutionoffsets[i], vposesolutionoffsets[i+1]) in vsolutions.
+        \return true if at least one pose has a solution
+     */
+    virtual bool SolveAllBatch(const std::vector<IkParameterization>& vparams, int filteroptions, std::vector<dReal>& vsolutions, std::vector<int>& vposesolutionoffsets);
+
     /// \brief returns true if the solver supports a particular ik parameterization as input.
     virtual bool Supports(IkParameterizationType iktype) const OPENRAVE_DUMMY_IMPLEMENTATION;
 
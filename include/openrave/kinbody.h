@@ -1182,6 +1182,7 @@ private:
         /// @name Private Link Variables
         //@{
         int _index;                  ///< \see GetIndex
+        uint64_t _nInfoHash;         ///< hash of the info the link was last updated from, 0 if unknown or the link changed since then. \see KinBody::UpdateFromKinBodyInfo
         KinBodyWeakPtr _parent;         ///< \see GetParent
         std::vector<int> _vParentLinks;         ///< \see GetParentLinks, IsParentLink
         std::vector<int> _vRigidlyAttachedLinks;         ///< \see IsRigidlyAttached, GetRigidlyAttachedLinks
@@ -1974,6 +1975,7 @@ private:
         //@{
         int dofindex;                   ///< the degree of freedom index in the body's DOF array, does not index in KinBody::_vecjoints!
         int jointindex;                 ///< the joint index into KinBody::_vecjoints
+        uint64_t _nInfoHash;            ///< hash of the info the joint was last updated from, 0 if unknown or the joint changed since then. \see KinBody::UpdateFromKinBodyInfo
         boost::array<dReal,3> _vcircularlowerlimit, _vcircularupperlimit;         ///< for circular joints, describes where the identification happens. this is set internally in _ComputeInternalInformation
 
         KinBodyWeakPtr _parent;               ///< body that joint belong to
@@ -2206,9 +2208,41 @@ protected:
     typedef boost::shared_ptr<KinBodyInfo> KinBodyInfoPtr;
     typedef boost::shared_ptr<KinBodyInfo const> KinBodyInfoConstPtr;
 
+    /// \brief The state stored by \ref KinBodyStateSaver and \ref KinBodyStateSaverRef.
+    ///
+    /// Snapshots are kept in a per-body pool and reused, so the vectors keep their capacity and saving the state of a body
+    /// does not allocate once the pool is warm.
+    class OPENRAVE_API StateSnapshot
+    {
+public:
+        StateSnapshot() : _options(0), _nUpdateStamp(-1) {
+        }
+
+        /// \brief saves the state of body given by options
+        void Save(const KinBody& body, int options);
+
+        /// \brief true if the state saved with Save_LinkTransformation, Save_LinkEnable, Save_GrabbedBodies, and the limits is the same as the current state of body.
+        ///
+        /// Uses the update stamps of the body and its grabbed bodies, so it is conservative.
+        bool IsUnchanged(const KinBody& body) const;
+
+        int _options; ///< saved options
+        int _nUpdateStamp; ///< the update stamp of the body when the state was saved
+        std::vector<Transform> _vLinkTransforms;
+        std::vector<uint8_t> _vEnabledLinks;
+        std::vector<std::pair<Vector,Vector> > _vLinkVelocities;
+        std::vector<dReal> _vdoflastsetvalues;
+        std::vector<dReal> _vMaxVelocities, _vMaxAccelerations, _vMaxJerks, _vDOFWeights, _vDOFLimits[2], _vDOFResolutions;
+        std::vector<UserDataPtr> _vGrabbedBodies;
+        std::vector<int> _vGrabbedUpdateStamps; ///< update stamps of the grabbed bodies in _vGrabbedBodies, -1 if the body is gone
+    };
+    typedef boost::shared_ptr<StateSnapshot> StateSnapshotPtr;
+
     /// \brief Helper class to save and restore the entire kinbody state.
     ///
     /// Options can be passed to the constructor in order to choose which parameters to save (see \ref SaveParameters)
+    /// The saved state is taken from a pool of the body so construction does not allocate, and restoring is skipped if the
+    /// update stamp of the body shows that the state was not touched.
     class OPENRAVE_API KinBodyStateSaver
     {
 public:
@@ -2234,12 +2268,8 @@ public:
 protected:
         KinBodyPtr _pbody;
         int _options;         ///< saved options
-        std::vector<Transform> _vLinkTransforms;
-        std::vector<uint8_t> _vEnabledLinks;
-        std::vector<std::pair<Vector,Vector> > _vLinkVelocities;
-        std::vector<dReal> _vdoflastsetvalues;
-        std::vector<dReal> _vMaxVelocities, _vMaxAccelerations, _vMaxJerks, _vDOFWeights, _vDOFLimits[2], _vDOFResolutions;
-        std::vector<UserDataPtr> _vGrabbedBodies;
+        StateSnapshotPtr _psnapshot; ///< the saved state, taken from the pool of _pbody
+        KinBodyWeakPtr _pSnapshotOwner; ///< the body whose pool _psnapshot is returned to, set even after Release
         bool _bRestoreOnDestructor;
 private:
         virtual void _RestoreKinBody(boost::shared_ptr<KinBody> body);
@@ -2280,12 +2310,7 @@ protected:
         KinBody& _body;
 
         int _options;         ///< saved options
-        std::vector<Transform> _vLinkTransforms;
-        std::vector<uint8_t> _vEnabledLinks;
-        std::vector<std::pair<Vector,Vector> > _vLinkVelocities;
-        std::vector<dReal> _vdoflastsetvalues;
-        std::vector<dReal> _vMaxVelocities, _vMaxAccelerations, _vMaxJerks, _vDOFWeights, _vDOFLimits[2], _vDOFResolutions;
-        std::vector<UserDataPtr> _vGrabbedBodies;
+        StateSnapshotPtr _psnapshot; ///< the saved state, taken from the pool of _body
         bool _bRestoreOnDestructor;
         bool _bReleased; ///< if true, then body should not be restored
 private:
@@ -2294,6 +2319,22 @@ private:
 
     typedef boost::shared_ptr<KinBodyStateSaverRef> KinBodyStateSaverRefPtr;
 
+    /** \brief Helper class to coalesce the change notifications of a body, \see BeginChangeBatch
+
+        Useful for loops that make many small changes to a body (like setting dof values and enabling links) where
+        the change set callbacks only have to know about the final state. The batch is committed even if the scope is left with an exception.
+     */
+    class OPENRAVE_API ChangeBatchScope
+    {
+public:
+        ChangeBatchScope(KinBodyPtr pbody);
+        virtual ~ChangeBatchScope();
+protected:
+        KinBodyPtr _pbody;
+    };
+
+    typedef boost::shared_ptr<ChangeBatchScope> ChangeBatchScopePtr;
+
     virtual ~KinBody();
 
     /// return the static interface type this class points to (used for safe casting)
@@ -3063,6 +3104,19 @@ private:
         return _nUpdateStampId;
     }
 
+    /// \brief Returns the links that moved since the given update stamp, if only some of the links moved.
+    ///
+    /// When SetDOFValues is called with a subset of the dofs, only the links downstream of those dofs are recomputed. If that call is the
+    /// only change since nStamp, the recomputed links are returned so that collision checkers can skip synchronizing the other links.
+    /// \param nStamp the \ref GetUpdateStamp value the caller last synchronized with
+    /// \return the indices of the moved links, or NULL if they are unknown and all links have to be synchronized
+    inline const std::vector<int>* GetLinksMovedSinceStamp(int nStamp) const {
+        if( nStamp == _nPartialUpdateStartStamp && _nUpdateStampId == _nPartialUpdateEndStamp ) {
+            return &_vPartialUpdateLinkIndices;
+        }
+        return NULL;
+    }
+
     /// \brief Increments the unique id that indicates the number of transformation state changes of any link. Used to check if robot state has changed.
     void IncrementUpdateStamp(const int inc=1) {
         _nUpdateStampId += inc;
@@ -3079,6 +3133,27 @@ private:
     /// \param properties a mask of the \ref KinBodyProperty values that the callback should be called for when they change
     virtual UserDataPtr RegisterChangeCallback(uint32_t properties, const boost::function<void()>& callback) const;
 
+    /// \brief callback that receives the mask of the \ref KinBodyProperty values that changed and the bit mask of the links that changed (\see IsLinkStateBitEnabled)
+    typedef boost::function<void(uint32_t properties, const std::vector<uint64_t>& vChangedLinksMask)> ChangeSetCallbackFn;
+
+    /// \brief Register a callback that is told which properties and links changed.
+    ///
+    /// The properties passed to the callback are restricted to the registered properties. The links mask contains all the links
+    /// if it is not known which links changed. Every callback is called once per notification even if several of its properties changed.
+    /// \param properties a mask of the \ref KinBodyProperty values that the callback should be called for when they change
+    virtual UserDataPtr RegisterChangeSetCallback(uint32_t properties, const ChangeSetCallbackFn& callback) const;
+
+    /// \brief Starts coalescing the change notifications of the body.
+    ///
+    /// Update stamps, the internal state and the callbacks of \ref RegisterChangeCallback are still updated with every change, since collision
+    /// checkers and grabbed bodies use them to stay synchronized, so the body can be queried inside a batch.
+    /// The callbacks of \ref RegisterChangeSetCallback are only called when the outermost \ref CommitChangeBatch is called, once with all the
+    /// properties and links that changed in between. Calls can be nested. \ref ChangeBatchScope calls the pair automatically.
+    void BeginChangeBatch();
+
+    /// \brief Ends a batch started with \ref BeginChangeBatch and notifies the callbacks if it was the outermost batch.
+    void CommitChangeBatch();
+
     void Serialize(BaseXMLWriterPtr writer, int options=0) const;
 
     /// \brief A md5 hash unique to the particular kinematic and geometric structure of a KinBody.
@@ -3294,6 +3369,38 @@ protected:
     /// \brief de-initializes any internal information computed
     virtual void _DeinitializeInternalInformation();
 
+    /// \brief computes _vDOFDescendantLinkIndices from the topologically sorted joints
+    void _ComputeDOFDescendantLinks();
+
+    /// \brief returns an unused snapshot from the pool of the body, allocating one if the pool is empty
+    StateSnapshotPtr _AcquireStateSnapshot() const;
+
+    /// \brief returns the snapshot to the pool of the body. psnapshot is reset.
+    void _ReleaseStateSnapshot(StateSnapshotPtr& psnapshot) const;
+
+    /// \brief marks the link as changed for the next call to _PostprocessChangedParameters. If no links are marked, all links are considered changed.
+    inline void _MarkChangedLink(int linkindex) {
+        if( !_bChangedLinksMarked ) {
+            InitializeLinkStateBitMasks(_vChangedLinksMask, _veclinks.size());
+            _bChangedLinksMarked = true;
+        }
+        EnableLinkStateBit(_vChangedLinksMask, linkindex);
+    }
+
+    /// \brief notifies the change callbacks of the parameters, or only the \ref RegisterChangeCallback ones while a change batch is open
+    ///
+    /// \param pChangedLinksMask the links that changed, if NULL all links changed
+    void _NotifyChangedParameters(uint32_t parameters, const std::vector<uint64_t>* pChangedLinksMask);
+
+    /// \brief calls every change callback registered for any of the parameters once
+    ///
+    /// \param pChangedLinksMask the links that changed, if NULL all links changed
+    /// \param bChangeCallbacks if true, calls the callbacks of \ref RegisterChangeCallback
+    /// \param bChangeSetCallbacks if true, calls the callbacks of \ref RegisterChangeSetCallback
+    void _NotifyChangeCallbacks(uint32_t parameters, const std::vector<uint64_t>* pChangedLinksMask, bool bChangeCallbacks, bool bChangeSetCallbacks);
+
+    UserDataPtr _RegisterChangeCallback(uint32_t properties, const boost::function<void()>& callback, const ChangeSetCallbackFn& changesetcallback) const;
+
     /// \brief returns the dof velocities and link velocities
     ///
     /// \param[in] usebaselinkvelocity if true, will compute all velocities using the base link velocity. otherwise will assume it is 0
@@ -3307,6 +3414,24 @@ protected:
     /// \param[in] externalaccelerations [optional] The external accelerations to add to each link. When doing inverse dynamics, should set the base link's acceleration to -gravity.
     virtual void _ComputeLinkAccelerations(const std::vector<dReal>& dofvelocities, const std::vector<dReal>& dofaccelerations, const std::vector< std::pair<Vector, Vector> >& linkvelocities, std::vector<std::pair<Vector,Vector> >& linkaccelerations, AccelerationMapConstPtr externalaccelerations=AccelerationMapConstPtr()) const;
 
+    /// \brief updates the links and joints (except the ones of connected bodies) from info. \see UpdateFromKinBodyInfo
+    ///
+    /// \return false if the update could not be completed and updateFromInfoResult holds the reason
+    bool _UpdateLinksAndJointsFromInfo(const KinBodyInfo& info, UpdateFromInfoResult& updateFromInfoResult);
+
+    /// \brief computes a hash of everything in the link info that Link::UpdateFromInfo compares.
+    ///
+    /// Equal hashes imply equal infos up to the hash function.
+    static uint64_t _ComputeLinkInfoHash(const LinkInfo& info);
+
+    /// \brief computes a hash of everything in the joint info that Joint::UpdateFromInfo compares.
+    ///
+    /// Returns 0 if the info holds data that is not hashed, in which case it always has to be compared.
+    static uint64_t _ComputeJointInfoHash(const JointInfo& info);
+
+    /// \brief forgets the info hashes of all links and joints, called when the body changes outside of UpdateFromKinBodyInfo
+    void _ResetInfoHashes();
+
     /// \brief Called to notify the body that certain groups of parameters have been changed.
     ///
     /// This function in calls every registers calledback that is tracking the changes. It also
@@ -3371,6 +3496,7 @@ protected:
     std::vector<std::pair<int16_t,int16_t> > _vAllPairsShortestPaths; ///< all-pairs shortest paths through the link hierarchy. The first value describes the parent link index, and the second value is an index into _vecjoints or _vPassiveJoints. If the second value is greater or equal to  _vecjoints.size() then it indexes into _vPassiveJoints.
     std::vector<int8_t> _vJointsAffectingLinks; ///< joint x link: (jointindex*_veclinks.size()+linkindex). entry is non-zero if the joint affects the link in the forward kinematics. If negative, the partial derivative of ds/dtheta should be negated.
     std::vector< std::vector< std::pair<LinkPtr,JointPtr> > > _vClosedLoops; ///< \see GetClosedLoops
+    std::vector< std::vector<int> > _vDOFDescendantLinkIndices; ///< for every dof, the sorted indices of the links SetDOFValues has to recompute when the dof changes. Empty if all links always have to be recomputed.
     std::vector< std::vector< std::pair<int16_t,int16_t> > > _vClosedLoopIndices; ///< \see GetClosedLoops
     std::vector<JointPtr> _vPassiveJoints; ///< \see GetPassiveJoints()
     std::vector<int8_t> _vAdjacentLinks; ///< a vector of which links are connected to which if link i and j are connected and i < j, then value at (i + j * (j - 1) /2) is 1 where N is the number of links for the body
@@ -3404,7 +3530,16 @@ protected:
 
     int _environmentBodyIndex; ///< \see GetEnvironmentBodyIndex
     mutable int _nUpdateStampId; ///< \see GetUpdateStamp
+    std::vector<int> _vPartialUpdateLinkIndices; ///< links recomputed by the last partial SetDOFValues, \see GetLinksMovedSinceStamp
+    int _nPartialUpdateStartStamp, _nPartialUpdateEndStamp; ///< update stamps before and after the last partial SetDOFValues
     uint32_t _nParametersChanged; ///< set of parameters that changed and need callbacks
+    std::vector<uint64_t> _vChangedLinksMask; ///< links marked by _MarkChangedLink for the current change, only valid if _bChangedLinksMarked is true
+    bool _bChangedLinksMarked;
+    int _nChangeBatchDepth; ///< number of nested BeginChangeBatch calls
+    uint32_t _nBatchedParameters; ///< parameters that changed since the outermost BeginChangeBatch
+    std::vector<uint64_t> _vBatchedChangedLinksMask; ///< links that changed since the outermost BeginChangeBatch
+    mutable std::vector<StateSnapshotPtr> _vStateSnapshotPool; ///< unused snapshots of the state savers, protected by _mutexStateSnapshotPool
+    mutable boost::mutex _mutexStateSnapshotPool;
     ManageDataPtr _pManageData;
     uint32_t _nHierarchyComputed; ///< 2 if the joint heirarchy and other cached information is computed. 1 if the hierarchy information is computing
     bool _bMakeJoinedLinksAdjacent; ///< if true, then automatically add adjacent links to the adjacency list so that their self-collisions are ignored.
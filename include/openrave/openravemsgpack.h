@@ -36,6 +36,14 @@ OPENRAVE_API void DumpMsgPack(const rapidjson::Value& value, std::vector<char>&
 OPENRAVE_API void ParseMsgPack(rapidjson::Document& d, const std::string& str);
 OPENRAVE_API void ParseMsgPack(rapidjson::Document& d, std::istream& is);
 
+/// \brief parses msgpack bytes into the document without building an intermediate msgpack object tree
+///
+/// The rapidjson document itself is still built, the info structures are deserialized from it.
+OPENRAVE_API void ParseMsgPack(rapidjson::Document& d, const char* data, size_t size);
+
+/// \brief parses a msgpack file into the document. On POSIX systems the file is memory mapped instead of copied into a buffer.
+OPENRAVE_API void ParseMsgPackFile(rapidjson::Document& d, const std::string& filename);
+
 } // namespace MsgPack
 
 } // namespace OpenRAVE
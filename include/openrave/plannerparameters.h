@@ -264,7 +264,7 @@ protected:
 class OPENRAVE_API GraspParameters : public PlannerBase::PlannerParameters
 {
 public:
-    GraspParameters(EnvironmentBasePtr penv) : PlannerBase::PlannerParameters(), fstandoff(0), ftargetroll(0), vtargetdirection(0,0,1), btransformrobot(false), breturntrajectory(false), bonlycontacttarget(true), btightgrasp(false), bavoidcontact(false), fcoarsestep(0.1f), ffinestep(0.001f), ftranslationstepmult(0.1f), fgraspingnoise(0), _penv(penv) {
+    GraspParameters(EnvironmentBasePtr penv) : PlannerBase::PlannerParameters(), fstandoff(0), ftargetroll(0), vtargetdirection(0,0,1), btransformrobot(false), breturntrajectory(false), bonlycontacttarget(true), btightgrasp(false), bavoidcontact(false), fcoarsestep(0.1f), ffinestep(0.001f), ftranslationstepmult(0.1f), fgraspingnoise(0), bdistanceguidedclosing(false), _penv(penv) {
         _vXMLParameters.push_back("fstandoff");
         _vXMLParameters.push_back("targetbody");
         _vXMLParameters.push_back("ftargetroll");
@@ -283,6 +283,7 @@ public:
         _vXMLParameters.push_back("fgraspingnoise");
         _vXMLParameters.push_back("vintersectplane");
         _vXMLParameters.push_back("vordereddofindices");
+        _vXMLParameters.push_back("bdistanceguidedclosing");
         _bProcessingGrasp = false;
     }
 
@@ -306,6 +307,7 @@ public:
     Vector vintersectplane; ///< if norm > 0, then the manipulator transform has to be on the plane for grabbing to work. This is mutually exclusive from the standoff.
 
     std::vector<int> vordereddofindices; ///< if specified, will move fingers in this order instead of the order specified by robot->GetActiveDOFIndices().
+    bool bdistanceguidedclosing; ///< if true and the collision checker supports CO_Distance, the hand approach and finger joints advance by steps bounded by the distance to the obstacles instead of fixed coarse steps
 
 protected:
     EnvironmentBasePtr _penv;     ///< environment target belongs to
@@ -342,6 +344,7 @@ protected:
             O << *it << " ";
         }
         O << "</vordereddofindices>" << std::endl;
+        O << "<bdistanceguidedclosing>" << bdistanceguidedclosing << "</bdistanceguidedclosing>" << std::endl;
         if( !(options & 1) ) {
             O << _sExtraParameters << std::endl;
         }
@@ -363,7 +366,7 @@ protected:
             return PE_Support;
         }
 
-        static boost::array<std::string,18> tags = {{"fstandoff","targetbody","ftargetroll","vtargetdirection","vtargetposition","vmanipulatordirection", "btransformrobot","breturntrajectory","bonlycontacttarget","btightgrasp","bavoidcontact","vavoidlinkgeometry","fcoarsestep","ffinestep","ftranslationstepmult","fgraspingnoise","vintersectplane","vordereddofindices"}};
+        static boost::array<std::string,19> tags = {{"fstandoff","targetbody","ftargetroll","vtargetdirection","vtargetposition","vmanipulatordirection", "btransformrobot","breturntrajectory","bonlycontacttarget","btightgrasp","bavoidcontact","vavoidlinkgeometry","fcoarsestep","ffinestep","ftranslationstepmult","fgraspingnoise","vintersectplane","vordereddofindices","bdistanceguidedclosing"}};
         _bProcessingGrasp = find(tags.begin(),tags.end(),name) != tags.end();
         return _bProcessingGrasp ? PE_Support : PE_Pass;
     }
@@ -430,6 +433,9 @@ protected:
             else if( name == "vintersectplane" ) {
                 _ss >> vintersectplane;
             }
+            else if( name == "bdistanceguidedclosing" ) {
+                _ss >> bdistanceguidedclosing;
+            }
             else {
                 RAVELOG_WARN(str(boost::format("unknown tag %s\n")%name));
             }
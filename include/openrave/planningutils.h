@@ -563,6 +563,65 @@ protected:
     PlannerBase::PlannerParameters::DiffStateFn _diffstatefn;
 };
 
+/** \brief Caches the ik solutions found by \ref ManipulatorIKGoalSampler so that retries of a plan with the same goals do not call the ik solver again.
+
+    Entries are keyed by the manipulator, the values of the ik parameterization, the free values, and the filter options.
+    Only successful queries are cached, failed ones call the ik solver again. All entries are dropped when the state the
+    solutions depend on changes: the update stamp of any body other than the robot and its grabbed bodies, the robot base
+    transform, the values of the dofs that are not part of the manipulator arm, the arm dof limits, the link enable states,
+    the grabbed bodies and their relative transforms, or the geometry, enable, and attachment properties of any body.
+    Custom ik filters registered on the ik solver are not tracked, so the cache should be cleared if they change.
+ */
+class OPENRAVE_API ManipulatorIKGoalSamplerCache
+{
+public:
+    ManipulatorIKGoalSamplerCache(int maxentries=1000);
+    virtual ~ManipulatorIKGoalSamplerCache() {
+    }
+
+    /// \brief returns true if the query is cached and the state did not change since it was inserted.
+    ///
+    /// \param[out] vikreturns copies of the cached solutions
+    virtual bool Find(RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikparam, const std::vector<dReal>& vfree, int filteroptions, std::vector<IkReturnPtr>& vikreturns);
+
+    /// \brief stores the solutions of a successful query. Failures are not cached since they are usually retried with different free values or jittered goals.
+    virtual void Insert(RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikparam, const std::vector<dReal>& vfree, int filteroptions, const std::vector<IkReturnPtr>& vikreturns);
+
+    virtual void Clear();
+
+protected:
+    /// \brief drops all entries if the state of the environment changed since they were inserted
+    void _Validate(RobotBase::ManipulatorConstPtr pmanip);
+
+    /// \brief registers change callbacks on the robot and all bodies of the environment for the properties that are not tracked by _GetState
+    void _RegisterChangeCallbacks(RobotBasePtr probot);
+
+    void _OnBodyChanged();
+
+    /// \brief computes the state the ik solutions of pmanip depend on
+    void _GetState(RobotBase::ManipulatorConstPtr pmanip, std::vector<dReal>& vrobotstate, std::vector< std::pair<int, int> >& vbodystamps);
+
+    void _GetKey(RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikparam, const std::vector<dReal>& vfree, int filteroptions, std::string& key);
+
+    std::map<std::string, std::vector<IkReturnPtr> > _mapentries;
+    int _maxentries;
+    std::string _robotname; ///< name of the robot the cached state belongs to
+    std::vector<dReal> _vrobotstate; ///< base transform, non-arm dof values, arm dof limits, link enable states of the robot, and relative transforms of the grabbed bodies
+    std::vector< std::pair<int, int> > _vbodystamps; ///< (environment body index, update stamp) of the other bodies
+    std::vector<UserDataPtr> _vchangecallbacks; ///< geometry, enable, visibility, and limit changes of the bodies of _vbodystamps and the robot
+    bool _bBodyChanged; ///< set by the change callbacks
+    std::vector<KinBodyPtr> _vbodiescache;
+    std::vector<KinBodyPtr> _vgrabbedcache;
+    std::vector<dReal> _vrobotstatecache;
+    std::vector< std::pair<int, int> > _vbodystampscache;
+    std::vector<dReal> _vikvaluescache;
+    std::vector<dReal> _vlowercache, _vuppercache;
+    std::vector<KinBody::GrabbedInfo> _vgrabbedinfocache;
+    std::string _keycache;
+};
+
+typedef boost::shared_ptr<ManipulatorIKGoalSamplerCache> ManipulatorIKGoalSamplerCachePtr;
+
 /// \brief Samples numsamples of solutions and each solution to vsolutions
 ///
 /// \param nummaxsamples the max samples to query from a particular workspace goal. This does not necessarily mean every goal will have this many samples.
@@ -600,6 +659,9 @@ public:
     /// \param maxdist If > 0, allows jittering of the goal IK if they cause the robot to be in collision and no IK solutions to be found
     virtual void SetJitter(dReal maxdist);
 
+    /// \brief sets a cache of ik solutions that can be shared by samplers of different planning calls
+    virtual void SetCache(ManipulatorIKGoalSamplerCachePtr pcache);
+
 protected:
     struct SampleInfo
     {
@@ -625,10 +687,144 @@ protected:
     int _ikfilteroptions;
     bool _searchfreeparameters;
     std::vector<dReal> _vfreegoalvalues;
+    ManipulatorIKGoalSamplerCachePtr _pcache; ///< optional cache of the ik solutions
 };
 
 typedef boost::shared_ptr<ManipulatorIKGoalSampler> ManipulatorIKGoalSamplerPtr;
 
+class PlannerExecutor;
+
+/** \brief Handle to a plan submitted to a \ref PlannerExecutor. <b>Methods are multi-thread safe.</b>
+
+    The plan runs in a worker environment of the executor. When it finishes, the trajectory is copied back into the environment the plan was submitted against.
+ */
+class OPENRAVE_API PlannerFuture
+{
+public:
+    /// \brief called from the worker thread every time the planner calls its plan callbacks
+    typedef boost::function<void(const PlannerBase::PlannerProgress&)> ProgressFn;
+
+    virtual ~PlannerFuture();
+
+    /// \brief requests the plan to stop. If it has not started yet, it is never run.
+    ///
+    /// \param bReturnWithAnySolution if true, the planner is asked to return with any solution it has (PA_ReturnWithAnySolution) instead of being interrupted (PA_Interrupt). Useful for anytime planners and smoothers.
+    virtual void Cancel(bool bReturnWithAnySolution=false);
+
+    /// \brief true if the plan finished, failed, or was cancelled
+    virtual bool IsDone() const;
+
+    /// \brief waits for the plan to finish
+    ///
+    /// \param timeoutms if > 0, the maximum time to wait in milliseconds, otherwise waits forever
+    /// \return true if the plan is done
+    virtual bool Wait(uint32_t timeoutms=0);
+
+    /// \brief waits for the plan to finish and returns its status.
+    ///
+    /// Collision reports inside the status refer to the bodies of the worker environment.
+    virtual PlannerStatus GetStatus();
+
+    /// \brief waits for the plan to finish and returns the trajectory in the submitted environment, or empty if no solution was found
+    virtual TrajectoryBasePtr GetTrajectory();
+
+    /// \brief the last iteration reported by the planner
+    virtual int GetIteration() const;
+
+protected:
+    struct SharedState
+    {
+        boost::mutex _mutex;
+        boost::condition_variable _condition; ///< notified whenever a plan of the executor progresses or finishes
+    };
+    typedef boost::shared_ptr<SharedState> SharedStatePtr;
+
+    PlannerFuture(SharedStatePtr pstate, const std::string& plannername, const std::string& robotname, PlannerParametersPtr parameters, int planningoptions, const ProgressFn& progressfn);
+
+    /// \brief plan callback registered in the worker planner
+    PlannerAction _PlanCallback(const PlannerBase::PlannerProgress& progress);
+
+    /// \brief sets the result and wakes up all waiting threads
+    void _SetDone(const PlannerStatus& status, TrajectoryBasePtr ptraj);
+
+    SharedStatePtr _pstate; ///< protects all the members below
+    std::string _plannername, _robotname;
+    PlannerParametersPtr _parameters; ///< copy of the submitted parameters, the functions are bound to the worker environment before planning
+    int _planningoptions;
+    ProgressFn _progressfn;
+
+    PlannerAction _action; ///< returned to the planner on the next callback
+    PlannerStatus _status;
+    TrajectoryBasePtr _ptraj;
+    int _iteration;
+    bool _bStarted, _bDone;
+
+    friend class PlannerExecutor;
+};
+
+typedef boost::shared_ptr<PlannerFuture> PlannerFuturePtr;
+
+/** \brief Runs plans asynchronously on a pool of worker threads, each owning a clone of the environment. <b>Methods are multi-thread safe.</b>
+
+    Before a plan starts, its worker environment is synchronized with the source environment, so plans always see the state at the time they start.
+    The worker locks the source environment to do this, so callers should not keep it locked while waiting on a future.
+
+    The submitted parameters are copied and rebound to the worker environment through PlannerParameters::SetConfigurationSpecification. Limits and initial/goal configurations are preserved, but custom functions like _samplegoalfn, _sampleinitialfn, _goalfn and _costfn cannot be transferred and are ignored.
+ */
+class OPENRAVE_API PlannerExecutor
+{
+public:
+    /// \param penv the environment plans are submitted against
+    /// \param numthreads number of worker threads and cloned environments
+    /// \param cloningoptions Clone_X options used to create and synchronize the worker environments
+    PlannerExecutor(EnvironmentBasePtr penv, int numthreads, int cloningoptions=Clone_Bodies);
+
+    /// \brief cancels all plans and waits for the workers to finish
+    virtual ~PlannerExecutor();
+
+    /// \brief queues a plan, plans are started in the order they are submitted
+    ///
+    /// \param plannername the planner interface to create in the worker environment
+    /// \param robotname the robot to pass to PlannerBase::InitPlan
+    /// \param parameters the planner parameters, copied before returning
+    /// \param planningoptions options passed to PlannerBase::PlanPath
+    /// \param progressfn optional function called from the worker thread with the progress of the planner
+    virtual PlannerFuturePtr Submit(const std::string& plannername, const std::string& robotname, PlannerParametersConstPtr parameters, int planningoptions=0, const PlannerFuture::ProgressFn& progressfn=PlannerFuture::ProgressFn());
+
+    /// \brief waits until any of the futures has a solution or all of them are done.
+    ///
+    /// Use this to race several planners or goals and keep the first result.
+    /// \param timeoutms if > 0, the maximum time to wait in milliseconds, otherwise waits forever
+    /// \param bCancelOthers if true, cancels the rest of the futures once one has a solution
+    /// \return the index of the first future with a solution, or -1 if none has one
+    virtual int WaitForAny(const std::vector<PlannerFuturePtr>& vfutures, uint32_t timeoutms=0, bool bCancelOthers=true);
+
+    /// \brief cancels all the queued and running plans
+    virtual void CancelAll();
+
+    virtual int GetNumThreads() const {
+        return (int)_vthreads.size();
+    }
+
+protected:
+    void _WorkerThread(EnvironmentBasePtr pworkerenv);
+
+    /// \brief synchronizes the worker environment and runs the plan of pfuture in it
+    void _RunPlan(EnvironmentBasePtr pworkerenv, PlannerFuturePtr pfuture);
+
+    EnvironmentBasePtr _penv;
+    int _cloningoptions;
+    PlannerFuture::SharedStatePtr _pstate;
+    boost::mutex _mutexQueue;
+    boost::condition_variable _conditionQueue;
+    std::list<PlannerFuturePtr> _listQueue; ///< plans that have not been started yet
+    std::list<PlannerFuturePtr> _listRunning;
+    std::vector<boost::shared_ptr<boost::thread> > _vthreads;
+    bool _bShutdown;
+};
+
+typedef boost::shared_ptr<PlannerExecutor> PlannerExecutorPtr;
+
 } // planningutils
 } // OpenRAVE
 
@@ -318,6 +318,16 @@ public:
         bool FindIKSolutions(const IkParameterization& param, int filteroptions, std::vector<IkReturnPtr>& vikreturns) const;
         bool FindIKSolutions(const IkParameterization& param, const std::vector<dReal>& vFreeParameters, int filteroptions, std::vector<IkReturnPtr>& vikreturns) const;
 
+        /// \brief Find all the IK solutions for a batch of end effector transforms
+        ///
+        /// The robot state and collision filters are set up once for the whole batch, so this is much faster than calling FindIKSolutions for every pose.
+        /// \param vparams The transformations of the end-effector in the global coord system
+        /// \param[in] filteroptions A bitmask of \ref IkFilterOptions values controlling what is checked for each ik solution.
+        /// \param vsolutions The solutions of all the poses packed one after another, each solution is of size GetArmIndices().size()
+        /// \param vposesolutionoffsets Of size vparams.size()+1, the solutions of vparams[i] are the solutions with indices [vposesolutionoffsets[i], vposesolutionoffsets[i+1]) in vsolutions
+        /// \return true if at least one pose has a solution
+        bool FindIKSolutionsBatch(const std::vector<IkParameterization>& vparams, int filteroptions, std::vector<dReal>& vsolutions, std::vector<int>& vposesolutionoffsets) const;
+
         /** \brief returns the parameterization of a given IK type for the current manipulator position.
 
             Ideally pluging the returned ik parameterization into FindIkSolution should return the a manipulator configuration
@@ -568,6 +568,15 @@ public:
     /// Only valid if this sensor is simulation based. A sensor hooked up to a real device can ignore this call
     virtual bool SimulationStep(dReal fTimeElapsed) OPENRAVE_DUMMY_IMPLEMENTATION;
 
+    /// \brief Returns true if \ref SimulationStep only reads the state of the environment bodies.
+    ///
+    /// Such a sensor does not modify bodies, does not lock the environment mutex and does not use the collision checker or the physics engine,
+    /// it can only change its own data and draw through the multi-thread safe plotting functions. The environment can then call SimulationStep
+    /// on a worker thread concurrently with other read-only sensors, after all the bodies, modules and other sensors have been stepped.
+    virtual bool IsSimulationStepReadOnly() const {
+        return false;
+    }
+
     /// \brief Returns the sensor geometry. This method is thread safe.
     ///
     /// \param type the requested sensor type to create. A sensor can support many types. If type is ST_Invalid, then returns any structure that represents the geometry.
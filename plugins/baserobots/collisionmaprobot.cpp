@@ -42,7 +42,62 @@ public:
         };
         typedef COLLISIONMAP<2> COLLISIONPAIR;
 
-        XMLData() : Readable("collisionmap") {
+        /// the state of a cell of a LINKPAIRTABLE
+        enum LinkPairState
+        {
+            LPS_Free = 0, ///< the distance of the links at the cell center is larger than how much they can move inside the cell, so they are not colliding anywhere in the cell
+            LPS_Colliding = 1, ///< not generated anymore, treated like LPS_Unknown
+            LPS_Unknown = 2, ///< the links might collide inside the cell, narrowphase has to be called
+        };
+
+        /// generated occupancy table of a non-adjacent link pair whose relative pose only depends on the values of a few 1-dof joints
+        struct LINKPAIRTABLE
+        {
+            LINKPAIRTABLE() {
+                linkindices[0] = linkindices[1] = -1;
+            }
+
+            /// returns the state of the cell, 2 bits per cell
+            inline int GetCellState(size_t icell) const {
+                return (vstates[icell>>5]>>((icell&31)<<1))&3;
+            }
+
+            inline void SetCellState(size_t icell, int state) {
+                uint64_t& word = vstates[icell>>5];
+                word = (word & ~(uint64_t(3)<<((icell&31)<<1))) | (uint64_t(state)<<((icell&31)<<1));
+            }
+
+            /// returns the state of the link pair at the current joint values of the robot
+            int GetState(const KinBody& body) const {
+                size_t icell = 0;
+                for(size_t i = 0; i < vjointindices.size(); ++i) {
+                    dReal f = (body.GetJoints()[vjointindices[i]]->GetValue(0)-vmin[i])*vfidelta[i];
+                    if( !(f >= 0) || f >= vdims[i] ) {
+                        return LPS_Unknown;
+                    }
+                    icell = icell*vdims[i] + (size_t)f;
+                }
+                return GetCellState(icell);
+            }
+
+            bool operator==(const LINKPAIRTABLE& other) const {
+                return linkindices[0] == other.linkindices[0] &&
+                    linkindices[1] == other.linkindices[1] &&
+                    vjointindices == other.vjointindices &&
+                    vdims == other.vdims &&
+                    vmin == other.vmin &&
+                    vfidelta == other.vfidelta &&
+                    vstates == other.vstates;
+            }
+
+            int linkindices[2];
+            std::vector<int> vjointindices; ///< indices into GetJoints() of the joints the relative pose depends on, the first joint is the slowest changing index of the cells
+            std::vector<int> vdims; ///< number of cells for each joint
+            std::vector<dReal> vmin, vfidelta; ///< joint value of the first cell and the inverse of the cell size
+            std::vector<uint64_t> vstates; ///< bit-packed LinkPairState of each cell
+        };
+
+        XMLData() : Readable("collisionmap"), nlinkpairtablesversion(0) {
         }
 
         bool SerializeXML(BaseXMLWriterPtr writer, int options=0) const override {
@@ -57,7 +112,7 @@ public:
             if (!pOther) {
                 return false;
             }
-            return listmaps == pOther->listmaps;
+            return listmaps == pOther->listmaps && linkpairtableshash == pOther->linkpairtableshash && vlinkpairtables == pOther->vlinkpairtables;
         }
 
         ReadablePtr CloneSelf() const override {
@@ -67,6 +122,9 @@ public:
         }
 
         list<COLLISIONPAIR> listmaps;
+        std::vector<LINKPAIRTABLE> vlinkpairtables; ///< generated with GenerateSelfCollisionTables
+        std::string linkpairtableshash; ///< kinematics geometry hash of the robot vlinkpairtables were generated for
+        int nlinkpairtablesversion; ///< incremented every time vlinkpairtables changes
     };
 
     class CollisionMapXMLReader : public BaseXMLReader
@@ -178,7 +236,16 @@ The first pair specifies a map where both joints J0 and J1 have range [-1.5708,
   pair_J0xJ1[ 180*(J0+1.57)/(1.57+1.57) ][ 180*(J1+1.57)/(1.57+1.57) ]\n\n\
 For joints J2xJ3, the index operation is::\n\n\
   pair_J2xJ3[ 90*(J2+1)/(1+1) ][ 130*(J3+2)/(2+2) ]\n\n\
+Self-collision tables can also be generated offline with the **GenerateSelfCollisionTables** command. For every non-adjacent link pair whose relative pose only depends on a few 1-dof joints, the distance between the links is computed at the center of every cell of the joint space of those joints. A cell is only marked free if that distance is larger than a conservative bound on how much the links can move relative to each other inside the cell, so generating the tables requires a collision checker supporting CO_Distance. When checking self-collision, only the links of pairs that are not free are passed to the collision checker, so contacts and collision callbacks are the same as without the tables. The tables are stored with the robot and can be saved and loaded with **SaveSelfCollisionTables** and **LoadSelfCollisionTables**.\n\n\
 ";
+        RegisterCommand("GenerateSelfCollisionTables",boost::bind(&CollisionMapRobot::_GenerateSelfCollisionTablesCommand,this,_1,_2),
+                        "Samples the self-collision tables of the non-adjacent link pairs. Options: cells [num cells per joint, default 64], maxjoints [max number of joints a link pair can depend on, 0-2, default 2]. Returns the number of generated tables.");
+        RegisterCommand("SaveSelfCollisionTables",boost::bind(&CollisionMapRobot::_SaveSelfCollisionTablesCommand,this,_1,_2),
+                        "Saves the generated self-collision tables to the given filename.");
+        RegisterCommand("LoadSelfCollisionTables",boost::bind(&CollisionMapRobot::_LoadSelfCollisionTablesCommand,this,_1,_2),
+                        "Loads self-collision tables from the given filename. Fails if they were generated for a robot with different kinematics or geometry.");
+        _nLinkPairTablesCacheVersion = -1;
+        _bLinkPairTablesUsable = false;
     }
     virtual ~CollisionMapRobot() {
     }
@@ -227,78 +294,533 @@ For joints J2xJ3, the index operation is::\n\n\
                 }
             }
         }
+        _ResetLinkPairTablesCache();
+        if( !_geometrychangedcallback ) {
+            _geometrychangedcallback = RegisterChangeCallback(Prop_LinkGeometry|Prop_LinkGeometryGroup, boost::bind(&CollisionMapRobot::_ResetLinkPairTablesCache,this));
+        }
     }
 
     virtual bool CheckSelfCollision(CollisionReportPtr report = CollisionReportPtr(), CollisionCheckerBasePtr collisionchecker=CollisionCheckerBasePtr()) const
     {
-        if( RobotBase::CheckSelfCollision(report, collisionchecker) ) {
+        boost::shared_ptr<XMLData> cmdata = boost::dynamic_pointer_cast<XMLData>(GetReadableInterface("collisionmap"));
+        int tablecollision = -1;
+        if( !!cmdata && cmdata->vlinkpairtables.size() > 0 ) {
+            tablecollision = _CheckSelfCollisionWithTables(cmdata, report, collisionchecker);
+        }
+        if( tablecollision < 0 ) {
+            if( RobotBase::CheckSelfCollision(report, collisionchecker) ) {
+                return true;
+            }
+        }
+        else if( tablecollision > 0 ) {
             return true;
         }
-        // check if the current joint angles fall within the allowable range
-        boost::shared_ptr<XMLData> cmdata = boost::dynamic_pointer_cast<XMLData>(GetReadableInterface("collisionmap"));
-        if( !!cmdata ) {
-            vector<dReal> values;
-            boost::array<int,2> indices={ { 0,0}};
-            FOREACHC(itmap,cmdata->listmaps) {
-                size_t i=0;
-                const XMLData::COLLISIONPAIR& curmap = *itmap;     // for debugging
-                FOREACHC(itjindex,curmap.jointindices) {
-                    if( *itjindex < 0 ) {
+        if( !cmdata ) {
+            return false;
+        }
+        return _CheckCollisionMaps(*cmdata, report);
+    }
+
+protected:
+    /// \brief check if the current joint angles fall within the allowable range of the collision maps
+    bool _CheckCollisionMaps(const XMLData& cmdata, CollisionReportPtr report) const
+    {
+        vector<dReal> values;
+        boost::array<int,2> indices={ { 0,0}};
+        FOREACHC(itmap,cmdata.listmaps) {
+            size_t i=0;
+            const XMLData::COLLISIONPAIR& curmap = *itmap;     // for debugging
+            FOREACHC(itjindex,curmap.jointindices) {
+                if( *itjindex < 0 ) {
+                    break;
+                }
+                GetJoints().at(*itjindex)->GetValues(values);
+                if( curmap.fmin[i] < curmap.fmax[i] ) {
+                    int index = (int)((values.at(0)-curmap.fmin[i])*curmap.fidelta[i]);
+                    if( index < 0 || index >= (int)curmap.vfreespace.shape()[i] ) {
                         break;
                     }
-                    GetJoints().at(*itjindex)->GetValues(values);
-                    if( curmap.fmin[i] < curmap.fmax[i] ) {
-                        int index = (int)((values.at(0)-curmap.fmin[i])*curmap.fidelta[i]);
-                        if( index < 0 || index >= (int)curmap.vfreespace.shape()[i] ) {
-                            break;
+                    indices.at(i) = index;
+                }
+                ++i;
+            }
+            if( i != curmap.jointindices.size() ) {
+                continue;
+            }
+            if( !curmap.vfreespace(indices) ) {
+                // get all colliding links and check to make sure that at least two are enabled
+                vector< std::pair<LinkConstPtr, LinkConstPtr> > vLinkColliding;
+                FOREACHC(itjindex,curmap.jointindices) {
+                    JointPtr pjoint = GetJoints().at(*itjindex);
+                    if( !!pjoint->GetFirstAttached() && !!pjoint->GetSecondAttached() ) {
+                        std::pair<LinkConstPtr, LinkConstPtr> links(pjoint->GetFirstAttached(), pjoint->GetSecondAttached());
+                        if( links.first->IsEnabled() && links.second->IsEnabled() ) {
+                            if( links.second->GetIndex() < links.first->GetIndex() ) {
+                                std::swap(links.first, links.second);
+                            }
+                            if( find(vLinkColliding.begin(),vLinkColliding.end(), links) == vLinkColliding.end() ) {
+                                vLinkColliding.push_back(links);
+                            }
                         }
-                        indices.at(i) = index;
                     }
-                    ++i;
                 }
-                if( i != curmap.jointindices.size() ) {
+                if( vLinkColliding.size() == 0 ) {
+                    continue;
+                }
+                if( !!report ) {
+                    report->vLinkColliding = vLinkColliding;
+                    if( vLinkColliding.size() > 0 ) {
+                        report->plink1 = vLinkColliding.at(0).first;
+                        report->plink2 = vLinkColliding.at(0).second;
+                    }
+                }
+                RAVELOG_VERBOSE_FORMAT("Self collision: joints %s(%d):%s(%d)", curmap.jointnames[0]%indices[0]%curmap.jointnames[1]%indices[1]);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /// \brief checks the non-adjacent link pairs using the generated tables before calling the narrowphase.
+    ///
+    /// \return -1 if the tables cannot be used for this query and KinBody::CheckSelfCollision has to be called, otherwise 1 if in self-collision and 0 if not
+    int _CheckSelfCollisionWithTables(boost::shared_ptr<XMLData> cmdata, CollisionReportPtr report, CollisionCheckerBasePtr collisionchecker) const
+    {
+        if( GetNumGrabbed() > 0 ) {
+            // grabbed bodies are handled by KinBody::CheckSelfCollision
+            return -1;
+        }
+        if( !_UpdateLinkPairTablesCache(cmdata) ) {
+            return -1;
+        }
+        if( !collisionchecker ) {
+            collisionchecker = _selfcollisionchecker;
+            if( !collisionchecker ) {
+                collisionchecker = GetEnv()->GetCollisionChecker();
+                if( !collisionchecker ) {
+                    // no checker set
+                    return 0;
+                }
+            }
+            else {
+                // have to set the same options as GetEnv()->GetCollisionChecker() since stuff like CO_ActiveDOFs is only set on the global checker
+                collisionchecker->SetCollisionOptions(GetEnv()->GetCollisionChecker()->GetCollisionOptions());
+            }
+        }
+        if( collisionchecker->GetCollisionOptions() & (CO_Distance|CO_Contacts|CO_ActiveDOFs|CO_AllLinkCollisions) ) {
+            return -1;
+        }
+
+        // every pair that is not certified free needs one of its links checked against all its non-adjacent links
+        const size_t nlinks = GetLinks().size();
+        _vLinkPairTablesCheckLinks.assign(nlinks, 0);
+        size_t numcheck = 0;
+        FOREACHC(itpair, GetNonAdjacentLinks(AO_Enabled)) {
+            int index0 = *itpair&0xffff, index1 = *itpair>>16;
+            int itable = _vLinkPairTableIndices[index0*nlinks+index1];
+            if( itable >= 0 && cmdata->vlinkpairtables[itable].GetState(*this) == XMLData::LPS_Free ) {
+                continue;
+            }
+            if( !_vLinkPairTablesCheckLinks[index0] && !_vLinkPairTablesCheckLinks[index1] ) {
+                _vLinkPairTablesCheckLinks[index1] = 1;
+                ++numcheck;
+            }
+        }
+        if( numcheck == 0 ) {
+            if( !!report ) {
+                report->Reset(collisionchecker->GetCollisionOptions());
+            }
+            return 0;
+        }
+        if( 2*numcheck > nlinks ) {
+            // checking the links one by one is slower than the broadphase of the whole robot
+            return -1;
+        }
+        for(size_t ilink = 0; ilink < nlinks; ++ilink) {
+            if( _vLinkPairTablesCheckLinks[ilink] && collisionchecker->CheckStandaloneSelfCollision(LinkConstPtr(GetLinks()[ilink]), report) ) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    /// \brief updates _vLinkPairTableIndices for the tables of cmdata
+    ///
+    /// \return true if the tables are valid for the current robot
+    bool _UpdateLinkPairTablesCache(boost::shared_ptr<XMLData> cmdata) const
+    {
+        if( _pLinkPairTablesCacheData == cmdata && _nLinkPairTablesCacheVersion == cmdata->nlinkpairtablesversion ) {
+            return _bLinkPairTablesUsable;
+        }
+        _pLinkPairTablesCacheData = cmdata;
+        _nLinkPairTablesCacheVersion = cmdata->nlinkpairtablesversion;
+        _bLinkPairTablesUsable = false;
+        if( cmdata->linkpairtableshash != GetKinematicsGeometryHash() ) {
+            RAVELOG_WARN_FORMAT("env=%d, robot %s changed since its self-collision tables were generated, so ignoring them", GetEnv()->GetId()%GetName());
+            return false;
+        }
+        const size_t nlinks = GetLinks().size();
+        _vLinkPairTableIndices.assign(nlinks*nlinks, -1);
+        for(size_t itable = 0; itable < cmdata->vlinkpairtables.size(); ++itable) {
+            const XMLData::LINKPAIRTABLE& table = cmdata->vlinkpairtables[itable];
+            if( table.linkindices[0] < 0 || table.linkindices[0] >= (int)nlinks || table.linkindices[1] < 0 || table.linkindices[1] >= (int)nlinks ) {
+                RAVELOG_WARN_FORMAT("env=%d, robot %s has self-collision table with invalid links %d:%d", GetEnv()->GetId()%GetName()%table.linkindices[0]%table.linkindices[1]);
+                return false;
+            }
+            _vLinkPairTableIndices[table.linkindices[0]*nlinks+table.linkindices[1]] = itable;
+            _vLinkPairTableIndices[table.linkindices[1]*nlinks+table.linkindices[0]] = itable;
+        }
+        _bLinkPairTablesUsable = true;
+        return true;
+    }
+
+    void _ResetLinkPairTablesCache()
+    {
+        _pLinkPairTablesCacheData.reset();
+        _nLinkPairTablesCacheVersion = -1;
+        _bLinkPairTablesUsable = false;
+    }
+
+    bool _GenerateSelfCollisionTablesCommand(std::ostream& sout, std::istream& sinput)
+    {
+        int ncells = 64, nmaxjoints = 2;
+        string cmd;
+        while(!sinput.eof()) {
+            sinput >> cmd;
+            if( !sinput ) {
+                break;
+            }
+            std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
+            if( cmd == "cells" ) {
+                sinput >> ncells;
+            }
+            else if( cmd == "maxjoints" ) {
+                sinput >> nmaxjoints;
+            }
+            else {
+                RAVELOG_WARN_FORMAT("unrecognized command: %s", cmd);
+                break;
+            }
+            if( !sinput ) {
+                RAVELOG_ERROR_FORMAT("failed processing command %s", cmd);
+                return false;
+            }
+        }
+        if( ncells <= 0 || nmaxjoints < 0 || nmaxjoints > 2 ) {
+            RAVELOG_ERROR_FORMAT("env=%d, invalid self-collision table parameters cells=%d, maxjoints=%d", GetEnv()->GetId()%ncells%nmaxjoints);
+            return false;
+        }
+        CollisionCheckerBasePtr pchecker = !!_selfcollisionchecker ? _selfcollisionchecker : GetEnv()->GetCollisionChecker();
+        if( !pchecker ) {
+            RAVELOG_ERROR_FORMAT("env=%d, no collision checker set to generate the self-collision tables of %s", GetEnv()->GetId()%GetName());
+            return false;
+        }
+
+        std::vector<XMLData::LINKPAIRTABLE> vtables;
+        {
+            CollisionOptionsStateSaver colsaver(pchecker, 0);
+            if( !pchecker->SetCollisionOptions(CO_Distance) ) {
+                RAVELOG_ERROR_FORMAT("env=%d, collision checker %s does not support CO_Distance, cannot generate the self-collision tables of %s", GetEnv()->GetId()%pchecker->GetXMLId()%GetName());
+                return false;
+            }
+            CollisionReportPtr report(new CollisionReport());
+            KinBodyStateSaver saver(shared_kinbody(), Save_LinkTransformation|Save_LinkEnable);
+            // disabled links are ignored by the collision checker
+            FOREACHC(itlink, GetLinks()) {
+                if( !(*itlink)->IsEnabled() ) {
+                    (*itlink)->Enable(true);
+                }
+            }
+            std::vector<int> vnonadjacent = GetNonAdjacentLinks(0);
+            FOREACHC(itpair, vnonadjacent) {
+                XMLData::LINKPAIRTABLE table;
+                if( !_InitializeLinkPairTable(*itpair&0xffff, *itpair>>16, nmaxjoints, ncells, table) ) {
                     continue;
                 }
-                if( !curmap.vfreespace(indices) ) {
-                    // get all colliding links and check to make sure that at least two are enabled
-                    vector< std::pair<LinkConstPtr, LinkConstPtr> > vLinkColliding;
-                    FOREACHC(itjindex,curmap.jointindices) {
-                        JointPtr pjoint = GetJoints().at(*itjindex);
-                        if( !!pjoint->GetFirstAttached() && !!pjoint->GetSecondAttached() ) {
-                            std::pair<LinkConstPtr, LinkConstPtr> links(pjoint->GetFirstAttached(), pjoint->GetSecondAttached());
-                            if( links.first->IsEnabled() && links.second->IsEnabled() ) {
-                                if( links.second->GetIndex() < links.first->GetIndex() ) {
-                                    std::swap(links.first, links.second);
-                                }
-                                if( find(vLinkColliding.begin(),vLinkColliding.end(), links) == vLinkColliding.end() ) {
-                                    vLinkColliding.push_back(links);
-                                }
+                _ComputeLinkPairTable(pchecker, report, table);
+                vtables.push_back(table);
+            }
+        }
+
+        boost::shared_ptr<XMLData> cmdata = boost::dynamic_pointer_cast<XMLData>(GetReadableInterface("collisionmap"));
+        if( !cmdata ) {
+            cmdata.reset(new XMLData());
+            SetReadableInterface("collisionmap", cmdata);
+        }
+        cmdata->vlinkpairtables.swap(vtables);
+        cmdata->linkpairtableshash = GetKinematicsGeometryHash();
+        cmdata->nlinkpairtablesversion++;
+        RAVELOG_DEBUG_FORMAT("env=%d, generated %d self-collision tables for %s", GetEnv()->GetId()%cmdata->vlinkpairtables.size()%GetName());
+        sout << cmdata->vlinkpairtables.size();
+        return true;
+    }
+
+    /// \brief sets the joints and cells of the table if the relative pose of the links only depends on at most nmaxjoints 1-dof joints
+    bool _InitializeLinkPairTable(int index0, int index1, int nmaxjoints, int ncells, XMLData::LINKPAIRTABLE& table) const
+    {
+        std::vector<JointPtr> vchain;
+        if( !GetChain(index0, index1, vchain) ) {
+            return false;
+        }
+        table.linkindices[0] = index0;
+        table.linkindices[1] = index1;
+        FOREACHC(itjoint, vchain) {
+            if( (*itjoint)->IsStatic() ) {
+                continue;
+            }
+            if( (*itjoint)->GetDOF() != 1 || (*itjoint)->GetDOFIndex() < 0 || (*itjoint)->IsMimic() ) {
+                return false;
+            }
+            if( (int)table.vjointindices.size() >= nmaxjoints ) {
+                return false;
+            }
+            table.vjointindices.push_back((*itjoint)->GetJointIndex());
+        }
+
+        size_t numcells = 1;
+        std::vector<dReal> vlower, vupper;
+        FOREACHC(itjointindex, table.vjointindices) {
+            JointPtr pjoint = GetJoints().at(*itjointindex);
+            if( pjoint->IsCircular(0) ) {
+                vlower.assign(1, -PI);
+                vupper.assign(1, PI);
+            }
+            else {
+                pjoint->GetLimits(vlower, vupper);
+            }
+            table.vmin.push_back(vlower.at(0));
+            if( vupper.at(0) > vlower.at(0) ) {
+                table.vdims.push_back(ncells);
+                table.vfidelta.push_back(ncells/(vupper.at(0)-vlower.at(0)));
+            }
+            else {
+                table.vdims.push_back(1);
+                table.vfidelta.push_back(0);
+            }
+            numcells *= table.vdims.back();
+        }
+        table.vstates.resize((numcells+31)/32, 0);
+        return true;
+    }
+
+    /// \brief marks the cells where the links are guaranteed to be apart as free
+    ///
+    /// When the joints move by at most vdelta[i] from the cell center, a point moves relative to the other link by at most sum_i vdelta[i]*r_i for revolute joints and sum_i vdelta[i] for prismatic joints, where r_i is its distance to the axis of joint i. r_i is bounded with the distance of the joint anchor to the corners of the link AABBs and the other anchors at the cell center, increased by how much those can move inside the cell.
+    void _ComputeLinkPairTable(CollisionCheckerBasePtr pchecker, CollisionReportPtr report, XMLData::LINKPAIRTABLE& table)
+    {
+        LinkConstPtr plink0 = GetLinks().at(table.linkindices[0]), plink1 = GetLinks().at(table.linkindices[1]);
+        const size_t njoints = table.vjointindices.size();
+        std::vector<int> vdofindices(njoints), vcell(njoints);
+        std::vector<dReal> vvalues(njoints), vdelta(njoints);
+        std::vector<Vector> vpoints;
+        size_t numcells = 1;
+        for(size_t i = 0; i < njoints; ++i) {
+            vdofindices[i] = GetJoints().at(table.vjointindices[i])->GetDOFIndex();
+            vdelta[i] = table.vfidelta[i] > 0 ? 0.5/table.vfidelta[i] : 0;
+            numcells *= table.vdims[i];
+        }
+
+        for(size_t icell = 0; icell < numcells; ++icell) {
+            size_t index = icell;
+            for(int i = (int)njoints-1; i >= 0; --i) {
+                vcell[i] = index % table.vdims[i];
+                index /= table.vdims[i];
+                vvalues[i] = table.vmin[i] + (table.vfidelta[i] > 0 ? (vcell[i]+0.5)/table.vfidelta[i] : 0);
+            }
+            if( njoints > 0 ) {
+                SetDOFValues(vvalues, KinBody::CLA_Nothing, vdofindices);
+            }
+            int state = XMLData::LPS_Unknown;
+            if( !pchecker->CheckCollision(plink0, plink1, report) && report->minDistance > 0 ) {
+                vpoints.resize(0);
+                const AABB ab0 = plink0->ComputeAABB(), ab1 = plink1->ComputeAABB();
+                for(int icorner = 0; icorner < 8; ++icorner) {
+                    vpoints.push_back(ab0.pos + Vector(icorner&1 ? ab0.extents.x : -ab0.extents.x, icorner&2 ? ab0.extents.y : -ab0.extents.y, icorner&4 ? ab0.extents.z : -ab0.extents.z));
+                    vpoints.push_back(ab1.pos + Vector(icorner&1 ? ab1.extents.x : -ab1.extents.x, icorner&2 ? ab1.extents.y : -ab1.extents.y, icorner&4 ? ab1.extents.z : -ab1.extents.z));
+                }
+                for(size_t i = 0; i < njoints; ++i) {
+                    vpoints.push_back(GetJoints()[table.vjointindices[i]]->GetAnchor());
+                }
+                // radii at the cell center, then inflated by the maximum displacement of the points
+                dReal fmaxmove = 0, fmove = 0;
+                for(int ipass = 0; ipass < 2; ++ipass) {
+                    fmove = 0;
+                    for(size_t i = 0; i < njoints; ++i) {
+                        JointConstPtr pjoint = GetJoints()[table.vjointindices[i]];
+                        if( pjoint->IsRevolute(0) ) {
+                            dReal fmaxradius = 0;
+                            FOREACHC(itpoint, vpoints) {
+                                fmaxradius = max(fmaxradius, RaveSqrt((*itpoint-pjoint->GetAnchor()).lengthsqr3()));
                             }
+                            fmove += vdelta[i]*(fmaxradius + 2*fmaxmove);
                         }
-                    }
-                    if( vLinkColliding.size() == 0 ) {
-                        continue;
-                    }
-                    if( !!report ) {
-                        report->vLinkColliding = vLinkColliding;
-                        if( vLinkColliding.size() > 0 ) {
-                            report->plink1 = vLinkColliding.at(0).first;
-                            report->plink2 = vLinkColliding.at(0).second;
+                        else {
+                            fmove += vdelta[i];
                         }
                     }
-                    RAVELOG_VERBOSE_FORMAT("Self collision: joints %s(%d):%s(%d)", curmap.jointnames[0]%indices[0]%curmap.jointnames[1]%indices[1]);
-                    return true;
+                    fmaxmove = fmove;
+                }
+                if( report->minDistance > fmove ) {
+                    state = XMLData::LPS_Free;
                 }
             }
+            table.SetCellState(icell, state);
         }
-        return false;
     }
 
-protected:
+    bool _SaveSelfCollisionTablesCommand(std::ostream& sout, std::istream& sinput)
+    {
+        std::string filename;
+        sinput >> filename;
+        if( !sinput ) {
+            RAVELOG_ERROR("SaveSelfCollisionTables needs a filename\n");
+            return false;
+        }
+        boost::shared_ptr<XMLData> cmdata = boost::dynamic_pointer_cast<XMLData>(GetReadableInterface("collisionmap"));
+        if( !cmdata || cmdata->vlinkpairtables.size() == 0 ) {
+            RAVELOG_ERROR_FORMAT("env=%d, robot %s has no self-collision tables", GetEnv()->GetId()%GetName());
+            return false;
+        }
+        std::ofstream f(filename.c_str(), std::ios::binary);
+        if( !f ) {
+            RAVELOG_ERROR_FORMAT("failed to open %s", filename);
+            return false;
+        }
+        f.write(s_linkPairTablesMagic, 4);
+        _WriteBinary(f, (uint32_t)sizeof(dReal));
+        _WriteBinary(f, (uint32_t)cmdata->linkpairtableshash.size());
+        f.write(cmdata->linkpairtableshash.c_str(), cmdata->linkpairtableshash.size());
+        _WriteBinary(f, (uint32_t)cmdata->vlinkpairtables.size());
+        FOREACHC(ittable, cmdata->vlinkpairtables) {
+            _WriteBinary(f, (int32_t)ittable->linkindices[0]);
+            _WriteBinary(f, (int32_t)ittable->linkindices[1]);
+            _WriteBinary(f, (uint32_t)ittable->vjointindices.size());
+            for(size_t i = 0; i < ittable->vjointindices.size(); ++i) {
+                _WriteBinary(f, (int32_t)ittable->vjointindices[i]);
+                _WriteBinary(f, (int32_t)ittable->vdims[i]);
+                _WriteBinary(f, ittable->vmin[i]);
+                _WriteBinary(f, ittable->vfidelta[i]);
+            }
+            _WriteBinary(f, (uint32_t)ittable->vstates.size());
+            f.write(reinterpret_cast<const char*>(ittable->vstates.data()), ittable->vstates.size()*sizeof(uint64_t));
+        }
+        if( !f ) {
+            RAVELOG_ERROR_FORMAT("failed to write %s", filename);
+            return false;
+        }
+        return true;
+    }
+
+    bool _LoadSelfCollisionTablesCommand(std::ostream& sout, std::istream& sinput)
+    {
+        std::string filename;
+        sinput >> filename;
+        if( !sinput ) {
+            RAVELOG_ERROR("LoadSelfCollisionTables needs a filename\n");
+            return false;
+        }
+        std::ifstream f(filename.c_str(), std::ios::binary);
+        if( !f ) {
+            RAVELOG_ERROR_FORMAT("failed to open %s", filename);
+            return false;
+        }
+        char magic[4] = {0,0,0,0};
+        uint32_t realsize = 0, hashsize = 0, numtables = 0;
+        f.read(magic, 4);
+        _ReadBinary(f, realsize);
+        _ReadBinary(f, hashsize);
+        if( !f || memcmp(magic, s_linkPairTablesMagic, 4) != 0 || realsize != sizeof(dReal) || hashsize > 1024 ) {
+            RAVELOG_ERROR_FORMAT("%s is not a self-collision table file for this build", filename);
+            return false;
+        }
+        std::string hash(hashsize, '\0');
+        f.read(&hash[0], hashsize);
+        if( hash != GetKinematicsGeometryHash() ) {
+            RAVELOG_ERROR_FORMAT("env=%d, self-collision tables in %s were generated for a different robot than %s", GetEnv()->GetId()%filename%GetName());
+            return false;
+        }
+        _ReadBinary(f, numtables);
+        std::vector<XMLData::LINKPAIRTABLE> vtables;
+        const int nlinks = (int)GetLinks().size(), njoints = (int)GetJoints().size();
+        for(uint32_t itable = 0; itable < numtables && !!f; ++itable) {
+            XMLData::LINKPAIRTABLE table;
+            int32_t linkindex0 = -1, linkindex1 = -1;
+            uint32_t numjoints = 0, numwords = 0;
+            _ReadBinary(f, linkindex0);
+            _ReadBinary(f, linkindex1);
+            _ReadBinary(f, numjoints);
+            if( !f || linkindex0 < 0 || linkindex0 >= nlinks || linkindex1 < 0 || linkindex1 >= nlinks || numjoints > 2 ) {
+                break;
+            }
+            table.linkindices[0] = linkindex0;
+            table.linkindices[1] = linkindex1;
+            size_t numcells = 1;
+            for(uint32_t i = 0; i < numjoints; ++i) {
+                int32_t jointindex = -1, dims = 0;
+                dReal fmin = 0, fidelta = 0;
+                _ReadBinary(f, jointindex);
+                _ReadBinary(f, dims);
+                _ReadBinary(f, fmin);
+                _ReadBinary(f, fidelta);
+                if( jointindex < 0 || jointindex >= njoints || dims <= 0 ) {
+                    f.setstate(std::ios::failbit);
+                    break;
+                }
+                table.vjointindices.push_back(jointindex);
+                table.vdims.push_back(dims);
+                table.vmin.push_back(fmin);
+                table.vfidelta.push_back(fidelta);
+                numcells *= dims;
+            }
+            _ReadBinary(f, numwords);
+            if( !f || numwords != (numcells+31)/32 ) {
+                break;
+            }
+            table.vstates.resize(numwords);
+            f.read(reinterpret_cast<char*>(table.vstates.data()), numwords*sizeof(uint64_t));
+            vtables.push_back(table);
+        }
+        if( !f || vtables.size() != numtables ) {
+            RAVELOG_ERROR_FORMAT("failed to read self-collision tables from %s", filename);
+            return false;
+        }
+
+        boost::shared_ptr<XMLData> cmdata = boost::dynamic_pointer_cast<XMLData>(GetReadableInterface("collisionmap"));
+        if( !cmdata ) {
+            cmdata.reset(new XMLData());
+            SetReadableInterface("collisionmap", cmdata);
+        }
+        cmdata->vlinkpairtables.swap(vtables);
+        cmdata->linkpairtableshash = hash;
+        cmdata->nlinkpairtablesversion++;
+        return true;
+    }
+
+    template <typename T>
+    static void _WriteBinary(std::ostream& f, const T& value) {
+        f.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static void _ReadBinary(std::istream& f, T& value) {
+        f.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+
+    static const char s_linkPairTablesMagic[5];
+
     TrajectoryBaseConstPtr _trajcur;
     ControllerBasePtr _pController;
+
+    UserDataPtr _geometrychangedcallback; ///< resets the self-collision table cache when the geometry changes
+    mutable std::vector<int> _vLinkPairTableIndices; ///< nlinks*nlinks indices into XMLData::vlinkpairtables, -1 if the link pair has no table
+    mutable boost::shared_ptr<XMLData> _pLinkPairTablesCacheData; ///< the data _vLinkPairTableIndices was computed for
+    mutable int _nLinkPairTablesCacheVersion; ///< XMLData::nlinkpairtablesversion _vLinkPairTableIndices was computed for
+    mutable bool _bLinkPairTablesUsable; ///< true if the tables are valid for the current robot
+    mutable std::vector<uint8_t> _vLinkPairTablesCheckLinks; ///< cache, 1 for the links that have to be passed to the collision checker
 };
 
+const char CollisionMapRobot::s_linkPairTablesMagic[5] = "ORS2"; // ORSC tables were classified from samples only
+
 RobotBasePtr CreateCollisionMapRobot(EnvironmentBasePtr penv, std::istream& sinput)
 {
     return RobotBasePtr(new CollisionMapRobot(penv,sinput));
@@ -61,6 +61,8 @@
 #include <fstream>
 #include <iostream>
 
+#include <boost/bind.hpp>
+
 using namespace std;
 using namespace OpenRAVE;
 
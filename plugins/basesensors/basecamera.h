@@ -17,6 +17,7 @@
 #define OPENRAVE_BASECAMERA_H
 
 #include <boost/lexical_cast.hpp>
+#include "softwarerasterizer.h"
 
 class BaseCameraSensor : public SensorBase
 {
@@ -185,6 +186,16 @@ public:
                         "Set the dimensions of the image (width,height)");
         RegisterCommand("SaveImage",boost::bind(&BaseCameraSensor::_SaveImage,this,_1,_2),
                         "Saves the next camera image to the given filename");
+        RegisterCommand("SetRenderMode",boost::bind(&BaseCameraSensor::_SetRenderModeCommand,this,_1,_2),
+                        "Sets how images are rendered: 'viewer' (default) uses the environment viewer, 'cpu' uses the built-in software rasterizer, 'auto' uses the viewer if there is one and the rasterizer otherwise.");
+        RegisterCommand("SetRasterizerThreads",boost::bind(&BaseCameraSensor::_SetRasterizerThreadsCommand,this,_1,_2),
+                        "Sets the number of threads the software rasterizer uses, 0 (default) uses all hardware threads.");
+        RegisterCommand("SetRasterizerOutputs",boost::bind(&BaseCameraSensor::_SetRasterizerOutputsCommand,this,_1,_2),
+                        "Sets which images the software rasterizer keeps besides the color image: 'depth 0|1' and 'labels 0|1'. Both are off by default.");
+        RegisterCommand("GetDepthImage",boost::bind(&BaseCameraSensor::_GetDepthImageCommand,this,_1,_2),
+                        "Returns the stamp, width, height, and the row-major depth along the camera z-axis of the last rasterized frame, inf where no geometry is seen. Needs 'SetRasterizerOutputs depth 1'.");
+        RegisterCommand("GetLabelImage",boost::bind(&BaseCameraSensor::_GetLabelImageCommand,this,_1,_2),
+                        "Returns the stamp, width, height, and the row-major environment body indices seen in the last rasterized frame, 0 where no body is seen. Needs 'SetRasterizerOutputs labels 1'.");
         _pgeom.reset(new CameraGeomData());
         _pdata.reset(new CameraSensorData());
         _bPower = false;
@@ -193,6 +204,10 @@ public:
         //_numchannels = 3;
         _bRenderGeometry = true;
         _bRenderData = false;
+        _rendermode = "viewer"; // rasterizing on the cpu has to be requested, since it uses all the hardware threads by default
+        _nRasterizerThreads = 0;
+        _bRasterizeDepth = false;
+        _bRasterizeLabels = false;
         _Reset();
     }
 
@@ -255,9 +270,16 @@ public:
         _pdata->vimagedata.resize(0);
         _pdata->__stamp = 0;
         _vimagedata.clear(); // do not resize vector here since it might never be used and it will take up lots of memory!
+        {
+            boost::mutex::scoped_lock lock(_mutexdata);
+            _vdepthdata.clear();
+            _vlabeldata.clear();
+            _rasterizedstamp = 0;
+        }
         _fTimeToImage = 0;
         _graphgeometry.reset();
         _dataviewer.reset();
+        _rasterizer.reset();
     }
 
     virtual void SetSensorGeometry(SensorGeometryConstPtr pgeometry)
@@ -276,15 +298,32 @@ public:
             _fTimeToImage -= fTimeElapsed;
             if( _fTimeToImage <= 0 ) {
                 _fTimeToImage = 1 / (float)framerate;
-                GetEnv()->UpdatePublishedBodies();
-                if( !!GetEnv()->GetViewer() ) {
+                bool bImage = false, bRasterized = false;
+                if( _rendermode != "cpu" && !!GetEnv()->GetViewer() ) {
+                    GetEnv()->UpdatePublishedBodies();
                     _vimagedata.resize(3*_pgeom->width*_pgeom->height);
-                    if( GetEnv()->GetViewer()->GetCameraImage(_vimagedata, _pgeom->width, _pgeom->height, _trans, _pgeom->KK) ) {
-                        // copy the data
-                        boost::mutex::scoped_lock lock(_mutexdata);
-                        pdata->vimagedata = _vimagedata;
-                        pdata->__stamp = GetEnv()->GetSimulationTime();
-                        pdata->__trans = _trans;
+                    bImage = GetEnv()->GetViewer()->GetCameraImage(_vimagedata, _pgeom->width, _pgeom->height, _trans, _pgeom->KK);
+                }
+                else if( _rendermode != "viewer" ) {
+                    // no viewer to render with, so rasterize on the cpu
+                    if( !_rasterizer ) {
+                        _rasterizer.reset(new SoftwareRasterizer());
+                    }
+                    _rasterizer->SetNumThreads(_nRasterizerThreads);
+                    _rasterizer->Render(GetEnv(), _trans, _pgeom->KK, _pgeom->width, _pgeom->height, _bRasterizeDepth ? &_vdepthimage : NULL, _bRasterizeLabels ? &_vlabelimage : NULL, &_vimagedata);
+                    bImage = bRasterized = true;
+                }
+                if( bImage ) {
+                    // copy the data
+                    boost::mutex::scoped_lock lock(_mutexdata);
+                    pdata->vimagedata = _vimagedata;
+                    pdata->__stamp = GetEnv()->GetSimulationTime();
+                    pdata->__trans = _trans;
+                    if( bRasterized ) {
+                        // the viewer does not produce depth and labels, so keep the last rasterized ones with their stamp
+                        _vdepthdata.swap(_vdepthimage);
+                        _vlabeldata.swap(_vlabelimage);
+                        _rasterizedstamp = pdata->__stamp;
                     }
                 }
             }
@@ -292,6 +331,12 @@ public:
         return true;
     }
 
+    virtual bool IsSimulationStepReadOnly() const
+    {
+        // the rasterizer only reads the bodies, the viewer needs the published bodies to be updated
+        return _rendermode == "cpu";
+    }
+
     virtual SensorGeometryConstPtr GetSensorGeometry(SensorType type)
     {
         if(( type == ST_Invalid) ||( type == ST_Camera) ) {
@@ -362,6 +407,71 @@ public:
         RAVELOG_WARN("SaveImage not implemented yet\n");
         return false;
     }
+    bool _SetRenderModeCommand(ostream& sout, istream& sinput)
+    {
+        string rendermode;
+        sinput >> rendermode;
+        if( !sinput || (rendermode != "auto" && rendermode != "viewer" && rendermode != "cpu") ) {
+            return false;
+        }
+        _rendermode = rendermode;
+        return true;
+    }
+    bool _SetRasterizerThreadsCommand(ostream& sout, istream& sinput)
+    {
+        sinput >> _nRasterizerThreads;
+        return !!sinput;
+    }
+    bool _SetRasterizerOutputsCommand(ostream& sout, istream& sinput)
+    {
+        string cmd;
+        while( sinput >> cmd ) {
+            std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
+            if( cmd == "depth" ) {
+                sinput >> _bRasterizeDepth;
+            }
+            else if( cmd == "labels" ) {
+                sinput >> _bRasterizeLabels;
+            }
+            else {
+                RAVELOG_WARN(str(boost::format("unrecognized command: %s\n")%cmd));
+                return false;
+            }
+            if( !sinput ) {
+                return false;
+            }
+        }
+        boost::mutex::scoped_lock lock(_mutexdata);
+        if( !_bRasterizeDepth ) {
+            _vdepthdata.clear();
+        }
+        if( !_bRasterizeLabels ) {
+            _vlabeldata.clear();
+        }
+        return true;
+    }
+    bool _GetDepthImageCommand(ostream& sout, istream& sinput)
+    {
+        boost::mutex::scoped_lock lock(_mutexdata);
+        return _WriteRasterizedImage(sout, _vdepthdata);
+    }
+    bool _GetLabelImageCommand(ostream& sout, istream& sinput)
+    {
+        boost::mutex::scoped_lock lock(_mutexdata);
+        return _WriteRasterizedImage(sout, _vlabeldata);
+    }
+    template <typename T>
+    bool _WriteRasterizedImage(ostream& sout, const std::vector<T>& vimage)
+    {
+        if( vimage.size() == 0 || vimage.size() != (size_t)(_pgeom->width*_pgeom->height) ) {
+            return false;
+        }
+        sout << _rasterizedstamp << " " << _pgeom->width << " " << _pgeom->height;
+        FOREACHC(it, vimage) {
+            sout << " " << *it;
+        }
+        return true;
+    }
 
     virtual void SetTransform(const Transform& trans)
     {
@@ -384,6 +494,10 @@ public:
         _bRenderGeometry = r->_bRenderGeometry;
         _bRenderData = r->_bRenderData;
         _bPower = r->_bPower;
+        _rendermode = r->_rendermode;
+        _nRasterizerThreads = r->_nRasterizerThreads;
+        _bRasterizeDepth = r->_bRasterizeDepth;
+        _bRasterizeLabels = r->_bRasterizeLabels;
         _Reset();
     }
 
@@ -455,6 +569,15 @@ protected:
     GraphHandlePtr _graphgeometry;
     ViewerBasePtr _dataviewer;
     string _channelformat;
+    string _rendermode; ///< one of auto, viewer, cpu
+    boost::shared_ptr<SoftwareRasterizer> _rasterizer; ///< renders the images when there is no viewer
+    int _nRasterizerThreads;
+    bool _bRasterizeDepth, _bRasterizeLabels; ///< if true, the rasterizer also outputs the depth and the body label images
+    std::vector<float> _vdepthimage; ///< rendered by the rasterizer, swapped into _vdepthdata
+    std::vector<int> _vlabelimage; ///< rendered by the rasterizer, swapped into _vlabeldata
+    std::vector<float> _vdepthdata; ///< depth image of the last rasterized frame, protected by _mutexdata
+    std::vector<int> _vlabeldata; ///< label image of the last rasterized frame, protected by _mutexdata
+    uint64_t _rasterizedstamp; ///< simulation time of _vdepthdata and _vlabeldata
 
     mutable boost::mutex _mutexdata;
 
@@ -16,6 +16,8 @@
 #ifndef OPENRAVE_BASEFLASHLIDAR_H
 #define OPENRAVE_BASEFLASHLIDAR_H
 
+#include "softwarerasterizer.h"
+
 /// Flash LIDAR - sends laser points given a camera projection matrix
 class BaseFlashLidar3DSensor : public SensorBase
 {
@@ -160,6 +162,10 @@ public:
                         "Set rendering of the plots (1 or 0).");
         RegisterCommand("collidingbodies",boost::bind(&BaseFlashLidar3DSensor::_CollidingBodies,this,_1,_2),
                         "Returns the ids of the bodies that the laser beams have hit.");
+        RegisterCommand("SetRenderMode",boost::bind(&BaseFlashLidar3DSensor::_SetRenderModeCommand,this,_1,_2),
+                        "Sets how the depth is measured: 'raycast' (default) casts one collision ray per element, 'cpu' rasterizes the visible link geometry with the built-in software rasterizer.");
+        RegisterCommand("SetRasterizerThreads",boost::bind(&BaseFlashLidar3DSensor::_SetRasterizerThreadsCommand,this,_1,_2),
+                        "Sets the number of threads the software rasterizer uses, 0 (default) uses all hardware threads.");
 
         _pgeom.reset(new BaseFlashLidar3DGeom());
         _pdata.reset(new LaserSensorData());
@@ -175,6 +181,8 @@ public:
         _pgeom->width = 64; _pgeom->height = 64;
         _fTimeToScan = 0;
         _vColor = RaveVector<float>(0.5f,0.5f,1,1);
+        _bRasterize = false;
+        _nRasterizerThreads = 0;
         _Reset();
     }
 
@@ -225,53 +233,13 @@ public:
         if(( _fTimeToScan <= 0) && _bPower ) {
             _fTimeToScan = _pgeom->time_scan;
 
-            RAY r;
-
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(CO_Distance);
-            Transform t;
-
-            {
-                // Lock the data mutex and fill with the range data (get all in one timestep)
-                boost::mutex::scoped_lock lock(_mutexdata);
-                t = GetTransform();
-                _pdata->__trans = t;
-                _pdata->__stamp = GetEnv()->GetSimulationTime();
-
-                r.pos = t.trans;
-                _pdata->positions.at(0) = t.trans;
-
-                for(int w = 0; w < _pgeom->width; ++w) {
-                    for(int h = 0; h < _pgeom->height; ++h) {
-                        Vector vdir;
-                        vdir.x = (float)w*_iKK[0] + _iKK[2];
-                        vdir.y = (float)h*_iKK[1] + _iKK[3];
-                        vdir.z = 1.0f;
-                        vdir = t.rotate(vdir.normalize3());
-                        r.dir = _pgeom->max_range*vdir;
-
-                        int index = w*_pgeom->height+h;
-
-                        if( GetEnv()->CheckCollision(r, _report)) {
-                            _pdata->ranges[index] = vdir*_report->minDistance;
-                            _pdata->intensity[index] = 1;
-                            // store the colliding bodies
-                            KinBody::LinkConstPtr plink = !!_report->plink1 ? _report->plink1 : _report->plink2;
-                            if( !!plink ) {
-                                _databodyids[index] = plink->GetParent()->GetEnvironmentBodyIndex();
-                            }
-                        }
-                        else {
-                            _databodyids[index] = 0;
-                            _pdata->ranges[index] = vdir*_pgeom->max_range;
-                            _pdata->intensity[index] = 0;
-                        }
-                    }
-                }
-
-                _report->Reset();
+            Transform t = GetTransform();
+            if( _bRasterize ) {
+                _RasterizeScan(t);
+            }
+            else {
+                _RaycastScan(t);
             }
-
-            GetEnv()->GetCollisionChecker()->SetCollisionOptions(0);
 
             if( _bRenderData ) {
                 // If can render, check if some time passed before last update
@@ -320,6 +288,12 @@ public:
         return true;
     }
 
+    virtual bool IsSimulationStepReadOnly() const
+    {
+        // ray casting uses the collision checker of the environment
+        return _bRasterize;
+    }
+
     virtual SensorGeometryConstPtr GetSensorGeometry(SensorType type)
     {
         if(( type == ST_Invalid) ||( type == ST_Laser) ) {
@@ -365,6 +339,21 @@ public:
         }
         return true;
     }
+    bool _SetRenderModeCommand(ostream& sout, istream& sinput)
+    {
+        string rendermode;
+        sinput >> rendermode;
+        if( !sinput || (rendermode != "raycast" && rendermode != "cpu") ) {
+            return false;
+        }
+        _bRasterize = rendermode == "cpu";
+        return true;
+    }
+    bool _SetRasterizerThreadsCommand(ostream& sout, istream& sinput)
+    {
+        sinput >> _nRasterizerThreads;
+        return !!sinput;
+    }
 
     virtual void SetTransform(const Transform& trans)
     {
@@ -387,10 +376,103 @@ public:
         _bRenderGeometry = r->_bRenderGeometry;
         _bRenderData = r->_bRenderData;
         _bPower = r->_bPower;
+        _bRasterize = r->_bRasterize;
+        _nRasterizerThreads = r->_nRasterizerThreads;
         _Reset();
     }
 
 protected:
+    /// \brief measures the depth by casting one collision ray per element
+    void _RaycastScan(const Transform& t)
+    {
+        RAY r;
+        GetEnv()->GetCollisionChecker()->SetCollisionOptions(CO_Distance);
+
+        {
+            // Lock the data mutex and fill with the range data (get all in one timestep)
+            boost::mutex::scoped_lock lock(_mutexdata);
+            _pdata->__trans = t;
+            _pdata->__stamp = GetEnv()->GetSimulationTime();
+
+            r.pos = t.trans;
+            _pdata->positions.at(0) = t.trans;
+
+            for(int w = 0; w < _pgeom->width; ++w) {
+                for(int h = 0; h < _pgeom->height; ++h) {
+                    Vector vdir;
+                    vdir.x = (float)w*_iKK[0] + _iKK[2];
+                    vdir.y = (float)h*_iKK[1] + _iKK[3];
+                    vdir.z = 1.0f;
+                    vdir = t.rotate(vdir.normalize3());
+                    r.dir = _pgeom->max_range*vdir;
+
+                    int index = w*_pgeom->height+h;
+
+                    if( GetEnv()->CheckCollision(r, _report)) {
+                        _pdata->ranges[index] = vdir*_report->minDistance;
+                        _pdata->intensity[index] = 1;
+                        // store the colliding bodies
+                        KinBody::LinkConstPtr plink = !!_report->plink1 ? _report->plink1 : _report->plink2;
+                        if( !!plink ) {
+                            _databodyids[index] = plink->GetParent()->GetEnvironmentBodyIndex();
+                        }
+                    }
+                    else {
+                        _databodyids[index] = 0;
+                        _pdata->ranges[index] = vdir*_pgeom->max_range;
+                        _pdata->intensity[index] = 0;
+                    }
+                }
+            }
+
+            _report->Reset();
+        }
+
+        GetEnv()->GetCollisionChecker()->SetCollisionOptions(0);
+    }
+
+    /// \brief measures the depth by rasterizing the visible link geometry, much faster than casting rays for large images
+    void _RasterizeScan(const Transform& t)
+    {
+        if( !_rasterizer ) {
+            _rasterizer.reset(new SoftwareRasterizer());
+        }
+        _rasterizer->SetNumThreads(_nRasterizerThreads);
+        // elements sample the rays through integer image coordinates while the rasterizer samples pixel centers
+        CameraIntrinsics KK = _pgeom->KK;
+        KK.cx += 0.5;
+        KK.cy += 0.5;
+        _rasterizer->Render(GetEnv(), t, KK, _pgeom->width, _pgeom->height, &_vrasterdepth, &_vrasterlabels, NULL);
+
+        boost::mutex::scoped_lock lock(_mutexdata);
+        _pdata->__trans = t;
+        _pdata->__stamp = GetEnv()->GetSimulationTime();
+        _pdata->positions.at(0) = t.trans;
+        for(int w = 0; w < _pgeom->width; ++w) {
+            for(int h = 0; h < _pgeom->height; ++h) {
+                Vector vdir;
+                vdir.x = (float)w*_iKK[0] + _iKK[2];
+                vdir.y = (float)h*_iKK[1] + _iKK[3];
+                vdir.z = 1.0f;
+                // the depth is along the z-axis, convert it to the distance along the ray
+                dReal frange = _vrasterdepth[h*_pgeom->width+w]*RaveSqrt(vdir.lengthsqr3());
+                vdir = t.rotate(vdir.normalize3());
+
+                int index = w*_pgeom->height+h;
+                if( frange <= _pgeom->max_range ) {
+                    _pdata->ranges[index] = vdir*frange;
+                    _pdata->intensity[index] = 1;
+                    _databodyids[index] = _vrasterlabels[h*_pgeom->width+w];
+                }
+                else {
+                    _databodyids[index] = 0;
+                    _pdata->ranges[index] = vdir*_pgeom->max_range;
+                    _pdata->intensity[index] = 0;
+                }
+            }
+        }
+    }
+
     virtual void _Reset()
     {
         _iKK[0] = 1.0f / _pgeom->KK.fx;
@@ -402,6 +484,7 @@ protected:
         _pdata->ranges.resize(_pgeom->width*_pgeom->height);
         _pdata->intensity.resize(_pgeom->width*_pgeom->height);
         _databodyids.resize(_pgeom->width*_pgeom->height);
+        _rasterizer.reset();
         FOREACH(it, _pdata->ranges) {
             *it = Vector(0,0,0);
         }
@@ -455,8 +538,14 @@ protected:
     GraphHandlePtr _graphgeometry;
     dReal _fTimeToScan;
 
+    boost::shared_ptr<SoftwareRasterizer> _rasterizer; ///< used instead of ray casting if _bRasterize is set
+    std::vector<float> _vrasterdepth;
+    std::vector<int> _vrasterlabels;
+    int _nRasterizerThreads;
+
     boost::mutex _mutexdata;
     bool _bRenderData, _bRenderGeometry, _bPower;
+    bool _bRasterize;
 
     friend class BaseFlashLidar3DXMLReader;
 };
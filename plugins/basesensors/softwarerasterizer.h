@@ -0,0 +1,563 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 OpenRAVE contributors
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef OPENRAVE_SOFTWARERASTERIZER_H
+#define OPENRAVE_SOFTWARERASTERIZER_H
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <atomic>
+#include <exception>
+#include <limits>
+
+/// \brief persistent worker threads of the software rasterizer so that a frame does not have to create threads
+class SoftwareRasterizerThreadPool
+{
+public:
+    SoftwareRasterizerThreadPool() : _nJobId(0), _numjobthreads(0), _numpending(0), _numrunning(0), _bShutdown(false) {
+    }
+    virtual ~SoftwareRasterizerThreadPool() {
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _bShutdown = true;
+            _conditionJob.notify_all();
+        }
+        _threads.join_all();
+    }
+
+    /// \brief runs fn(ithread) for ithread in [0, nThreads) and returns when all of them finished. fn(0) runs on the calling thread.
+    ///
+    /// If any of the calls throws, the first exception is rethrown after all of them finished.
+    void Run(int nThreads, const boost::function<void(int)>& fn)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        while( (int)_threads.size() < nThreads-1 ) {
+            _threads.create_thread(boost::bind(&SoftwareRasterizerThreadPool::_WorkerThread, this));
+        }
+        _fn = fn;
+        _exception = std::exception_ptr();
+        _numjobthreads = _numpending = _numrunning = std::max(0, nThreads-1);
+        ++_nJobId;
+        _conditionJob.notify_all();
+        lock.unlock();
+        std::exception_ptr exception;
+        try {
+            fn(0);
+        }
+        catch(...) {
+            exception = std::current_exception();
+        }
+        lock.lock();
+        while( _numrunning > 0 ) {
+            _conditionDone.wait(lock);
+        }
+        _fn.clear();
+        if( !exception ) {
+            exception = _exception;
+        }
+        lock.unlock();
+        if( !!exception ) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+protected:
+    void _WorkerThread()
+    {
+        int lastjobid = 0;
+        boost::mutex::scoped_lock lock(_mutex);
+        while( true ) {
+            while( !_bShutdown && (_nJobId == lastjobid || _numpending == 0) ) {
+                _conditionJob.wait(lock);
+            }
+            if( _bShutdown ) {
+                return;
+            }
+            lastjobid = _nJobId;
+            const int ithread = 1 + _numjobthreads - _numpending;
+            --_numpending;
+            boost::function<void(int)> fn = _fn;
+            lock.unlock();
+            std::exception_ptr exception;
+            try {
+                fn(ithread);
+            }
+            catch(...) {
+                exception = std::current_exception();
+            }
+            lock.lock();
+            if( !!exception && !_exception ) {
+                _exception = exception;
+            }
+            if( --_numrunning == 0 ) {
+                _conditionDone.notify_all();
+            }
+        }
+    }
+
+    boost::thread_group _threads;
+    boost::mutex _mutex; ///< protects the members below
+    boost::condition_variable _conditionJob, _conditionDone;
+    boost::function<void(int)> _fn;
+    std::exception_ptr _exception; ///< first exception thrown by a worker of the current job
+    int _nJobId; ///< incremented for every Run, each thread runs a job at most once
+    int _numjobthreads; ///< number of worker threads of the current job
+    int _numpending; ///< number of threads that still have to start the current job
+    int _numrunning; ///< number of threads that did not finish the current job
+    bool _bShutdown;
+};
+
+/** \brief Renders depth, body label, and color images of the environment on the CPU.
+
+    Used by the camera sensors when there is no viewer to render with (headless simulations). The triangle meshes of
+    every link are extracted once from the link geometries and cached in the link coordinate system, a frame only
+    transforms them into the camera. The image is split into tiles which are rasterized in parallel by threads that are kept
+    across frames.
+
+    All images are row-major of size width*height. The pixel (u,v) samples the ray through (u+0.5,v+0.5) in image coordinates.
+ */
+class SoftwareRasterizer
+{
+public:
+    SoftwareRasterizer() : _nThreads(0), _fNear(0.01f) {
+    }
+    virtual ~SoftwareRasterizer() {
+        Reset();
+    }
+
+    /// \brief sets the number of threads to rasterize with, 0 uses all the hardware threads
+    void SetNumThreads(int nThreads) {
+        _nThreads = nThreads;
+    }
+
+    /// \brief removes all cached meshes
+    void Reset() {
+        boost::mutex::scoped_lock lock(_GetCallbackMutex());
+        _mapbodymeshes.clear();
+    }
+
+    /** \brief renders the visible geometry of the environment as seen from the camera
+
+        Has to be called with the environment locked.
+        \param tcamera the camera transform in the world, the camera looks along +z with +x right and +y down in the image
+        \param vdepth if not NULL, filled with the depth along the camera z-axis, pixels not covering any geometry are set to infinity
+        \param vlabels if not NULL, filled with the environment body index of the body that is seen, 0 if none
+        \param vrgb if not NULL, filled with 3*width*height shaded diffuse colors
+     */
+    void Render(EnvironmentBasePtr penv, const Transform& tcamera, const SensorBase::CameraIntrinsics& KK, int width, int height, std::vector<float>* vdepth, std::vector<int>* vlabels, std::vector<uint8_t>* vrgb)
+    {
+        _width = width;
+        _height = height;
+        _numtilesx = (width+TILE_SIZE-1)/TILE_SIZE;
+        _numtilesy = (height+TILE_SIZE-1)/TILE_SIZE;
+        _vdepth.resize(width*height);
+        _vlabels.resize(width*height);
+        std::fill(_vdepth.begin(), _vdepth.end(), std::numeric_limits<float>::infinity());
+        std::fill(_vlabels.begin(), _vlabels.end(), -1);
+
+        _GatherTriangles(penv, tcamera, KK);
+        _SetupTriangles();
+        _BinTriangles();
+
+        int nThreads = _nThreads > 0 ? _nThreads : (int)boost::thread::hardware_concurrency();
+        int numtiles = _numtilesx*_numtilesy;
+        nThreads = max(1, min(nThreads, numtiles));
+        if( nThreads <= 1 ) {
+            _RasterizeTiles(0, 1);
+        }
+        else {
+            _threadpool.Run(nThreads, boost::bind(&SoftwareRasterizer::_RasterizeTiles, this, _1, nThreads));
+        }
+
+        if( !!vdepth ) {
+            *vdepth = _vdepth;
+        }
+        if( !!vlabels ) {
+            vlabels->resize(_vlabels.size());
+            for(size_t i = 0; i < _vlabels.size(); ++i) {
+                (*vlabels)[i] = _vlabels[i] >= 0 ? _vtrilabels[_vlabels[i]] : 0;
+            }
+        }
+        if( !!vrgb ) {
+            vrgb->resize(3*_vlabels.size());
+            for(size_t i = 0; i < _vlabels.size(); ++i) {
+                if( _vlabels[i] >= 0 ) {
+                    const uint8_t* pcolor = &_vtricolors[3*_vlabels[i]];
+                    (*vrgb)[3*i+0] = pcolor[0];
+                    (*vrgb)[3*i+1] = pcolor[1];
+                    (*vrgb)[3*i+2] = pcolor[2];
+                }
+                else {
+                    (*vrgb)[3*i+0] = (*vrgb)[3*i+1] = (*vrgb)[3*i+2] = 0;
+                }
+            }
+        }
+    }
+
+protected:
+    enum { TILE_SIZE = 32 };
+
+    /// \brief mesh of one link in the link coordinate system
+    struct LinkMesh
+    {
+        std::vector<RaveVector<float> > vertices;
+        std::vector<int> indices;
+        std::vector<uint8_t> colors; ///< diffuse color for every triangle
+        RaveVector<float> vcenter; ///< center of the bounding sphere
+        float fradius; ///< radius of the bounding sphere
+    };
+
+    /// \brief cached meshes of all the links of a body, rebuilt when the link geometries change
+    struct BodyMeshes
+    {
+        KinBodyWeakPtr pbody;
+        UserDataPtr geometrychangehandle;
+        std::vector<LinkMesh> vlinkmeshes;
+        std::atomic<bool> bUpdateMeshes; ///< set by the geometry change callback, which can be called from other threads
+        bool bUsed; ///< set when the body was seen in the current frame
+    };
+    typedef boost::shared_ptr<BodyMeshes> BodyMeshesPtr;
+
+    /// \brief serializes registering and removing the geometry change callbacks, since sensors using rasterizers can be stepped in parallel on the same bodies
+    static boost::mutex& _GetCallbackMutex()
+    {
+        static boost::mutex s_mutex;
+        return s_mutex;
+    }
+
+    static void _SetUpdateMeshes(boost::weak_ptr<BodyMeshes> pweakmeshes)
+    {
+        BodyMeshesPtr pmeshes = pweakmeshes.lock();
+        if( !!pmeshes ) {
+            pmeshes->bUpdateMeshes = true;
+        }
+    }
+
+    static void _ExtractLinkMesh(const KinBody::Link& link, LinkMesh& linkmesh)
+    {
+        linkmesh.vertices.resize(0);
+        linkmesh.indices.resize(0);
+        linkmesh.colors.resize(0);
+        FOREACHC(itgeom, link.GetGeometries()) {
+            const KinBody::Link::Geometry& geom = **itgeom;
+            if( !geom.IsVisible() ) {
+                continue;
+            }
+            const TriMesh& trimesh = geom.GetCollisionMesh();
+            Transform tgeom = geom.GetTransform();
+            int offset = (int)linkmesh.vertices.size();
+            FOREACHC(itvertex, trimesh.vertices) {
+                linkmesh.vertices.push_back(RaveVector<float>(tgeom*(*itvertex)));
+            }
+            FOREACHC(itindex, trimesh.indices) {
+                linkmesh.indices.push_back(offset + *itindex);
+            }
+            const RaveVector<float>& vdiffuse = geom.GetDiffuseColor();
+            for(size_t itri = 0; itri < trimesh.indices.size()/3; ++itri) {
+                linkmesh.colors.push_back((uint8_t)(255*min(1.0f, max(0.0f, vdiffuse.x))));
+                linkmesh.colors.push_back((uint8_t)(255*min(1.0f, max(0.0f, vdiffuse.y))));
+                linkmesh.colors.push_back((uint8_t)(255*min(1.0f, max(0.0f, vdiffuse.z))));
+            }
+        }
+        RaveVector<float> vmin(1e30f,1e30f,1e30f), vmax(-1e30f,-1e30f,-1e30f);
+        FOREACHC(itvertex, linkmesh.vertices) {
+            vmin.x = min(vmin.x, itvertex->x); vmin.y = min(vmin.y, itvertex->y); vmin.z = min(vmin.z, itvertex->z);
+            vmax.x = max(vmax.x, itvertex->x); vmax.y = max(vmax.y, itvertex->y); vmax.z = max(vmax.z, itvertex->z);
+        }
+        linkmesh.vcenter = 0.5f*(vmin+vmax);
+        linkmesh.fradius = 0;
+        FOREACHC(itvertex, linkmesh.vertices) {
+            linkmesh.fradius = max(linkmesh.fradius, (*itvertex-linkmesh.vcenter).lengthsqr3());
+        }
+        linkmesh.fradius = RaveSqrt(linkmesh.fradius);
+    }
+
+    /// \brief updates the mesh cache and fills the camera space triangles of all the visible links
+    void _GatherTriangles(EnvironmentBasePtr penv, const Transform& tcamera, const SensorBase::CameraIntrinsics& KK)
+    {
+        _fx = KK.fx; _fy = KK.fy; _cx = KK.cx; _cy = KK.cy;
+        // normals of the side planes of the view frustum pointing outside
+        RaveVector<float> vcorners[4] = {
+            RaveVector<float>(-_cx/_fx, -_cy/_fy, 1), RaveVector<float>((_width-_cx)/_fx, -_cy/_fy, 1),
+            RaveVector<float>((_width-_cx)/_fx, (_height-_cy)/_fy, 1), RaveVector<float>(-_cx/_fx, (_height-_cy)/_fy, 1)
+        };
+        RaveVector<float> vplanes[4];
+        for(int i = 0; i < 4; ++i) {
+            vplanes[i] = vcorners[(i+1)%4].cross(vcorners[i]).normalize3();
+        }
+
+        FOREACH(it, _mapbodymeshes) {
+            it->second->bUsed = false;
+        }
+        _vcamvertices.resize(0);
+        _vtrilabels.resize(0);
+        _vtricolors.resize(0);
+        RaveTransform<float> tcamerainv = RaveTransform<float>(tcamera.inverse());
+        std::vector<KinBodyPtr> vbodies;
+        penv->GetBodies(vbodies);
+        FOREACHC(itbody, vbodies) {
+            const KinBody& body = **itbody;
+            if( !body.IsVisible() ) {
+                continue;
+            }
+            BodyMeshesPtr& pmeshes = _mapbodymeshes[body.GetEnvironmentBodyIndex()];
+            if( !!pmeshes && pmeshes->pbody.lock() != *itbody ) {
+                boost::mutex::scoped_lock lock(_GetCallbackMutex());
+                pmeshes.reset(); // the index was reused by another body
+            }
+            if( !pmeshes ) {
+                boost::mutex::scoped_lock lock(_GetCallbackMutex());
+                pmeshes.reset(new BodyMeshes());
+                pmeshes->pbody = *itbody;
+                pmeshes->bUpdateMeshes = true;
+                pmeshes->geometrychangehandle = body.RegisterChangeCallback(KinBody::Prop_LinkGeometry|KinBody::Prop_LinkDraw|KinBody::Prop_LinkGeometryGroup, boost::bind(&SoftwareRasterizer::_SetUpdateMeshes, boost::weak_ptr<BodyMeshes>(pmeshes)));
+            }
+            pmeshes->bUsed = true;
+            // clear the flag before extracting so that a change during the extraction is picked up in the next frame
+            if( pmeshes->bUpdateMeshes.exchange(false) || pmeshes->vlinkmeshes.size() != body.GetLinks().size() ) {
+                pmeshes->vlinkmeshes.resize(body.GetLinks().size());
+                for(size_t ilink = 0; ilink < body.GetLinks().size(); ++ilink) {
+                    _ExtractLinkMesh(*body.GetLinks()[ilink], pmeshes->vlinkmeshes[ilink]);
+                }
+            }
+
+            for(size_t ilink = 0; ilink < body.GetLinks().size(); ++ilink) {
+                const LinkMesh& linkmesh = pmeshes->vlinkmeshes[ilink];
+                if( linkmesh.indices.size() == 0 ) {
+                    continue;
+                }
+                RaveTransform<float> t = tcamerainv*RaveTransform<float>(body.GetLinks()[ilink]->GetTransform());
+                RaveVector<float> vcenter = t*linkmesh.vcenter;
+                if( vcenter.z + linkmesh.fradius < _fNear ) {
+                    continue;
+                }
+                bool bOutside = false;
+                for(int i = 0; i < 4; ++i) {
+                    if( vplanes[i].dot3(vcenter) > linkmesh.fradius ) {
+                        bOutside = true;
+                        break;
+                    }
+                }
+                if( bOutside ) {
+                    continue;
+                }
+                _vlinkvertices.resize(linkmesh.vertices.size());
+                for(size_t i = 0; i < linkmesh.vertices.size(); ++i) {
+                    _vlinkvertices[i] = t*linkmesh.vertices[i];
+                }
+                for(size_t i = 0; i+2 < linkmesh.indices.size(); i += 3) {
+                    _AddTriangle(_vlinkvertices[linkmesh.indices[i]], _vlinkvertices[linkmesh.indices[i+1]], _vlinkvertices[linkmesh.indices[i+2]], body.GetEnvironmentBodyIndex(), &linkmesh.colors[i]);
+                }
+            }
+        }
+
+        // remove the bodies that are not in the environment anymore
+        boost::mutex::scoped_lock lock(_GetCallbackMutex());
+        std::map<int, BodyMeshesPtr>::iterator it = _mapbodymeshes.begin();
+        while(it != _mapbodymeshes.end()) {
+            if( !it->second || !it->second->bUsed ) {
+                _mapbodymeshes.erase(it++);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    /// \brief adds a camera space triangle, clipping it against the near plane
+    void _AddTriangle(const RaveVector<float>& v0, const RaveVector<float>& v1, const RaveVector<float>& v2, int label, const uint8_t* pcolor)
+    {
+        // shade with a head light
+        RaveVector<float> vnormal = (v1-v0).cross(v2-v0);
+        RaveVector<float> vcenter = v0+v1+v2;
+        float fnormal2 = vnormal.lengthsqr3(), fcenter2 = vcenter.lengthsqr3();
+        float fshade = 1;
+        if( fnormal2 > 0 && fcenter2 > 0 ) {
+            fshade = 0.3f + 0.7f*RaveFabs(vnormal.dot3(vcenter))/RaveSqrt(fnormal2*fcenter2);
+        }
+        uint8_t color[3] = { (uint8_t)(fshade*pcolor[0]), (uint8_t)(fshade*pcolor[1]), (uint8_t)(fshade*pcolor[2]) };
+
+        const RaveVector<float>* vertices[3] = { &v0, &v1, &v2 };
+        int numinside = (v0.z >= _fNear) + (v1.z >= _fNear) + (v2.z >= _fNear);
+        if( numinside == 0 ) {
+            return;
+        }
+        if( numinside == 3 ) {
+            _PushTriangle(v0, v1, v2, label, color);
+            return;
+        }
+        // Sutherland-Hodgman against z = _fNear, results in a triangle or a quad
+        RaveVector<float> vclipped[4];
+        int numclipped = 0;
+        for(int i = 0; i < 3; ++i) {
+            const RaveVector<float>& va = *vertices[i];
+            const RaveVector<float>& vb = *vertices[(i+1)%3];
+            if( va.z >= _fNear ) {
+                vclipped[numclipped++] = va;
+            }
+            if( (va.z >= _fNear) != (vb.z >= _fNear) ) {
+                float s = (_fNear - va.z)/(vb.z - va.z);
+                vclipped[numclipped++] = va + s*(vb-va);
+            }
+        }
+        _PushTriangle(vclipped[0], vclipped[1], vclipped[2], label, color);
+        if( numclipped == 4 ) {
+            _PushTriangle(vclipped[0], vclipped[2], vclipped[3], label, color);
+        }
+    }
+
+    inline void _PushTriangle(const RaveVector<float>& v0, const RaveVector<float>& v1, const RaveVector<float>& v2, int label, const uint8_t* pcolor)
+    {
+        _vcamvertices.push_back(v0);
+        _vcamvertices.push_back(v1);
+        _vcamvertices.push_back(v2);
+        _vtrilabels.push_back(label);
+        _vtricolors.insert(_vtricolors.end(), pcolor, pcolor+3);
+    }
+
+    /// \brief projects the triangles and computes their edge equations
+    ///
+    /// Data is kept in separate arrays with branch free loops so that the compiler can vectorize the setup.
+    void _SetupTriangles()
+    {
+        size_t numtriangles = _vtrilabels.size();
+        _vsx.resize(3*numtriangles);
+        _vsy.resize(3*numtriangles);
+        _vsw.resize(3*numtriangles);
+        for(size_t i = 0; i < _vcamvertices.size(); ++i) {
+            float w = 1.0f/_vcamvertices[i].z;
+            _vsx[i] = _fx*_vcamvertices[i].x*w + _cx;
+            _vsy[i] = _fy*_vcamvertices[i].y*w + _cy;
+            _vsw[i] = w;
+        }
+
+        // edge function e_k(x,y) = a_k*x + b_k*y + c_k, positive inside for counter-clockwise triangles
+        _vedges.resize(9*numtriangles);
+        _vinvarea.resize(numtriangles);
+        _vbounds.resize(4*numtriangles);
+        const float fwidth = (float)_width, fheight = (float)_height;
+        for(size_t itri = 0; itri < numtriangles; ++itri) {
+            const float* px = &_vsx[3*itri];
+            const float* py = &_vsy[3*itri];
+            float* pedges = &_vedges[9*itri];
+            for(int k = 0; k < 3; ++k) {
+                int k1 = (k+1)%3, k2 = (k+2)%3;
+                pedges[3*k+0] = py[k1] - py[k2];
+                pedges[3*k+1] = px[k2] - px[k1];
+                pedges[3*k+2] = px[k1]*py[k2] - px[k2]*py[k1];
+            }
+            float area = pedges[2] + pedges[5] + pedges[8];
+            _vinvarea[itri] = area != 0 ? 1.0f/area : 0.0f;
+            // vertices close to the near plane can project far outside of the image, so clip the bounds to the image before they are cast to int
+            _vbounds[4*itri+0] = max(-1.0f, min(fwidth, min(px[0], min(px[1], px[2]))));
+            _vbounds[4*itri+1] = max(-1.0f, min(fheight, min(py[0], min(py[1], py[2]))));
+            _vbounds[4*itri+2] = max(-1.0f, min(fwidth, max(px[0], max(px[1], px[2]))));
+            _vbounds[4*itri+3] = max(-1.0f, min(fheight, max(py[0], max(py[1], py[2]))));
+        }
+    }
+
+    /// \brief assigns the triangles to the tiles their bounding box overlaps
+    void _BinTriangles()
+    {
+        _vtiletriangles.resize(_numtilesx*_numtilesy);
+        FOREACH(it, _vtiletriangles) {
+            it->resize(0);
+        }
+        for(size_t itri = 0; itri < _vinvarea.size(); ++itri) {
+            if( _vinvarea[itri] == 0 ) {
+                continue; // degenerate
+            }
+            const float* pbounds = &_vbounds[4*itri];
+            if( pbounds[2] < 0 || pbounds[3] < 0 || pbounds[0] >= _width || pbounds[1] >= _height ) {
+                continue;
+            }
+            // the bounds are clipped to the image, so the casts cannot overflow
+            int tx0 = max(0, (int)pbounds[0]/TILE_SIZE), ty0 = max(0, (int)pbounds[1]/TILE_SIZE);
+            int tx1 = min(_numtilesx-1, (int)pbounds[2]/TILE_SIZE), ty1 = min(_numtilesy-1, (int)pbounds[3]/TILE_SIZE);
+            for(int ty = ty0; ty <= ty1; ++ty) {
+                for(int tx = tx0; tx <= tx1; ++tx) {
+                    _vtiletriangles[ty*_numtilesx+tx].push_back((int)itri);
+                }
+            }
+        }
+    }
+
+    /// \brief rasterizes the tiles ithread, ithread+nThreads, ... Tiles do not share pixels so no synchronization is needed.
+    void _RasterizeTiles(int ithread, int nThreads)
+    {
+        for(int itile = ithread; itile < (int)_vtiletriangles.size(); itile += nThreads) {
+            int tilex0 = (itile%_numtilesx)*TILE_SIZE, tiley0 = (itile/_numtilesx)*TILE_SIZE;
+            int tilex1 = min(_width, tilex0+TILE_SIZE), tiley1 = min(_height, tiley0+TILE_SIZE);
+            FOREACHC(ittri, _vtiletriangles[itile]) {
+                int itri = *ittri;
+                const float* pbounds = &_vbounds[4*itri];
+                int x0 = max(tilex0, (int)floor(pbounds[0])), y0 = max(tiley0, (int)floor(pbounds[1]));
+                int x1 = min(tilex1, (int)ceil(pbounds[2])+1), y1 = min(tiley1, (int)ceil(pbounds[3])+1);
+                const float* pedges = &_vedges[9*itri];
+                const float* pw = &_vsw[3*itri];
+                // the sign of the area orients the edge functions so that inside is positive
+                float fsign = _vinvarea[itri] > 0 ? 1.0f : -1.0f;
+                float finvarea = fsign*_vinvarea[itri];
+                for(int y = y0; y < y1; ++y) {
+                    float fy = y + 0.5f;
+                    for(int x = x0; x < x1; ++x) {
+                        float fx = x + 0.5f;
+                        float e0 = fsign*(pedges[0]*fx + pedges[1]*fy + pedges[2]);
+                        float e1 = fsign*(pedges[3]*fx + pedges[4]*fy + pedges[5]);
+                        float e2 = fsign*(pedges[6]*fx + pedges[7]*fy + pedges[8]);
+                        if( e0 < 0 || e1 < 0 || e2 < 0 ) {
+                            continue;
+                        }
+                        // 1/z is linear in screen space
+                        float w = (e0*pw[0] + e1*pw[1] + e2*pw[2])*finvarea;
+                        if( w <= 0 ) {
+                            continue;
+                        }
+                        float depth = 1.0f/w;
+                        int index = y*_width+x;
+                        if( depth < _vdepth[index] ) {
+                            _vdepth[index] = depth;
+                            _vlabels[index] = itri;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::map<int, BodyMeshesPtr> _mapbodymeshes; ///< indexed by the environment body index
+
+    int _nThreads;
+    float _fNear; ///< near clipping plane
+    int _width, _height, _numtilesx, _numtilesy;
+    float _fx, _fy, _cx, _cy;
+
+    std::vector<RaveVector<float> > _vlinkvertices; ///< cache
+    std::vector<RaveVector<float> > _vcamvertices; ///< 3 vertices for every triangle in camera coordinates
+    std::vector<int> _vtrilabels; ///< environment body index of every triangle
+    std::vector<uint8_t> _vtricolors; ///< shaded color of every triangle
+    std::vector<float> _vsx, _vsy, _vsw; ///< projected vertices and their inverse depth
+    std::vector<float> _vedges; ///< 3 edge equations for every triangle
+    std::vector<float> _vinvarea;
+    std::vector<float> _vbounds; ///< screen bounding box for every triangle, clipped to [-1, width]x[-1, height]
+    std::vector< std::vector<int> > _vtiletriangles; ///< triangles overlapping each tile
+
+    std::vector<float> _vdepth;
+    std::vector<int> _vlabels; ///< triangle index for every pixel, -1 if none
+
+    SoftwareRasterizerThreadPool _threadpool;
+};
+
+#endif
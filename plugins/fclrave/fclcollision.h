@@ -61,7 +61,7 @@ class FCLCollisionChecker : public OpenRAVE::CollisionCheckerBase
 public:
     class CollisionCallbackData {
 public:
-        CollisionCallbackData(boost::shared_ptr<FCLCollisionChecker> pchecker, CollisionReportPtr report, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<LinkConstPtr>& vlinkexcluded) : _pchecker(pchecker), _report(report), _vbodyexcluded(vbodyexcluded), _vlinkexcluded(vlinkexcluded), bselfCollision(false), _bStopChecking(false), _bCollision(false)
+        CollisionCallbackData(boost::shared_ptr<FCLCollisionChecker> pchecker, CollisionReportPtr report, const std::vector<KinBodyConstPtr>& vbodyexcluded, const std::vector<LinkConstPtr>& vlinkexcluded) : _pchecker(pchecker), _report(report), _vbodyexcluded(vbodyexcluded), _vlinkexcluded(vlinkexcluded), _pLinkEnableStatesMaskOverrides(NULL), bselfCollision(false), _bStopChecking(false), _bCollision(false)
         {
             _bHasCallbacks = _pchecker->GetEnv()->HasRegisteredCollisionCallbacks();
             if( _bHasCallbacks && !_report ) {
@@ -93,6 +93,22 @@ public:
             return _listcallbacks;
         }
 
+        /// \brief true if the link is masked out by _pLinkEnableStatesMaskOverrides for this query
+        bool IsLinkMaskedOut(const KinBody::Link& link) const
+        {
+            if( !_pLinkEnableStatesMaskOverrides ) {
+                return false;
+            }
+            const KinBody* pbody = link.GetParent().get();
+            FOREACHC(itoverride, *_pLinkEnableStatesMaskOverrides) {
+                if( itoverride->first.get() == pbody ) {
+                    const size_t linkindex = link.GetIndex();
+                    return (linkindex >> 6) >= itoverride->second.size() || !IsLinkStateBitEnabled(itoverride->second, linkindex);
+                }
+            }
+            return false;
+        }
+
         boost::shared_ptr<FCLCollisionChecker> _pchecker;
         fcl::CollisionRequest _request;
         fcl::CollisionResult _result;
@@ -101,6 +117,7 @@ public:
         CollisionReportPtr _report;
         std::vector<KinBodyConstPtr> const& _vbodyexcluded;
         std::vector<LinkConstPtr> const& _vlinkexcluded;
+        const LinkEnableStatesMaskOverrides* _pLinkEnableStatesMaskOverrides; ///< if not NULL, per-query masks that exclude links in addition to their enable states
         std::list<EnvironmentBase::CollisionCallbackFn> listcallbacks;
 
         bool bselfCollision;  ///< true if currently checking for self collision.
@@ -552,35 +569,14 @@ public:
 
     virtual bool CheckCollision(KinBodyConstPtr pbody, std::vector<KinBodyConstPtr> const &vbodyexcluded, std::vector<LinkConstPtr> const &vlinkexcluded, CollisionReportPtr report = CollisionReportPtr())
     {
-        if( !!report ) {
-            report->Reset(_options);
-        }
-
-        if( (pbody->GetLinks().size() == 0) || !_IsEnabled(*pbody) ) {
-            return false;
-        }
-
-        _fclspace->Synchronize();
-        FCLCollisionManagerInstance& bodyManager = _GetBodyManager(pbody, !!(_options & OpenRAVE::CO_ActiveDOFs));
-
-        std::vector<int> attachedBodyIndices;
-        pbody->GetAttachedEnvironmentBodyIndices(attachedBodyIndices);
-        FCLCollisionManagerInstance& envManager = _GetEnvManager(attachedBodyIndices);
-
-        CollisionCallbackData query(shared_checker(), report, vbodyexcluded, vlinkexcluded);
-        if( _options & OpenRAVE::CO_Distance ) {
-            if(!report) {
-                throw openrave_exception("FCLCollision - ERROR: YOU MUST PASS IN A CollisionReport STRUCT TO MEASURE DISTANCE!\n");
-            }
-            envManager.GetManager()->distance(bodyManager.GetManager().get(), &query, &FCLCollisionChecker::CheckNarrowPhaseDistance);
-        }
-        ADD_TIMING(_statistics);
-#ifdef FCLRAVE_CHECKPARENTLESS
-        boost::shared_ptr<void> onexit((void*) 0, boost::bind(&FCLCollisionChecker::_PrintCollisionManagerInstanceBE, this, boost::ref(*pbody), boost::ref(bodyManager), boost::ref(envManager)));
-#endif
-        envManager.GetManager()->collide(bodyManager.GetManager().get(), &query, &FCLCollisionChecker::CheckNarrowPhaseCollision);
+        return _CheckCollision(pbody, vbodyexcluded, vlinkexcluded, NULL, report);
+    }
 
-        return query._bCollision;
+    virtual bool CheckCollision(KinBodyConstPtr pbody, const LinkEnableStatesMaskOverrides& vLinkEnableStatesMaskOverrides, CollisionReportPtr report = CollisionReportPtr())
+    {
+        START_TIMING_OPT(_statistics, "Body/Env",_options,pbody->IsRobot());
+        // the broadphase managers are left untouched, the masked links are filtered out in the narrow phase
+        return _CheckCollision(pbody, std::vector<KinBodyConstPtr>(), std::vector<LinkConstPtr>(), &vLinkEnableStatesMaskOverrides, report);
     }
 
     virtual bool CheckCollision(const RAY& ray, LinkConstPtr plink,CollisionReportPtr report = CollisionReportPtr())
@@ -934,7 +930,7 @@ private:
         LinkConstPtr& plink2 = o2info.second;
 
         if( !!plink1 ) {
-            if( !plink1->IsEnabled() ) {
+            if( !plink1->IsEnabled() || pcb->IsLinkMaskedOut(*plink1) ) {
                 return false;
             }
             if( IsIn<KinBodyConstPtr>(plink1->GetParent(), pcb->_vbodyexcluded) || IsIn<LinkConstPtr>(plink1, pcb->_vlinkexcluded) ) {
@@ -943,7 +939,7 @@ private:
         }
 
         if( !!plink2 ) {
-            if( !plink2->IsEnabled() ) {
+            if( !plink2->IsEnabled() || pcb->IsLinkMaskedOut(*plink2) ) {
                 return false;
             }
             if( IsIn<KinBodyConstPtr>(plink2->GetParent(), pcb->_vbodyexcluded) || IsIn<LinkConstPtr>(plink2, pcb->_vlinkexcluded) ) {
@@ -1144,7 +1140,7 @@ private:
         LinkConstPtr& plink2 = o2info.second;
 
         if( !!plink1 ) {
-            if( !plink1->IsEnabled() ) {
+            if( !plink1->IsEnabled() || pcb->IsLinkMaskedOut(*plink1) ) {
                 return false;
             }
             if( IsIn<KinBodyConstPtr>(plink1->GetParent(), pcb->_vbodyexcluded) || IsIn<LinkConstPtr>(plink1, pcb->_vlinkexcluded) ) {
@@ -1153,7 +1149,7 @@ private:
         }
 
         if( !!plink2 ) {
-            if( !plink2->IsEnabled() ) {
+            if( !plink2->IsEnabled() || pcb->IsLinkMaskedOut(*plink2) ) {
                 return false;
             }
             if( IsIn<KinBodyConstPtr>(plink2->GetParent(), pcb->_vbodyexcluded) || IsIn<LinkConstPtr>(plink2, pcb->_vlinkexcluded) ) {
@@ -1267,6 +1263,43 @@ private:
         return _CreateManagerFromBroadphaseAlgorithm(_broadPhaseCollisionManagerAlgorithm);
     }
 
+    /// \brief checks collision of a body and the environment
+    ///
+    /// \param pLinkEnableStatesMaskOverrides if not NULL, masks out links for this query only
+    bool _CheckCollision(KinBodyConstPtr pbody, std::vector<KinBodyConstPtr> const &vbodyexcluded, std::vector<LinkConstPtr> const &vlinkexcluded, const LinkEnableStatesMaskOverrides* pLinkEnableStatesMaskOverrides, CollisionReportPtr report)
+    {
+        if( !!report ) {
+            report->Reset(_options);
+        }
+
+        if( (pbody->GetLinks().size() == 0) || !_IsEnabled(*pbody) ) {
+            return false;
+        }
+
+        _fclspace->Synchronize();
+        FCLCollisionManagerInstance& bodyManager = _GetBodyManager(pbody, !!(_options & OpenRAVE::CO_ActiveDOFs));
+
+        std::vector<int> attachedBodyIndices;
+        pbody->GetAttachedEnvironmentBodyIndices(attachedBodyIndices);
+        FCLCollisionManagerInstance& envManager = _GetEnvManager(attachedBodyIndices);
+
+        CollisionCallbackData query(shared_checker(), report, vbodyexcluded, vlinkexcluded);
+        query._pLinkEnableStatesMaskOverrides = pLinkEnableStatesMaskOverrides;
+        if( _options & OpenRAVE::CO_Distance ) {
+            if(!report) {
+                throw openrave_exception("FCLCollision - ERROR: YOU MUST PASS IN A CollisionReport STRUCT TO MEASURE DISTANCE!\n");
+            }
+            envManager.GetManager()->distance(bodyManager.GetManager().get(), &query, &FCLCollisionChecker::CheckNarrowPhaseDistance);
+        }
+        ADD_TIMING(_statistics);
+#ifdef FCLRAVE_CHECKPARENTLESS
+        boost::shared_ptr<void> onexit((void*) 0, boost::bind(&FCLCollisionChecker::_PrintCollisionManagerInstanceBE, this, boost::ref(*pbody), boost::ref(bodyManager), boost::ref(envManager)));
+#endif
+        envManager.GetManager()->collide(bodyManager.GetManager().get(), &query, &FCLCollisionChecker::CheckNarrowPhaseCollision);
+
+        return query._bCollision;
+    }
+
     FCLCollisionManagerInstance& _GetBodyManager(KinBodyConstPtr pbody, bool bactiveDOFs)
     {
         _bParentlessCollisionObject = false;
@@ -744,36 +744,18 @@ private:
     {
         //KinBodyPtr pbody = info.GetBody();
         if( info.nLastStamp != body.GetUpdateStamp()) {
+            // if only some dofs were set since the last synchronization, only their descendant links moved
+            const std::vector<int>* pvmovedlinks = body.GetLinksMovedSinceStamp(info.nLastStamp);
             info.nLastStamp = body.GetUpdateStamp();
             BOOST_ASSERT( body.GetLinks().size() == info.vlinks.size() );
-            CollisionObjectPtr pcoll;
-            for(size_t i = 0; i < body.GetLinks().size(); ++i) {
-                const FCLSpace::FCLKinBodyInfo::LinkInfo& linkInfo = *info.vlinks[i];
-                pcoll = linkInfo.linkBV.second;
-                if( !pcoll ) {
-                    continue;
+            if( !!pvmovedlinks ) {
+                for(int linkindex : *pvmovedlinks) {
+                    _SynchronizeLink(*info.vlinks[linkindex], body.GetLinks()[linkindex]->GetTransform());
                 }
-                const Transform& linkTransform = body.GetLinks()[i]->GetTransform();
-                Transform pose = linkTransform * linkInfo.linkBV.first;
-                fcl::Vec3f newPosition = ConvertVectorToFCL(pose.trans);
-                fcl::Quaternion3f newOrientation = ConvertQuaternionToFCL(pose.rot);
-
-                pcoll->setTranslation(newPosition);
-                pcoll->setQuatRotation(newOrientation);
-                // Do not forget to recompute the AABB otherwise getAABB won't give an up to date AABB
-                pcoll->computeAABB();
-
-                //info.vlinks[i]->nLastStamp = info.nLastStamp;
-                for (const TransformCollisionPair& pgeom : linkInfo.vgeoms) {
-                    fcl::CollisionObject& coll = *pgeom.second;
-                    Transform pose = linkTransform * pgeom.first;
-                    fcl::Vec3f newPosition = ConvertVectorToFCL(pose.trans);
-                    fcl::Quaternion3f newOrientation = ConvertQuaternionToFCL(pose.rot);
-
-                    coll.setTranslation(newPosition);
-                    coll.setQuatRotation(newOrientation);
-                    // Do not forget to recompute the AABB otherwise getAABB won't give an up to date AABB
-                    coll.computeAABB();
+            }
+            else {
+                for(size_t i = 0; i < body.GetLinks().size(); ++i) {
+                    _SynchronizeLink(*info.vlinks[i], body.GetLinks()[i]->GetTransform());
                 }
             }
 
@@ -784,6 +766,34 @@ private:
         }
     }
 
+    void _SynchronizeLink(const FCLSpace::FCLKinBodyInfo::LinkInfo& linkInfo, const Transform& linkTransform)
+    {
+        const CollisionObjectPtr& pcoll = linkInfo.linkBV.second;
+        if( !pcoll ) {
+            return;
+        }
+        Transform pose = linkTransform * linkInfo.linkBV.first;
+        fcl::Vec3f newPosition = ConvertVectorToFCL(pose.trans);
+        fcl::Quaternion3f newOrientation = ConvertQuaternionToFCL(pose.rot);
+
+        pcoll->setTranslation(newPosition);
+        pcoll->setQuatRotation(newOrientation);
+        // Do not forget to recompute the AABB otherwise getAABB won't give an up to date AABB
+        pcoll->computeAABB();
+
+        for (const TransformCollisionPair& pgeom : linkInfo.vgeoms) {
+            fcl::CollisionObject& coll = *pgeom.second;
+            Transform pose = linkTransform * pgeom.first;
+            fcl::Vec3f newPosition = ConvertVectorToFCL(pose.trans);
+            fcl::Quaternion3f newOrientation = ConvertQuaternionToFCL(pose.rot);
+
+            coll.setTranslation(newPosition);
+            coll.setQuatRotation(newOrientation);
+            // Do not forget to recompute the AABB otherwise getAABB won't give an up to date AABB
+            coll.computeAABB();
+        }
+    }
+
     /// \brief controls whether the kinbody info is removed during the destructor
     class FCLKinBodyInfoRemover
     {
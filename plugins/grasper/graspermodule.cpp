@@ -14,11 +14,21 @@
 // You should have received a copy of the GNU Lesser General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "plugindefs.h"
+#include "wrenchspacequality.h"
 
 #include <algorithm>
+#include <atomic>
+#include <boost/algorithm/string.hpp>
 #include <boost/thread/condition.hpp>
 #include <boost/thread/mutex.hpp>
 #include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 
 #ifdef QHULL_FOUND
@@ -84,13 +94,17 @@ public:
         RegisterCommand("Grasp",boost::bind(&GrasperModule::_GraspCommand,this,_1,_2),
                         "Performs a grasp and returns contact points");
         RegisterCommand("GraspThreaded",boost::bind(&GrasperModule::_GraspThreadedCommand,this,_1,_2),
-                        "Parllelizes the computation of the grasp planning and force closure. Number of threads can be specified with 'numthreads'.");
+                        "Parllelizes the computation of the grasp planning and force closure. Number of threads can be specified with 'numthreads'. If 'outputfile' is specified, every evaluated grasp is appended to that binary file as soon as it finishes, and running the same command again resumes from the grasps already in the file.");
         RegisterCommand("ComputeDistanceMap",boost::bind(&GrasperModule::_ComputeDistanceMapCommand,this,_1,_2),
                         "Computes a distance map around a particular point in space");
         RegisterCommand("GetStableContacts",boost::bind(&GrasperModule::_GetStableContactsCommand,this,_1,_2),
                         "Returns the stable contacts as defined by the closing direction");
         RegisterCommand("ConvexHull",boost::bind(&GrasperModule::_ConvexHullCommand,this,_1,_2),
                         "Given a point cloud, returns information about its convex hull like normal planes, vertex indices, and triangle indices. Computed planes point outside the mesh, face indices are not ordered, triangles point outside the mesh (counter-clockwise)");
+        RegisterCommand("ComputeGraspQualities",boost::bind(&GrasperModule::_ComputeGraspQualitiesCommand,this,_1,_2),
+                        "Computes the force closure epsilon quality of many sets of contacts in parallel without building convex hulls. Returns one value per set, 0 if the contacts are not in force closure. Force closure is exact, the epsilon quality is an upper bound that is usually within a few percent of the convex hull value.");
+        RegisterCommand("GetNumCollisionChecks",boost::bind(&GrasperModule::_GetNumCollisionChecksCommand,this,_1,_2),
+                        "Returns the number of link collision checks the planner did for the last Grasp command");
     }
     virtual ~GrasperModule() {
         if( !!outfile )
@@ -103,6 +117,7 @@ public:
     {
         _planner.reset();
         _robot.reset();
+        _pqualitythreadpool.reset();
     }
 
     virtual int main(const std::string& args)
@@ -152,6 +167,7 @@ public:
         bool bExecute = true;
         bool bComputeStableContacts = false;
         bool bComputeForceClosure = false;
+        bool bFastForceClosure = false;
         bool bOutputFinal = false;
         dReal friction = 0;
 
@@ -269,6 +285,9 @@ public:
                 // initialization
                 sinput >> bComputeForceClosure;
             }
+            else if( cmd == "fastforceclosure" ) {
+                sinput >> bFastForceClosure;
+            }
             else if( cmd == "collision" ) {
                 // initialiation
                 string name; sinput >> name;
@@ -284,6 +303,9 @@ public:
             else if( cmd == "finestep" ) {
                 sinput >> params->ffinestep;
             }
+            else if( cmd == "distanceguidedclosing" ) {
+                sinput >> params->bdistanceguidedclosing;
+            }
             else if( cmd == "chuckingdirection" ) {
                 vchuckingdir.resize(_robot->GetActiveManipulator()->GetGripperDOF());
                 for(size_t i = 0; i < vchuckingdir.size(); ++i) {
@@ -403,7 +425,13 @@ public:
                 for(size_t i = 0; i < c.size(); ++i) {
                     c[i] = contacts[i].first;
                 }
-                analysis = _AnalyzeContacts3D(c,friction,8);
+                if( bFastForceClosure ) {
+                    WrenchSpaceQualityEvaluator::Workspace workspace;
+                    analysis = _AnalyzeContactsWrenchSpace(c, WrenchSpaceQualityEvaluator(friction,8), workspace);
+                }
+                else {
+                    analysis = _AnalyzeContacts3D(c,friction,8);
+                }
             }
             catch(const std::exception& ex) {
                 RAVELOG_WARN("AnalyzeContacts3D: %s\n",ex.what());
@@ -417,6 +445,12 @@ public:
         return true;
     }
 
+    virtual bool _GetNumCollisionChecksCommand(std::ostream& sout, std::istream& sinput)
+    {
+        stringstream scmd("GetNumCollisionChecks");
+        return _planner->SendCommand(sout, scmd);
+    }
+
     virtual bool _ComputeDistanceMapCommand(std::ostream& sout, std::istream& sinput)
     {
         EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
@@ -523,6 +557,69 @@ public:
         return true;
     }
 
+    virtual bool _ComputeGraspQualitiesCommand(std::ostream& sout, std::istream& sinput)
+    {
+        string cmd;
+        dReal friction = 0.4;
+        int nconepoints = 8;
+        int numthreads = 0;
+        vector< vector<CollisionReport::CONTACT> > vgrasps;
+        while(!sinput.eof()) {
+            sinput >> cmd;
+            if( !sinput ) {
+                break;
+            }
+            std::transform(cmd.begin(), cmd.end(), cmd.begin(), ::tolower);
+
+            if( cmd == "friction" ) {
+                sinput >> friction;
+            }
+            else if( cmd == "conepoints" ) {
+                sinput >> nconepoints;
+            }
+            else if( cmd == "numthreads" ) {
+                sinput >> numthreads;
+            }
+            else if( cmd == "grasps" ) {
+                int numgrasps = 0;
+                sinput >> numgrasps;
+                vgrasps.resize(numgrasps);
+                FOREACH(itgrasp, vgrasps) {
+                    int numcontacts = 0;
+                    sinput >> numcontacts;
+                    itgrasp->resize(numcontacts);
+                    FOREACH(itcontact, *itgrasp) {
+                        sinput >> itcontact->pos.x >> itcontact->pos.y >> itcontact->pos.z >> itcontact->norm.x >> itcontact->norm.y >> itcontact->norm.z;
+                    }
+                }
+            }
+            else {
+                RAVELOG_WARN(str(boost::format("unrecognized command: %s\n")%cmd));
+                break;
+            }
+
+            if( !sinput ) {
+                RAVELOG_ERROR(str(boost::format("failed processing command %s\n")%cmd));
+                return false;
+            }
+        }
+
+        if( nconepoints <= 0 ) {
+            RAVELOG_ERROR(str(boost::format("conepoints needs to be positive, got %d\n")%nconepoints));
+            return false;
+        }
+        WrenchSpaceQualityEvaluator evaluator(friction, nconepoints);
+        vector<WrenchSpaceQualityEvaluator::Quality> vqualities;
+        if( !_pqualitythreadpool ) {
+            _pqualitythreadpool.reset(new WrenchSpaceQualityThreadPool());
+        }
+        evaluator.EvaluateBatch(vgrasps, vqualities, *_pqualitythreadpool, numthreads);
+        FOREACHC(itquality, vqualities) {
+            sout << itquality->mindist << " ";
+        }
+        return true;
+    }
+
     virtual bool _ConvexHullCommand(std::ostream& sout, std::istream& sinput)
     {
         string cmd;
@@ -665,6 +762,8 @@ public:
             nGraspingNoiseRetries = 0;
             forceclosurethreshold = 0;
             ffinestep = 0.001f;
+            bDistanceGuidedClosing = false;
+            bFastForceClosure = false;
             bCheckGraspIK = false;
         }
 
@@ -680,6 +779,9 @@ public:
         string collisionchecker;
         dReal ftranslationstepmult;
         dReal ffinestep;
+        bool bDistanceGuidedClosing;
+        bool bFastForceClosure; ///< if true, use pqualityevaluator instead of convex hulls
+        boost::shared_ptr<WrenchSpaceQualityEvaluator> pqualityevaluator;
 
         string manipname;
         vector<int> vactiveindices;
@@ -723,6 +825,7 @@ public:
         vector<dReal> standoffs;
         size_t startindex = 0;
         size_t maxgrasps = 0;
+        string outputfilename;
 
         while(!sinput.eof()) {
             sinput >> cmd;
@@ -769,9 +872,22 @@ public:
             else if( cmd == "finestep" ) {
                 sinput >> worker_params->ffinestep;
             }
+            else if( cmd == "distanceguidedclosing" ) {
+                sinput >> worker_params->bDistanceGuidedClosing;
+            }
+            else if( cmd == "fastforceclosure" ) {
+                sinput >> worker_params->bFastForceClosure;
+            }
             else if( cmd == "numthreads" ) {
                 sinput >> numthreads;
             }
+            else if( cmd == "outputfile" ) {
+                // rest of the line, so the path can have spaces
+                if( !getline(sinput, outputfilename) ) {
+                    return false;
+                }
+                boost::trim(outputfilename);
+            }
             // grasp specific
             else if( cmd == "approachrays" ) {
                 int numapproachrays = 0;
@@ -835,58 +951,70 @@ public:
         worker_params->vactiveindices = _robot->GetActiveDOFIndices();
         worker_params->affinedofs = _robot->GetAffineDOF();
         worker_params->affineaxis = _robot->GetAffineRotationAxis();
-
-        EnvironmentBasePtr pcloneenv = GetEnv()->CloneSelf(Clone_Bodies|Clone_Simulation);
-
-        _bContinueWorker = true;
-        // start worker threads
-        vector<boost::shared_ptr<boost::thread> > listthreads(numthreads);
-        FOREACH(itthread,listthreads) {
-            itthread->reset(new boost::thread(boost::bind(&GrasperModule::_WorkerThread,this,worker_params,pcloneenv)));
+        if( worker_params->bComputeForceClosure && worker_params->bFastForceClosure ) {
+            worker_params->pqualityevaluator.reset(new WrenchSpaceQualityEvaluator(worker_params->friction,8));
+        }
+
+        GraspWorkQueuePtr queue(new GraspWorkQueue());
+        queue->approachrays.swap(approachrays);
+        queue->rolls.swap(rolls);
+        queue->preshapes.swap(preshapes);
+        queue->manipulatordirections.swap(manipulatordirections);
+        queue->standoffs.swap(standoffs);
+        queue->numgrasps = queue->approachrays.size()*queue->rolls.size()*queue->preshapes.size()*queue->standoffs.size()*queue->manipulatordirections.size();
+        queue->maxgrasps = maxgrasps == 0 ? queue->numgrasps : maxgrasps;
+        queue->nextid = startindex;
+        queue->numresults = 0;
+        queue->vevaluated.resize(queue->numgrasps, 0);
+        if( outputfilename.size() > 0 ) {
+            if( !_OpenGraspOutputFile(*queue, *worker_params, outputfilename) ) {
+                return false;
+            }
         }
+        RAVELOG_INFO(str(boost::format("number of grasps to test: %d\n")%queue->numgrasps));
 
-        _listGraspResults.clear();
-        size_t numgrasps = approachrays.size()*rolls.size()*preshapes.size()*standoffs.size()*manipulatordirections.size();
-        if( maxgrasps == 0 ) {
-            maxgrasps = numgrasps;
+        // every worker gets its own environment so that collision checkers and planners are never shared
+        vector<EnvironmentBasePtr> vworkerenvs(max(1,numthreads));
+        try {
+            FOREACH(itenv, vworkerenvs) {
+                *itenv = GetEnv()->CloneSelf(Clone_Bodies|Clone_Simulation);
+            }
         }
-        RAVELOG_INFO(str(boost::format("number of grasps to test: %d\n")%numgrasps));
-        size_t id = startindex;
-        for(id=startindex; id < numgrasps; ++id) {
-            size_t istandoff = id % standoffs.size();
-            size_t ipreshape = (id / standoffs.size()) % preshapes.size();
-            size_t iroll = (id / (preshapes.size() * standoffs.size())) % rolls.size();
-            size_t iapproachray = (id / (rolls.size() * preshapes.size() * standoffs.size()))%approachrays.size();
-            size_t imanipulatordirection = (id / (rolls.size() * preshapes.size() * standoffs.size()*approachrays.size()));
-
-            boost::mutex::scoped_lock lock(_mutexGrasp);
-            if( _listGraspResults.size() >= maxgrasps ) {
-                break;
+        catch(...) {
+            FOREACH(itenv, vworkerenvs) {
+                if( !!*itenv ) {
+                    (*itenv)->Destroy();
+                }
             }
-
-            // initialize _graspParamsWork
-            BOOST_ASSERT(!_graspParamsWork);
-            _graspParamsWork.reset(new GraspParametersThread());
-            _graspParamsWork->id = id;
-            _graspParamsWork->vtargetposition = approachrays.at(iapproachray).first;
-            _graspParamsWork->vtargetdirection = approachrays.at(iapproachray).second;
-            _graspParamsWork->vmanipulatordirection = manipulatordirections.at(imanipulatordirection);
-            _graspParamsWork->ftargetroll = rolls.at(iroll);
-            _graspParamsWork->fstandoff = standoffs.at(istandoff);
-            _graspParamsWork->preshape = preshapes.at(ipreshape);
-            _condGraspHasWork.notify_one();     // notify there is work
-            _condGraspReceivedWork.wait(lock);     // wait for more work
+            if( !!queue->outputfile ) {
+                fclose(queue->outputfile);
+                queue->outputfile = NULL;
+            }
+            throw;
         }
 
-        // wait for workers
-        _bContinueWorker = false;
+        _listGraspResults.clear();
+        vector<boost::shared_ptr<boost::thread> > listthreads(vworkerenvs.size());
+        for(size_t ithread = 0; ithread < listthreads.size(); ++ithread) {
+            listthreads[ithread].reset(new boost::thread(boost::bind(&GrasperModule::_WorkerThread,this,worker_params,vworkerenvs[ithread],queue)));
+        }
         FOREACH(itthread,listthreads) {
-            _condGraspHasWork.notify_all();     // signal
             (*itthread)->join();
         }
         listthreads.clear();
+        vworkerenvs.clear();
+        if( !!queue->outputfile ) {
+            fclose(queue->outputfile);
+            queue->outputfile = NULL;
+        }
 
-        // parse results to output
+        // the first grasp that was not evaluated, so the command can be resumed with startindex
+        size_t id = startindex;
+        while( id < queue->numgrasps && queue->vevaluated[id] ) {
+            ++id;
+        }
+
+        // parse results to output, results written to the output file are not repeated
         sout << id << " " << _listGraspResults.size() << " ";
         FOREACH(itresult, _listGraspResults) {
             sout << (*itresult)->vtargetposition.x << " " << (*itresult)->vtargetposition.y << " " << (*itresult)->vtargetposition.z << " ";
@@ -907,21 +1035,91 @@ public:
                 sout << c.pos.x << " " << c.pos.y << " " << c.pos.z << " " << c.norm.x << " " << c.norm.y << " " << c.norm.z << " ";
             }
         }
+        _listGraspResults.clear();
         return true;
     }
 
-    void _WorkerThread(const WorkerParametersPtr worker_params, EnvironmentBasePtr penv)
+    /// \brief grasps to evaluate by GraspThreaded, shared by all the worker threads
+    ///
+    /// Workers pop the next grasp id with an atomic increment, so no lock is needed to distribute the work.
+    struct GraspWorkQueue
     {
-        // clone environment
-        EnvironmentBasePtr pcloneenv = penv->CloneSelf(Clone_Bodies|Clone_Simulation);
+        GraspWorkQueue() : numgrasps(0), maxgrasps(0), outputfile(NULL) {
+        }
+
+        /// \brief returns the parameters of the next grasp to evaluate, or an empty pointer if there is no work left
+        GraspParametersThreadPtr Pop()
         {
+            while( numresults < maxgrasps ) {
+                size_t id = nextid++;
+                if( id >= numgrasps ) {
+                    break;
+                }
+                if( vevaluated[id] ) {
+                    // already in the output file from a previous run
+                    continue;
+                }
+                size_t istandoff = id % standoffs.size();
+                size_t ipreshape = (id / standoffs.size()) % preshapes.size();
+                size_t iroll = (id / (preshapes.size() * standoffs.size())) % rolls.size();
+                size_t iapproachray = (id / (rolls.size() * preshapes.size() * standoffs.size()))%approachrays.size();
+                size_t imanipulatordirection = (id / (rolls.size() * preshapes.size() * standoffs.size()*approachrays.size()));
+
+                GraspParametersThreadPtr grasp_params(new GraspParametersThread());
+                grasp_params->id = id;
+                grasp_params->vtargetposition = approachrays.at(iapproachray).first;
+                grasp_params->vtargetdirection = approachrays.at(iapproachray).second;
+                grasp_params->vmanipulatordirection = manipulatordirections.at(imanipulatordirection);
+                grasp_params->ftargetroll = rolls.at(iroll);
+                grasp_params->fstandoff = standoffs.at(istandoff);
+                grasp_params->preshape = preshapes.at(ipreshape);
+                grasp_params->mindist = 0;
+                grasp_params->volume = 0;
+                return grasp_params;
+            }
+            return GraspParametersThreadPtr();
+        }
+
+        vector< pair<Vector, Vector> > approachrays;
+        vector<dReal> rolls;
+        vector< vector<dReal> > preshapes;
+        vector<Vector> manipulatordirections;
+        vector<dReal> standoffs;
+        size_t numgrasps, maxgrasps;
+        std::atomic<size_t> nextid; ///< next grasp id to pop
+        std::atomic<size_t> numresults; ///< number of successful grasps, including the ones from a resumed output file
+        vector<uint8_t> vevaluated; ///< 1 if the grasp was evaluated, every worker only writes the entries of the ids it popped
+        FILE* outputfile; ///< if not NULL, results are streamed into this file, protected by _mutexGrasp
+    };
+    typedef boost::shared_ptr<GraspWorkQueue> GraspWorkQueuePtr;
+
+    /// \brief objects used by one worker thread, all belong to the environment of the worker
+    struct GraspWorkerContext
+    {
+        EnvironmentBasePtr penv;
+        PlannerBasePtr planner;
+        RobotBasePtr probot;
+        GraspParametersPtr params;
+        CollisionReportPtr report;
+        TrajectoryBasePtr ptraj;
+        std::vector<KinBody::LinkPtr> vlinks;
+        Transform trobotstart;
+        int coloptions;
+        WrenchSpaceQualityEvaluator::Workspace qualityworkspace;
+    };
+
+    void _WorkerThread(const WorkerParametersPtr worker_params, EnvironmentBasePtr pcloneenv, GraspWorkQueuePtr queue)
+    {
+        // destroy the environment even if the setup throws, after all the worker objects are released
+        boost::shared_ptr<void> destroyenv((void*)0, boost::bind(&EnvironmentBase::Destroy, pcloneenv));
+        try {
             EnvironmentMutex::scoped_lock lock(pcloneenv->GetMutex());
             boost::shared_ptr<CollisionCheckerMngr> pcheckermngr(new CollisionCheckerMngr(pcloneenv, worker_params->collisionchecker));
-            PlannerBasePtr planner = RaveCreatePlanner(pcloneenv,"Grasper");
-            RobotBasePtr probot = pcloneenv->GetRobot(_robot->GetName());
-            string strsavetraj;
-
-            probot->SetActiveManipulator(worker_params->manipname);
+            GraspWorkerContext context;
+            context.penv = pcloneenv;
+            context.planner = RaveCreatePlanner(pcloneenv,"Grasper");
+            context.probot = pcloneenv->GetRobot(_robot->GetName());
+            context.probot->SetActiveManipulator(worker_params->manipname);
 
             // setup parameters
             GraspParametersPtr params(new GraspParameters(pcloneenv));
@@ -932,93 +1130,204 @@ public:
             params->btightgrasp = worker_params->btightgrasp;
             params->fgraspingnoise = 0;
             params->ftranslationstepmult = worker_params->ftranslationstepmult;
+            params->bdistanceguidedclosing = worker_params->bDistanceGuidedClosing;
+            context.params = params;
 
-            CollisionReportPtr report(new CollisionReport());
-            TrajectoryBasePtr ptraj = RaveCreateTrajectory(pcloneenv,"");
-            GraspParametersThreadPtr grasp_params;
+            context.report.reset(new CollisionReport());
+            context.ptraj = RaveCreateTrajectory(pcloneenv,"");
 
             // calculate the contact normals
-            std::vector<KinBody::LinkPtr> vlinks, vindependentlinks;
-            probot->GetActiveManipulator()->GetChildLinks(vlinks);
-            probot->GetActiveManipulator()->GetIndependentLinks(vindependentlinks);
-            Transform trobotstart = probot->GetTransform();
-
-            vector<dReal> vtrajpoint;
+            context.probot->GetActiveManipulator()->GetChildLinks(context.vlinks);
+            context.trobotstart = context.probot->GetTransform();
 
             // use CO_ActiveDOFs since might be calling FindIKSolution
-            int coloptions = GetEnv()->GetCollisionChecker()->GetCollisionOptions()|(worker_params->bCheckGraspIK ? CO_ActiveDOFs : 0);
-            coloptions &= ~CO_Contacts;
-            pcloneenv->GetCollisionChecker()->SetCollisionOptions(coloptions|CO_Contacts);
-
-            while(_bContinueWorker) {
-                {
-                    // wait for work
-                    boost::mutex::scoped_lock lock(_mutexGrasp);
-                    if( !_graspParamsWork ) {
-                        _condGraspHasWork.wait(lock);
-                        // after signal
-                        if( !_graspParamsWork ) {
-                            continue;
-                        }
+            context.coloptions = GetEnv()->GetCollisionChecker()->GetCollisionOptions()|(worker_params->bCheckGraspIK ? CO_ActiveDOFs : 0);
+            context.coloptions &= ~CO_Contacts;
+            pcloneenv->GetCollisionChecker()->SetCollisionOptions(context.coloptions|CO_Contacts);
+
+            std::vector<uint8_t> vrecord;
+            GraspParametersThreadPtr grasp_params;
+            while( !!(grasp_params = queue->Pop()) ) {
+                bool bSuccess = false;
+                try {
+                    bSuccess = _EvaluateGrasp(context, worker_params, grasp_params);
+                }
+                catch(const std::exception& ex) {
+                    RAVELOG_WARN(str(boost::format("grasp %d: failed with exception: %s")%grasp_params->id%ex.what()));
+                }
+                if( bSuccess && queue->numresults++ >= queue->maxgrasps ) {
+                    // other workers already found maxgrasps grasps while this one was evaluated. Leave the grasp unevaluated so a resumed run evaluates it again.
+                    continue;
+                }
+                if( !!queue->outputfile ) {
+                    _SerializeGraspRecord(vrecord, *grasp_params, bSuccess);
+                }
+
+                boost::mutex::scoped_lock lock(_mutexGrasp);
+                queue->vevaluated[grasp_params->id] = 1;
+                if( !!queue->outputfile ) {
+                    // flush every record so that a crash loses at most the grasps being evaluated
+                    if( fwrite(vrecord.data(), 1, vrecord.size(), queue->outputfile) != vrecord.size() || fflush(queue->outputfile) != 0 ) {
+                        RAVELOG_ERROR(str(boost::format("grasp %d: failed to write to the grasp output file")%grasp_params->id));
                     }
-                    grasp_params = _graspParamsWork;
-                    _graspParamsWork.reset();
-                    _condGraspReceivedWork.notify_all();
                 }
+                else if( bSuccess ) {
+                    _listGraspResults.push_back(grasp_params);
+                }
+            }
+        }
+        catch(const std::exception& ex) {
+            // an exception must not leave the thread, the grasps of this worker stay unevaluated
+            RAVELOG_ERROR(str(boost::format("grasp worker failed: %s")%ex.what()));
+        }
+    }
+
+    /// \brief plans the grasp in the environment of the worker and fills the results of grasp_params
+    ///
+    /// \return true if the grasp succeeded
+    bool _EvaluateGrasp(GraspWorkerContext& context, const WorkerParametersPtr& worker_params, const GraspParametersThreadPtr& grasp_params)
+    {
+        EnvironmentBasePtr& pcloneenv = context.penv;
+        PlannerBasePtr& planner = context.planner;
+        RobotBasePtr& probot = context.probot;
+        GraspParametersPtr& params = context.params;
+        CollisionReportPtr& report = context.report;
+        TrajectoryBasePtr& ptraj = context.ptraj;
+        const std::vector<KinBody::LinkPtr>& vlinks = context.vlinks;
+        const Transform& trobotstart = context.trobotstart;
+        const int coloptions = context.coloptions;
+
+        RAVELOG_DEBUG(str(boost::format("grasp %d: start")%grasp_params->id));
+
+        // fill params
+        params->vtargetdirection = grasp_params->vtargetdirection;
+        params->ftargetroll = grasp_params->ftargetroll;
+        params->vtargetposition = grasp_params->vtargetposition;
+        params->vmanipulatordirection = grasp_params->vmanipulatordirection;
+        params->fstandoff = grasp_params->fstandoff;
+        probot->SetActiveDOFs(worker_params->vactiveindices);
+        probot->SetActiveDOFValues(grasp_params->preshape);
+        probot->SetActiveDOFs(worker_params->vactiveindices,worker_params->affinedofs,worker_params->affineaxis);
+        params->SetRobotActiveJoints(probot);
+
+        RobotBase::RobotStateSaver saver(probot);
+        probot->Enable(true);
+
+        params->fgraspingnoise = 0;
+        ptraj->Init(probot->GetActiveConfigurationSpecification());
+
+        // InitPlan/PlanPath
+        if( !planner->InitPlan(probot, params) ) {
+            RAVELOG_DEBUG(str(boost::format("grasp %d: grasper planner failed")%grasp_params->id));
+            return false;
+        }
+        if( !planner->PlanPath(ptraj).GetStatusCode() ) {
+            RAVELOG_DEBUG(str(boost::format("grasp %d: grasper planner failed")%grasp_params->id));
+            return false;
+        }
 
-                RAVELOG_DEBUG(str(boost::format("grasp %d: start")%grasp_params->id));
+        BOOST_ASSERT(ptraj->GetNumWaypoints() > 0);
+        vector<dReal> vtrajpoint;
+        ptraj->GetWaypoint(-1,vtrajpoint,probot->GetConfigurationSpecification());
+        probot->SetConfigurationValues(vtrajpoint.begin(),true);
+        grasp_params->transfinal = probot->GetTransform();
+        probot->GetDOFValues(grasp_params->finalshape);
 
-                // fill params
-                params->vtargetdirection = grasp_params->vtargetdirection;
-                params->ftargetroll = grasp_params->ftargetroll;
-                params->vtargetposition = grasp_params->vtargetposition;
-                params->vmanipulatordirection = grasp_params->vmanipulatordirection;
-                params->fstandoff = grasp_params->fstandoff;
+        FOREACHC(itlink, vlinks) {
+            if( pcloneenv->CheckCollision(KinBody::LinkConstPtr(*itlink), KinBodyConstPtr(params->targetbody), report) ) {
+                RAVELOG_VERBOSE(str(boost::format("contact %s\n")%report->__str__()));
+                FOREACH(itcontact,report->contacts) {
+                    if( report->plink1 != *itlink ) {
+                        itcontact->norm = -itcontact->norm;
+                        itcontact->depth = -itcontact->depth;
+                    }
+                    grasp_params->contacts.emplace_back(*itcontact, (*itlink)->GetIndex());
+                }
+            }
+        }
+
+        if ( worker_params->bCheckGraspIK ) {
+            CollisionOptionsStateSaver optionstate(pcloneenv->GetCollisionChecker(),coloptions,false); // remove contacts
+            Transform Tgoalgrasp = probot->GetActiveManipulator()->GetEndEffectorTransform();
+            RobotBase::RobotStateSaver linksaver(probot);
+            probot->SetTransform(trobotstart);
+            FOREACH(itlink,vlinks) {
+                (*itlink)->Enable(false);
+            }
+            probot->SetActiveDOFs(worker_params->vactiveindices);
+            probot->SetActiveDOFValues(grasp_params->preshape);
+            probot->SetActiveDOFs(probot->GetActiveManipulator()->GetArmIndices());
+            vector<dReal> solution;
+            if( !probot->GetActiveManipulator()->FindIKSolution(Tgoalgrasp, solution,IKFO_CheckEnvCollisions) ) {
+                RAVELOG_DEBUG(str(boost::format("grasp %d: ik failed")%grasp_params->id));
+                return false;     // ik failed
+            }
+
+            grasp_params->transfinal = trobotstart;
+            size_t index = 0;
+            FOREACHC(itarmindex,probot->GetActiveManipulator()->GetArmIndices()) {
+                grasp_params->finalshape.at(*itarmindex) = solution.at(index++);
+            }
+        }
+
+        GRASPANALYSIS analysis;
+        if( worker_params->bComputeForceClosure ) {
+            try {
+                vector<CollisionReport::CONTACT> c(grasp_params->contacts.size());
+                for(size_t i = 0; i < c.size(); ++i) {
+                    c[i] = grasp_params->contacts[i].first;
+                }
+                if( !!worker_params->pqualityevaluator ) {
+                    analysis = _AnalyzeContactsWrenchSpace(c, *worker_params->pqualityevaluator, context.qualityworkspace);
+                    // the estimate is an upper bound of the epsilon quality, so it can only reject grasps. the convex hull certifies the rest.
+                    if( worker_params->forceclosurethreshold > 0 && analysis.mindist >= worker_params->forceclosurethreshold ) {
+                        analysis = _AnalyzeContacts3D(c,worker_params->friction,8);
+                    }
+                }
+                else {
+                    analysis = _AnalyzeContacts3D(c,worker_params->friction,8);
+                }
+                if( analysis.mindist < worker_params->forceclosurethreshold ) {
+                    RAVELOG_DEBUG(str(boost::format("grasp %d: force closure failed")%grasp_params->id));
+                    return false;
+                }
+                grasp_params->mindist = analysis.mindist;
+                grasp_params->volume = analysis.volume;
+            }
+            catch(const std::exception& ex) {
+                RAVELOG_DEBUG(str(boost::format("grasp %d: force closure failed: %s")%grasp_params->id%ex.what()));
+                return false;     // failed
+            }
+        }
+
+        if( worker_params->fgraspingnoise > 0 && worker_params->nGraspingNoiseRetries > 0 ) {
+            params->fgraspingnoise = worker_params->fgraspingnoise;
+            vector<Transform> vfinaltransformations; vfinaltransformations.reserve(worker_params->nGraspingNoiseRetries);
+            vector< vector<dReal> > vfinalvalues; vfinalvalues.reserve(worker_params->nGraspingNoiseRetries);
+            for(int igrasp = 0; igrasp < worker_params->nGraspingNoiseRetries; ++igrasp) {
                 probot->SetActiveDOFs(worker_params->vactiveindices);
                 probot->SetActiveDOFValues(grasp_params->preshape);
                 probot->SetActiveDOFs(worker_params->vactiveindices,worker_params->affinedofs,worker_params->affineaxis);
-                params->SetRobotActiveJoints(probot);
-
-                RobotBase::RobotStateSaver saver(probot);
-                probot->Enable(true);
-
-                params->fgraspingnoise = 0;
+                params->vinitialconfig.resize(0);
                 ptraj->Init(probot->GetActiveConfigurationSpecification());
-
-                // InitPlan/PlanPath
                 if( !planner->InitPlan(probot, params) ) {
-                    RAVELOG_DEBUG(str(boost::format("grasp %d: grasper planner failed")%grasp_params->id));
-                    continue;
+                    RAVELOG_VERBOSE(str(boost::format("grasp %d: grasping noise planner failed")%grasp_params->id));
+                    break;
                 }
                 if( !planner->PlanPath(ptraj).GetStatusCode() ) {
-                    RAVELOG_DEBUG(str(boost::format("grasp %d: grasper planner failed")%grasp_params->id));
-                    continue;
+                    RAVELOG_VERBOSE(str(boost::format("grasp %d: grasping noise planner failed")%grasp_params->id));
+                    break;
                 }
-
                 BOOST_ASSERT(ptraj->GetNumWaypoints() > 0);
-                vector<dReal> vtrajpoint;
-                ptraj->GetWaypoint(-1,vtrajpoint,probot->GetConfigurationSpecification());
-                probot->SetConfigurationValues(vtrajpoint.begin(),true);
-                grasp_params->transfinal = probot->GetTransform();
-                probot->GetDOFValues(grasp_params->finalshape);
-
-                FOREACHC(itlink, vlinks) {
-                    if( pcloneenv->CheckCollision(KinBody::LinkConstPtr(*itlink), KinBodyConstPtr(params->targetbody), report) ) {
-                        RAVELOG_VERBOSE(str(boost::format("contact %s\n")%report->__str__()));
-                        FOREACH(itcontact,report->contacts) {
-                            if( report->plink1 != *itlink ) {
-                                itcontact->norm = -itcontact->norm;
-                                itcontact->depth = -itcontact->depth;
-                            }
-                            grasp_params->contacts.emplace_back(*itcontact, (*itlink)->GetIndex());
-                        }
-                    }
-                }
 
                 if ( worker_params->bCheckGraspIK ) {
                     CollisionOptionsStateSaver optionstate(pcloneenv->GetCollisionChecker(),coloptions,false); // remove contacts
-                    Transform Tgoalgrasp = probot->GetActiveManipulator()->GetEndEffectorTransform();
                     RobotBase::RobotStateSaver linksaver(probot);
+                    ptraj->GetWaypoint(-1,vtrajpoint);
+                    Transform t = probot->GetTransform();
+                    ptraj->GetConfigurationSpecification().ExtractTransform(t,vtrajpoint.begin(),probot);
+                    probot->SetTransform(t);
+                    Transform Tgoalgrasp = probot->GetActiveManipulator()->GetEndEffectorTransform();
                     probot->SetTransform(trobotstart);
                     FOREACH(itlink,vlinks) {
                         (*itlink)->Enable(false);
@@ -1028,153 +1337,299 @@ public:
                     probot->SetActiveDOFs(probot->GetActiveManipulator()->GetArmIndices());
                     vector<dReal> solution;
                     if( !probot->GetActiveManipulator()->FindIKSolution(Tgoalgrasp, solution,IKFO_CheckEnvCollisions) ) {
-                        RAVELOG_DEBUG(str(boost::format("grasp %d: ik failed")%grasp_params->id));
-                        continue;     // ik failed
-                    }
-
-                    grasp_params->transfinal = trobotstart;
-                    size_t index = 0;
-                    FOREACHC(itarmindex,probot->GetActiveManipulator()->GetArmIndices()) {
-                        grasp_params->finalshape.at(*itarmindex) = solution.at(index++);
+                        RAVELOG_VERBOSE(str(boost::format("grasp %d: grasping noise ik failed")%grasp_params->id));
+                        break;
                     }
                 }
 
-                GRASPANALYSIS analysis;
-                if( worker_params->bComputeForceClosure ) {
-                    try {
-                        vector<CollisionReport::CONTACT> c(grasp_params->contacts.size());
-                        for(size_t i = 0; i < c.size(); ++i) {
-                            c[i] = grasp_params->contacts[i].first;
-                        }
-                        analysis = _AnalyzeContacts3D(c,worker_params->friction,8);
-                        if( analysis.mindist < worker_params->forceclosurethreshold ) {
-                            RAVELOG_DEBUG(str(boost::format("grasp %d: force closure failed")%grasp_params->id));
-                            continue;
-                        }
-                        grasp_params->mindist = analysis.mindist;
-                        grasp_params->volume = analysis.volume;
-                    }
-                    catch(const std::exception& ex) {
-                        RAVELOG_DEBUG(str(boost::format("grasp %d: force closure failed: %s")%grasp_params->id%ex.what()));
-                        continue;     // failed
+                ptraj->GetWaypoint(-1,vtrajpoint,probot->GetConfigurationSpecification());
+                probot->SetConfigurationValues(vtrajpoint.begin(),true);
+                vfinalvalues.push_back(vector<dReal>());
+                probot->GetDOFValues(vfinalvalues.back());
+                vfinaltransformations.push_back(probot->GetActiveManipulator()->GetTransform());
+            }
+
+            if( (int)vfinaltransformations.size() != worker_params->nGraspingNoiseRetries ) {
+                RAVELOG_DEBUG(str(boost::format("grasp %d: grasping noise failed")%grasp_params->id));
+                return false;
+            }
+
+            // take statistics
+            Vector translationmean;
+            FOREACHC(ittrans,vfinaltransformations) {
+                translationmean += ittrans->trans;
+            }
+            translationmean *= (1.0/vfinaltransformations.size());
+            Vector translationstd;
+            FOREACHC(ittrans,vfinaltransformations) {
+                Vector v = ittrans->trans - translationmean;
+                translationstd += v*v;
+            }
+            translationstd *= (1.0/vfinaltransformations.size());
+            dReal ftranslationdisplacement = (RaveSqrt(translationstd.x)+RaveSqrt(translationstd.y)+RaveSqrt(translationstd.z))/3;
+            vector<dReal> jointvaluesstd(vfinalvalues.at(0).size());
+            for(size_t i = 0; i < jointvaluesstd.size(); ++i) {
+                dReal jointmean = 0;
+                FOREACHC(it, vfinalvalues) {
+                    jointmean += it->at(i);
+                }
+                jointmean /= dReal(vfinalvalues.size());
+                dReal jointstd = 0;
+                FOREACHC(it, vfinalvalues) {
+                    jointstd += (it->at(i)-jointmean)*(it->at(i)-jointmean);
+                }
+                jointvaluesstd[i] = _vjointmaxlengths.at(i) * RaveSqrt(jointstd / dReal(vfinalvalues.size()));
+            }
+            dReal fmaxjointdisplacement = 0;
+            FOREACHC(itlink, _robot->GetLinks()) {
+                dReal f = 0;
+                for(size_t ijoint = 0; ijoint < _robot->GetJoints().size(); ++ijoint) {
+                    if( _robot->DoesAffect(ijoint, (*itlink)->GetIndex()) ) {
+                        f += jointvaluesstd.at(ijoint);
                     }
                 }
+                fmaxjointdisplacement = max(fmaxjointdisplacement,f);
+            }
 
-                if( worker_params->fgraspingnoise > 0 && worker_params->nGraspingNoiseRetries > 0 ) {
-                    params->fgraspingnoise = worker_params->fgraspingnoise;
-                    vector<Transform> vfinaltransformations; vfinaltransformations.reserve(worker_params->nGraspingNoiseRetries);
-                    vector< vector<dReal> > vfinalvalues; vfinalvalues.reserve(worker_params->nGraspingNoiseRetries);
-                    for(int igrasp = 0; igrasp < worker_params->nGraspingNoiseRetries; ++igrasp) {
-                        probot->SetActiveDOFs(worker_params->vactiveindices);
-                        probot->SetActiveDOFValues(grasp_params->preshape);
-                        probot->SetActiveDOFs(worker_params->vactiveindices,worker_params->affinedofs,worker_params->affineaxis);
-                        params->vinitialconfig.resize(0);
-                        ptraj->Init(probot->GetActiveConfigurationSpecification());
-                        if( !planner->InitPlan(probot, params) ) {
-                            RAVELOG_VERBOSE(str(boost::format("grasp %d: grasping noise planner failed")%grasp_params->id));
-                            break;
-                        }
-                        if( !planner->PlanPath(ptraj).GetStatusCode() ) {
-                            RAVELOG_VERBOSE(str(boost::format("grasp %d: grasping noise planner failed")%grasp_params->id));
-                            break;
-                        }
-                        BOOST_ASSERT(ptraj->GetNumWaypoints() > 0);
-
-                        if ( worker_params->bCheckGraspIK ) {
-                            CollisionOptionsStateSaver optionstate(pcloneenv->GetCollisionChecker(),coloptions,false); // remove contacts
-                            RobotBase::RobotStateSaver linksaver(probot);
-                            ptraj->GetWaypoint(-1,vtrajpoint);
-                            Transform t = probot->GetTransform();
-                            ptraj->GetConfigurationSpecification().ExtractTransform(t,vtrajpoint.begin(),probot);
-                            probot->SetTransform(t);
-                            Transform Tgoalgrasp = probot->GetActiveManipulator()->GetEndEffectorTransform();
-                            probot->SetTransform(trobotstart);
-                            FOREACH(itlink,vlinks) {
-                                (*itlink)->Enable(false);
-                            }
-                            probot->SetActiveDOFs(worker_params->vactiveindices);
-                            probot->SetActiveDOFValues(grasp_params->preshape);
-                            probot->SetActiveDOFs(probot->GetActiveManipulator()->GetArmIndices());
-                            vector<dReal> solution;
-                            if( !probot->GetActiveManipulator()->FindIKSolution(Tgoalgrasp, solution,IKFO_CheckEnvCollisions) ) {
-                                RAVELOG_VERBOSE(str(boost::format("grasp %d: grasping noise ik failed")%grasp_params->id));
-                                break;
-                            }
-                        }
+            dReal graspthresh = 0.005*RaveSqrt(0.49+400*worker_params->fgraspingnoise)-0.0035;
+            if( graspthresh < worker_params->fgraspingnoise*0.1 ) {
+                graspthresh = worker_params->fgraspingnoise*0.1;
+            }
+            if( ftranslationdisplacement+fmaxjointdisplacement > graspthresh ) {
+                RAVELOG_DEBUG(str(boost::format("grasp %d: fragile grasp %f>%f\n")%grasp_params->id%(ftranslationdisplacement+fmaxjointdisplacement)%(0.7 * worker_params->fgraspingnoise)));
+                return false;
+            }
+        }
 
-                        ptraj->GetWaypoint(-1,vtrajpoint,probot->GetConfigurationSpecification());
-                        probot->SetConfigurationValues(vtrajpoint.begin(),true);
-                        vfinalvalues.push_back(vector<dReal>());
-                        probot->GetDOFValues(vfinalvalues.back());
-                        vfinaltransformations.push_back(probot->GetActiveManipulator()->GetTransform());
-                    }
+        RAVELOG_DEBUG(str(boost::format("grasp %d: success")%grasp_params->id));
+        return true;
+    }
 
-                    if( (int)vfinaltransformations.size() != worker_params->nGraspingNoiseRetries ) {
-                        RAVELOG_DEBUG(str(boost::format("grasp %d: grasping noise failed")%grasp_params->id));
-                        continue;
-                    }
+    /// \brief file layout of the GraspThreaded output file
+    ///
+    /// The header is followed by one record per evaluated grasp, in the order they finish.
+    /// Every record starts with its size so that a record cut by a crash can be detected and dropped when resuming.
+    /// record: uint32 size, uint64 id, uint8 success, and if successful: position(3), direction(3), roll, standoff, manipulatordirection(3), mindist, volume, preshape, final transform(7), final dof values, uint32 numcontacts, contacts(6 each)
+    struct GraspFileHeader
+    {
+        char magic[4]; ///< "ORGT"
+        uint32_t version;
+        uint32_t realsize; ///< sizeof(dReal)
+        uint32_t preshapedof;
+        uint32_t robotdof;
+        uint32_t reserved;
+        uint64_t numgrasps;
+        char inputhash[32]; ///< md5 of the grasp space, the target and the grasp parameters, see _ComputeGraspInputHash
+    };
 
-                    // take statistics
-                    Vector translationmean;
-                    FOREACHC(ittrans,vfinaltransformations) {
-                        translationmean += ittrans->trans;
-                    }
-                    translationmean *= (1.0/vfinaltransformations.size());
-                    Vector translationstd;
-                    FOREACHC(ittrans,vfinaltransformations) {
-                        Vector v = ittrans->trans - translationmean;
-                        translationstd += v*v;
-                    }
-                    translationstd *= (1.0/vfinaltransformations.size());
-                    dReal ftranslationdisplacement = (RaveSqrt(translationstd.x)+RaveSqrt(translationstd.y)+RaveSqrt(translationstd.z))/3;
-                    vector<dReal> jointvaluesstd(vfinalvalues.at(0).size());
-                    for(size_t i = 0; i < jointvaluesstd.size(); ++i) {
-                        dReal jointmean = 0;
-                        FOREACHC(it, vfinalvalues) {
-                            jointmean += it->at(i);
-                        }
-                        jointmean /= dReal(vfinalvalues.size());
-                        dReal jointstd = 0;
-                        FOREACHC(it, vfinalvalues) {
-                            jointstd += (it->at(i)-jointmean)*(it->at(i)-jointmean);
-                        }
-                        jointvaluesstd[i] = _vjointmaxlengths.at(i) * RaveSqrt(jointstd / dReal(vfinalvalues.size()));
-                    }
-                    dReal fmaxjointdisplacement = 0;
-                    FOREACHC(itlink, _robot->GetLinks()) {
-                        dReal f = 0;
-                        for(size_t ijoint = 0; ijoint < _robot->GetJoints().size(); ++ijoint) {
-                            if( _robot->DoesAffect(ijoint, (*itlink)->GetIndex()) ) {
-                                f += jointvaluesstd.at(ijoint);
-                            }
-                        }
-                        fmaxjointdisplacement = max(fmaxjointdisplacement,f);
-                    }
+    template <typename T>
+    static void _AppendValue(std::vector<uint8_t>& vdata, const T& value)
+    {
+        size_t offset = vdata.size();
+        vdata.resize(offset+sizeof(T));
+        memcpy(&vdata[offset], &value, sizeof(T));
+    }
 
-                    dReal graspthresh = 0.005*RaveSqrt(0.49+400*worker_params->fgraspingnoise)-0.0035;
-                    if( graspthresh < worker_params->fgraspingnoise*0.1 ) {
-                        graspthresh = worker_params->fgraspingnoise*0.1;
-                    }
-                    if( ftranslationdisplacement+fmaxjointdisplacement > graspthresh ) {
-                        RAVELOG_DEBUG(str(boost::format("grasp %d: fragile grasp %f>%f\n")%grasp_params->id%(ftranslationdisplacement+fmaxjointdisplacement)%(0.7 * worker_params->fgraspingnoise)));
-                        continue;
-                    }
+    static void _SerializeGraspRecord(std::vector<uint8_t>& vrecord, const GraspParametersThread& grasp, bool bSuccess)
+    {
+        vrecord.resize(0);
+        _AppendValue<uint32_t>(vrecord, 0); // size, filled at the end
+        _AppendValue<uint64_t>(vrecord, grasp.id);
+        _AppendValue<uint8_t>(vrecord, bSuccess);
+        if( bSuccess ) {
+            for(int i = 0; i < 3; ++i) {
+                _AppendValue<dReal>(vrecord, grasp.vtargetposition[i]);
+            }
+            for(int i = 0; i < 3; ++i) {
+                _AppendValue<dReal>(vrecord, grasp.vtargetdirection[i]);
+            }
+            _AppendValue<dReal>(vrecord, grasp.ftargetroll);
+            _AppendValue<dReal>(vrecord, grasp.fstandoff);
+            for(int i = 0; i < 3; ++i) {
+                _AppendValue<dReal>(vrecord, grasp.vmanipulatordirection[i]);
+            }
+            _AppendValue<dReal>(vrecord, grasp.mindist);
+            _AppendValue<dReal>(vrecord, grasp.volume);
+            FOREACHC(itvalue, grasp.preshape) {
+                _AppendValue<dReal>(vrecord, *itvalue);
+            }
+            for(int i = 0; i < 4; ++i) {
+                _AppendValue<dReal>(vrecord, grasp.transfinal.rot[i]);
+            }
+            for(int i = 0; i < 3; ++i) {
+                _AppendValue<dReal>(vrecord, grasp.transfinal.trans[i]);
+            }
+            FOREACHC(itvalue, grasp.finalshape) {
+                _AppendValue<dReal>(vrecord, *itvalue);
+            }
+            _AppendValue<uint32_t>(vrecord, grasp.contacts.size());
+            FOREACHC(itc, grasp.contacts) {
+                for(int i = 0; i < 3; ++i) {
+                    _AppendValue<dReal>(vrecord, itc->first.pos[i]);
                 }
+                for(int i = 0; i < 3; ++i) {
+                    _AppendValue<dReal>(vrecord, itc->first.norm[i]);
+                }
+            }
+        }
+        uint32_t recordsize = vrecord.size()-sizeof(uint32_t);
+        memcpy(&vrecord[0], &recordsize, sizeof(recordsize));
+    }
 
-                RAVELOG_DEBUG(str(boost::format("grasp %d: success")%grasp_params->id));
+    /// \brief hashes everything that decides which grasp an id refers to and what its result is: the grasp space, the manipulator, the target body and pose, and the planning and force closure parameters
+    std::string _ComputeGraspInputHash(const GraspWorkQueue& queue, const WorkerParameters& worker_params)
+    {
+        std::vector<uint8_t> vdata;
+        FOREACHC(itray, queue.approachrays) {
+            for(int i = 0; i < 3; ++i) {
+                _AppendValue<dReal>(vdata, itray->first[i]);
+            }
+            for(int i = 0; i < 3; ++i) {
+                _AppendValue<dReal>(vdata, itray->second[i]);
+            }
+        }
+        FOREACHC(itroll, queue.rolls) {
+            _AppendValue<dReal>(vdata, *itroll);
+        }
+        FOREACHC(itpreshape, queue.preshapes) {
+            FOREACHC(itvalue, *itpreshape) {
+                _AppendValue<dReal>(vdata, *itvalue);
+            }
+        }
+        FOREACHC(itstandoff, queue.standoffs) {
+            _AppendValue<dReal>(vdata, *itstandoff);
+        }
+        FOREACHC(itdirection, queue.manipulatordirections) {
+            for(int i = 0; i < 3; ++i) {
+                _AppendValue<dReal>(vdata, (*itdirection)[i]);
+            }
+        }
+        _AppendValue<dReal>(vdata, worker_params.friction);
+        _AppendValue<uint8_t>(vdata, worker_params.bComputeForceClosure);
+        _AppendValue<dReal>(vdata, worker_params.forceclosurethreshold);
+        _AppendValue<uint8_t>(vdata, worker_params.bFastForceClosure);
+        _AppendValue<dReal>(vdata, worker_params.ftranslationstepmult);
+        _AppendValue<dReal>(vdata, worker_params.ffinestep);
+        _AppendValue<uint8_t>(vdata, worker_params.bDistanceGuidedClosing);
+        _AppendValue<uint8_t>(vdata, worker_params.bonlycontacttarget);
+        _AppendValue<uint8_t>(vdata, worker_params.btightgrasp);
+        _AppendValue<dReal>(vdata, worker_params.fgraspingnoise);
+        _AppendValue<int32_t>(vdata, worker_params.nGraspingNoiseRetries);
+        _AppendValue<uint8_t>(vdata, worker_params.bCheckGraspIK);
+        std::string sinfo = _robot->GetActiveManipulator()->GetName();
+        sinfo += " ";
+        if( worker_params.collisionchecker.size() > 0 ) {
+            sinfo += worker_params.collisionchecker;
+        }
+        else if( !!GetEnv()->GetCollisionChecker() ) {
+            sinfo += GetEnv()->GetCollisionChecker()->GetXMLId();
+        }
+        FOREACHC(itlinkname, worker_params.vavoidlinkgeometry) {
+            sinfo += " ";
+            sinfo += *itlinkname;
+        }
+        KinBodyPtr ptarget = GetEnv()->GetKinBody(worker_params.targetname);
+        if( !!ptarget ) {
+            Transform ttarget = ptarget->GetTransform();
+            for(int i = 0; i < 4; ++i) {
+                _AppendValue<dReal>(vdata, ttarget.rot[i]);
+            }
+            for(int i = 0; i < 3; ++i) {
+                _AppendValue<dReal>(vdata, ttarget.trans[i]);
+            }
+            sinfo += " ";
+            sinfo += ptarget->GetName();
+            sinfo += " ";
+            sinfo += ptarget->GetKinematicsGeometryHash();
+        }
+        vdata.insert(vdata.end(), sinfo.begin(), sinfo.end());
+        return utils::GetMD5HashString(vdata);
+    }
 
-                boost::mutex::scoped_lock lock(_mutexGrasp);
-                _listGraspResults.push_back(grasp_params);
+    /// \brief opens the grasp output file for appending. If the file already has results for the same grasps, marks them as evaluated so they are skipped.
+    bool _OpenGraspOutputFile(GraspWorkQueue& queue, const WorkerParameters& worker_params, const std::string& filename)
+    {
+        GraspFileHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, "ORGT", 4);
+        header.version = 3;
+        header.realsize = sizeof(dReal);
+        header.preshapedof = queue.preshapes.size() > 0 ? queue.preshapes[0].size() : 0;
+        header.robotdof = _robot->GetDOF();
+        header.numgrasps = queue.numgrasps;
+        std::string inputhash = _ComputeGraspInputHash(queue, worker_params);
+        memcpy(header.inputhash, inputhash.c_str(), std::min(inputhash.size(), sizeof(header.inputhash)));
+
+        FILE* f = fopen(filename.c_str(), "r+b");
+        if( !f ) {
+            f = fopen(filename.c_str(), "wb");
+            if( !f ) {
+                RAVELOG_ERROR(str(boost::format("failed to create grasp output file %s")%filename));
+                return false;
+            }
+            if( fwrite(&header, sizeof(header), 1, f) != 1 || fflush(f) != 0 ) {
+                RAVELOG_ERROR(str(boost::format("failed to write grasp output file %s")%filename));
+                fclose(f);
+                return false;
+            }
+            queue.outputfile = f;
+            return true;
+        }
+
+        GraspFileHeader fileheader;
+        if( fread(&fileheader, sizeof(fileheader), 1, f) != 1 || memcmp(&fileheader, &header, sizeof(header)) != 0 ) {
+            RAVELOG_ERROR(str(boost::format("grasp output file %s was generated with different grasp parameters, cannot resume")%filename));
+            fclose(f);
+            return false;
+        }
+
+        // read the complete records
+        long validsize = sizeof(header);
+        size_t numresumed = 0;
+        std::vector<uint8_t> vrecord;
+        uint32_t recordsize = 0;
+        while( fread(&recordsize, sizeof(recordsize), 1, f) == 1 ) {
+            if( recordsize < sizeof(uint64_t)+sizeof(uint8_t) ) {
+                break;
+            }
+            vrecord.resize(recordsize);
+            if( fread(vrecord.data(), 1, recordsize, f) != recordsize ) {
+                break;
+            }
+            uint64_t id = 0;
+            memcpy(&id, &vrecord[0], sizeof(id));
+            if( id >= queue.numgrasps ) {
+                break;
+            }
+            if( !queue.vevaluated[id] ) {
+                queue.vevaluated[id] = 1;
+                if( vrecord[sizeof(uint64_t)] ) {
+                    ++queue.numresults;
+                }
             }
+            validsize += sizeof(recordsize) + recordsize;
+            ++numresumed;
+        }
+
+        // drop a record that was cut by a crash before appending
+        fflush(f);
+#ifdef _WIN32
+        bool bTruncated = _chsize_s(_fileno(f), validsize) == 0;
+#else
+        bool bTruncated = ftruncate(fileno(f), validsize) == 0;
+#endif
+        if( !bTruncated || fseek(f, validsize, SEEK_SET) != 0 ) {
+            RAVELOG_ERROR(str(boost::format("failed to resume grasp output file %s")%filename));
+            fclose(f);
+            return false;
         }
-        pcloneenv->Destroy();
+        RAVELOG_INFO(str(boost::format("resuming grasp output file %s with %d evaluated grasps, %d successful")%filename%numresumed%queue.numresults));
+        queue.outputfile = f;
+        return true;
     }
 
-    bool _bContinueWorker;
-    boost::mutex _mutexGrasp;
-    GraspParametersThreadPtr _graspParamsWork;
+    boost::mutex _mutexGrasp; ///< protects _listGraspResults and the output file of the grasp work queue
     list<GraspParametersThreadPtr> _listGraspResults;
-    boost::condition _condGraspHasWork, _condGraspReceivedWork;
 
 protected:
     void _ComputeJointMaxLengths(vector<dReal>& vjointlengths)
@@ -1558,6 +2013,16 @@ protected:
         }
     }
 
+    /// \brief analyzes the contacts with the wrench space evaluator, volume is not computed
+    GRASPANALYSIS _AnalyzeContactsWrenchSpace(const vector<CollisionReport::CONTACT>& contacts, const WrenchSpaceQualityEvaluator& evaluator, WrenchSpaceQualityEvaluator::Workspace& workspace)
+    {
+        WrenchSpaceQualityEvaluator::Quality quality;
+        evaluator.Evaluate(contacts, quality, workspace);
+        GRASPANALYSIS analysis;
+        analysis.mindist = quality.mindist;
+        return analysis;
+    }
+
     virtual GRASPANALYSIS _AnalyzeContacts3D(const vector<CollisionReport::CONTACT>& contacts, dReal mu, int Nconepoints)
     {
         if( mu == 0 ) {
@@ -1786,6 +2251,7 @@ protected:
     FILE *outfile;
     FILE *errfile;
     std::vector<dReal> _vjointmaxlengths;
+    boost::shared_ptr<WrenchSpaceQualityThreadPool> _pqualitythreadpool; ///< threads of GraspQualityBatch
 };
 
 ModuleBasePtr CreateGrasperModule(EnvironmentBasePtr penv, std::istream& sinput)
@@ -33,8 +33,10 @@ class GrasperPlanner :  public PlannerBase
     };
 
 public:
-    GrasperPlanner(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv), _report(new CollisionReport()) {
+    GrasperPlanner(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv), _report(new CollisionReport()), _distancereport(new CollisionReport()), _bDistanceGuided(false), _nCollisionChecks(0) {
         __description = ":Interface Authors: Rosen Diankov, Dmitry Berenson\n\nSimple planner that performs a follow and squeeze operation of a robotic hand.";
+        RegisterCommand("GetNumCollisionChecks",boost::bind(&GrasperPlanner::_GetNumCollisionChecksCommand,this,_1,_2),
+                        "returns the number of link collision checks done by the last PlanPath call");
     }
     bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr pparams)
     {
@@ -108,6 +110,17 @@ public:
         CollisionCheckerMngr checkermngr(GetEnv(),"");
         GetEnv()->GetCollisionChecker()->SetCollisionOptions(0);
 
+        _nCollisionChecks = 0;
+        _bDistanceGuided = false;
+        if( _parameters->bdistanceguidedclosing ) {
+            // only use distance guided steps if the checker can answer distance queries
+            _bDistanceGuided = GetEnv()->GetCollisionChecker()->SetCollisionOptions(CO_Distance);
+            GetEnv()->GetCollisionChecker()->SetCollisionOptions(0);
+            if( !_bDistanceGuided ) {
+                RAVELOG_DEBUG_FORMAT("env=%s, collision checker %s does not support distance queries, closing with fixed steps", GetEnv()->GetNameId()%GetEnv()->GetCollisionChecker()->GetXMLId());
+            }
+        }
+
         // do not disable any links of the robot here!
         KinBody::LinkPtr pbase;
         if( !!pmanip ) {
@@ -459,17 +472,76 @@ public:
                 continue;
             }
 
-            while(num_iters-- > 0) {
+            const dReal ffinestep = _parameters->ffinestep*fmult;
+            const dReal fchuckingmult = RaveFabs(vchuckingdir[iindex]);
+            bool bGuided = _bDistanceGuided; // take steps bounded by the distance to the environment while no contact is imminent
+            bool bFineApproach = false; // fine stepping because the distance bound said that a contact is within a fine step
+            bool bPassedApproach = false; // the fine approach did not reach a contact, so take one fixed coarse step before bounding again
+            int nguidedsteps = 0;
+            while(true) {
+                if( num_iters-- <= 0 ) {
+                    if( !bFineApproach ) {
+                        break;
+                    }
+                    // the distance bound is conservative and the contact was not reached within one coarse step, so go back to coarse steps
+                    bFineApproach = false;
+                    bPassedApproach = true;
+                    coarse_pass = true;
+                    step_size = _parameters->fcoarsestep*fmult;
+                    dReal fremaining = (vchuckingdir[iindex] > 0 ? vupperlim[iindex]-dofvals[iindex] : dofvals[iindex]-vlowerlim[iindex])/fchuckingmult;
+                    num_iters = (int)(fremaining/step_size+0.5)+2;
+                    continue;
+                }
                 // set manip joints that haven't been covered so far
                 if( (vchuckingdir[iindex] > 0 && dofvals[iindex] > vupperlim[iindex]+step_size ) || ( vchuckingdir[iindex] < 0 && dofvals[iindex] < vlowerlim[iindex]-step_size ) ) {
                     break;
                 }
 
-                dofvals[iindex] += vchuckingdir[iindex] * step_size;
+                dReal fstep = step_size;
+                bool bGuidedStep = false;
+                if( bPassedApproach ) {
+                    bPassedApproach = false;
+                }
+                else if( bGuided && coarse_pass ) {
+                    dReal fremaining = (vchuckingdir[iindex] > 0 ? vupperlim[iindex]-dofvals[iindex] : dofvals[iindex]-vlowerlim[iindex])/fchuckingmult;
+                    dReal fbound = -1;
+                    if( fremaining > ffinestep && nguidedsteps < 64 ) {
+                        fbound = _ComputeDistanceGuidedJointStep(KinBody::JointConstPtr(pjoint), nDOFIndex, KinBodyPtr());
+                    }
+                    if( fbound < 0 ) {
+                        // cannot bound the motion of the links (or the limit is reached), so keep the fixed steps for the rest of the range
+                        bGuided = false;
+                        num_iters = (int)(max(fremaining,dReal(0))/step_size+0.5)+1;
+                    }
+                    else if( fbound/fchuckingmult < ffinestep ) {
+                        // a contact is imminent, so only the final approach is done with fine steps, at most one coarse step worth of them
+                        coarse_pass = false;
+                        bFineApproach = true;
+                        num_iters = (int)(step_size/ffinestep);
+                        step_size = ffinestep;
+                        fstep = step_size;
+                    }
+                    else {
+                        fstep = min(fbound/fchuckingmult, fremaining);
+                        bGuidedStep = true;
+                        ++nguidedsteps;
+                        ++num_iters; // guided steps do not use up the fixed steps
+                    }
+                }
+
+                dofvals[iindex] += vchuckingdir[iindex] * fstep;
                 _robot->SetActiveDOFValues(dofvals,KinBody::CLA_CheckLimitsSilent);
                 _robot->GetActiveDOFValues(dofvals);
                 ct = _CheckCollision(KinBody::JointConstPtr(pjoint),KinBodyPtr());
                 if( ct&CT_CollisionMask ) {
+                    if( bGuidedStep ) {
+                        // self-collisions are not covered by the distance, so back up and let the fixed steps resolve the contact
+                        bGuided = false;
+                        dofvals[iindex] -= vchuckingdir[iindex] * fstep;
+                        dReal fremaining = (vchuckingdir[iindex] > 0 ? vupperlim[iindex]-dofvals[iindex] : dofvals[iindex]-vlowerlim[iindex])/fchuckingmult;
+                        num_iters = (int)(fremaining/step_size+0.5)+2;
+                        continue;
+                    }
                     if(coarse_pass) {
                         //coarse step collided, back up and shrink step
                         coarse_pass = false;
@@ -556,6 +628,7 @@ public:
     virtual int _CheckCollision(KinBody::LinkConstPtr plink, KinBodyPtr targetbody)
     {
         int ct = (plink->GetIndex()<<CT_LinkMaskShift);
+        ++_nCollisionChecks;
         bool bcollision;
         if( !!targetbody ) {
             bcollision = GetEnv()->CheckCollision(plink, KinBodyConstPtr(targetbody),_report);
@@ -593,6 +666,74 @@ public:
         return ct;
     }
 
+    /// \brief returns the distance of the link to the target body (or the environment if empty), 0 if in collision
+    virtual dReal _ComputeLinkDistance(KinBody::LinkConstPtr plink, KinBodyPtr targetbody)
+    {
+        CollisionOptionsStateSaver optionsaver(GetEnv()->GetCollisionChecker(), CO_Distance, false);
+        bool bcollision;
+        if( !!targetbody ) {
+            bcollision = GetEnv()->CheckCollision(plink, KinBodyConstPtr(targetbody), _distancereport);
+        }
+        else {
+            bcollision = GetEnv()->CheckCollision(plink, _distancereport);
+        }
+        if( bcollision || _distancereport->minDistance < 0 ) {
+            return 0;
+        }
+        return _distancereport->minDistance;
+    }
+
+    /// \brief computes how far the dof can move without any of the moved links touching the environment.
+    ///
+    /// Rotating about the joint axis keeps the distance of every point to the axis, so the farthest corner of the link AABB bounds the speed of the link points per radian.
+    /// \return the bound on the dof step, 0 if a link is in contact, or -1 if the step cannot be bounded
+    virtual dReal _ComputeDistanceGuidedJointStep(KinBody::JointConstPtr pjoint, int nDOFIndex, KinBodyPtr targetbody)
+    {
+        int iaxis = nDOFIndex-pjoint->GetDOFIndex();
+        bool bRevolute = pjoint->IsRevolute(iaxis);
+        if( !bRevolute && !pjoint->IsPrismatic(iaxis) ) {
+            return -1;
+        }
+        Vector vanchor = pjoint->GetAnchor(), vaxis = pjoint->GetAxis(iaxis);
+        dReal fstep = -1;
+        FOREACHC(itlink, _vlinks) {
+            int linkindex = (*itlink)->GetIndex();
+            if( !_robot->DoesDOFAffectLink(nDOFIndex, linkindex) ) {
+                continue;
+            }
+            if( !_robot->DoesAffect(pjoint->GetJointIndex(), linkindex) ) {
+                // moved through a mimic joint, so the motion is not a rigid rotation about the axis
+                return -1;
+            }
+            dReal fspeed = 1;
+            if( bRevolute ) {
+                AABB ab = (*itlink)->ComputeAABB();
+                fspeed = 0;
+                for(int icorner = 0; icorner < 8; ++icorner) {
+                    Vector v = ab.pos - vanchor;
+                    v.x += (icorner&1) ? ab.extents.x : -ab.extents.x;
+                    v.y += (icorner&2) ? ab.extents.y : -ab.extents.y;
+                    v.z += (icorner&4) ? ab.extents.z : -ab.extents.z;
+                    v -= vaxis*vaxis.dot3(v);
+                    fspeed = max(fspeed, RaveSqrt(v.lengthsqr3()));
+                }
+                if( fspeed <= g_fEpsilon ) {
+                    continue;
+                }
+            }
+            dReal fdist = _ComputeLinkDistance(KinBody::LinkConstPtr(*itlink), targetbody);
+            if( fdist <= 0 ) {
+                return 0;
+            }
+            // leave some margin since distance queries of some checkers are approximate
+            dReal flinkstep = 0.9*fdist/fspeed;
+            if( fstep < 0 || flinkstep < fstep ) {
+                fstep = flinkstep;
+            }
+        }
+        return fstep;
+    }
+
     virtual RobotBasePtr GetRobot() {
         return _robot;
     }
@@ -601,6 +742,12 @@ public:
     }
 
 protected:
+    bool _GetNumCollisionChecksCommand(std::ostream& sout, std::istream& sinput)
+    {
+        sout << _nCollisionChecks;
+        return !!sout;
+    }
+
     virtual int _MoveStraight(TrajectoryBasePtr ptraj, const Vector& vapproachdir, vector<dReal>& dofvals, int checkcollisions)
     {
         dReal* pX = NULL, *pY = NULL, *pZ = NULL;
@@ -620,7 +767,9 @@ protected:
         }
 
         bool bMoved = false;
-        Vector v = vapproachdir * (_parameters->fcoarsestep*_parameters->ftranslationstepmult);
+        const dReal fcoarsetranslation = _parameters->fcoarsestep*_parameters->ftranslationstepmult;
+        Vector v = vapproachdir * fcoarsetranslation;
+        Vector vstep = v; // last step, can be bigger than v when distance guided
         int ct = 0;
         while(1) {
             ct = 0;
@@ -638,14 +787,28 @@ protected:
                 ptraj->Insert(ptraj->GetNumWaypoints(),dofvals, _robot->GetActiveConfigurationSpecification());
             }
 
+            vstep = v;
+            if( _bDistanceGuided ) {
+                // the hand translates rigidly, so it can move by the distance to the closest obstacle
+                dReal fmindist = -1;
+                for(int q = 0; q < (int)_vlinks.size(); q++) {
+                    dReal fdist = _ComputeLinkDistance(KinBody::LinkConstPtr(_vlinks[q]), targetbody);
+                    if( fmindist < 0 || fdist < fmindist ) {
+                        fmindist = fdist;
+                    }
+                }
+                if( 0.9*fmindist > fcoarsetranslation ) {
+                    vstep = vapproachdir * (0.9*fmindist);
+                }
+            }
             if( pX != NULL ) {
-                *pX += v.x;
+                *pX += vstep.x;
             }
             if( pY != NULL ) {
-                *pY += v.y;
+                *pY += vstep.y;
             }
             if( pZ != NULL ) {
-                *pZ += v.z;
+                *pZ += vstep.z;
             }
             _robot->SetActiveDOFValues(dofvals,KinBody::CLA_CheckLimitsSilent);
             bMoved = true;
@@ -663,13 +826,13 @@ protected:
 
         // move back and try again with a finer step
         if( pX != NULL ) {
-            *pX -= v.x;
+            *pX -= vstep.x;
         }
         if( pY != NULL ) {
-            *pY -= v.y;
+            *pY -= vstep.y;
         }
         if( pZ != NULL ) {
-            *pZ -= v.z;
+            *pZ -= vstep.z;
         }
         // know the robot is not in collision at this point
         v = vapproachdir * (_parameters->ffinestep*_parameters->ftranslationstepmult);
@@ -704,12 +867,15 @@ protected:
         return ct;
     }
     CollisionReportPtr _report;
+    CollisionReportPtr _distancereport; ///< used for the distance queries so that _report keeps the last contact
     boost::shared_ptr<GraspParameters> _parameters;
     RobotBasePtr _robot;
     vector<KinBody::LinkPtr> _vAvoidLinkGeometry;
     std::vector<KinBody::LinkPtr> _vlinks;
     Vector _vTargetCenter;
     dReal _fTargetRadius;
+    bool _bDistanceGuided; ///< true if bdistanceguidedclosing is set and the collision checker supports distance queries
+    int _nCollisionChecks; ///< number of link collision checks done by the last PlanPath call
 };
 
 PlannerBasePtr CreateGrasperPlanner(EnvironmentBasePtr penv, std::istream& sinput)
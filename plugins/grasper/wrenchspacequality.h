@@ -0,0 +1,627 @@
+// -*- coding: utf-8 --*
+// Copyright (C) 2026 OpenRAVE contributors
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef OPENRAVE_WRENCHSPACEQUALITY_H
+#define OPENRAVE_WRENCHSPACEQUALITY_H
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <atomic>
+#include <exception>
+#include <random>
+
+/// \brief persistent threads that run the same function in parallel, so that batches do not create threads every call
+class WrenchSpaceQualityThreadPool
+{
+public:
+    WrenchSpaceQualityThreadPool() : _nJobId(0), _numpending(0), _numrunning(0), _bShutdown(false) {
+    }
+    virtual ~WrenchSpaceQualityThreadPool() {
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _bShutdown = true;
+            _conditionJob.notify_all();
+        }
+        _threads.join_all();
+    }
+
+    /// \brief runs fn on nThreads threads including the calling thread and returns when all of them finished
+    ///
+    /// If any of the calls throws, the first exception is rethrown after all of them finished.
+    void Run(int nThreads, const boost::function<void()>& fn)
+    {
+        boost::mutex::scoped_lock runlock(_mutexRun);
+        boost::mutex::scoped_lock lock(_mutex);
+        while( (int)_threads.size() < nThreads-1 ) {
+            _threads.create_thread(boost::bind(&WrenchSpaceQualityThreadPool::_WorkerThread, this));
+        }
+        _fn = fn;
+        _exception = std::exception_ptr();
+        _numpending = _numrunning = std::max(0, nThreads-1);
+        ++_nJobId;
+        _conditionJob.notify_all();
+        lock.unlock();
+        std::exception_ptr exception;
+        try {
+            fn();
+        }
+        catch(...) {
+            exception = std::current_exception();
+        }
+        lock.lock();
+        while( _numrunning > 0 ) {
+            _conditionDone.wait(lock);
+        }
+        _fn.clear();
+        if( !exception ) {
+            exception = _exception;
+        }
+        lock.unlock();
+        if( !!exception ) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+protected:
+    void _WorkerThread()
+    {
+        int lastjobid = 0;
+        boost::mutex::scoped_lock lock(_mutex);
+        while( true ) {
+            while( !_bShutdown && (_nJobId == lastjobid || _numpending == 0) ) {
+                _conditionJob.wait(lock);
+            }
+            if( _bShutdown ) {
+                return;
+            }
+            lastjobid = _nJobId;
+            --_numpending;
+            boost::function<void()> fn = _fn;
+            lock.unlock();
+            std::exception_ptr exception;
+            try {
+                fn();
+            }
+            catch(...) {
+                exception = std::current_exception();
+            }
+            lock.lock();
+            if( !!exception && !_exception ) {
+                _exception = exception;
+            }
+            if( --_numrunning == 0 ) {
+                _conditionDone.notify_all();
+            }
+        }
+    }
+
+    boost::thread_group _threads;
+    boost::mutex _mutexRun; ///< only one Run at a time
+    boost::mutex _mutex; ///< protects the members below
+    boost::condition_variable _conditionJob, _conditionDone;
+    boost::function<void()> _fn;
+    std::exception_ptr _exception; ///< first exception thrown by a worker of the current job
+    int _nJobId; ///< incremented for every Run, each thread runs a job at most once
+    int _numpending; ///< number of threads that still have to start the current job
+    int _numrunning; ///< number of threads that did not finish the current job
+    bool _bShutdown;
+};
+
+/** \brief Force-closure test and epsilon grasp quality in wrench space without building a convex hull.
+
+    Every contact is expanded to the edges of a discretized friction cone. The contact frame is computed once per contact, and
+    since the cone edges are linear combinations of the frame axes, the edge torques are combined from three cross products.
+
+    Force closure is tested exactly by computing the point of the wrench hull closest to the origin with Wolfe's minimum norm point algorithm,
+    and checking that the wrenches span the 6D wrench space.
+    The epsilon quality (radius of the largest ball around the origin inside the hull) is the minimum of the support function of the hull over
+    all directions. It is estimated from a fixed set of directions on the 6D unit sphere followed by a local descent from the best ones,
+    so the returned value is an upper bound that is usually within a few percent of the convex hull result. A grasp whose estimate is
+    below a quality threshold is guaranteed to be below it, but grasps accepted by a threshold have to be certified with the convex hull.
+
+    The evaluator is immutable after construction and can be shared by threads as long as each thread uses its own \ref Workspace.
+ */
+class WrenchSpaceQualityEvaluator
+{
+public:
+    /// \brief quality of one grasp
+    struct Quality
+    {
+        Quality() : mindist(0), bForceClosure(false) {
+        }
+        dReal mindist; ///< epsilon quality, 0 if not in force closure
+        bool bForceClosure;
+    };
+
+    /// \brief buffers used while evaluating one grasp, one per thread
+    struct Workspace
+    {
+        std::vector<double> vwrenches; ///< 6 values per wrench
+        std::vector<int> vcorral;
+        std::vector<double> vlambda, valpha;
+        std::vector<double> vactive; ///< wrenches projected on the tangent space of the current direction
+    };
+
+    /// \param mu friction coefficient, if 0 only the contact normals are used
+    /// \param nConePoints number of edges of the discretized friction cones
+    WrenchSpaceQualityEvaluator(dReal mu, int nConePoints) : _mu(mu)
+    {
+        if( _mu > 0 ) {
+            dReal fdeltaang = 2*PI/(dReal)nConePoints;
+            dReal fnormalize = 1/RaveSqrt(1+_mu*_mu);
+            _vconesincos.resize(nConePoints);
+            for(int i = 0; i < nConePoints; ++i) {
+                // cone edge is (n + mu*sin*right + mu*cos*up)*fnormalize and its torque is the same combination of the axis torques
+                _vconesincos[i].first = _mu*RaveSin(i*fdeltaang)*fnormalize;
+                _vconesincos[i].second = _mu*RaveCos(i*fdeltaang)*fnormalize;
+            }
+            _fnormalscale = fnormalize;
+        }
+        else {
+            _fnormalscale = 1;
+        }
+    }
+
+    /// \brief evaluates the force closure and the epsilon quality of the contacts
+    void Evaluate(const std::vector<CollisionReport::CONTACT>& contacts, Quality& quality, Workspace& workspace) const
+    {
+        quality = Quality();
+        _ComputeWrenches(contacts, workspace.vwrenches);
+        const int numwrenches = workspace.vwrenches.size()/6;
+        if( numwrenches < 7 ) {
+            // need at least 7 wrenches to have force closure in 3D
+            return;
+        }
+        if( !_SpansWrenchSpace(workspace.vwrenches) ) {
+            return;
+        }
+        double fmaxnorm2 = 0;
+        for(int i = 0; i < numwrenches; ++i) {
+            fmaxnorm2 = std::max(fmaxnorm2, _Dot(&workspace.vwrenches[6*i], &workspace.vwrenches[6*i]));
+        }
+        double x[6];
+        double fminnorm2 = _ComputeMinNormPoint(workspace.vwrenches, workspace, x);
+        if( fminnorm2 > 1e-12*fmaxnorm2 ) {
+            // origin is outside of the hull
+            return;
+        }
+        double fepsilon = _ComputeEpsilon(workspace);
+        if( fepsilon <= 1e-15 ) {
+            return;
+        }
+        quality.mindist = fepsilon;
+        quality.bForceClosure = true;
+    }
+
+    /// \brief evaluates many grasps in parallel
+    ///
+    /// \param pool runs the evaluation, the calling thread is one of the threads
+    /// \param nThreads number of threads, 0 uses all hardware threads
+    void EvaluateBatch(const std::vector< std::vector<CollisionReport::CONTACT> >& vgrasps, std::vector<Quality>& vqualities, WrenchSpaceQualityThreadPool& pool, int nThreads=0) const
+    {
+        vqualities.resize(vgrasps.size());
+        if( nThreads <= 0 ) {
+            nThreads = std::max(1, (int)boost::thread::hardware_concurrency());
+        }
+        nThreads = std::min(nThreads, (int)vgrasps.size());
+        std::atomic<size_t> nextgrasp(0);
+        if( nThreads <= 1 ) {
+            _EvaluateBatchWorker(vgrasps, vqualities, nextgrasp);
+            return;
+        }
+        pool.Run(nThreads, boost::bind(&WrenchSpaceQualityEvaluator::_EvaluateBatchWorker, this, boost::cref(vgrasps), boost::ref(vqualities), boost::ref(nextgrasp)));
+    }
+
+protected:
+    void _EvaluateBatchWorker(const std::vector< std::vector<CollisionReport::CONTACT> >& vgrasps, std::vector<Quality>& vqualities, std::atomic<size_t>& nextgrasp) const
+    {
+        Workspace workspace;
+        for(size_t igrasp = nextgrasp++; igrasp < vgrasps.size(); igrasp = nextgrasp++) {
+            Evaluate(vgrasps[igrasp], vqualities[igrasp], workspace);
+        }
+    }
+
+    /// \brief expands the contacts into the wrenches of the friction cone edges
+    void _ComputeWrenches(const std::vector<CollisionReport::CONTACT>& contacts, std::vector<double>& vwrenches) const
+    {
+        const size_t numedges = _vconesincos.size() > 0 ? _vconesincos.size() : 1;
+        vwrenches.resize(6*numedges*contacts.size());
+        std::vector<double>::iterator itwrench = vwrenches.begin();
+        FOREACHC(itcontact, contacts) {
+            Vector n = itcontact->norm*_fnormalscale, tn = itcontact->pos.cross(n);
+            if( _vconesincos.size() == 0 ) {
+                *itwrench++ = n.x; *itwrench++ = n.y; *itwrench++ = n.z;
+                *itwrench++ = tn.x; *itwrench++ = tn.y; *itwrench++ = tn.z;
+                continue;
+            }
+            // find a coordinate system where z is the normal
+            TransformMatrix torient = matrixFromQuat(quatRotateDirection(Vector(0,0,1),itcontact->norm));
+            Vector right(torient.m[0],torient.m[4],torient.m[8]);
+            Vector up(torient.m[1],torient.m[5],torient.m[9]);
+            Vector tright = itcontact->pos.cross(right), tup = itcontact->pos.cross(up);
+            FOREACHC(it, _vconesincos) {
+                Vector f = n + right*it->first + up*it->second;
+                Vector t = tn + tright*it->first + tup*it->second;
+                *itwrench++ = f.x; *itwrench++ = f.y; *itwrench++ = f.z;
+                *itwrench++ = t.x; *itwrench++ = t.y; *itwrench++ = t.z;
+            }
+        }
+    }
+
+    static inline double _Dot(const double* a, const double* b)
+    {
+        return a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3] + a[4]*b[4] + a[5]*b[5];
+    }
+
+    /// \brief returns true if the wrenches span the 6D space, checked with a Cholesky decomposition of their 6x6 scatter matrix
+    static bool _SpansWrenchSpace(const std::vector<double>& vwrenches)
+    {
+        double A[6][6] = {{0}};
+        for(size_t i = 0; i < vwrenches.size(); i += 6) {
+            const double* w = &vwrenches[i];
+            for(int j = 0; j < 6; ++j) {
+                for(int k = 0; k <= j; ++k) {
+                    A[j][k] += w[j]*w[k];
+                }
+            }
+        }
+        double fscale = 0;
+        for(int j = 0; j < 6; ++j) {
+            fscale = std::max(fscale, A[j][j]);
+        }
+        if( fscale <= 0 ) {
+            return false;
+        }
+        for(int j = 0; j < 6; ++j) {
+            double d = A[j][j];
+            for(int k = 0; k < j; ++k) {
+                d -= A[j][k]*A[j][k];
+            }
+            if( d <= 1e-12*fscale ) {
+                return false;
+            }
+            A[j][j] = std::sqrt(d);
+            for(int i = j+1; i < 6; ++i) {
+                double s = A[i][j];
+                for(int k = 0; k < j; ++k) {
+                    s -= A[i][k]*A[j][k];
+                }
+                A[i][j] = s/A[j][j];
+            }
+        }
+        return true;
+    }
+
+    /// \brief solves for the affine combination of the corral wrenches with minimum norm
+    ///
+    /// \return false if the corral is affinely dependent
+    static bool _SolveAffineMinimizer(const std::vector<double>& vwrenches, const std::vector<int>& vcorral, std::vector<double>& valpha)
+    {
+        // [G 1; 1^T 0] [alpha; mu] = [0; 1] where G is the gram matrix of the corral
+        const int m = vcorral.size();
+        const int n = m+1;
+        double M[8][9];
+        for(int i = 0; i < m; ++i) {
+            for(int j = 0; j <= i; ++j) {
+                M[i][j] = M[j][i] = _Dot(&vwrenches[6*vcorral[i]], &vwrenches[6*vcorral[j]]);
+            }
+            M[i][m] = 1;
+            M[m][i] = 1;
+            M[i][n] = 0;
+        }
+        M[m][m] = 0;
+        M[m][n] = 1;
+
+        double fscale = 0;
+        for(int i = 0; i < m; ++i) {
+            fscale = std::max(fscale, M[i][i]);
+        }
+        fscale = std::max(fscale, 1.0);
+        for(int col = 0; col < n; ++col) {
+            int pivot = col;
+            for(int row = col+1; row < n; ++row) {
+                if( std::fabs(M[row][col]) > std::fabs(M[pivot][col]) ) {
+                    pivot = row;
+                }
+            }
+            if( std::fabs(M[pivot][col]) <= 1e-14*fscale ) {
+                return false;
+            }
+            if( pivot != col ) {
+                for(int k = col; k <= n; ++k) {
+                    std::swap(M[pivot][k], M[col][k]);
+                }
+            }
+            for(int row = col+1; row < n; ++row) {
+                double f = M[row][col]/M[col][col];
+                for(int k = col; k <= n; ++k) {
+                    M[row][k] -= f*M[col][k];
+                }
+            }
+        }
+        double solution[8];
+        for(int row = n-1; row >= 0; --row) {
+            double s = M[row][n];
+            for(int k = row+1; k < n; ++k) {
+                s -= M[row][k]*solution[k];
+            }
+            solution[row] = s/M[row][row];
+        }
+        valpha.assign(solution, solution+m);
+        return true;
+    }
+
+    /// \brief computes the point of the convex hull of the 6D points closest to the origin with Wolfe's algorithm
+    ///
+    /// \param[out] x the closest point
+    /// \return the squared norm of x
+    static double _ComputeMinNormPoint(const std::vector<double>& vwrenches, Workspace& workspace, double* x)
+    {
+        const int numwrenches = vwrenches.size()/6;
+        std::vector<int>& vcorral = workspace.vcorral;
+        std::vector<double>& vlambda = workspace.vlambda;
+        std::vector<double>& valpha = workspace.valpha;
+
+        // start with the wrench of minimum norm
+        int istart = 0;
+        double fstartnorm2 = _Dot(&vwrenches[0], &vwrenches[0]);
+        for(int i = 1; i < numwrenches; ++i) {
+            double f = _Dot(&vwrenches[6*i], &vwrenches[6*i]);
+            if( f < fstartnorm2 ) {
+                fstartnorm2 = f;
+                istart = i;
+            }
+        }
+        vcorral.resize(1);
+        vcorral[0] = istart;
+        vlambda.resize(1);
+        vlambda[0] = 1;
+        std::copy(&vwrenches[6*istart], &vwrenches[6*istart]+6, x);
+
+        const double ftol = 1e-12;
+        for(int iter = 0; iter < 4*numwrenches; ++iter) {
+            double xx = _Dot(x, x);
+            if( xx <= ftol*ftol ) {
+                return 0;
+            }
+            // wrench furthest along -x
+            int jmin = -1;
+            double fmin = xx;
+            for(int j = 0; j < numwrenches; ++j) {
+                double f = _Dot(x, &vwrenches[6*j]);
+                if( f < fmin ) {
+                    fmin = f;
+                    jmin = j;
+                }
+            }
+            if( jmin < 0 || xx - fmin <= ftol*std::max(xx, 1.0) || vcorral.size() >= 7 || std::find(vcorral.begin(), vcorral.end(), jmin) != vcorral.end() ) {
+                // x is the minimum norm point (up to the tolerance)
+                return xx;
+            }
+            vcorral.push_back(jmin);
+            vlambda.push_back(0);
+
+            while(true) {
+                if( !_SolveAffineMinimizer(vwrenches, vcorral, valpha) ) {
+                    return xx;
+                }
+                bool bAllPositive = true;
+                for(size_t i = 0; i < valpha.size(); ++i) {
+                    if( valpha[i] <= ftol ) {
+                        bAllPositive = false;
+                        break;
+                    }
+                }
+                if( bAllPositive ) {
+                    vlambda = valpha;
+                    break;
+                }
+                // move towards the affine minimizer until a weight becomes zero
+                double theta = 1;
+                for(size_t i = 0; i < valpha.size(); ++i) {
+                    if( valpha[i] <= ftol && vlambda[i] - valpha[i] > 0 ) {
+                        theta = std::min(theta, vlambda[i]/(vlambda[i]-valpha[i]));
+                    }
+                }
+                size_t inew = 0;
+                for(size_t i = 0; i < vlambda.size(); ++i) {
+                    double f = (1-theta)*vlambda[i] + theta*valpha[i];
+                    if( f > ftol ) {
+                        vcorral[inew] = vcorral[i];
+                        vlambda[inew] = f;
+                        ++inew;
+                    }
+                }
+                vcorral.resize(inew);
+                vlambda.resize(inew);
+                if( inew == 0 ) {
+                    return xx;
+                }
+            }
+
+            for(int k = 0; k < 6; ++k) {
+                x[k] = 0;
+            }
+            for(size_t i = 0; i < vcorral.size(); ++i) {
+                const double* w = &vwrenches[6*vcorral[i]];
+                for(int k = 0; k < 6; ++k) {
+                    x[k] += vlambda[i]*w[k];
+                }
+            }
+        }
+        return _Dot(x, x);
+    }
+
+    /// \brief returns the support function of the wrenches along the unit direction d and the index of the supporting wrench
+    static inline double _Support(const std::vector<double>& vwrenches, const double* d, int& isupport)
+    {
+        double fmax = -1e30;
+        isupport = 0;
+        for(size_t i = 0; i < vwrenches.size(); i += 6) {
+            double f = _Dot(d, &vwrenches[i]);
+            if( f > fmax ) {
+                fmax = f;
+                isupport = i/6;
+            }
+        }
+        return fmax;
+    }
+
+    /// \brief estimates the epsilon quality as the minimum of the support function over the unit directions
+    ///
+    /// The best sampled directions are refined by steepest descent on the sphere. The descent direction is the minimum norm element of
+    /// the tangential components of the nearly supporting wrenches, so the refinement converges to the normal of a facet of the hull.
+    static double _ComputeEpsilon(Workspace& workspace)
+    {
+        const std::vector<double>& vwrenches = workspace.vwrenches;
+        const std::vector<double>& vdirections = _GetDirections();
+        const int numstarts = 3;
+        std::pair<double, int> vstarts[numstarts];
+        for(int i = 0; i < numstarts; ++i) {
+            vstarts[i] = std::make_pair(1e30, -1);
+        }
+        int isupport = 0;
+        for(size_t i = 0; i < vdirections.size(); i += 6) {
+            double f = _Support(vwrenches, &vdirections[i], isupport);
+            if( f < vstarts[numstarts-1].first ) {
+                // keep the starts sorted
+                int j = numstarts-1;
+                for(; j > 0 && vstarts[j-1].first > f; --j) {
+                    vstarts[j] = vstarts[j-1];
+                }
+                vstarts[j] = std::make_pair(f, (int)i);
+            }
+        }
+
+        double fbest = vstarts[0].first;
+        for(int istart = 0; istart < numstarts && vstarts[istart].second >= 0; ++istart) {
+            double d[6];
+            std::copy(&vdirections[vstarts[istart].second], &vdirections[vstarts[istart].second]+6, d);
+            fbest = std::min(fbest, _RefineDirection(workspace, d, vstarts[istart].first));
+        }
+        return fbest;
+    }
+
+    /// \brief locally minimizes the support function of the wrenches starting at the unit direction d with value fvalue
+    static double _RefineDirection(Workspace& workspace, double* d, double fvalue)
+    {
+        const std::vector<double>& vwrenches = workspace.vwrenches;
+        std::vector<double>& vactive = workspace.vactive;
+        double factivetol = 0.1*fvalue, fstep = 0.2;
+        int isupport = 0;
+        for(int iter = 0; iter < 60 && factivetol > 1e-9*fvalue; ++iter) {
+            vactive.resize(0);
+            for(size_t i = 0; i < vwrenches.size(); i += 6) {
+                const double* w = &vwrenches[i];
+                double fdw = _Dot(d, w);
+                if( fdw >= fvalue - factivetol ) {
+                    for(int k = 0; k < 6; ++k) {
+                        vactive.push_back(w[k] - fdw*d[k]);
+                    }
+                }
+            }
+            double g[6];
+            double fgnorm2 = _ComputeMinNormPoint(vactive, workspace, g);
+            if( fgnorm2 <= 1e-20*fvalue*fvalue ) {
+                // stationary for the current active set, so shrink it
+                factivetol *= 0.25;
+                continue;
+            }
+            double fgscale = 1/std::sqrt(fgnorm2);
+            bool bImproved = false;
+            for(int isearch = 0; isearch < 8; ++isearch) {
+                double dnew[6], fnorm2 = 0;
+                for(int k = 0; k < 6; ++k) {
+                    dnew[k] = d[k] - fstep*fgscale*g[k];
+                    fnorm2 += dnew[k]*dnew[k];
+                }
+                double finvnorm = 1/std::sqrt(fnorm2);
+                for(int k = 0; k < 6; ++k) {
+                    dnew[k] *= finvnorm;
+                }
+                double f = _Support(vwrenches, dnew, isupport);
+                if( f < fvalue ) {
+                    fvalue = f;
+                    std::copy(dnew, dnew+6, d);
+                    bImproved = true;
+                    fstep *= 1.5;
+                    break;
+                }
+                fstep *= 0.25;
+            }
+            if( !bImproved ) {
+                factivetol *= 0.25;
+            }
+        }
+        return fvalue;
+    }
+
+    /// \brief fixed set of unit directions in 6D, the signed axes and their pairwise diagonals followed by deterministic random directions
+    static const std::vector<double>& _GetDirections()
+    {
+        static const std::vector<double> s_vdirections = _GenerateDirections(512);
+        return s_vdirections;
+    }
+
+    static std::vector<double> _GenerateDirections(int numdirections)
+    {
+        std::vector<double> vdirections;
+        vdirections.reserve(6*numdirections);
+        for(int i = 0; i < 6; ++i) {
+            for(int s = -1; s <= 1; s += 2) {
+                double d[6] = {0};
+                d[i] = s;
+                vdirections.insert(vdirections.end(), d, d+6);
+            }
+        }
+        const double fdiag = 1/std::sqrt(2.0);
+        for(int i = 0; i < 6; ++i) {
+            for(int j = i+1; j < 6; ++j) {
+                for(int s = 0; s < 4; ++s) {
+                    double d[6] = {0};
+                    d[i] = (s&1) ? -fdiag : fdiag;
+                    d[j] = (s&2) ? -fdiag : fdiag;
+                    vdirections.insert(vdirections.end(), d, d+6);
+                }
+            }
+        }
+        std::mt19937 rng(0x6f72);
+        std::normal_distribution<double> normal;
+        while( (int)vdirections.size() < 6*numdirections ) {
+            double d[6], fnorm2 = 0;
+            for(int k = 0; k < 6; ++k) {
+                d[k] = normal(rng);
+                fnorm2 += d[k]*d[k];
+            }
+            if( fnorm2 < 1e-12 ) {
+                continue;
+            }
+            double finvnorm = 1/std::sqrt(fnorm2);
+            for(int k = 0; k < 6; ++k) {
+                d[k] *= finvnorm;
+            }
+            vdirections.insert(vdirections.end(), d, d+6);
+        }
+        return vdirections;
+    }
+
+    dReal _mu;
+    dReal _fnormalscale; ///< 1/sqrt(1+mu^2) so that the cone edges have unit length
+    std::vector< std::pair<dReal,dReal> > _vconesincos; ///< mu*sin and mu*cos of every cone edge, scaled by _fnormalscale
+};
+
+#endif
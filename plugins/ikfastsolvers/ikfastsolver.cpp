@@ -18,11 +18,87 @@
 #include <boost/bind.hpp>
 #include <boost/tuple/tuple.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <exception>
 
 #ifdef OPENRAVE_HAS_LAPACK
 #include "jacobianinverse.h"
 #endif
 
+/// \brief persistent worker threads for the free parameter sweep, so that the threads are not created for every batch
+class IkFreeSweepThreadPool
+{
+public:
+    IkFreeSweepThreadPool() : _nJobId(0), _numjobthreads(0), _numpending(0), _numrunning(0), _bShutdown(false) {
+    }
+    virtual ~IkFreeSweepThreadPool() {
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            _bShutdown = true;
+            _conditionJob.notify_all();
+        }
+        _threads.join_all();
+    }
+
+    /// \brief runs fn(ithread) for ithread in [0, nThreads) and returns when all of them finished. fn(0) runs on the calling thread.
+    void Run(int nThreads, const boost::function<void(int)>& fn)
+    {
+        boost::mutex::scoped_lock runlock(_mutexRun);
+        boost::mutex::scoped_lock lock(_mutex);
+        while( (int)_threads.size() < nThreads-1 ) {
+            _threads.create_thread(boost::bind(&IkFreeSweepThreadPool::_WorkerThread, this));
+        }
+        _fn = fn;
+        _numjobthreads = _numpending = _numrunning = std::max(0, nThreads-1);
+        ++_nJobId;
+        _conditionJob.notify_all();
+        lock.unlock();
+        fn(0);
+        lock.lock();
+        while( _numrunning > 0 ) {
+            _conditionDone.wait(lock);
+        }
+        _fn.clear();
+    }
+
+protected:
+    void _WorkerThread()
+    {
+        int lastjobid = 0;
+        boost::mutex::scoped_lock lock(_mutex);
+        while( true ) {
+            while( !_bShutdown && (_nJobId == lastjobid || _numpending == 0) ) {
+                _conditionJob.wait(lock);
+            }
+            if( _bShutdown ) {
+                return;
+            }
+            lastjobid = _nJobId;
+            const int ithread = 1 + _numjobthreads - _numpending;
+            --_numpending;
+            boost::function<void(int)> fn = _fn;
+            lock.unlock();
+            fn(ithread);
+            lock.lock();
+            if( --_numrunning == 0 ) {
+                _conditionDone.notify_all();
+            }
+        }
+    }
+
+    boost::thread_group _threads;
+    boost::mutex _mutexRun; ///< only one Run at a time
+    boost::mutex _mutex; ///< protects the members below
+    boost::condition_variable _conditionJob, _conditionDone;
+    boost::function<void(int)> _fn;
+    int _nJobId; ///< incremented for every Run, each thread runs a job at most once
+    int _numjobthreads; ///< number of worker threads of the current job
+    int _numpending; ///< number of threads that still have to start the current job
+    int _numrunning; ///< number of threads that did not finish the current job
+    bool _bShutdown;
+};
+
 template <typename IkReal>
 class IkFastSolver : public IkSolverBase
 {
@@ -81,8 +157,12 @@ public:
         RegisterCommand("SetBackTraceSelfCollisionLinks",boost::bind(&IkFastSolver<IkReal>::_SetBackTraceSelfCollisionLinksCommand,this,_1,_2),
                         "format: int int\n\n\
 for numBacktraceLinksForSelfCollisionWithNonMoving numBacktraceLinksForSelfCollisionWithFree, when pruning self collisions, the number of links to look at. If the tip of the manip self collides with the base, then can safely quit the IK.");
+        RegisterCommand("SetFreeSweepThreads",boost::bind(&IkFastSolver<IkReal>::_SetFreeSweepThreadsCommand,this,_1,_2),
+                        "format: int\n\n\
+the number of threads computing the closed-form solutions when sweeping the free parameters. 0 uses all hardware threads, 1 (default) sweeps on the calling thread only. Filters and collision checks always run on the calling thread in the same order as the serial sweep.");
         _numBacktraceLinksForSelfCollisionWithNonMoving = 2;
         _numBacktraceLinksForSelfCollisionWithFree = 0;
+        _nFreeSweepThreads = 1;
     }
     virtual ~IkFastSolver() {
     }
@@ -209,6 +289,17 @@ for numBacktraceLinksForSelfCollisionWithNonMoving numBacktraceLinksForSelfColli
         return true;
     }
 
+    bool _SetFreeSweepThreadsCommand(ostream& sout, istream& sinput)
+    {
+        int nthreads = 1;
+        sinput >> nthreads;
+        if( !sinput || nthreads < 0 ) {
+            return false;
+        }
+        _nFreeSweepThreads = nthreads;
+        return true;
+    }
+
     virtual IkReturnAction CallFilters(const IkParameterization& param, IkReturnPtr ikreturn, int minpriority, int maxpriority) {
         // have to convert to the manipulator's base coordinate system
         RobotBase::ManipulatorPtr pmanip = _pmanip.lock();
@@ -423,56 +514,49 @@ for numBacktraceLinksForSelfCollisionWithNonMoving numBacktraceLinksForSelfColli
         return false;
     }
 
-    /// \brief manages the enabling and disabling of the end effector links depending on the filter options
+    /// \brief manages the masking of the end effector links depending on the filter options
+    ///
+    /// The end effector links and the bodies they grab are excluded from environment collision checks through per-query link enable masks, so the link enable states of the robot are never modified.
     class StateCheckEndEffector
     {
 public:
         StateCheckEndEffector(RobotBasePtr probot, const std::vector<KinBody::LinkPtr>& vchildlinks, const std::vector<KinBody::LinkPtr>& vindependentlinks, int filteroptions) : _vchildlinks(vchildlinks), _vindependentlinks(vindependentlinks) {
             _probot = probot;
+            _filteroptions = filteroptions;
             _bCheckEndEffectorEnvCollision = !(filteroptions & IKFO_IgnoreEndEffectorEnvCollisions);
             _bCheckEndEffectorSelfCollision = !(filteroptions & (IKFO_IgnoreEndEffectorSelfCollisions|IKFO_IgnoreSelfCollisions));
             _bCheckSelfCollision = !(filteroptions & IKFO_IgnoreSelfCollisions);
             _bDisabled = false;
+            _bInitSavers = false;
             numImpossibleSelfCollisions = 0;
         }
         virtual ~StateCheckEndEffector() {
-            // restore the link states
-            if( _vlinkenabled.size() == _vchildlinks.size() ) {
-                for(size_t i = 0; i < _vchildlinks.size(); ++i) {
-                    _vchildlinks[i]->Enable(!!_vlinkenabled[i]);
-                }
-            }
+        }
+
+        /// \brief resets the state gathered while solving one pose so the object can be reused for the next pose of a batch. The link masks and the collision callback are kept.
+        void Reset()
+        {
+            _bCheckEndEffectorEnvCollision = !(_filteroptions & IKFO_IgnoreEndEffectorEnvCollisions);
+            _bDisabled = false;
+            _listCollidingTransforms.clear();
+            numImpossibleSelfCollisions = 0;
         }
 
         void SetEnvironmentCollisionState()
         {
             if( !_bDisabled && (!_bCheckEndEffectorEnvCollision || !_bCheckEndEffectorSelfCollision) ) {
                 _InitSavers();
-                for(size_t i = 0; i < _vchildlinks.size(); ++i) {
-                    _vchildlinks[i]->Enable(false);
-                }
-                FOREACH(it, _listGrabbedSavedStates) {
-                    it->GetBody()->Enable(false);
-                }
+                _InitCollisionCallback();
                 _bDisabled = true;
             }
         }
         void SetSelfCollisionState()
         {
-            if( _bDisabled ) {
-                _InitSavers();
-                for(size_t i = 0; i < _vchildlinks.size(); ++i) {
-                    _vchildlinks[i]->Enable(!!_vlinkenabled[i]);
-                }
-                FOREACH(it, _listGrabbedSavedStates) {
-                    it->Restore();
-                }
-                _bDisabled = false;
-            }
-            if( (!_bCheckEndEffectorEnvCollision || !_bCheckEndEffectorSelfCollision) && !_callbackhandle ) {
+            _bDisabled = false;
+            if( !_bCheckEndEffectorEnvCollision || !_bCheckEndEffectorSelfCollision ) {
                 _InitSavers();
                 // have to register a handle if we're ignoring end effector collisions
-                _callbackhandle = _probot->GetEnv()->RegisterCollisionCallback(boost::bind(&StateCheckEndEffector::_CollisionCallback,this,_1,_2));
+                _InitCollisionCallback();
             }
         }
 
@@ -488,16 +572,16 @@ public:
 
         void RestoreCheckEndEffectorEnvCollision() {
             _bCheckEndEffectorEnvCollision = true;
+            _bDisabled = false;
+        }
+
+        /// \brief checks the robot against the environment, ignoring the end effector links and their grabbed bodies if the environment collision state is set
+        bool CheckEnvCollision(CollisionReportPtr report)
+        {
             if( _bDisabled ) {
-                _InitSavers();
-                for(size_t i = 0; i < _vchildlinks.size(); ++i) {
-                    _vchildlinks[i]->Enable(!!_vlinkenabled[i]);
-                }
-                FOREACH(it, _listGrabbedSavedStates) {
-                    it->Restore();
-                }
-                _bDisabled = false;
+                return _probot->GetEnv()->CheckCollision(KinBodyConstPtr(_probot), _vLinkEnableStatesMaskOverrides, report);
             }
+            return _probot->GetEnv()->CheckCollision(KinBodyConstPtr(_probot), report);
         }
 
         /// \brief check if end effector is colliding if there's a colliding transform within some angle (this is used for TranslationDirection5D IK where end effector differs by a rotation around an axis)
@@ -525,23 +609,36 @@ public:
 protected:
         void _InitSavers()
         {
-            if( _vlinkenabled.size() > 0 ) {
+            if( _bInitSavers ) {
                 return; // already initialized
             }
-            _vlinkenabled.resize(_vchildlinks.size());
+            _bInitSavers = true;
+            _vLinkEnableStatesMaskOverrides.resize(0);
+            // the overrides can only disable links, so leave every other link set and let the checker use the enable states current at query time
+            _vLinkEnableStatesMaskOverrides.emplace_back(_probot, std::vector<uint64_t>(_probot->GetLinkEnableStatesMasks().size(), ~uint64_t(0)));
+            std::vector<uint64_t>& vrobotmask = _vLinkEnableStatesMaskOverrides.back().second;
             for(size_t i = 0; i < _vchildlinks.size(); ++i) {
-                _vlinkenabled[i] = _vchildlinks[i]->IsEnabled();
+                DisableLinkStateBit(vrobotmask, _vchildlinks[i]->GetIndex());
             }
-            _listGrabbedSavedStates.clear();
+            _vGrabbedBodies.resize(0);
             std::vector<KinBodyPtr> vgrabbedbodies;
             _probot->GetGrabbed(vgrabbedbodies);
             FOREACH(itbody,vgrabbedbodies) {
                 if( find(_vchildlinks.begin(),_vchildlinks.end(),_probot->IsGrabbing(**itbody)) != _vchildlinks.end() ) {
-                    _listGrabbedSavedStates.push_back(KinBody::KinBodyStateSaver(*itbody, KinBody::Save_LinkEnable));
+                    _vGrabbedBodies.push_back(*itbody);
+                    // a zero mask excludes all links of the grabbed body
+                    _vLinkEnableStatesMaskOverrides.emplace_back(*itbody, std::vector<uint64_t>((*itbody)->GetLinkEnableStatesMasks().size(), 0));
                 }
             }
         }
 
+        void _InitCollisionCallback()
+        {
+            if( !_callbackhandle ) {
+                _callbackhandle = _probot->GetEnv()->RegisterCollisionCallback(boost::bind(&StateCheckEndEffector::_CollisionCallback,this,_1,_2));
+            }
+        }
+
         CollisionAction _CollisionCallback(CollisionReportPtr report, bool IsCalledFromPhysicsEngine)
         {
             if( !_bCheckEndEffectorEnvCollision || !_bCheckEndEffectorSelfCollision ) {
@@ -565,8 +662,8 @@ protected:
                 // check for attached bodies of the child links
                 if( !bIndependentLink2 && !bChildLink2 && !!report->plink2 ) {
                     KinBodyPtr pcolliding = report->plink2->GetParent();
-                    FOREACH(it,_listGrabbedSavedStates) {
-                        if( it->GetBody() == pcolliding ) {
+                    FOREACH(it,_vGrabbedBodies) {
+                        if( *it == pcolliding ) {
                             if( !_bCheckEndEffectorEnvCollision ) {
                                 // if plink1 is not part of the robot, then ignore.
                                 if( !report->plink1 || report->plink1->GetParent() != _probot ) {
@@ -582,8 +679,8 @@ protected:
                 }
                 if( !bIndependentLink1 && !bChildLink1 && !!report->plink1 ) {
                     KinBodyPtr pcolliding = report->plink1->GetParent();
-                    FOREACH(it,_listGrabbedSavedStates) {
-                        if( it->GetBody() == pcolliding ) {
+                    FOREACH(it,_vGrabbedBodies) {
+                        if( *it == pcolliding ) {
                             if( !_bCheckEndEffectorEnvCollision ) {
                                 // if plink2 is not part of the robot, then ignore. otherwise it needs to be counted as self-collision
                                 if( !report->plink2 || report->plink2->GetParent() != _probot ) {
@@ -602,12 +699,13 @@ protected:
         }
 
         RobotBasePtr _probot;
-        std::list<KinBody::KinBodyStateSaver> _listGrabbedSavedStates;
-        vector<uint8_t> _vlinkenabled;
+        std::vector<KinBodyPtr> _vGrabbedBodies; ///< bodies grabbed by the end effector links
+        LinkEnableStatesMaskOverrides _vLinkEnableStatesMaskOverrides; ///< masks out the end effector links and _vGrabbedBodies for environment collision checks
         UserDataPtr _callbackhandle;
         const std::vector<KinBody::LinkPtr>& _vchildlinks, &_vindependentlinks;
         std::list<std::pair<Transform, bool> > _listCollidingTransforms;
-        bool _bCheckEndEffectorEnvCollision, _bCheckEndEffectorSelfCollision, _bCheckSelfCollision, _bDisabled;
+        int _filteroptions;
+        bool _bCheckEndEffectorEnvCollision, _bCheckEndEffectorSelfCollision, _bCheckSelfCollision, _bDisabled, _bInitSavers;
     };
 
     virtual bool Solve(const IkParameterization& rawparam, const std::vector<dReal>& q0, int filteroptions, boost::shared_ptr< std::vector<dReal> > result)
@@ -686,7 +784,13 @@ protected:
         std::vector<IkReal> vfree(_vfreeparams.size());
         StateCheckEndEffector stateCheck(probot,_vchildlinks,_vindependentlinks,filteroptions);
         CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
-        IkReturnAction retaction = ComposeSolution(_vfreeparams, vfree, 0, q0, boost::bind(&IkFastSolver::_SolveSingle,shared_solver(), boost::ref(param),boost::ref(vfree),boost::ref(q0),filteroptions,ikreturn,boost::ref(stateCheck)), _vFreeInc);
+        IkReturnAction retaction;
+        if( _GetNumFreeSweepThreads() > 1 ) {
+            retaction = _ComposeSolutionParallel(param, q0, boost::bind(&IkFastSolver::_ValidateFreeSampleSingle,shared_solver(), boost::ref(param),_1,boost::ref(q0),filteroptions,ikreturn,boost::ref(stateCheck)));
+        }
+        else {
+            retaction = ComposeSolution(_vfreeparams, vfree, 0, q0, boost::bind(&IkFastSolver::_SolveSingle,shared_solver(), boost::ref(param),boost::ref(vfree),boost::ref(q0),filteroptions,ikreturn,boost::ref(stateCheck)), _vFreeInc);
+        }
         if( !!ikreturn ) {
             ikreturn->_action = retaction;
         }
@@ -705,7 +809,7 @@ protected:
         std::vector<IkReal> vfree(_vfreeparams.size());
         StateCheckEndEffector stateCheck(probot,_vchildlinks,_vindependentlinks,filteroptions);
         CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
-        IkReturnAction retaction = ComposeSolution(_vfreeparams, vfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_SolveAll,shared_solver(), param,boost::ref(vfree),filteroptions,boost::ref(vikreturns), boost::ref(stateCheck)), _vFreeInc);
+        IkReturnAction retaction = _SolveAllFreeSweep(param, vfree, filteroptions, vikreturns, stateCheck);
         if( retaction & IKRA_Quit ) {
             return false;
         }
@@ -766,6 +870,64 @@ protected:
         return vikreturns.size()>0;
     }
 
+    virtual bool SolveAllBatch(const std::vector<IkParameterization>& vrawparams, int filteroptions, std::vector<dReal>& vsolutions, std::vector<int>& vposesolutionoffsets)
+    {
+        vsolutions.resize(0);
+        vposesolutionoffsets.resize(vrawparams.size()+1);
+        vposesolutionoffsets[0] = 0;
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
+        RobotBasePtr probot = pmanip->GetRobot();
+        // set up the robot and the collision filters once for all the poses
+        RobotBase::RobotStateSaver saver(probot);
+        probot->SetActiveDOFs(pmanip->GetArmIndices());
+        std::vector<IkReal> vfree(_vfreeparams.size());
+        StateCheckEndEffector stateCheck(probot,_vchildlinks,_vindependentlinks,filteroptions);
+        CollisionOptionsStateSaver optionstate(GetEnv()->GetCollisionChecker(),GetEnv()->GetCollisionChecker()->GetCollisionOptions()|CO_ActiveDOFs,false);
+
+        // when the ik fully determines the end effector pose, a colliding end effector rejects all the solutions of the pose, so check it before calling the ik
+        bool bCheckEndEffectorFirst = (filteroptions & IKFO_CheckEnvCollisions) && !(filteroptions & IKFO_IgnoreEndEffectorEnvCollisions);
+        Transform tBase;
+        if( !!pmanip->GetBase() ) {
+            tBase = pmanip->GetBase()->GetTransform();
+        }
+
+        std::vector<size_t> vorder;
+        _GetBatchSolveOrder(vrawparams, vorder);
+        std::vector< std::vector<dReal> > vposesolutions(vrawparams.size()); // packed solutions of each pose
+        std::vector<IkReturnPtr> vikreturns;
+        IkParameterization ikparamdummy;
+        FOREACHC(itindex, vorder) {
+            const IkParameterization& param = _ConvertIkParameterization(vrawparams[*itindex], ikparamdummy);
+            if( bCheckEndEffectorFirst && param.GetType() == IKP_Transform6D && pmanip->CheckEndEffectorCollision(tBase*param.GetTransform6D()) ) {
+                continue;
+            }
+            stateCheck.Reset();
+            vikreturns.resize(0);
+            IkReturnAction retaction = _SolveAllFreeSweep(param, vfree, filteroptions, vikreturns, stateCheck);
+            if( (retaction & IKRA_Quit) || vikreturns.size() == 0 ) {
+                continue;
+            }
+            _SortSolutions(probot, vikreturns);
+            std::vector<dReal>& vposesolution = vposesolutions[*itindex];
+            vposesolution.reserve(vikreturns.size()*pmanip->GetArmIndices().size());
+            FOREACHC(itikreturn, vikreturns) {
+                vposesolution.insert(vposesolution.end(), (*itikreturn)->_vsolution.begin(), (*itikreturn)->_vsolution.end());
+            }
+        }
+
+        size_t numdofs = pmanip->GetArmIndices().size();
+        size_t numvalues = 0;
+        FOREACHC(itposesolution, vposesolutions) {
+            numvalues += itposesolution->size();
+        }
+        vsolutions.reserve(numvalues);
+        for(size_t iparam = 0; iparam < vposesolutions.size(); ++iparam) {
+            vsolutions.insert(vsolutions.end(), vposesolutions[iparam].begin(), vposesolutions[iparam].end());
+            vposesolutionoffsets[iparam+1] = numdofs > 0 ? (int)(vsolutions.size()/numdofs) : 0;
+        }
+        return vsolutions.size() > 0;
+    }
+
     virtual int GetNumFreeParameters() const
     {
         return (int)_vfreeparams.size();
@@ -847,6 +1009,7 @@ protected:
         _kinematicshash = r->_kinematicshash;
         _numBacktraceLinksForSelfCollisionWithNonMoving = r->_numBacktraceLinksForSelfCollisionWithNonMoving;
         _numBacktraceLinksForSelfCollisionWithFree = r->_numBacktraceLinksForSelfCollisionWithFree;
+        _nFreeSweepThreads = r->_nFreeSweepThreads;
         _ikthreshold = r->_ikthreshold;
 #ifdef OPENRAVE_HAS_LAPACK
         _SetJacobianRefine(r->_fRefineWithJacobianInverseAllowedError, r->_jacobinvsolver._nMaxIterations);
@@ -944,6 +1107,113 @@ protected:
         return static_cast<IkReturnAction>(allres);
     }
 
+    /// \brief closed-form solutions for one value of the free parameters
+    struct FreeParameterSample
+    {
+        FreeParameterSample() : bsuccess(false) {
+        }
+        std::vector<IkReal> vfree;
+        ikfast::IkSolutionList<IkReal> solutions;
+        bool bsuccess; ///< return value of _CallIk
+    };
+
+    inline int _GetNumFreeSweepThreads() const
+    {
+        if( _vfreeparams.size() == 0 ) {
+            return 1;
+        }
+        if( _nFreeSweepThreads == 0 ) {
+            return std::max(1, (int)boost::thread::hardware_concurrency());
+        }
+        return _nFreeSweepThreads;
+    }
+
+    IkReturnAction _RecordFreeSample(const vector<IkReal>& vfree, std::vector<IkReal>& vfreesamples)
+    {
+        vfreesamples.insert(vfreesamples.end(), vfree.begin(), vfree.end());
+        return IKRA_Reject; // continue the sweep
+    }
+
+    /// \brief computes the closed-form solutions of every nthreads-th sample of vsamples starting at ithread.
+    void _ComputeFreeSampleSolutions(const IkParameterization& param, const Transform& tLocalTool, std::vector<FreeParameterSample>& vsamples, size_t numsamples, int ithread, int nthreads, std::vector<std::exception_ptr>& vexceptions)
+    {
+        std::exception_ptr& exception = vexceptions.at(ithread);
+        try {
+            for(size_t isample = ithread; isample < numsamples; isample += nthreads) {
+                FreeParameterSample& sample = vsamples[isample];
+                sample.solutions.Clear();
+                sample.bsuccess = _CallIk(param, sample.vfree, tLocalTool, sample.solutions);
+            }
+        }
+        catch(...) {
+            exception = std::current_exception();
+        }
+    }
+
+    /// \brief sweeps the free parameters in the same order as ComposeSolution, but computes the closed-form solutions of batches of free values on several threads.
+    ///
+    /// fnvalidate is called on the calling thread for every sample in the sweep order, so filters and collision checks see exactly the sequence of the serial sweep and the sweep stops at the same place.
+    IkReturnAction _ComposeSolutionParallel(const IkParameterization& param, const vector<dReal>& q0, const boost::function<IkReturnAction(const FreeParameterSample&)>& fnvalidate)
+    {
+        const int nthreads = _GetNumFreeSweepThreads();
+        const size_t numfree = _vfreeparams.size();
+        std::vector<IkReal> vfree(numfree), vfreesamples;
+        ComposeSolution(_vfreeparams, vfree, 0, q0, boost::bind(&IkFastSolver::_RecordFreeSample, this, boost::cref(vfree), boost::ref(vfreesamples)), _vFreeInc);
+        const size_t numtotalsamples = vfreesamples.size()/numfree;
+
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
+        Transform tIkChainEndlinkToEE;
+        if (!!pmanip->GetIkChainEndLink()) {
+            tIkChainEndlinkToEE = pmanip->GetIkChainEndLink()->GetTransform().inverse() * pmanip->GetEndEffector()->GetTransform();
+        }
+        const Transform tLocalTool = tIkChainEndlinkToEE * pmanip->GetLocalToolTransform();
+
+        // start with small batches so that early exits do not waste too much work, then grow them to amortize the synchronization
+        size_t batchsize = 16*nthreads;
+        const size_t maxbatchsize = 256*nthreads;
+        std::vector<FreeParameterSample> vsamples;
+        std::vector<std::exception_ptr> vexceptions(nthreads);
+        int allres = IKRA_Reject;
+        for(size_t isampleoffset = 0; isampleoffset < numtotalsamples; isampleoffset += batchsize, batchsize = std::min(2*batchsize, maxbatchsize)) {
+            const size_t numsamples = std::min(batchsize, numtotalsamples-isampleoffset);
+            if( vsamples.size() < numsamples ) {
+                vsamples.resize(numsamples);
+            }
+            for(size_t isample = 0; isample < numsamples; ++isample) {
+                vsamples[isample].vfree.assign(vfreesamples.begin()+(isampleoffset+isample)*numfree, vfreesamples.begin()+(isampleoffset+isample+1)*numfree);
+            }
+
+            // a closed-form solution takes a few microseconds, so small batches are not worth waking up the workers for
+            const int nbatchthreads = std::max(1, std::min(nthreads, (int)(numsamples/s_nMinFreeSamplesPerThread)));
+            if( nbatchthreads <= 1 ) {
+                _ComputeFreeSampleSolutions(param, tLocalTool, vsamples, numsamples, 0, 1, vexceptions);
+            }
+            else {
+                if( !_pfreesweeppool ) {
+                    _pfreesweeppool.reset(new IkFreeSweepThreadPool());
+                }
+                _pfreesweeppool->Run(nbatchthreads, boost::bind(&IkFastSolver::_ComputeFreeSampleSolutions, this, boost::cref(param), boost::cref(tLocalTool), boost::ref(vsamples), numsamples, _1, nbatchthreads, boost::ref(vexceptions)));
+            }
+            FOREACH(itexception, vexceptions) {
+                if( !!*itexception ) {
+                    std::rethrow_exception(*itexception);
+                }
+            }
+
+            for(size_t isample = 0; isample < numsamples; ++isample) {
+                IkReturnAction res = fnvalidate(vsamples[isample]);
+                if( !(res & IKRA_Reject) ) {
+                    return res;
+                }
+                if( res & IKRA_Quit ) {
+                    return res;
+                }
+                allres |= res;
+            }
+        }
+        return static_cast<IkReturnAction>(allres);
+    }
+
     /// \param tLocalTool _pmanip->GetLocalToolTransform()
     inline bool _CallIk(const IkParameterization& param, const vector<IkReal>& vfree, const Transform& tLocalTool, ikfast::IkSolutionList<IkReal>& solutions)
     {
@@ -1315,7 +1585,21 @@ protected:
         if( !_CallIk(param,vfree, tIkChainEndlinkToEE * pmanip->GetLocalToolTransform(), solutions) ) {
             return IKRA_RejectKinematics;
         }
+        return _ValidateSolutionsSingle(param, solutions, q0, filteroptions, ikreturn, stateCheck);
+    }
+
+    IkReturnAction _ValidateFreeSampleSingle(const IkParameterization& param, const FreeParameterSample& sample, const vector<dReal>& q0, int filteroptions, IkReturnPtr ikreturn, StateCheckEndEffector& stateCheck)
+    {
+        if( !sample.bsuccess ) {
+            return IKRA_RejectKinematics;
+        }
+        return _ValidateSolutionsSingle(param, sample.solutions, q0, filteroptions, ikreturn, stateCheck);
+    }
 
+    /// \brief validates the closed-form solutions computed for one value of the free parameters
+    IkReturnAction _ValidateSolutionsSingle(const IkParameterization& param, const ikfast::IkSolutionList<IkReal>& solutions, const vector<dReal>& q0, int filteroptions, IkReturnPtr ikreturn, StateCheckEndEffector& stateCheck)
+    {
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
         RobotBasePtr probot = pmanip->GetRobot();
         SolutionInfo bestsolution;
         std::vector<dReal> vravesol(pmanip->GetArmIndices().size());
@@ -1683,7 +1967,7 @@ protected:
                     }
                 }
             }
-            if( GetEnv()->CheckCollision(KinBodyConstPtr(probot), ptempreport) ) {
+            if( stateCheck.CheckEnvCollision(ptempreport) ) {
                 if( paramnewglobal.GetType() == IKP_TranslationDirection5D ) {
                     // colliding and 5d,so check if colliding with end effector. If yes, then register as part of the stateCheck
                     bool bIsEndEffectorCollision = false;
@@ -1865,10 +2149,62 @@ protected:
 //        return IKRA_Success;
     }
 
+    /// \brief gathers the solutions of param over the whole range of the free parameters
+    IkReturnAction _SolveAllFreeSweep(const IkParameterization& param, std::vector<IkReal>& vfree, int filteroptions, std::vector<IkReturnPtr>& vikreturns, StateCheckEndEffector& stateCheck)
+    {
+        if( _GetNumFreeSweepThreads() > 1 ) {
+            return _ComposeSolutionParallel(param, vector<dReal>(), boost::bind(&IkFastSolver::_ValidateFreeSampleAll,shared_solver(), boost::ref(param),_1,filteroptions,boost::ref(vikreturns), boost::ref(stateCheck)));
+        }
+        return ComposeSolution(_vfreeparams, vfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_SolveAll,shared_solver(), param,boost::ref(vfree),filteroptions,boost::ref(vikreturns), boost::ref(stateCheck)), _vFreeInc);
+    }
+
+    /// \brief orders the poses of a batch so that consecutive poses are close to each other
+    ///
+    /// Sorts along a Morton curve over the last three values of every pose (the translation for most parameterizations), which keeps the collision checker caches and the end effector state coherent between consecutive solves.
+    static void _GetBatchSolveOrder(const std::vector<IkParameterization>& vparams, std::vector<size_t>& vorder)
+    {
+        vorder.resize(vparams.size());
+        for(size_t i = 0; i < vorder.size(); ++i) {
+            vorder[i] = i;
+        }
+        if( vparams.size() <= 2 ) {
+            return;
+        }
+        std::vector<dReal> vpoints(3*vparams.size(), 0), vvalues;
+        Vector vmin(1e30,1e30,1e30), vmax(-1e30,-1e30,-1e30);
+        for(size_t iparam = 0; iparam < vparams.size(); ++iparam) {
+            vvalues.resize(vparams[iparam].GetNumberOfValues());
+            vparams[iparam].GetValues(vvalues.begin());
+            for(size_t j = 0; j < 3 && j < vvalues.size(); ++j) {
+                dReal f = vvalues[vvalues.size()-1-j];
+                vpoints[3*iparam+j] = f;
+                vmin[j] = min(vmin[j], f);
+                vmax[j] = max(vmax[j], f);
+            }
+        }
+        std::vector< std::pair<uint64_t, size_t> > vkeys(vparams.size());
+        for(size_t iparam = 0; iparam < vparams.size(); ++iparam) {
+            uint64_t key = (uint64_t)vparams[iparam].GetType() << 30;
+            for(int j = 0; j < 3; ++j) {
+                uint32_t cell = 0;
+                if( vmax[j] > vmin[j] ) {
+                    cell = (uint32_t)(1023*(vpoints[3*iparam+j]-vmin[j])/(vmax[j]-vmin[j]));
+                }
+                for(int ibit = 0; ibit < 10; ++ibit) {
+                    key |= (uint64_t)((cell>>ibit)&1) << (3*ibit+j);
+                }
+            }
+            vkeys[iparam] = std::make_pair(key, iparam);
+        }
+        std::sort(vkeys.begin(), vkeys.end());
+        for(size_t i = 0; i < vkeys.size(); ++i) {
+            vorder[i] = vkeys[i].second;
+        }
+    }
+
     IkReturnAction _SolveAll(const IkParameterization& param, const vector<IkReal>& vfree, int filteroptions, std::vector<IkReturnPtr>& vikreturns, StateCheckEndEffector& stateCheck)
     {
         RobotBase::ManipulatorPtr pmanip(_pmanip);
-        RobotBasePtr probot = pmanip->GetRobot();
         ikfast::IkSolutionList<IkReal> solutions;
         Transform tIkChainEndlinkToEE;
         if (!!pmanip->GetIkChainEndLink()) {
@@ -1876,26 +2212,42 @@ protected:
         }
 
         if( _CallIk(param,vfree, tIkChainEndlinkToEE * pmanip->GetLocalToolTransform(), solutions) ) {
-            vector<IkReal> vsolfree;
-            std::vector<IkReal> sol(pmanip->GetArmIndices().size());
-            for(size_t isolution = 0; isolution < solutions.GetNumSolutions(); ++isolution) {
-                const ikfast::IkSolution<IkReal>& iksol = dynamic_cast<const ikfast::IkSolution<IkReal>& >(solutions.GetSolution(isolution));
-                iksol.Validate();
-                //RAVELOG_VERBOSE_FORMAT("ikfast solution %d/%d (free=%d)", isolution%solutions.GetNumSolutions()%iksol.GetFree().size());
-                if( iksol.GetFree().size() > 0 ) {
-                    // have to search over all the free parameters of the solution!
-                    vsolfree.resize(iksol.GetFree().size());
-                    std::vector<dReal> vFreeInc(_GetFreeIncFromIndices(iksol.GetFree()));
-                    IkReturnAction retaction = ComposeSolution(iksol.GetFree(), vsolfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_ValidateSolutionAll,shared_solver(), boost::ref(param), boost::ref(iksol), boost::ref(vsolfree), filteroptions, boost::ref(sol), boost::ref(vikreturns), boost::ref(stateCheck)), vFreeInc);
-                    if( retaction & IKRA_Quit) {
-                        return retaction;
-                    }
+            return _ValidateSolutionsAll(param, solutions, filteroptions, vikreturns, stateCheck);
+        }
+        return IKRA_Reject; // signals to continue
+    }
+
+    IkReturnAction _ValidateFreeSampleAll(const IkParameterization& param, const FreeParameterSample& sample, int filteroptions, std::vector<IkReturnPtr>& vikreturns, StateCheckEndEffector& stateCheck)
+    {
+        if( !sample.bsuccess ) {
+            return IKRA_Reject; // signals to continue
+        }
+        return _ValidateSolutionsAll(param, sample.solutions, filteroptions, vikreturns, stateCheck);
+    }
+
+    /// \brief validates the closed-form solutions computed for one value of the free parameters and appends the valid ones to vikreturns
+    IkReturnAction _ValidateSolutionsAll(const IkParameterization& param, const ikfast::IkSolutionList<IkReal>& solutions, int filteroptions, std::vector<IkReturnPtr>& vikreturns, StateCheckEndEffector& stateCheck)
+    {
+        RobotBase::ManipulatorPtr pmanip(_pmanip);
+        vector<IkReal> vsolfree;
+        std::vector<IkReal> sol(pmanip->GetArmIndices().size());
+        for(size_t isolution = 0; isolution < solutions.GetNumSolutions(); ++isolution) {
+            const ikfast::IkSolution<IkReal>& iksol = dynamic_cast<const ikfast::IkSolution<IkReal>& >(solutions.GetSolution(isolution));
+            iksol.Validate();
+            //RAVELOG_VERBOSE_FORMAT("ikfast solution %d/%d (free=%d)", isolution%solutions.GetNumSolutions()%iksol.GetFree().size());
+            if( iksol.GetFree().size() > 0 ) {
+                // have to search over all the free parameters of the solution!
+                vsolfree.resize(iksol.GetFree().size());
+                std::vector<dReal> vFreeInc(_GetFreeIncFromIndices(iksol.GetFree()));
+                IkReturnAction retaction = ComposeSolution(iksol.GetFree(), vsolfree, 0, vector<dReal>(), boost::bind(&IkFastSolver::_ValidateSolutionAll,shared_solver(), boost::ref(param), boost::ref(iksol), boost::ref(vsolfree), filteroptions, boost::ref(sol), boost::ref(vikreturns), boost::ref(stateCheck)), vFreeInc);
+                if( retaction & IKRA_Quit) {
+                    return retaction;
                 }
-                else {
-                    IkReturnAction retaction = _ValidateSolutionAll(param, iksol, vector<IkReal>(), filteroptions, sol, vikreturns, stateCheck);
-                    if( retaction & IKRA_Quit ) {
-                        return retaction;
-                    }
+            }
+            else {
+                IkReturnAction retaction = _ValidateSolutionAll(param, iksol, vector<IkReal>(), filteroptions, sol, vikreturns, stateCheck);
+                if( retaction & IKRA_Quit ) {
+                    return retaction;
                 }
             }
         }
@@ -2127,7 +2479,7 @@ protected:
                     stateCheck.ResetCheckEndEffectorEnvCollision();
                 }
             }
-            if( GetEnv()->CheckCollision(KinBodyConstPtr(probot), ptempreport) ) {
+            if( stateCheck.CheckEnvCollision(ptempreport) ) {
                 if( !!ptempreport ) {
                     stringstream ss; ss << std::setprecision(std::numeric_limits<OpenRAVE::dReal>::digits10+1);
                     ss << "ikfast collision " << report.__str__() << " colvalues=[";
@@ -2450,6 +2802,9 @@ protected:
     std::vector<size_t> _qbigrangemaxsols, _qbigrangemaxcumprod;
     IkParameterizationType _iktype;
     std::string _kinematicshash;
+    int _nFreeSweepThreads; ///< number of threads computing closed-form solutions in _ComposeSolutionParallel, 0 for all hardware threads. If 1, sweep serially with ComposeSolution
+    boost::shared_ptr<IkFreeSweepThreadPool> _pfreesweeppool; ///< workers of _ComposeSolutionParallel, created on first use and kept until the solver is destroyed
+    static const size_t s_nMinFreeSamplesPerThread = 8; ///< batches are split over at most numsamples/s_nMinFreeSamplesPerThread threads
     int _numBacktraceLinksForSelfCollisionWithNonMoving, _numBacktraceLinksForSelfCollisionWithFree; ///< when pruning self collisions, the number of links to look at. If the tip of the manip self collides with the base, then can safely quit the IK. this is used purely for optimization purposes and by default it is mostly disabled. For more complex robots with a lot of joints, can use these parameters to speed up searching for IK.
     dReal _ikthreshold; ///< workspace distance threshold sanity checking between desired workspace goal and the workspace position with the returned ik values.
     dReal _fRefineWithJacobianInverseAllowedError; ///< if > 0, then use jacobian inverse numerical method to refine the results until workspace error drops down this much. By default it is disabled (=-1)
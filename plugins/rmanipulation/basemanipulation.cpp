@@ -67,11 +67,15 @@ Method wraps the WorkspaceTrajectoryTracker planner. For more details on paramet
     virtual void Destroy()
     {
         robot.reset();
+        _pikgoalcache.reset();
         ModuleBase::Destroy();
     }
 
     virtual void Reset()
     {
+        if( !!_pikgoalcache ) {
+            _pikgoalcache->Clear();
+        }
         ModuleBase::Reset();
     }
 
@@ -598,6 +602,7 @@ protected:
         dReal jitterikparam = 0;
         dReal goalsampleprob = 0.1;
         int nGoalMaxTries=10;
+        bool bCacheIkGoals = false;
         std::vector<dReal> vinitialconfig;
         std::vector<dReal> vfreevalues;
         while(!sinput.eof()) {
@@ -735,6 +740,9 @@ protected:
             else if( cmd == "goalmaxtries" ) {
                 sinput >> nGoalMaxTries;
             }
+            else if( cmd == "cacheikgoals" ) {
+                sinput >> bCacheIkGoals;
+            }
             else if( cmd == "initialconfigs" ) {
                 size_t num=0;
                 sinput >> num;
@@ -796,6 +804,12 @@ protected:
         const bool searchfreeparameters = vfreevalues.empty();
         planningutils::ManipulatorIKGoalSampler goalsampler(pmanip, listgoals,goalsamples,nGoalMaxTries, 1, searchfreeparameters, IKFO_CheckEnvCollisions, vfreevalues);
         goalsampler.SetJitter(jitterikparam);
+        if( bCacheIkGoals ) {
+            if( !_pikgoalcache ) {
+                _pikgoalcache.reset(new planningutils::ManipulatorIKGoalSamplerCache());
+            }
+            goalsampler.SetCache(_pikgoalcache);
+        }
         params->vgoalconfig.reserve(nSeedIkSolutions*robot->GetActiveDOF());
         while(nSeedIkSolutions > 0) {
             if( goalsampler.Sample(vgoal) ) {
@@ -1128,6 +1142,7 @@ protected:
     dReal _fMaxVelMult;
     int _minimumgoalpaths;
     string _sPostProcessingParameters;
+    planningutils::ManipulatorIKGoalSamplerCachePtr _pikgoalcache; ///< ik solutions of previous MoveToHandPosition goals when called with cacheikgoals 1, invalidated when the environment changes
 };
 
 ModuleBasePtr CreateBaseManipulation(EnvironmentBasePtr penv) {
@@ -33,12 +33,149 @@ namespace RampOptimizer = RampOptimizerInternal;
 
 class ParabolicSmoother2 : public PlannerBase, public RampOptimizer::FeasibilityCheckerBase, public RampOptimizer::RandomNumberGeneratorBase {
 
+    /// \brief Measures the distance of the robot to the environment and to itself for sweeping RampNDs in
+    /// MyRampNDFeasibilityChecker. Only usable when the configuration space is the joint values of one robot.
+    class MyDistanceChecker : public RampOptimizer::DistanceCheckerBase {
+public:
+        MyDistanceChecker() {
+            _options = 0;
+        }
+
+        /// \brief computes the displacement weights of the joints, returns false if the distance sweep cannot be used
+        bool Init(EnvironmentBasePtr penv, ConstraintTrajectoryTimingParametersPtr parameters)
+        {
+            _penv = penv;
+            _parameters = parameters;
+            _pbody.reset();
+            std::vector<KinBodyPtr> vusedbodies;
+            parameters->_configurationspecification.ExtractUsedBodies(penv, vusedbodies);
+            if( vusedbodies.size() != 1 ) {
+                RAVELOG_DEBUG_FORMAT("env=%d, distance sweep needs the configuration of exactly one body, got %d", penv->GetId()%vusedbodies.size());
+                return false;
+            }
+            KinBodyPtr pbody = vusedbodies[0];
+            std::vector<int> vdofindices, vconfigindices;
+            parameters->_configurationspecification.ExtractUsedIndices(pbody, vdofindices, vconfigindices);
+            if( (int)vdofindices.size() != parameters->GetDOF() ) {
+                RAVELOG_DEBUG_FORMAT("env=%d, distance sweep only supports joint values", penv->GetId());
+                return false;
+            }
+            std::vector<KinBodyPtr> vgrabbed;
+            pbody->GetGrabbed(vgrabbed);
+            if( vgrabbed.size() > 0 ) {
+                RAVELOG_DEBUG_FORMAT("env=%d, distance sweep does not support grabbed bodies", penv->GetId());
+                return false;
+            }
+            _pchecker = penv->GetCollisionChecker();
+            _pselfchecker = !!pbody->GetSelfCollisionChecker() ? pbody->GetSelfCollisionChecker() : _pchecker;
+            if( !_pchecker || !_SupportsDistance(_pchecker) || !_SupportsDistance(_pselfchecker) ) {
+                RAVELOG_DEBUG_FORMAT("env=%d, collision checker does not support distance queries", penv->GetId());
+                return false;
+            }
+
+            // For a revolute joint, bound the distance from its axis to every point of the links it moves by the
+            // distances between consecutive joint anchors along the chain, which do not change with the configuration.
+            _vweights.resize(parameters->GetDOF());
+            std::vector<KinBody::JointPtr> vchainjoints;
+            boost::array<dReal,3> vlowerlimits, vupperlimits;
+            for(size_t i = 0; i < vdofindices.size(); ++i) {
+                KinBody::JointPtr pjoint = pbody->GetJointFromDOFIndex(vdofindices[i]);
+                int iaxis = vdofindices[i] - pjoint->GetDOFIndex();
+                dReal& fweight = _vweights.at(vconfigindices[i]);
+                fweight = 0;
+                if( pjoint->IsPrismatic(iaxis) ) {
+                    fweight = 1;
+                    continue;
+                }
+                int childlinkindex = pjoint->GetHierarchyChildLink()->GetIndex();
+                FOREACHC(itlink, pbody->GetLinks()) {
+                    if( !pbody->DoesDOFAffectLink(vdofindices[i], (*itlink)->GetIndex()) || !pbody->GetChain(childlinkindex, (*itlink)->GetIndex(), vchainjoints) ) {
+                        continue;
+                    }
+                    dReal freach = 0;
+                    Vector vprevanchor = pjoint->GetAnchor();
+                    FOREACHC(itchainjoint, vchainjoints) {
+                        freach += RaveSqrt(((*itchainjoint)->GetAnchor() - vprevanchor).lengthsqr3());
+                        for(int ichainaxis = 0; ichainaxis < (*itchainjoint)->GetDOF(); ++ichainaxis) {
+                            if( (*itchainjoint)->IsPrismatic(ichainaxis) ) {
+                                (*itchainjoint)->GetLimits(vlowerlimits, vupperlimits);
+                                freach += vupperlimits[ichainaxis] - vlowerlimits[ichainaxis];
+                            }
+                        }
+                        vprevanchor = (*itchainjoint)->GetAnchor();
+                    }
+                    AABB ab = (*itlink)->ComputeLocalAABB();
+                    freach += RaveSqrt(((*itlink)->GetTransform()*ab.pos - vprevanchor).lengthsqr3()) + RaveSqrt(ab.extents.lengthsqr3());
+                    fweight = max(fweight, freach);
+                }
+            }
+            _pbody = pbody;
+            return true;
+        }
+
+        /// \brief sets which of CFO_CheckEnvCollisions and CFO_CheckSelfCollisions ObstacleDistance measures
+        void SetCheckOptions(int options)
+        {
+            _options = options;
+        }
+
+        virtual dReal ObstacleDistance(const std::vector<dReal>& x)
+        {
+            if( _parameters->SetStateValues(x, 0) != 0 ) {
+                return 0;
+            }
+            if( !_report ) {
+                _report.reset(new CollisionReport());
+            }
+            dReal fdist = RampOptimizer::g_fRampInf;
+            if( _options & CFO_CheckEnvCollisions ) {
+                CollisionOptionsStateSaver optionsaver(_pchecker, _pchecker->GetCollisionOptions()|CO_Distance);
+                if( _penv->CheckCollision(KinBodyConstPtr(_pbody), _report) ) {
+                    return 0;
+                }
+                fdist = min(fdist, _report->minDistance);
+            }
+            if( _options & CFO_CheckSelfCollisions ) {
+                // both links of a pair can move towards each other
+                CollisionOptionsStateSaver optionsaver(_pselfchecker, _pselfchecker->GetCollisionOptions()|CO_Distance);
+                if( _pbody->CheckSelfCollision(_report, _pselfchecker) ) {
+                    return 0;
+                }
+                fdist = min(fdist, 0.5*_report->minDistance);
+            }
+            return fdist;
+        }
+
+        virtual void GetDOFDisplacementWeights(const std::vector<dReal>& x, std::vector<dReal>& vweights)
+        {
+            vweights = _vweights;
+        }
+
+private:
+        static bool _SupportsDistance(CollisionCheckerBasePtr pchecker)
+        {
+            int oldoptions = pchecker->GetCollisionOptions();
+            bool bsupported = pchecker->SetCollisionOptions(oldoptions|CO_Distance);
+            pchecker->SetCollisionOptions(oldoptions);
+            return bsupported;
+        }
+
+        EnvironmentBasePtr _penv;
+        ConstraintTrajectoryTimingParametersPtr _parameters;
+        KinBodyPtr _pbody;
+        CollisionCheckerBasePtr _pchecker, _pselfchecker;
+        CollisionReportPtr _report;
+        std::vector<dReal> _vweights; ///< max workspace displacement of the body per unit of each configuration value
+        int _options; ///< CFO_X collision options to measure
+    }; // end class MyDistanceChecker
+
     class MyRampNDFeasibilityChecker : public RampOptimizer::RampNDFeasibilityChecker {
 public:
         MyRampNDFeasibilityChecker(RampOptimizer::FeasibilityCheckerBase* feas) : RampOptimizer::RampNDFeasibilityChecker(feas) {
             _bHasParameters = false;
             _cacheRampNDVectIn.resize(1);
             _envid = 0;
+            _pdistancechecker = NULL;
         }
 
         void SetParameters(PlannerParametersConstPtr params)
@@ -53,6 +190,15 @@ public:
             _envid = envid;
         }
 
+        /// \brief if pdistancechecker is set, collisions are swept over the RampNDs with at most maxiter distance queries
+        /// per RampND instead of being checked at every discretized configuration
+        void SetDistanceChecker(MyDistanceChecker* pdistancechecker, int maxiter_)
+        {
+            _pdistancechecker = pdistancechecker;
+            distance = pdistancechecker;
+            maxiter = maxiter_;
+        }
+
         /// \brief A wrapper function for Check2.
         RampOptimizer::CheckReturn Check2(const RampOptimizer::RampND& rampndIn, int options, std::vector<RampOptimizer::RampND>& rampndVectOut)
         {
@@ -136,6 +282,11 @@ public:
 #else
             bool doLazyCollisionChecking = false;
 #endif
+            int sweepoptions = 0;
+            if( !!_pdistancechecker ) {
+                sweepoptions = options & (CFO_CheckEnvCollisions|CFO_CheckSelfCollisions);
+                options = options & (~sweepoptions);
+            }
             bool doCheckEnvCollisionsLater = doLazyCollisionChecking ? (options & CFO_CheckEnvCollisions) == CFO_CheckEnvCollisions : false;
             bool doCheckSelfCollisionsLater = doLazyCollisionChecking ? (options & CFO_CheckSelfCollisions) == CFO_CheckSelfCollisions : false;
             if( doLazyCollisionChecking ) {
@@ -319,6 +470,14 @@ public:
 #endif
             }
 
+            if( sweepoptions != 0 ) {
+                _pdistancechecker->SetCheckOptions(sweepoptions);
+                int sweepret = RampOptimizer::CheckRampNDFeasibility(rampndVectOut.size() > 0 ? rampndVectOut : rampndVect, feas, distance, maxiter, tol, sweepoptions);
+                if( sweepret != 0 ) {
+                    return RampOptimizer::CheckReturn(sweepret);
+                }
+            }
+
             bool bDifferentVelocity = false;
             if( rampndVectOut.size() > 0 ) {
                 for (size_t idof = 0; idof < q0.size(); ++idof) {
@@ -341,6 +500,7 @@ private:
         ConstraintTrajectoryTimingParametersPtr _parameters;
         bool _bHasParameters;
         int _envid; ///< useful for logging
+        MyDistanceChecker* _pdistancechecker; ///< if set, collisions are checked by sweeping with distance queries
 
         // Cache
         std::vector<dReal> _vswitchtimes;
@@ -364,6 +524,9 @@ public:
         _environmentid = GetEnv()->GetId();
         _vVisitedDiscretizationCache.resize(0x1000*0x1000,0); // pre-allocate in order to keep memory growth predictable
         _feasibilitychecker.SetEnvID(_environmentid); // set envid for logging purpose
+        _nDistanceSweepMaxIterations = 0;
+        RegisterCommand("SetDistanceSweep",boost::bind(&ParabolicSmoother2::_SetDistanceSweepCommand,this,_1,_2),
+                        "Format: SetDistanceSweep maxiter. If maxiter > 0 and the collision checker supports distance queries, collisions are checked by sweeping each ramp with at most maxiter distance queries instead of at every discretized configuration. 0 (default) disables it.");
     }
 
     virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr params)
@@ -432,6 +595,13 @@ public:
 
         _bUseNewHeuristic = false; // dof-depending velocity/acceleration scaling factors
 
+        if( _nDistanceSweepMaxIterations > 0 && _distancechecker.Init(GetEnv(), _parameters) ) {
+            _feasibilitychecker.SetDistanceChecker(&_distancechecker, _nDistanceSweepMaxIterations);
+        }
+        else {
+            _feasibilitychecker.SetDistanceChecker(NULL, 0);
+        }
+
         // Caching stuff
         size_t ndof = _parameters->GetDOF();
         if( _cacheCurPos.capacity() < ndof ) {
@@ -474,6 +644,17 @@ public:
         return _parameters;
     }
 
+    bool _SetDistanceSweepCommand(std::ostream& sout, std::istream& sinput)
+    {
+        int maxiter = 0;
+        sinput >> maxiter;
+        if( !sinput ) {
+            return false;
+        }
+        _nDistanceSweepMaxIterations = maxiter;
+        return true;
+    }
+
     virtual PlannerStatus PlanPath(TrajectoryBasePtr ptraj, int planningoptions) override
     {
         BOOST_ASSERT(!!_parameters && !!ptraj);
@@ -3418,6 +3599,8 @@ protected:
     SpaceSamplerBasePtr _uniformsampler;        ///< used for planning, seed is controlled
     ConstraintFilterReturnPtr _constraintreturn;
     MyRampNDFeasibilityChecker _feasibilitychecker;
+    MyDistanceChecker _distancechecker;
+    int _nDistanceSweepMaxIterations; ///< if > 0, max number of distance queries per RampND when sweeping collisions
     boost::shared_ptr<ManipConstraintChecker2> _manipconstraintchecker;
     TrajectoryBasePtr _pdummytraj;
     PlannerProgress _progress;
@@ -46,10 +46,98 @@ struct RampNDSection {
     dReal da, db; // obstacle distances at xa and xb
 };
 
-int CheckRampNDFeasibility(const std::vector<RampND>& rampndVect, FeasibilityCheckerBase* feas, DistanceCheckerBase* dist, int maxiter, __attribute__((unused)) int options)
+/// \brief checks the configurations of rampnd from tstart on with steps that move every dof by at most tol. a is the constant acceleration of rampnd.
+inline int CheckRampNDDiscretized(const RampND& rampnd, dReal tstart, const std::vector<dReal>& a, FeasibilityCheckerBase* feas, const std::vector<dReal>& tol, int options, std::vector<dReal>& x, std::vector<dReal>& v)
 {
-    BOOST_ASSERT(0);
-    return 0xffff;
+    OPENRAVE_ASSERT_OP(tol.size(), ==, a.size());
+    dReal duration = rampnd.GetDuration();
+    dReal t = tstart;
+    while( t < duration ) {
+        rampnd.EvalPos(t, x);
+        rampnd.EvalVel(t, v);
+        int ret = feas->ConfigFeasible(x, v, options);
+        if( ret != 0 ) {
+            return ret;
+        }
+        // largest dt with |v_i|*dt + 0.5*|a_i|*dt^2 <= tol_i for every dof
+        dReal dt = duration - t;
+        for (size_t idof = 0; idof < tol.size(); ++idof) {
+            dReal fabsv = Abs(v[idof]);
+            dt = Min(dt, 2*tol[idof]/(fabsv + Sqrt(fabsv*fabsv + 2*Abs(a[idof])*tol[idof])));
+        }
+        t += Max(dt, g_fRampEpsilon);
+    }
+    return 0;
+}
+
+int CheckRampNDFeasibility(const std::vector<RampND>& rampndVect, FeasibilityCheckerBase* feas, DistanceCheckerBase* dist, int maxiter, const std::vector<dReal>& tol, int options)
+{
+    if( rampndVect.size() == 0 ) {
+        return 0;
+    }
+    std::vector<dReal> x, v, a, vweights;
+    rampndVect[0].GetX0Vect(x);
+    rampndVect[0].GetV0Vect(v);
+    int ret = feas->ConfigFeasible(x, v, options);
+    if( ret != 0 ) {
+        return ret;
+    }
+
+    FOREACHC(itrampnd, rampndVect) {
+        itrampnd->EvalAcc(a);
+        dReal duration = itrampnd->GetDuration();
+        dReal t = 0;
+        int iters = 0;
+        while( t < duration ) {
+            itrampnd->EvalPos(t, x);
+            itrampnd->EvalVel(t, v);
+            dReal d = dist->ObstacleDistance(x);
+            if( d <= 0 ) {
+                ret = feas->ConfigFeasible(x, v, options);
+                return ret != 0 ? ret : 0xffff; // no code
+            }
+
+            // Since the acceleration is constant, |x_i(t + dt) - x_i(t)| <= |v_i(t)|*dt + 0.5*|a_i|*dt^2. Take the
+            // largest dt for which the weighted sum of these bounds does not exceed d.
+            dist->GetDOFDisplacementWeights(x, vweights);
+            OPENRAVE_ASSERT_OP(vweights.size(), ==, x.size());
+            dReal fquad = 0, flinear = 0;
+            for (size_t idof = 0; idof < x.size(); ++idof) {
+                fquad += 0.5*vweights[idof]*Abs(a[idof]);
+                flinear += vweights[idof]*Abs(v[idof]);
+            }
+            dReal dt;
+            if( fquad > g_fRampEpsilon ) {
+                dt = 2*d/(flinear + Sqrt(flinear*flinear + 4*fquad*d));
+            }
+            else if( flinear > g_fRampEpsilon ) {
+                dt = d/flinear;
+            }
+            else {
+                dt = duration - t; // not moving
+            }
+            t += dt;
+            if( ++iters >= maxiter && t < duration ) {
+                // the obstacle distance is too small to sweep the rest of the RampND in time, so discretize it instead
+                if( tol.size() == 0 ) {
+                    return 0xffff; // no code
+                }
+                ret = CheckRampNDDiscretized(*itrampnd, t, a, feas, tol, options, x, v);
+                if( ret != 0 ) {
+                    return ret;
+                }
+                break;
+            }
+        }
+
+        itrampnd->GetX1Vect(x);
+        itrampnd->GetV1Vect(v);
+        ret = feas->ConfigFeasible(x, v, options);
+        if( ret != 0 ) {
+            return ret;
+        }
+    }
+    return 0;
 }
 
 int CheckRampNDFeasibility(const std::vector<RampND>& rampndVect, FeasibilityCheckerBase* feas, const std::vector<dReal>& tol, int options)
@@ -72,7 +160,7 @@ int RampNDFeasibilityChecker::Check(const std::vector<RampND>& rampndVect, int o
         }
     }
     if( distance ) {
-        return CheckRampNDFeasibility(rampndVect, feas, distance, maxiter, options);
+        return CheckRampNDFeasibility(rampndVect, feas, distance, maxiter, tol, options);
     }
     else {
         return CheckRampNDFeasibility(rampndVect, feas, tol, options);
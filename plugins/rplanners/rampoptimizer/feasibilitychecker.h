@@ -74,8 +74,29 @@ public:
         return g_fRampInf;
     }
     virtual dReal ObstacleDistance(const std::vector<dReal>& x)=0;
+
+    /// \brief Fills vweights[i] with an upper bound on how far any point that ObstacleDistance measures can move per
+    /// unit change of DOF i, valid along the whole swept RampND (for example the norm of the Jacobian column of the
+    /// farthest point from the joint axis).
+    ///
+    /// A displacement dx is then guaranteed to stay collision-free when sum_i vweights[i]*|dx_i| < ObstacleDistance(x).
+    /// The default weights of 1 are conservative for any ObstacleDistanceNorm.
+    virtual void GetDOFDisplacementWeights(const std::vector<dReal>& x, std::vector<dReal>& vweights)
+    {
+        vweights.resize(x.size());
+        std::fill(vweights.begin(), vweights.end(), 1);
+    }
 };
 
+/// \brief Checks the RampNDs by conservative advancement: from each configuration the largest step whose displacement
+/// bound stays within the obstacle distance is computed analytically from the velocities and accelerations of the
+/// RampND, so only a few distance queries are needed per RampND.
+///
+/// The end points of every RampND are checked with feas->ConfigFeasible using options, the interior only with
+/// dist. When a RampND needs more than maxiter distance queries, the rest of it is checked with feas->ConfigFeasible at
+/// configurations that are at most tol apart. Returns 0xffff in that case if tol is empty.
+int CheckRampNDFeasibility(const std::vector<RampND>& rampndVect, FeasibilityCheckerBase* feas, DistanceCheckerBase* dist, int maxiter, const std::vector<dReal>& tol, int options=0xffff);
+
 class RampNDFeasibilityChecker {
 public:
     RampNDFeasibilityChecker(FeasibilityCheckerBase* feas);
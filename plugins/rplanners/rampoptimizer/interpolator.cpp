@@ -84,7 +84,7 @@ bool ParabolicInterpolator::ComputeZeroVelNDTrajectory(const std::vector<dReal>&
     }
     if( !(vMin < g_fRampInf && aMin < g_fRampInf) ) {
         // Displacements are zero.
-        rampndVectOut.resize(1);
+        _ResizeRampNDVect(rampndVectOut, 1);
         rampndVectOut[0].Initialize(_ndof);
         rampndVectOut[0].SetConstant(x0Vect, 0);
         return true;
@@ -97,9 +97,7 @@ bool ParabolicInterpolator::ComputeZeroVelNDTrajectory(const std::vector<dReal>&
 
     // Map the computed sd profile to joint velocity profiles
     if( _cacheCurve.GetRamps().size() == 2 ) {
-        if( rampndVectOut.size() != 2 ) {
-            rampndVectOut.resize(2);
-        }
+        _ResizeRampNDVect(rampndVectOut, 2);
         // Initialize and fill rampnd._data with zeros
         rampndVectOut[0].Initialize(_ndof);
         rampndVectOut[1].Initialize(_ndof);
@@ -130,9 +128,7 @@ bool ParabolicInterpolator::ComputeZeroVelNDTrajectory(const std::vector<dReal>&
         rampndVectOut[1].SetAVect(aVect);
     }
     else {
-        if( rampndVectOut.size() != 3 ) {
-            rampndVectOut.resize(3);
-        }
+        _ResizeRampNDVect(rampndVectOut, 3);
         // Initialize and fill rampnd._data with zeros
         rampndVectOut[0].Initialize(_ndof);
         rampndVectOut[1].Initialize(_ndof);
@@ -301,7 +297,7 @@ bool ParabolicInterpolator::_RecomputeNDTrajectoryFixedDuration(std::vector<Para
             break;
         }
         // Store the result back in the input curvesVect
-        curvesVect[idof] = _cacheCurve;
+        curvesVect[idof].Swap(_cacheCurve); // no copy needed since _cacheCurve is re-initialized before every use
     }
 
     if( !bSuccess ) {
@@ -328,7 +324,7 @@ bool ParabolicInterpolator::_RecomputeNDTrajectoryFixedDuration(std::vector<Para
                 break;
             }
             // Store the result back in the input curvesVect
-            curvesVect[idof] = _cacheCurve;
+            curvesVect[idof].Swap(_cacheCurve);
         }
         if( !bSuccess ) {
             RAVELOG_VERBOSE_FORMAT("env=%d, Failed for joint %d. Info: x0=%.15e; x1=%.15e; v0=%.15e; v1=%.15e; duration=%.15e; vm=%.15e; am=%.15e", _envid%iFailingDOF%curvesVect[iFailingDOF].GetX0()%curvesVect[iFailingDOF].GetX1()%curvesVect[iFailingDOF].GetV0()%curvesVect[iFailingDOF].GetV1()%newDuration%vmVect[iFailingDOF]%amVect[iFailingDOF]);
@@ -391,7 +387,7 @@ bool ParabolicInterpolator::ComputeNDTrajectoryFixedDuration(const std::vector<d
             return false;
         }
 
-        _cacheCurvesVect[idof] = _cacheCurve;
+        _cacheCurvesVect[idof].Swap(_cacheCurve);
     }
 
     //RAVELOG_VERBOSE("Successfully computed ND trajectory with joint limits and fixed duration");
@@ -1588,7 +1584,7 @@ void ParabolicInterpolator::_ConvertParabolicCurvesToRampNDs(const std::vector<P
         }
     }
 
-    rampndVectOut.resize(switchpointsList.size() - 1);
+    _ResizeRampNDVect(rampndVectOut, switchpointsList.size() - 1);
     std::vector<dReal>& x0Vect = _cacheX0Vect, &x1Vect = _cacheX1Vect, &v0Vect = _cacheV0Vect, &v1Vect = _cacheV1Vect, &aVect = _cacheAVect;
     for (size_t jdof = 0; jdof < _ndof; ++jdof) {
         x0Vect[jdof] = curvesVectIn[jdof].GetX0();
@@ -1625,6 +1621,26 @@ void ParabolicInterpolator::_ConvertParabolicCurvesToRampNDs(const std::vector<P
     }
 }
 
+void ParabolicInterpolator::_ResizeRampNDVect(std::vector<RampND>& rampndVect, size_t newSize)
+{
+    size_t oldSize = rampndVect.size();
+    if( newSize < oldSize ) {
+        // Keep the data of the removed RampNDs so that the next call does not need to reallocate.
+        for (size_t irampnd = newSize; irampnd < oldSize; ++irampnd) {
+            _cacheRampNDPool.push_back(RampND());
+            _cacheRampNDPool.back().Swap(rampndVect[irampnd]);
+        }
+        rampndVect.resize(newSize);
+    }
+    else if( newSize > oldSize ) {
+        rampndVect.resize(newSize);
+        for (size_t irampnd = oldSize; irampnd < newSize && _cacheRampNDPool.size() > 0; ++irampnd) {
+            rampndVect[irampnd].Swap(_cacheRampNDPool.back());
+            _cacheRampNDPool.pop_back();
+        }
+    }
+}
+
 } // end namespace RampOptimizerInternal
 
 } // end namespace OpenRAVE
@@ -168,6 +168,13 @@ public:
      */
     void _ConvertParabolicCurvesToRampNDs(const std::vector<ParabolicCurve>& curvesVectIn, std::vector<RampND>& rampndVectOut, const std::vector<dReal>& amVect=std::vector<dReal>());
 
+    /**
+       \brief Resize rampndVect to newSize. The data of RampNDs removed from rampndVect is kept in a
+       pool and given to RampNDs added later, so that repeated interpolation into the same output
+       vectors does not allocate once the pool has warmed up.
+     */
+    void _ResizeRampNDVect(std::vector<RampND>& rampndVect, size_t newSize);
+
     inline dReal SolveBrakeTime(dReal x, dReal v, dReal xbound) {
         dReal bt;
         bool res = SafeEqSolve(v, 2*(xbound - x), g_fRampEpsilon, 0, g_fRampInf, bt);
@@ -202,6 +209,7 @@ private:
     std::vector<Ramp> _cacheRampsVect2; // for using in Compute1DTrajectoryFixedDuration
     ParabolicCurve _cacheCurve;
     std::vector<ParabolicCurve> _cacheCurvesVect;
+    std::vector<RampND> _cacheRampNDPool; ///< RampNDs with allocated data removed from output vectors, see _ResizeRampNDVect
 };
 
 } // end namespace RampOptimizerInternal
@@ -831,6 +831,14 @@ void RampND::SetInitialPosition(const std::vector<dReal>& xVect)
     return;
 }
 
+void RampND::Swap(RampND& anotherRampND)
+{
+    _data.swap(anotherRampND._data);
+    std::swap(_ndof, anotherRampND._ndof);
+    std::swap(_duration, anotherRampND._duration);
+    std::swap(constraintChecked, anotherRampND.constraintChecked);
+}
+
 void RampND::Cut(dReal t, RampND& remRampND)
 {
     if( remRampND._ndof != _ndof ) {
@@ -290,6 +290,9 @@ public:
     /// \brief Cut the rampnd into two halves at time t and keep the left half.
     void TrimBack(dReal t);
 
+    /// \brief Swap the contents of this rampnd with anotherRampND without reallocating the data.
+    void Swap(RampND& anotherRampND);
+
     inline size_t GetDOF() const
     {
         return _ndof;
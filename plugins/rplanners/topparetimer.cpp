@@ -0,0 +1,563 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 OpenRAVE contributors
+//
+// This program is free software: you can redistribute it and/or modify it under the terms of the
+// GNU Lesser General Public License as published by the Free Software Foundation, either version 3
+// of the License, or at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without
+// even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License along with this program.
+// If not, see <http://www.gnu.org/licenses/>.
+#include "openraveplugindefs.h"
+#include <openrave/planningutils.h>
+
+namespace rplanners {
+
+/** \brief Time-optimal path parameterization by reachability analysis (TOPP-RA).
+
+    The path is discretized along its path parameter s. At every grid point the joint velocity, joint acceleration,
+    manipulator speed, and joint torque limits are linear in the path acceleration u = s'' and the squared path velocity x = s'^2.
+    A backward pass computes the interval of x from which the end of the path can still be reached (the controllable set)
+    with one two-variable LP per grid point, and a forward pass picks the largest u that stays inside the controllable sets.
+    Both passes are linear in the number of grid points and nothing is retried. The LP is solved by vertex enumeration,
+    which is cubic in the number of constraints per grid point, see _ComputeControllableSet.
+ */
+class TOPPRATrajectoryRetimer : public PlannerBase
+{
+    /// \brief constraint alpha*u + beta*x <= gamma
+    struct PathConstraint
+    {
+        PathConstraint() : alpha(0), beta(0), gamma(0) {
+        }
+        PathConstraint(dReal alpha, dReal beta, dReal gamma) : alpha(alpha), beta(beta), gamma(gamma) {
+        }
+        dReal alpha, beta, gamma;
+    };
+
+public:
+    TOPPRATrajectoryRetimer(EnvironmentBasePtr penv, std::istream& sinput) : PlannerBase(penv)
+    {
+        __description = "Time-optimal retiming of a path with joint velocity, acceleration, and torque limits using reachability analysis (TOPP-RA). \
+If the trajectory is already timed, its geometric path is kept and only re-parameterized. Otherwise the waypoints are connected by straight lines and the robot stops at every corner. \
+The output uses cubic interpolation with one waypoint per grid point.";
+        RegisterCommand("SetNumGridPoints",boost::bind(&TOPPRATrajectoryRetimer::_SetNumGridPointsCommand,this,_1,_2),
+                        "Sets the number of grid intervals the path is discretized into, default is 100.");
+        RegisterCommand("SetTorqueLimitMode",boost::bind(&TOPPRATrajectoryRetimer::_SetTorqueLimitModeCommand,this,_1,_2),
+                        "Sets the torque limits to check: ignore, nominal (default), or instantaneous.");
+        _nNumGridPoints = 100;
+        _torquelimitmode = DC_NominalTorque;
+    }
+
+    virtual bool InitPlan(RobotBasePtr pbase, PlannerParametersConstPtr params)
+    {
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        _parameters.reset(new ConstraintTrajectoryTimingParameters());
+        _parameters->copy(params);
+        return _InitPlan();
+    }
+
+    virtual bool InitPlan(RobotBasePtr pbase, std::istream& isParameters)
+    {
+        EnvironmentMutex::scoped_lock lock(GetEnv()->GetMutex());
+        _parameters.reset(new ConstraintTrajectoryTimingParameters());
+        isParameters >> *_parameters;
+        return _InitPlan();
+    }
+
+    bool _InitPlan()
+    {
+        if( (int)_parameters->_vConfigVelocityLimit.size() != _parameters->GetDOF() || (int)_parameters->_vConfigAccelerationLimit.size() != _parameters->GetDOF() ) {
+            RAVELOG_WARN_FORMAT("env=%d, velocity and acceleration limits do not match the dof %d", GetEnv()->GetId()%_parameters->GetDOF());
+            return false;
+        }
+        _pmanip.reset();
+        if( _parameters->manipname.size() > 0 && _parameters->maxmanipspeed > 0 ) {
+            std::vector<KinBodyPtr> vusedbodies;
+            _parameters->_configurationspecification.ExtractUsedBodies(GetEnv(), vusedbodies);
+            FOREACH(itbody, vusedbodies) {
+                if( (*itbody)->IsRobot() ) {
+                    _pmanip = RaveInterfaceCast<RobotBase>(*itbody)->GetManipulator(_parameters->manipname);
+                    if( !!_pmanip ) {
+                        break;
+                    }
+                }
+            }
+            if( !_pmanip ) {
+                RAVELOG_WARN_FORMAT("env=%d, could not find manipulator %s", GetEnv()->GetId()%_parameters->manipname);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    virtual PlannerParametersConstPtr GetParameters() const {
+        return _parameters;
+    }
+
+    virtual PlannerStatus PlanPath(TrajectoryBasePtr ptraj, int planningoptions) override
+    {
+        BOOST_ASSERT(!!_parameters && !!ptraj && ptraj->GetEnv()==GetEnv());
+        if( ptraj->GetNumWaypoints() == 0 ) {
+            std::string description = str(boost::format("env=%d, there's nothing to retime")%GetEnv()->GetId());
+            return OPENRAVE_PLANNER_STATUS(description, PS_Failed);
+        }
+
+        uint32_t basetime = utils::GetMilliTime();
+        PlannerParameters::StateSaver savestate(_parameters);
+        std::string description;
+        if( !_InitializePath(ptraj, description) || !_ComputeConstraints(description) ) {
+            RAVELOG_WARN(description);
+            return OPENRAVE_PLANNER_STATUS(description, PS_Failed);
+        }
+
+        const int numgrid = (int)_vgrid.size();
+        const int ndof = _parameters->GetDOF();
+        // backward pass, the path ends at rest
+        _vxmin.resize(numgrid);
+        _vxmax.resize(numgrid);
+        _vxmin.back() = 0;
+        _vxmax.back() = 0;
+        for(int igrid = numgrid-2; igrid >= 0; --igrid) {
+            if( !_ComputeControllableSet(igrid, _vxmin[igrid+1], _vxmax[igrid+1], _vxmin[igrid], _vxmax[igrid]) ) {
+                description = str(boost::format("env=%d, path is not controllable at s=%.15e (grid %d/%d), the constraints cannot be met")%GetEnv()->GetId()%_vgrid[igrid]%igrid%numgrid);
+                RAVELOG_WARN(description);
+                return OPENRAVE_PLANNER_STATUS(description, PS_Failed);
+            }
+        }
+        if( _vxmin[0] > g_fEpsilonLinear ) {
+            description = str(boost::format("env=%d, path cannot start at rest, min squared path velocity is %.15e")%GetEnv()->GetId()%_vxmin[0]);
+            RAVELOG_WARN(description);
+            return OPENRAVE_PLANNER_STATUS(description, PS_Failed);
+        }
+
+        // forward pass, greedily take the max path acceleration that stays inside the controllable sets
+        _vx.resize(numgrid);
+        _vx[0] = 0;
+        for(int igrid = 0; igrid+1 < numgrid; ++igrid) {
+            dReal ds = _vgrid[igrid+1] - _vgrid[igrid];
+            dReal ulower = (_vxmin[igrid+1] - _vx[igrid])/(2*ds), uupper = (_vxmax[igrid+1] - _vx[igrid])/(2*ds);
+            for(int iconstraint = _vconstraintoffsets[igrid]; iconstraint < _vconstraintoffsets[igrid+1]; ++iconstraint) {
+                const PathConstraint& c = _vconstraints[iconstraint];
+                dReal rhs = c.gamma - c.beta*_vx[igrid];
+                if( c.alpha > g_fEpsilon ) {
+                    uupper = min(uupper, rhs/c.alpha);
+                }
+                else if( c.alpha < -g_fEpsilon ) {
+                    ulower = max(ulower, rhs/c.alpha);
+                }
+            }
+            if( ulower > uupper + 1e-7*(1+RaveFabs(uupper)) ) {
+                description = str(boost::format("env=%d, no feasible path acceleration at s=%.15e (grid %d/%d), %.15e > %.15e")%GetEnv()->GetId()%_vgrid[igrid]%igrid%numgrid%ulower%uupper);
+                RAVELOG_WARN(description);
+                return OPENRAVE_PLANNER_STATUS(description, PS_Failed);
+            }
+            dReal u = max(ulower, uupper);
+            _vx[igrid+1] = max(dReal(0), min(_vxmax[igrid+1], _vx[igrid] + 2*ds*u));
+        }
+
+        // write the trajectory
+        ConfigurationSpecification velspec = _parameters->_configurationspecification.ConvertToVelocitySpecification();
+        ConfigurationSpecification newspec = _parameters->_configurationspecification;
+        newspec.AddDerivativeGroups(1,false);
+        newspec.AddDeltaTimeGroup();
+        int timeoffset = -1;
+        FOREACH(itgroup, newspec._vgroups) {
+            if( itgroup->name == "deltatime" ) {
+                timeoffset = itgroup->offset;
+            }
+            else if( _parameters->_configurationspecification.FindCompatibleGroup(*itgroup, true) != _parameters->_configurationspecification._vgroups.end() ) {
+                itgroup->interpolation = "cubic";
+            }
+            else if( velspec.FindCompatibleGroup(*itgroup, true) != velspec._vgroups.end() ) {
+                itgroup->interpolation = "quadratic";
+            }
+        }
+
+        _vtempvelocities.resize(numgrid*ndof);
+        for(int igrid = 0; igrid < numgrid; ++igrid) {
+            dReal sd = RaveSqrt(_vx[igrid]);
+            for(int idof = 0; idof < ndof; ++idof) {
+                _vtempvelocities[igrid*ndof+idof] = _vpathderiv[igrid*ndof+idof]*sd;
+            }
+        }
+        _vtempdata.resize(numgrid*newspec.GetDOF());
+        ConfigurationSpecification::ConvertData(_vtempdata.begin(), newspec, _vpathpos.begin(), _parameters->_configurationspecification, numgrid, GetEnv(), true);
+        ConfigurationSpecification::ConvertData(_vtempdata.begin(), newspec, _vtempvelocities.begin(), velspec, numgrid, GetEnv(), false);
+        _vtempdata[timeoffset] = 0;
+        for(int igrid = 1; igrid < numgrid; ++igrid) {
+            dReal denom = RaveSqrt(_vx[igrid-1]) + RaveSqrt(_vx[igrid]);
+            if( denom <= g_fEpsilon ) {
+                description = str(boost::format("env=%d, path velocity is zero on both sides of grid interval %d/%d")%GetEnv()->GetId()%igrid%numgrid);
+                RAVELOG_WARN(description);
+                return OPENRAVE_PLANNER_STATUS(description, PS_Failed);
+            }
+            _vtempdata[igrid*newspec.GetDOF()+timeoffset] = 2*(_vgrid[igrid]-_vgrid[igrid-1])/denom;
+        }
+
+        ptraj->Init(newspec);
+        ptraj->Insert(0, _vtempdata);
+        RAVELOG_DEBUG_FORMAT("env=%d, retimed path with %d grid points to duration %.15e in %dms", GetEnv()->GetId()%numgrid%ptraj->GetDuration()%(utils::GetMilliTime()-basetime));
+        return OPENRAVE_PLANNER_STATUS(PS_HasSolution);
+    }
+
+protected:
+    /// \brief discretizes the path of ptraj into _vgrid, _vpathpos, _vpathderiv (dq/ds), _vpathderiv2 (d^2q/ds^2), and _vstopgrid
+    bool _InitializePath(TrajectoryBasePtr ptraj, std::string& description)
+    {
+        const ConfigurationSpecification& posspec = _parameters->_configurationspecification;
+        ConfigurationSpecification velspec = posspec.ConvertToVelocitySpecification();
+        const int ndof = _parameters->GetDOF();
+        bool btimed = ptraj->GetDuration() > 0 && ptraj->GetNumWaypoints() > 1;
+        FOREACHC(itgroup, velspec._vgroups) {
+            if( ptraj->GetConfigurationSpecification().FindCompatibleGroup(*itgroup, true) == ptraj->GetConfigurationSpecification()._vgroups.end() ) {
+                btimed = false;
+            }
+        }
+
+        _vgrid.resize(0);
+        _vpathpos.resize(0);
+        _vpathderiv.resize(0);
+        _vpathderiv2.resize(0);
+        _vstopgrid.resize(0);
+        if( btimed ) {
+            // keep the geometric path of the trajectory and use its time as the path parameter
+            dReal duration = ptraj->GetDuration();
+            dReal ds = duration/_nNumGridPoints;
+            dReal h = 0.25*ds;
+            for(int igrid = 0; igrid <= _nNumGridPoints; ++igrid) {
+                dReal s = igrid < _nNumGridPoints ? igrid*ds : duration;
+                _vgrid.push_back(s);
+                ptraj->Sample(_vtempdata, s, posspec);
+                _vpathpos.insert(_vpathpos.end(), _vtempdata.begin(), _vtempdata.end());
+                ptraj->Sample(_vtempdata, s, velspec);
+                _vpathderiv.insert(_vpathderiv.end(), _vtempdata.begin(), _vtempdata.end());
+                // second derivative from the velocities around s
+                dReal s0 = max(dReal(0), s-h), s1 = min(duration, s+h);
+                ptraj->Sample(_vtempdata, s0, velspec);
+                ptraj->Sample(_vtempvelocities, s1, velspec);
+                for(int idof = 0; idof < ndof; ++idof) {
+                    _vpathderiv2.push_back((_vtempvelocities[idof]-_vtempdata[idof])/(s1-s0));
+                }
+                _vstopgrid.push_back(0);
+            }
+            return true;
+        }
+
+        // connect the waypoints with straight lines
+        size_t numpoints = ptraj->GetNumWaypoints();
+        ptraj->GetWaypoints(0, numpoints, _vtempdata, posspec);
+        std::vector<dReal> vprev(ndof), vdiff(ndof), vprevdir;
+        std::vector<dReal> vsegmentlengths;
+        std::vector< std::vector<dReal> > vsegmentdiffs;
+        std::vector<size_t> vsegmentstarts;
+        dReal ftotallength = 0;
+        for(size_t ipoint = 1; ipoint < numpoints; ++ipoint) {
+            std::copy(_vtempdata.begin()+(ipoint-1)*ndof, _vtempdata.begin()+ipoint*ndof, vprev.begin());
+            std::copy(_vtempdata.begin()+ipoint*ndof, _vtempdata.begin()+(ipoint+1)*ndof, vdiff.begin());
+            _parameters->_diffstatefn(vdiff, vprev);
+            dReal flength = 0;
+            for(int idof = 0; idof < ndof; ++idof) {
+                flength += vdiff[idof]*vdiff[idof];
+            }
+            flength = RaveSqrt(flength);
+            if( flength <= g_fEpsilonLinear ) {
+                continue;
+            }
+            vsegmentlengths.push_back(flength);
+            vsegmentdiffs.push_back(vdiff);
+            vsegmentstarts.push_back(ipoint-1);
+            ftotallength += flength;
+        }
+        if( vsegmentlengths.size() == 0 ) {
+            description = str(boost::format("env=%d, all %d waypoints are the same, nothing to retime")%GetEnv()->GetId()%numpoints);
+            return false;
+        }
+
+        // have to stop at corners since the path acceleration would be infinite there
+        std::vector<uint8_t> vsegmentstops(vsegmentlengths.size(), 1);
+        for(size_t isegment = 1; isegment < vsegmentlengths.size(); ++isegment) {
+            dReal fdot = 0;
+            for(int idof = 0; idof < ndof; ++idof) {
+                fdot += vsegmentdiffs[isegment-1][idof]*vsegmentdiffs[isegment][idof];
+            }
+            vsegmentstops[isegment] = fdot < (1-1e-10)*vsegmentlengths[isegment-1]*vsegmentlengths[isegment];
+        }
+
+        dReal s = 0;
+        for(size_t isegment = 0; isegment < vsegmentlengths.size(); ++isegment) {
+            const std::vector<dReal>& vsegmentdiff = vsegmentdiffs[isegment];
+            dReal flength = vsegmentlengths[isegment];
+            bool bstop = vsegmentstops[isegment];
+            bool bendstop = isegment+1 == vsegmentlengths.size() || vsegmentstops[isegment+1];
+            // a segment that stops at both ends needs an interior grid point, otherwise its only interval has zero path velocity on both sides
+            int numintervals = max(bstop && bendstop ? 2 : 1, (int)RaveCeil(_nNumGridPoints*flength/ftotallength));
+            vprevdir.resize(ndof);
+            for(int idof = 0; idof < ndof; ++idof) {
+                vprevdir[idof] = vsegmentdiff[idof]/flength;
+            }
+            for(int iinterval = 0; iinterval < numintervals; ++iinterval) {
+                dReal t = (dReal)iinterval/(dReal)numintervals;
+                _vgrid.push_back(s + t*flength);
+                for(int idof = 0; idof < ndof; ++idof) {
+                    _vpathpos.push_back(_vtempdata[vsegmentstarts[isegment]*ndof+idof] + t*vsegmentdiff[idof]);
+                }
+                _vpathderiv.insert(_vpathderiv.end(), vprevdir.begin(), vprevdir.end());
+                _vpathderiv2.insert(_vpathderiv2.end(), ndof, dReal(0));
+                _vstopgrid.push_back(iinterval == 0 && bstop);
+            }
+            s += flength;
+        }
+        _vgrid.push_back(s);
+        _vpathpos.insert(_vpathpos.end(), _vtempdata.begin()+(numpoints-1)*ndof, _vtempdata.begin()+numpoints*ndof);
+        _vpathderiv.insert(_vpathderiv.end(), vprevdir.begin(), vprevdir.end());
+        _vpathderiv2.insert(_vpathderiv2.end(), ndof, dReal(0));
+        _vstopgrid.push_back(1);
+        return true;
+    }
+
+    /// \brief computes _vconstraints of every grid point
+    bool _ComputeConstraints(std::string& description)
+    {
+        const int ndof = _parameters->GetDOF();
+        const int numgrid = (int)_vgrid.size();
+        const dReal fmaxvalue = 1e10; // keeps the LPs bounded
+
+        // torque limits of the bodies in the configuration space
+        std::vector<KinBodyPtr> vusedbodies;
+        std::vector< std::vector<int> > vuseddofindices(0), vusedconfigindices(0);
+        std::vector< std::vector< std::pair<int, std::pair<dReal, dReal> > > > vtorquelimits;
+        std::vector<KinBody::KinBodyStateSaverPtr> vsavers;
+        if( _torquelimitmode != DC_IgnoreTorque ) {
+            _parameters->_configurationspecification.ExtractUsedBodies(GetEnv(), vusedbodies);
+            FOREACH(itbody, vusedbodies) {
+                std::vector< std::pair<int, std::pair<dReal, dReal> > > vbodytorquelimits;
+                FOREACHC(itjoint, (*itbody)->GetJoints()) {
+                    for(int idof = 0; idof < (*itjoint)->GetDOF(); ++idof) {
+                        std::pair<dReal, dReal> torquelimits = _torquelimitmode == DC_InstantaneousTorque ? (*itjoint)->GetInstantaneousTorqueLimits(idof) : (*itjoint)->GetNominalTorqueLimits(idof);
+                        if( torquelimits.first < torquelimits.second ) {
+                            vbodytorquelimits.emplace_back((*itjoint)->GetDOFIndex()+idof, torquelimits);
+                        }
+                    }
+                }
+                vuseddofindices.push_back(std::vector<int>());
+                vusedconfigindices.push_back(std::vector<int>());
+                _parameters->_configurationspecification.ExtractUsedIndices(*itbody, vuseddofindices.back(), vusedconfigindices.back());
+                vtorquelimits.push_back(vbodytorquelimits);
+                if( vbodytorquelimits.size() > 0 ) {
+                    vsavers.push_back(KinBody::KinBodyStateSaverPtr(new KinBody::KinBodyStateSaver(*itbody, KinBody::Save_LinkTransformation|KinBody::Save_LinkVelocities)));
+                }
+            }
+        }
+        const bool bcomputestate = vsavers.size() > 0 || !!_pmanip;
+
+        std::vector<dReal> vgridxmax(numgrid, fmaxvalue);
+        std::vector<Vector> vmanippositions;
+        std::vector<dReal> vdofvelocities, vdofaccelerations;
+        boost::array< std::vector<dReal>, 3> vtorquecomponents, vinertiacomponents;
+        std::vector<dReal> vconfig(ndof);
+        _vconstraints.resize(0);
+        _vconstraintoffsets.resize(0);
+        for(int igrid = 0; igrid < numgrid; ++igrid) {
+            _vconstraintoffsets.push_back(_vconstraints.size());
+            std::vector<dReal>::const_iterator itderiv = _vpathderiv.begin()+igrid*ndof, itderiv2 = _vpathderiv2.begin()+igrid*ndof;
+            for(int idof = 0; idof < ndof; ++idof) {
+                dReal fderiv = RaveFabs(itderiv[idof]);
+                if( fderiv > g_fEpsilon ) {
+                    dReal fvel = _parameters->_vConfigVelocityLimit[idof]/fderiv;
+                    vgridxmax[igrid] = min(vgridxmax[igrid], fvel*fvel);
+                }
+                // -amax <= q' u + q'' x <= amax
+                dReal faccel = _parameters->_vConfigAccelerationLimit[idof];
+                _vconstraints.push_back(PathConstraint(itderiv[idof], itderiv2[idof], faccel));
+                _vconstraints.push_back(PathConstraint(-itderiv[idof], -itderiv2[idof], faccel));
+            }
+
+            if( bcomputestate ) {
+                std::copy(_vpathpos.begin()+igrid*ndof, _vpathpos.begin()+(igrid+1)*ndof, vconfig.begin());
+                if( _parameters->SetStateValues(vconfig, 0) != 0 ) {
+                    description = str(boost::format("env=%d, failed to set state at grid %d/%d")%GetEnv()->GetId()%igrid%numgrid);
+                    return false;
+                }
+                if( !!_pmanip ) {
+                    vmanippositions.push_back(_pmanip->GetTransform().trans);
+                }
+            }
+            for(size_t ibody = 0; ibody < vusedbodies.size(); ++ibody) {
+                if( vtorquelimits[ibody].size() == 0 ) {
+                    continue;
+                }
+                // torque = M(q) q' u + (M(q) q'' + C(q,q') q') x + G(q)
+                KinBodyPtr pbody = vusedbodies[ibody];
+                vdofvelocities.assign(pbody->GetDOF(), 0);
+                vdofaccelerations.assign(pbody->GetDOF(), 0);
+                for(size_t iused = 0; iused < vuseddofindices[ibody].size(); ++iused) {
+                    vdofvelocities.at(vuseddofindices[ibody][iused]) = itderiv[vusedconfigindices[ibody][iused]];
+                    vdofaccelerations.at(vuseddofindices[ibody][iused]) = itderiv2[vusedconfigindices[ibody][iused]];
+                }
+                pbody->SetDOFVelocities(vdofvelocities, KinBody::CLA_Nothing);
+                pbody->ComputeInverseDynamics(vtorquecomponents, vdofaccelerations);
+                pbody->ComputeInverseDynamics(vinertiacomponents, vdofvelocities);
+                FOREACHC(itlimit, vtorquelimits[ibody]) {
+                    int index = itlimit->first;
+                    dReal a = vinertiacomponents[0].at(index);
+                    dReal b = vtorquecomponents[0].at(index) + vtorquecomponents[1].at(index);
+                    dReal c = vtorquecomponents[2].at(index);
+                    _vconstraints.push_back(PathConstraint(a, b, itlimit->second.second - c));
+                    _vconstraints.push_back(PathConstraint(-a, -b, c - itlimit->second.first));
+                }
+            }
+        }
+        _vconstraintoffsets.push_back(_vconstraints.size());
+
+        if( !!_pmanip ) {
+            // speed of the manipulator is |dp/ds| s', dp/ds from the neighboring grid points
+            for(int igrid = 0; igrid < numgrid; ++igrid) {
+                int i0 = max(0, igrid-1), i1 = min(numgrid-1, igrid+1);
+                dReal ds = _vgrid[i1] - _vgrid[i0];
+                if( ds <= g_fEpsilon || _vstopgrid[igrid] ) {
+                    continue;
+                }
+                dReal fmanipderiv = RaveSqrt((vmanippositions[i1]-vmanippositions[i0]).lengthsqr3())/ds;
+                if( fmanipderiv > g_fEpsilon ) {
+                    dReal fvel = _parameters->maxmanipspeed/fmanipderiv;
+                    vgridxmax[igrid] = min(vgridxmax[igrid], fvel*fvel);
+                }
+            }
+        }
+
+        // append the bounds on x and u. the constraints of each grid point are stored contiguously, so rebuild with the bounds inserted
+        std::vector<PathConstraint> vconstraints;
+        vconstraints.reserve(_vconstraints.size() + 4*numgrid);
+        std::vector<int> vconstraintoffsets;
+        vconstraintoffsets.reserve(numgrid+1);
+        for(int igrid = 0; igrid < numgrid; ++igrid) {
+            vconstraintoffsets.push_back(vconstraints.size());
+            vconstraints.insert(vconstraints.end(), _vconstraints.begin()+_vconstraintoffsets[igrid], _vconstraints.begin()+_vconstraintoffsets[igrid+1]);
+            vconstraints.push_back(PathConstraint(0, 1, _vstopgrid[igrid] ? 0 : vgridxmax[igrid]));
+            vconstraints.push_back(PathConstraint(0, -1, 0));
+            vconstraints.push_back(PathConstraint(1, 0, fmaxvalue));
+            vconstraints.push_back(PathConstraint(-1, 0, fmaxvalue));
+        }
+        vconstraintoffsets.push_back(vconstraints.size());
+        _vconstraints.swap(vconstraints);
+        _vconstraintoffsets.swap(vconstraintoffsets);
+        return true;
+    }
+
+    /// \brief computes the interval of x at igrid from which [xnextmin, xnextmax] can be reached at igrid+1
+    ///
+    /// Solves min x and max x of the two variable LP in (u, x) by enumerating the vertices of its feasible polygon.
+    /// Every pair of the m constraints is intersected and checked against all the others, so this is O(m^3) per grid point,
+    /// where m grows linearly with the dof (velocity, acceleration, and torque limits). This is fast for arms but a
+    /// proper LP solver would be needed for bodies with many dofs.
+    bool _ComputeControllableSet(int igrid, dReal xnextmin, dReal xnextmax, dReal& xmin, dReal& xmax)
+    {
+        dReal ds = _vgrid[igrid+1] - _vgrid[igrid];
+        _vlpconstraints.resize(0);
+        _vlpconstraints.insert(_vlpconstraints.end(), _vconstraints.begin()+_vconstraintoffsets[igrid], _vconstraints.begin()+_vconstraintoffsets[igrid+1]);
+        // xnextmin <= x + 2 ds u <= xnextmax
+        _vlpconstraints.push_back(PathConstraint(2*ds, 1, xnextmax));
+        _vlpconstraints.push_back(PathConstraint(-2*ds, -1, -xnextmin));
+
+        bool bfound = false;
+        const size_t numconstraints = _vlpconstraints.size();
+        for(size_t i = 0; i < numconstraints; ++i) {
+            const PathConstraint& ci = _vlpconstraints[i];
+            for(size_t j = i+1; j < numconstraints; ++j) {
+                const PathConstraint& cj = _vlpconstraints[j];
+                dReal det = ci.alpha*cj.beta - cj.alpha*ci.beta;
+                dReal scale = RaveSqrt((ci.alpha*ci.alpha + ci.beta*ci.beta)*(cj.alpha*cj.alpha + cj.beta*cj.beta));
+                if( RaveFabs(det) <= 1e-12*scale ) {
+                    continue;
+                }
+                dReal u = (ci.gamma*cj.beta - cj.gamma*ci.beta)/det;
+                dReal x = (ci.alpha*cj.gamma - cj.alpha*ci.gamma)/det;
+                if( bfound && x >= xmin && x <= xmax ) {
+                    continue;
+                }
+                bool bfeasible = true;
+                for(size_t k = 0; k < numconstraints; ++k) {
+                    const PathConstraint& ck = _vlpconstraints[k];
+                    if( ck.alpha*u + ck.beta*x > ck.gamma + 1e-9*(1+RaveFabs(ck.gamma)) ) {
+                        bfeasible = false;
+                        break;
+                    }
+                }
+                if( !bfeasible ) {
+                    continue;
+                }
+                if( !bfound ) {
+                    xmin = xmax = x;
+                    bfound = true;
+                }
+                else {
+                    xmin = min(xmin, x);
+                    xmax = max(xmax, x);
+                }
+            }
+        }
+        if( bfound ) {
+            xmin = max(dReal(0), xmin);
+            xmax = max(xmin, xmax);
+        }
+        return bfound;
+    }
+
+    bool _SetNumGridPointsCommand(std::ostream& sout, std::istream& sinput)
+    {
+        int numgridpoints = 0;
+        sinput >> numgridpoints;
+        if( !sinput || numgridpoints < 1 ) {
+            return false;
+        }
+        _nNumGridPoints = numgridpoints;
+        return true;
+    }
+
+    bool _SetTorqueLimitModeCommand(std::ostream& sout, std::istream& sinput)
+    {
+        std::string mode;
+        sinput >> mode;
+        if( mode == "ignore" ) {
+            _torquelimitmode = DC_IgnoreTorque;
+        }
+        else if( mode == "nominal" ) {
+            _torquelimitmode = DC_NominalTorque;
+        }
+        else if( mode == "instantaneous" ) {
+            _torquelimitmode = DC_InstantaneousTorque;
+        }
+        else {
+            RAVELOG_WARN_FORMAT("env=%d, unknown torque limit mode '%s'", GetEnv()->GetId()%mode);
+            return false;
+        }
+        return true;
+    }
+
+    ConstraintTrajectoryTimingParametersPtr _parameters;
+    RobotBase::ManipulatorPtr _pmanip; ///< set if the manipulator speed is constrained
+    int _nNumGridPoints; ///< number of grid intervals of the path
+    DynamicsConstraintsType _torquelimitmode;
+
+    std::vector<dReal> _vgrid; ///< path parameter of every grid point
+    std::vector<dReal> _vpathpos, _vpathderiv, _vpathderiv2; ///< q, dq/ds, d^2q/ds^2 at every grid point
+    std::vector<uint8_t> _vstopgrid; ///< 1 if the path velocity has to be 0 at the grid point
+    std::vector<PathConstraint> _vconstraints; ///< constraints of all grid points
+    std::vector<int> _vconstraintoffsets; ///< the constraints of grid point i are [_vconstraintoffsets[i], _vconstraintoffsets[i+1])
+    std::vector<dReal> _vxmin, _vxmax; ///< controllable sets of the squared path velocity
+    std::vector<dReal> _vx; ///< squared path velocity of the parameterization
+
+    // cache
+    std::vector<PathConstraint> _vlpconstraints;
+    std::vector<dReal> _vtempdata, _vtempvelocities;
+};
+
+PlannerBasePtr CreateTOPPRATrajectoryRetimer(EnvironmentBasePtr penv, std::istream& sinput)
+{
+    return PlannerBasePtr(new TOPPRATrajectoryRetimer(penv, sinput));
+}
+
+} // end namespace rplanners
@@ -40,8 +40,12 @@ Planner Parameters\n\
 - **TrajectoryBasePtr workspacetraj** - workspace trajectory of the end effector, needs to hold 'ikparam_values' groups\n\
 \n\
 ";
+        RegisterCommand("SetWarmStart",boost::bind(&WorkspaceTrajectoryTracker::_SetWarmStartCommand,this,_1,_2),
+                        "Format: SetWarmStart enable [maxiterations]. If enabled, every step is first solved with a damped least-squares solver started from the previous solution, and the ik solver is only called if that fails to converge within maxiterations (default 10) or the solution is rejected.");
         _report.reset(new CollisionReport());
         _filteroptions = 0;
+        _bWarmStart = false;
+        _nWarmStartMaxIterations = 10;
     }
     virtual ~WorkspaceTrajectoryTracker() {
     }
@@ -244,10 +248,15 @@ Planner Parameters\n\
         list<Transform>::iterator ittrans = listtransforms.begin();
         bPrevInCollision = true;
         ftime = 0;
+        int nwarmstarted = 0;
         for(; ittrans != listtransforms.end(); ftime += _parameters->_fStepLength, ++ittrans) {
             _filteroptions = (ftime >= fstarttime) ? IKFO_CheckEnvCollisions : 0;
             IkParameterization ikparam(*ittrans,IKP_Transform6D);
-            if( !_manip->FindIKSolution(ikparam,vsolution,_filteroptions) ) {
+            if( _bWarmStart && _FindWarmStartedSolution(ikparam,vsolution) ) {
+                ++nwarmstarted;
+                bPrevInCollision = false;
+            }
+            else if( !_manip->FindIKSolution(ikparam,vsolution,_filteroptions) ) {
                 if( _filteroptions == 0 ) {
                     // haven't even checked with environment collisions, so a solution really doesn't exist
                     return PlannerStatus(PS_Failed);
@@ -289,7 +298,7 @@ Planner Parameters\n\
             return PlannerStatus(PS_Failed);
         }
 
-        RAVELOG_DEBUG(str(boost::format("workspace trajectory tracker plan success, path=%d points, traj time=%e computed in %fs\n")%poutputtraj->GetNumWaypoints()%poutputtraj->GetDuration()%((0.001f*(float)(utils::GetMilliTime()-basetime)))));
+        RAVELOG_DEBUG(str(boost::format("workspace trajectory tracker plan success, path=%d points (%d warm started), traj time=%e computed in %fs\n")%poutputtraj->GetNumWaypoints()%nwarmstarted%poutputtraj->GetDuration()%((0.001f*(float)(utils::GetMilliTime()-basetime)))));
         return PlannerStatus(PS_HasSolution);
     }
 
@@ -298,6 +307,125 @@ Planner Parameters\n\
     }
 
 protected:
+    bool _SetWarmStartCommand(std::ostream& sout, std::istream& sinput)
+    {
+        bool bwarmstart = false;
+        sinput >> bwarmstart;
+        if( !sinput ) {
+            return false;
+        }
+        _bWarmStart = bwarmstart;
+        int maxiterations = 0;
+        sinput >> maxiterations;
+        if( !!sinput && maxiterations > 0 ) {
+            _nWarmStartMaxIterations = maxiterations;
+        }
+        return true;
+    }
+
+    /// \brief solves ikparam locally starting from the previous solution and validates it like the ik filter would.
+    ///
+    /// The robot state is restored if no solution is found so that the ik solver can be called afterwards.
+    bool _FindWarmStartedSolution(const IkParameterization& ikparam, std::vector<dReal>& vsolution)
+    {
+        if( (int)_vprevsolution.size() != _parameters->GetDOF() ) {
+            return false;
+        }
+        {
+            RobotBase::RobotStateSaver saver(_robot);
+            if( !_SolveLocalIK(ikparam.GetTransform6D(), vsolution) ) {
+                return false;
+            }
+            // the ik solver checks self collisions even without any filter options
+            if( !(_filteroptions & IKFO_CheckEnvCollisions) && _robot->CheckSelfCollision() ) {
+                return false;
+            }
+        }
+        // _ValidateSolution expects the ik parameterization in the manipulator base frame like the ik filter gets it
+        return _ValidateSolution(vsolution, _manip, _tbaseinv*ikparam) == IKRA_Success;
+    }
+
+    /// \brief damped least-squares iterations from _vprevsolution towards tgoal, the joint values are kept in the limits.
+    bool _SolveLocalIK(const Transform& tgoal, std::vector<dReal>& vsolution)
+    {
+        const size_t ndof = _vprevsolution.size();
+        const dReal ftolerance2 = 1e-12; // squared tolerance on the translation and rotation error
+        const dReal fdamping2 = 1e-6; // keeps the steps bounded close to singularities
+        vsolution = _vprevsolution;
+        boost::array<dReal,6> verror;
+        boost::array<dReal,36> mjjt;
+        // the error is evaluated once more after the last step so that a step that converges is not thrown away
+        for(int iter = 0; ; ++iter) {
+            if( _parameters->SetStateValues(vsolution) != 0 ) {
+                return false;
+            }
+            Transform tcur = _manip->GetTransform();
+            Vector vtranserror = tgoal.trans - tcur.trans;
+            Vector vroterror = axisAngleFromQuat(quatMultiply(tgoal.rot, quatInverse(tcur.rot)));
+            if( vtranserror.lengthsqr3() <= ftolerance2 && vroterror.lengthsqr3() <= ftolerance2 ) {
+                return true;
+            }
+            if( iter >= _nWarmStartMaxIterations ) {
+                return false;
+            }
+            verror[0] = vtranserror.x; verror[1] = vtranserror.y; verror[2] = vtranserror.z;
+            verror[3] = vroterror.x; verror[4] = vroterror.y; verror[5] = vroterror.z;
+
+            _manip->CalculateJacobian(_vlocaljacobian);
+            _manip->CalculateAngularVelocityJacobian(_vlocalrotjacobian);
+            _vlocaljacobian.insert(_vlocaljacobian.end(), _vlocalrotjacobian.begin(), _vlocalrotjacobian.end());
+
+            // solve (J J^T + damping I) y = error with a Cholesky decomposition, the step is J^T y
+            for(int i = 0; i < 6; ++i) {
+                for(int j = 0; j <= i; ++j) {
+                    dReal f = 0;
+                    for(size_t k = 0; k < ndof; ++k) {
+                        f += _vlocaljacobian[i*ndof+k]*_vlocaljacobian[j*ndof+k];
+                    }
+                    mjjt[i*6+j] = f;
+                }
+                mjjt[i*6+i] += fdamping2;
+            }
+            for(int i = 0; i < 6; ++i) {
+                for(int j = 0; j <= i; ++j) {
+                    dReal f = mjjt[i*6+j];
+                    for(int k = 0; k < j; ++k) {
+                        f -= mjjt[i*6+k]*mjjt[j*6+k];
+                    }
+                    if( i == j ) {
+                        if( f <= 0 ) {
+                            return false;
+                        }
+                        mjjt[i*6+i] = RaveSqrt(f);
+                    }
+                    else {
+                        mjjt[i*6+j] = f/mjjt[j*6+j];
+                    }
+                }
+            }
+            for(int i = 0; i < 6; ++i) {
+                for(int k = 0; k < i; ++k) {
+                    verror[i] -= mjjt[i*6+k]*verror[k];
+                }
+                verror[i] /= mjjt[i*6+i];
+            }
+            for(int i = 5; i >= 0; --i) {
+                for(int k = i+1; k < 6; ++k) {
+                    verror[i] -= mjjt[k*6+i]*verror[k];
+                }
+                verror[i] /= mjjt[i*6+i];
+            }
+
+            for(size_t k = 0; k < ndof; ++k) {
+                dReal fstep = 0;
+                for(int i = 0; i < 6; ++i) {
+                    fstep += _vlocaljacobian[i*ndof+k]*verror[i];
+                }
+                vsolution[k] = max(_parameters->_vConfigLowerLimit.at(k), min(_parameters->_vConfigUpperLimit.at(k), vsolution[k] + fstep));
+            }
+        }
+    }
+
     void _SetPreviousSolution(const std::vector<dReal>& vsolution, bool bsetjacobian=true)
     {
         if( bsetjacobian ) {
@@ -331,14 +459,19 @@ protected:
         // check if continuous with previous solution using the jacobian
         if( _mjacobian.num_elements() > 0 ) {
             BOOST_ASSERT(ikp.GetType()==IKP_Transform6D);
+            // predict the translation and rotation deltas of the solution in one pass
             Vector expecteddeltatrans = ikp.GetTransform6D().trans - _ikprev.GetTransform6D().trans;
-            Vector jdeltatrans;
+            Vector jdeltatrans, jdeltaquat;
             dReal solutiondiff = 0;
             for(size_t j = 0; j < vsolution.size(); ++j) {
                 dReal d = vsolution[j]-_vprevsolution.at(j);
                 jdeltatrans.x += _mjacobian[0][j]*d;
                 jdeltatrans.y += _mjacobian[1][j]*d;
                 jdeltatrans.z += _mjacobian[2][j]*d;
+                jdeltaquat.x += _mquatjacobian[0][j]*d;
+                jdeltaquat.y += _mquatjacobian[1][j]*d;
+                jdeltaquat.z += _mquatjacobian[2][j]*d;
+                jdeltaquat.w += _mquatjacobian[3][j]*d;
                 solutiondiff += d*d;
             }
             dReal transangle = expecteddeltatrans.dot3(jdeltatrans);
@@ -353,16 +486,6 @@ protected:
 
             // constrain rotations
             Vector expecteddeltaquat = ikp.GetTransform6D().rot - _ikprev.GetTransform6D().rot;
-            Vector jdeltaquat;
-            solutiondiff = 0;
-            for(size_t j = 0; j < vsolution.size(); ++j) {
-                dReal d = vsolution[j]-_vprevsolution.at(j);
-                jdeltaquat.x += _mquatjacobian[0][j]*d;
-                jdeltaquat.y += _mquatjacobian[1][j]*d;
-                jdeltaquat.z += _mquatjacobian[2][j]*d;
-                jdeltaquat.w += _mquatjacobian[3][j]*d;
-                solutiondiff += d*d;
-            }
             dReal quatangle = expecteddeltaquat.dot(jdeltaquat);
             dReal expecteddeltaquat_len = expecteddeltaquat.lengthsqr4();
             dReal jdeltaquat_len = jdeltaquat.lengthsqr4();
@@ -384,7 +507,8 @@ protected:
 
         if( _vprevsolution.size() > 0 ) {
             // take the midpoint of the solutions and ikparameterization and see if they are close
-            std::vector<dReal> vmidsolution(vsolution.size());
+            std::vector<dReal>& vmidsolution = _vmidsolution;
+            vmidsolution.resize(vsolution.size());
             for(size_t i = 0; i < vsolution.size(); ++i) {
                 vmidsolution[i] = 0.5*(vsolution[i]+_vprevsolution[i]);
             }
@@ -435,6 +559,12 @@ protected:
     IkParameterization _ikprev;
     vector<dReal> _vprevsolution;
     PlannerBasePtr _retimerplanner;
+
+    bool _bWarmStart; ///< if true, solve each step locally from the previous solution before calling the ik solver
+    int _nWarmStartMaxIterations;
+
+    // cache
+    vector<dReal> _vlocaljacobian, _vlocalrotjacobian, _vmidsolution;
 };
 
 PlannerBasePtr CreateWorkspaceTrajectoryTracker(EnvironmentBasePtr penv, std::istream& sinput) {
@@ -329,6 +329,10 @@ public:
     py::object GetAdjacentLinks() const;
     py::object GetManageData() const;
     int GetUpdateStamp() const;
+    py::object RegisterChangeCallback(uint32_t properties, py::object fncallback) const;
+    py::object RegisterChangeSetCallback(uint32_t properties, py::object fncallback) const;
+    void BeginChangeBatch();
+    void CommitChangeBatch();
     std::string serialize(int options) const;
     std::string GetKinematicsGeometryHash() const;
     PyStateRestoreContextBase* CreateKinBodyStateSaver(py::object options=py::none_());
@@ -139,6 +139,8 @@ public:
 
         object FindIKSolutions(object oparam, object freeparams, int filteroptions, bool ikreturn=false, bool releasegil=false) const;
 
+        object FindIKSolutionsBatch(object oparams, int filteroptions, bool releasegil=false) const;
+
         object GetIkParameterization(object oparam, bool inworld=true);
 
         object GetChildJoints();
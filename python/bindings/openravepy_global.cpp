@@ -21,6 +21,7 @@
 #include <openravepy/openravepy_configurationspecification.h>
 #include <openrave/xmlreaders.h>
 #include <openrave/utils.h>
+#include <openrave/environmentstatediff.h>
 
 namespace openravepy {
 
@@ -144,6 +145,57 @@ object toPyReadable(ReadablePtr p) {
     return py::to_object(PyReadablePtr(new PyReadable(p)));
 }
 
+/// \brief returns binary data as python bytes
+static object toPyBytes(const std::vector<uint8_t>& vdata)
+{
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    return py::bytes(reinterpret_cast<const char*>(vdata.data()), vdata.size());
+#else
+    return py::to_object(py::handle<>(PyBytes_FromStringAndSize(reinterpret_cast<const char*>(vdata.data()), vdata.size())));
+#endif
+}
+
+class PyEnvironmentStateDiffWriter
+{
+public:
+    PyEnvironmentStateDiffWriter(object pyenv) : _writer(openravepy::GetEnvironment(pyenv)) {
+    }
+
+    object WriteDiff() {
+        std::vector<uint8_t> vdata;
+        {
+            openravepy::PythonThreadSaver threadsaver;
+            _writer.WriteDiff(vdata);
+        }
+        return toPyBytes(vdata);
+    }
+
+    void Reset() {
+        _writer.Reset();
+    }
+
+    uint32_t GetNextSequence() const {
+        return _writer.GetNextSequence();
+    }
+
+private:
+    EnvironmentStateDiffWriter _writer;
+};
+
+class PyEnvironmentStateDiffApplier
+{
+public:
+    PyEnvironmentStateDiffApplier(object pyenv) : _applier(openravepy::GetEnvironment(pyenv)) {
+    }
+
+    int ApplyDiff(const std::string& data) {
+        openravepy::PythonThreadSaver threadsaver;
+        return _applier.ApplyDiff(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+    }
+
+private:
+    EnvironmentStateDiffApplier _applier;
+};
 
 class PyStringReaderStaticClass
 {
@@ -1672,6 +1724,29 @@ void init_openravepy_global()
     .def_readonly("version",&PyPluginInfo::version)
     ;
 
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    class_<PyEnvironmentStateDiffWriter, OPENRAVE_SHARED_PTR<PyEnvironmentStateDiffWriter> >(m, "EnvironmentStateDiffWriter", DOXY_CLASS(EnvironmentStateDiffWriter))
+    .def(init<object>(), "env"_a)
+#else
+    class_<PyEnvironmentStateDiffWriter, OPENRAVE_SHARED_PTR<PyEnvironmentStateDiffWriter> >("EnvironmentStateDiffWriter", DOXY_CLASS(EnvironmentStateDiffWriter), no_init)
+    .def(init<object>(py::args("env")))
+#endif
+    .def("WriteDiff",&PyEnvironmentStateDiffWriter::WriteDiff,"returns the frame of the changes since the previous call as bytes")
+    .def("Reset",&PyEnvironmentStateDiffWriter::Reset,DOXY_FN(EnvironmentStateDiffWriter,Reset))
+    .def("GetNextSequence",&PyEnvironmentStateDiffWriter::GetNextSequence,DOXY_FN(EnvironmentStateDiffWriter,GetNextSequence))
+    ;
+
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+    class_<PyEnvironmentStateDiffApplier, OPENRAVE_SHARED_PTR<PyEnvironmentStateDiffApplier> >(m, "EnvironmentStateDiffApplier", DOXY_CLASS(EnvironmentStateDiffApplier))
+    .def(init<object>(), "env"_a)
+    .def("ApplyDiff",&PyEnvironmentStateDiffApplier::ApplyDiff, "data"_a, "applies the frames in data, returns the number of body states applied")
+#else
+    class_<PyEnvironmentStateDiffApplier, OPENRAVE_SHARED_PTR<PyEnvironmentStateDiffApplier> >("EnvironmentStateDiffApplier", DOXY_CLASS(EnvironmentStateDiffApplier), no_init)
+    .def(init<object>(py::args("env")))
+    .def("ApplyDiff",&PyEnvironmentStateDiffApplier::ApplyDiff, PY_ARGS("data") "applies the frames in data, returns the number of body states applied")
+#endif
+    ;
+
     {
         int (PyConfigurationSpecification::*addgroup1)(const std::string&, int, const std::string&) = &PyConfigurationSpecification::AddGroup;
         int (PyConfigurationSpecification::*addgroup2)(const ConfigurationSpecification::Group&) = &PyConfigurationSpecification::AddGroup;
@@ -214,6 +214,24 @@ object PyIkSolverBase::SolveAll(object oparam, object oFreeParameters, int filte
     return pyreturns;
 }
 
+object PyIkSolverBase::SolveAllBatch(object oparams, int filteroptions)
+{
+    std::vector<IkParameterization> vparams(len(oparams));
+    for(size_t iparam = 0; iparam < vparams.size(); ++iparam) {
+        if( !ExtractIkParameterization(oparams[iparam],vparams[iparam]) ) {
+            throw openrave_exception(_("first argument to IkSolver.SolveAllBatch needs to be a list of IkParameterization"),ORE_InvalidArguments);
+        }
+    }
+    std::vector<dReal> vsolutions;
+    std::vector<int> vposesolutionoffsets;
+    _pIkSolver->SolveAllBatch(vparams, filteroptions, vsolutions, vposesolutionoffsets);
+    RobotBase::ManipulatorPtr pmanip = _pIkSolver->GetManipulator();
+    std::vector<npy_intp> dims(2);
+    dims[1] = !pmanip ? 0 : pmanip->GetArmIndices().size();
+    dims[0] = dims[1] > 0 ? vsolutions.size()/dims[1] : 0;
+    return py::make_tuple(toPyArray(vsolutions, dims), toPyArray(vposesolutionoffsets));
+}
+
 PyIkReturnPtr PyIkSolverBase::CallFilters(object oparam)
 {
     PyIkReturnPtr pyreturn(new PyIkReturn(IKRA_Reject));
@@ -361,6 +379,7 @@ void init_openravepy_iksolver()
         .def("Solve",SolveFree, PY_ARGS("ikparam","q0","freeparameters", "filteroptions") DOXY_FN(IkSolverBase, Solve "const IkParameterization&; const std::vector; const std::vector; int; IkReturnPtr"))
         .def("SolveAll",SolveAll, PY_ARGS("ikparam","filteroptions") DOXY_FN(IkSolverBase, SolveAll "const IkParameterization&; int; std::vector<IkReturnPtr>"))
         .def("SolveAll",SolveAllFree, PY_ARGS("ikparam","freeparameters","filteroptions") DOXY_FN(IkSolverBase, SolveAll "const IkParameterization&; const std::vector; int; std::vector<IkReturnPtr>"))
+        .def("SolveAllBatch",&PyIkSolverBase::SolveAllBatch, PY_ARGS("ikparams","filteroptions") DOXY_FN(IkSolverBase, SolveAllBatch))
         .def("GetNumFreeParameters",&PyIkSolverBase::GetNumFreeParameters, DOXY_FN(IkSolverBase,GetNumFreeParameters))
         .def("GetFreeParameters",&PyIkSolverBase::GetFreeParameters, DOXY_FN(IkSolverBase,GetFreeParameters))
         .def("Supports",&PyIkSolverBase::Supports, PY_ARGS("iktype") DOXY_FN(IkSolverBase,Supports))
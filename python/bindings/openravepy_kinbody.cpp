@@ -3914,6 +3914,72 @@ int PyKinBody::GetUpdateStamp() const
     return _pbody->GetUpdateStamp();
 }
 
+static void _KinBodyChangeCallback(object fncallback)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    try {
+        fncallback();
+    }
+    catch(...) {
+        RAVELOG_ERROR("exception occured in python body change callback:\n");
+        PyErr_Print();
+    }
+    PyGILState_Release(gstate);
+}
+
+static void _KinBodyChangeSetCallback(object fncallback, size_t numlinks, uint32_t properties, const std::vector<uint64_t>& vChangedLinksMask)
+{
+    PyGILState_STATE gstate = PyGILState_Ensure();
+    try {
+        py::list changedlinkindices;
+        for(size_t ilink = 0; ilink < numlinks; ++ilink) {
+            if( IsLinkStateBitEnabled(vChangedLinksMask, ilink) ) {
+                changedlinkindices.append(ilink);
+            }
+        }
+        fncallback(properties, changedlinkindices);
+    }
+    catch(...) {
+        RAVELOG_ERROR("exception occured in python body change set callback:\n");
+        PyErr_Print();
+    }
+    PyGILState_Release(gstate);
+}
+
+object PyKinBody::RegisterChangeCallback(uint32_t properties, object fncallback) const
+{
+    if( IS_PYTHONOBJECT_NONE(fncallback) ) {
+        throw OpenRAVEException(_("callback not specified"));
+    }
+    UserDataPtr p = _pbody->RegisterChangeCallback(properties, boost::bind(&_KinBodyChangeCallback, fncallback));
+    if( !p ) {
+        throw OpenRAVEException(_("registration handle is NULL"));
+    }
+    return openravepy::GetUserData(p);
+}
+
+object PyKinBody::RegisterChangeSetCallback(uint32_t properties, object fncallback) const
+{
+    if( IS_PYTHONOBJECT_NONE(fncallback) ) {
+        throw OpenRAVEException(_("callback not specified"));
+    }
+    UserDataPtr p = _pbody->RegisterChangeSetCallback(properties, boost::bind(&_KinBodyChangeSetCallback, fncallback, _pbody->GetLinks().size(), _1, _2));
+    if( !p ) {
+        throw OpenRAVEException(_("registration handle is NULL"));
+    }
+    return openravepy::GetUserData(p);
+}
+
+void PyKinBody::BeginChangeBatch()
+{
+    _pbody->BeginChangeBatch();
+}
+
+void PyKinBody::CommitChangeBatch()
+{
+    _pbody->CommitChangeBatch();
+}
+
 string PyKinBody::serialize(int options) const
 {
     std::stringstream ss;
@@ -5524,6 +5590,10 @@ void init_openravepy_kinbody()
                          .def("GetAdjacentLinks",&PyKinBody::GetAdjacentLinks, DOXY_FN(KinBody,GetAdjacentLinks))
                          .def("GetManageData",&PyKinBody::GetManageData, DOXY_FN(KinBody,GetManageData))
                          .def("GetUpdateStamp",&PyKinBody::GetUpdateStamp, DOXY_FN(KinBody,GetUpdateStamp))
+                         .def("RegisterChangeCallback",&PyKinBody::RegisterChangeCallback, PY_ARGS("properties","callback") DOXY_FN(KinBody,RegisterChangeCallback))
+                         .def("RegisterChangeSetCallback",&PyKinBody::RegisterChangeSetCallback, PY_ARGS("properties","callback") DOXY_FN(KinBody,RegisterChangeSetCallback))
+                         .def("BeginChangeBatch",&PyKinBody::BeginChangeBatch, DOXY_FN(KinBody,BeginChangeBatch))
+                         .def("CommitChangeBatch",&PyKinBody::CommitChangeBatch, DOXY_FN(KinBody,CommitChangeBatch))
                          .def("serialize",&PyKinBody::serialize,PY_ARGS("options") DOXY_FN(KinBody,serialize))
                          .def("GetKinematicsGeometryHash",&PyKinBody::GetKinematicsGeometryHash, DOXY_FN(KinBody,GetKinematicsGeometryHash))
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
@@ -461,6 +461,122 @@ public:
 
 typedef OPENRAVE_SHARED_PTR<PyManipulatorIKGoalSampler> PyManipulatorIKGoalSamplerPtr;
 
+class PyPlannerFuture
+{
+public:
+    PyPlannerFuture(OpenRAVE::planningutils::PlannerFuturePtr pfuture, PyEnvironmentBasePtr pyenv) : _pfuture(pfuture), _pyenv(pyenv) {
+    }
+    virtual ~PyPlannerFuture() {
+    }
+
+    void Cancel(bool returnwithanysolution=false)
+    {
+        _pfuture->Cancel(returnwithanysolution);
+    }
+
+    bool IsDone() const
+    {
+        return _pfuture->IsDone();
+    }
+
+    bool Wait(uint32_t timeoutms=0)
+    {
+        openravepy::PythonThreadSaver statesaver;
+        return _pfuture->Wait(timeoutms);
+    }
+
+    object GetStatus()
+    {
+        PlannerStatus status;
+        {
+            openravepy::PythonThreadSaver statesaver;
+            status = _pfuture->GetStatus();
+        }
+        return openravepy::toPyPlannerStatus(status);
+    }
+
+    object GetTrajectory()
+    {
+        TrajectoryBasePtr ptraj;
+        {
+            openravepy::PythonThreadSaver statesaver;
+            ptraj = _pfuture->GetTrajectory();
+        }
+        if( !ptraj ) {
+            return py::none_();
+        }
+        return py::to_object(openravepy::toPyTrajectory(ptraj, _pyenv));
+    }
+
+    int GetIteration() const
+    {
+        return _pfuture->GetIteration();
+    }
+
+    OpenRAVE::planningutils::PlannerFuturePtr _pfuture;
+    PyEnvironmentBasePtr _pyenv;
+};
+
+typedef OPENRAVE_SHARED_PTR<PyPlannerFuture> PyPlannerFuturePtr;
+
+class PyPlannerExecutor
+{
+public:
+    PyPlannerExecutor(PyEnvironmentBasePtr pyenv, int numthreads, int cloningoptions=Clone_Bodies) : _pyenv(pyenv) {
+        _executor.reset(new OpenRAVE::planningutils::PlannerExecutor(openravepy::GetEnvironment(pyenv), numthreads, cloningoptions));
+    }
+    virtual ~PyPlannerExecutor() {
+        // the workers are joined here, so do not block other python threads on them
+        openravepy::PythonThreadSaver statesaver;
+        _executor.reset();
+    }
+
+    PyPlannerFuturePtr Submit(const std::string& plannername, const std::string& robotname, object oparameters, int planningoptions=0)
+    {
+        PlannerBase::PlannerParametersConstPtr parameters = openravepy::GetPlannerParametersConst(oparameters);
+        if( !parameters ) {
+            throw OPENRAVE_EXCEPTION_FORMAT0(_("PlannerExecutor.Submit needs valid planner parameters"),ORE_InvalidArguments);
+        }
+        OpenRAVE::planningutils::PlannerFuturePtr pfuture;
+        {
+            openravepy::PythonThreadSaver statesaver;
+            pfuture = _executor->Submit(plannername, robotname, parameters, planningoptions);
+        }
+        return PyPlannerFuturePtr(new PyPlannerFuture(pfuture, _pyenv));
+    }
+
+    int WaitForAny(object ofutures, uint32_t timeoutms=0, bool cancelothers=true)
+    {
+        std::vector<OpenRAVE::planningutils::PlannerFuturePtr> vfutures;
+        size_t num = len(ofutures);
+        for(size_t i = 0; i < num; ++i) {
+            PyPlannerFuturePtr pyfuture = extract<PyPlannerFuturePtr>(ofutures[i]);
+            if( !pyfuture ) {
+                throw OPENRAVE_EXCEPTION_FORMAT0(_("PlannerExecutor.WaitForAny needs a list of PlannerFuture objects"),ORE_InvalidArguments);
+            }
+            vfutures.push_back(pyfuture->_pfuture);
+        }
+        openravepy::PythonThreadSaver statesaver;
+        return _executor->WaitForAny(vfutures, timeoutms, cancelothers);
+    }
+
+    void CancelAll()
+    {
+        openravepy::PythonThreadSaver statesaver;
+        _executor->CancelAll();
+    }
+
+    int GetNumThreads() const
+    {
+        return _executor->GetNumThreads();
+    }
+
+    OpenRAVE::planningutils::PlannerExecutorPtr _executor;
+    PyEnvironmentBasePtr _pyenv;
+};
+
+typedef OPENRAVE_SHARED_PTR<PyPlannerExecutor> PyPlannerExecutorPtr;
+
 
 } // end namespace planningutils
 
@@ -485,6 +601,10 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Check_overloads, Check, 5, 8)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(PlanPath_overloads, PlanPath, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(PlanPath_overloads2, PlanPath, 3, 5)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(PlanPath_overloads3, PlanPath, 1, 3)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Cancel_overloads, Cancel, 0, 1)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Wait_overloads, Wait, 0, 1)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(Submit_overloads, Submit, 3, 4)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(WaitForAny_overloads, WaitForAny, 1, 3)
 #endif // USE_PYBIND11_PYTHON_BINDINGS
 
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
@@ -811,6 +931,63 @@ void InitPlanningUtils()
         .def("GetIkParameterizationIndex", &planningutils::PyManipulatorIKGoalSampler::GetIkParameterizationIndex, PY_ARGS("index") DOXY_FN(planningutils::ManipulatorIKGoalSampler, GetIkParameterizationIndex))
         ;
 
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+        class_<planningutils::PyPlannerFuture, planningutils::PyPlannerFuturePtr >(planningutils, "PlannerFuture", DOXY_CLASS(planningutils::PlannerFuture))
+#else
+        class_<planningutils::PyPlannerFuture, planningutils::PyPlannerFuturePtr >("PlannerFuture", DOXY_CLASS(planningutils::PlannerFuture), no_init)
+#endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+        .def("Cancel", &planningutils::PyPlannerFuture::Cancel,
+             "returnwithanysolution"_a = false,
+             DOXY_FN(planningutils::PlannerFuture, Cancel)
+             )
+        .def("Wait", &planningutils::PyPlannerFuture::Wait,
+             "timeoutms"_a = 0,
+             DOXY_FN(planningutils::PlannerFuture, Wait)
+             )
+#else
+        .def("Cancel",&planningutils::PyPlannerFuture::Cancel, Cancel_overloads(PY_ARGS("returnwithanysolution") DOXY_FN(planningutils::PlannerFuture, Cancel)))
+        .def("Wait",&planningutils::PyPlannerFuture::Wait, Wait_overloads(PY_ARGS("timeoutms") DOXY_FN(planningutils::PlannerFuture, Wait)))
+#endif
+        .def("IsDone", &planningutils::PyPlannerFuture::IsDone, DOXY_FN(planningutils::PlannerFuture, IsDone))
+        .def("GetStatus", &planningutils::PyPlannerFuture::GetStatus, DOXY_FN(planningutils::PlannerFuture, GetStatus))
+        .def("GetTrajectory", &planningutils::PyPlannerFuture::GetTrajectory, DOXY_FN(planningutils::PlannerFuture, GetTrajectory))
+        .def("GetIteration", &planningutils::PyPlannerFuture::GetIteration, DOXY_FN(planningutils::PlannerFuture, GetIteration))
+        ;
+
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+        class_<planningutils::PyPlannerExecutor, planningutils::PyPlannerExecutorPtr >(planningutils, "PlannerExecutor", DOXY_CLASS(planningutils::PlannerExecutor))
+        .def(init<PyEnvironmentBasePtr, int, int>(),
+             "env"_a,
+             "numthreads"_a,
+             "cloningoptions"_a = (int) Clone_Bodies
+             )
+#else
+        class_<planningutils::PyPlannerExecutor, planningutils::PyPlannerExecutorPtr >("PlannerExecutor", DOXY_CLASS(planningutils::PlannerExecutor), no_init)
+        .def(init<PyEnvironmentBasePtr, int, optional<int> >(py::args("env", "numthreads", "cloningoptions")))
+#endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+        .def("Submit", &planningutils::PyPlannerExecutor::Submit,
+             "plannername"_a,
+             "robotname"_a,
+             "parameters"_a,
+             "planningoptions"_a = 0,
+             DOXY_FN(planningutils::PlannerExecutor, Submit)
+             )
+        .def("WaitForAny", &planningutils::PyPlannerExecutor::WaitForAny,
+             "futures"_a,
+             "timeoutms"_a = 0,
+             "cancelothers"_a = true,
+             DOXY_FN(planningutils::PlannerExecutor, WaitForAny)
+             )
+#else
+        .def("Submit",&planningutils::PyPlannerExecutor::Submit, Submit_overloads(PY_ARGS("plannername", "robotname", "parameters", "planningoptions") DOXY_FN(planningutils::PlannerExecutor, Submit)))
+        .def("WaitForAny",&planningutils::PyPlannerExecutor::WaitForAny, WaitForAny_overloads(PY_ARGS("futures", "timeoutms", "cancelothers") DOXY_FN(planningutils::PlannerExecutor, WaitForAny)))
+#endif
+        .def("CancelAll", &planningutils::PyPlannerExecutor::CancelAll, DOXY_FN(planningutils::PlannerExecutor, CancelAll))
+        .def("GetNumThreads", &planningutils::PyPlannerExecutor::GetNumThreads, DOXY_FN(planningutils::PlannerExecutor, GetNumThreads))
+        ;
+
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
         class_<planningutils::PyActiveDOFTrajectorySmoother, planningutils::PyActiveDOFTrajectorySmootherPtr >(planningutils, "ActiveDOFTrajectorySmoother", DOXY_CLASS(planningutils::ActiveDOFTrajectorySmoother))
         .def(init<PyRobotBasePtr, const std::string&, const std::string&>(), "robot"_a, "plannername"_a, "plannerparameters"_a)
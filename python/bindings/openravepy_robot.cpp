@@ -1103,6 +1103,31 @@ object PyRobotBase::PyManipulator::FindIKSolutions(object oparam, object freepar
     }
 }
 
+object PyRobotBase::PyManipulator::FindIKSolutionsBatch(object oparams, int filteroptions, bool releasegil) const
+{
+    std::vector<IkParameterization> vparams(len(oparams));
+    for(size_t iparam = 0; iparam < vparams.size(); ++iparam) {
+        if( !ExtractIkParameterization(oparams[iparam],vparams[iparam]) ) {
+            // assume transformation matrix
+            vparams[iparam] = IkParameterization(ExtractTransform(oparams[iparam]));
+        }
+    }
+    std::vector<dReal> vsolutions;
+    std::vector<int> vposesolutionoffsets;
+    EnvironmentMutex::scoped_lock lock(openravepy::GetEnvironment(_pyenv)->GetMutex()); // lock just in case since many users call this without locking...
+    {
+        openravepy::PythonThreadSaverPtr statesaver;
+        if( releasegil ) {
+            statesaver.reset(new openravepy::PythonThreadSaver());
+        }
+        _pmanip->FindIKSolutionsBatch(vparams, filteroptions, vsolutions, vposesolutionoffsets);
+    }
+    std::vector<npy_intp> dims(2);
+    dims[1] = _pmanip->GetArmIndices().size();
+    dims[0] = dims[1] > 0 ? vsolutions.size()/dims[1] : 0;
+    return py::make_tuple(toPyArray(vsolutions, dims), toPyArray(vposesolutionoffsets));
+}
+
 object PyRobotBase::PyManipulator::GetIkParameterization(object oparam, bool inworld)
 {
     IkParameterization ikparam;
@@ -2293,6 +2318,7 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(FindIKSolution_overloads, FindIKSolution,
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(FindIKSolutionFree_overloads, FindIKSolution, 3, 5)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(FindIKSolutions_overloads, FindIKSolutions, 2, 4)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(FindIKSolutionsFree_overloads, FindIKSolutions, 3, 5)
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(FindIKSolutionsBatch_overloads, FindIKSolutionsBatch, 2, 3)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetArmConfigurationSpecification_overloads, GetArmConfigurationSpecification, 0, 1)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(GetIkConfigurationSpecification_overloads, GetIkConfigurationSpecification, 1, 2)
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(CreateRobotStateSaver_overloads, CreateRobotStateSaver, 0,1)
@@ -2803,6 +2829,16 @@ void init_openravepy_robot()
 #else
         .def("FindIKSolutions",pmanipiksf,FindIKSolutionsFree_overloads(PY_ARGS("param","freevalues","filteroptions","ikreturn","releasegil") DOXY_FN(RobotBase::Manipulator,FindIKSolutions "const IkParameterization; const std::vector; std::vector; int")))
 #endif
+#ifdef USE_PYBIND11_PYTHON_BINDINGS
+        .def("FindIKSolutionsBatch", &PyRobotBase::PyManipulator::FindIKSolutionsBatch,
+             "params"_a,
+             "filteroptions"_a,
+             "releasegil"_a = false,
+             DOXY_FN(RobotBase::Manipulator,FindIKSolutionsBatch)
+             )
+#else
+        .def("FindIKSolutionsBatch",&PyRobotBase::PyManipulator::FindIKSolutionsBatch,FindIKSolutionsBatch_overloads(PY_ARGS("params","filteroptions","releasegil") DOXY_FN(RobotBase::Manipulator,FindIKSolutionsBatch)))
+#endif
 #ifdef USE_PYBIND11_PYTHON_BINDINGS
         .def("GetIkParameterization", &PyRobotBase::PyManipulator::GetIkParameterization,
              "iktype"_a,
@@ -172,10 +172,12 @@ class BaseManipulation:
             return traj
         return res
 
-    def MoveToHandPosition(self,matrices=None,affinedofs=None,maxiter=None,maxtries=None,translation=None,rotation=None,seedik=None,constraintfreedoms=None,constraintmatrix=None,constrainterrorthresh=None,execute=None,outputtraj=None,steplength=None,goalsamples=None,ikparam=None,ikparams=None,jitter=None,minimumgoalpaths=None,outputtrajobj=None,postprocessing=None,jittergoal=None, constrainttaskmatrix=None, constrainttaskpose=None,goalsampleprob=None,goalmaxsamples=None,goalmaxtries=None,releasegil=False,initialconfigs=None,freevalues=None):
+    def MoveToHandPosition(self,matrices=None,affinedofs=None,maxiter=None,maxtries=None,translation=None,rotation=None,seedik=None,constraintfreedoms=None,constraintmatrix=None,constrainterrorthresh=None,execute=None,outputtraj=None,steplength=None,goalsamples=None,ikparam=None,ikparams=None,jitter=None,minimumgoalpaths=None,outputtrajobj=None,postprocessing=None,jittergoal=None, constrainttaskmatrix=None, constrainttaskpose=None,goalsampleprob=None,goalmaxsamples=None,goalmaxtries=None,releasegil=False,initialconfigs=None,freevalues=None,cacheikgoals=None):
         """See :ref:`module-basemanipulation-movetohandposition`
 
         postprocessing is two parameters: (plannername,parmaeters)
+
+        :param cacheikgoals: if True, reuses the ik solutions of previous calls while the environment does not change
         """
         cmd = 'MoveToHandPosition '
         if matrices is not None:
@@ -235,6 +237,8 @@ class BaseManipulation:
             cmd += 'freevalues %d '%len(freevalues)
             for fv in freevalues:
                 cmd += '%f ' % fv
+        if cacheikgoals is not None:
+            cmd += 'cacheikgoals %d '%cacheikgoals
         res = self.prob.SendCommand(cmd, releasegil=releasegil)
         if res is None:
             raise PlanningError('MoveToHandPosition')
@@ -18,6 +18,7 @@ from .. import PlanningError
 
 from numpy import *
 from copy import copy as shallowcopy
+import struct
 
 import logging
 log = logging.getLogger('openravepy.interfaces.Grasper')
@@ -58,8 +59,10 @@ class Grasper:
         clone.avoidlinks = [clone.robot.GetLink(link.GetName()) for link in self.avoidlinks]
         envother.Add(clone.prob,True,clone.args)
         return clone
-    def Grasp(self, direction=None, roll=None, position=None, standoff=None, target=None, stablecontacts=False, forceclosure=False, transformrobot=True, onlycontacttarget=True, tightgrasp=False, graspingnoise=None, execute=None, translationstepmult=None, outputfinal=False, manipulatordirection=None, coarsestep=None, finestep=None, vintersectplane=None, chuckingdirection=None, ordereddofindices=None, avoidcontact=False):
+    def Grasp(self, direction=None, roll=None, position=None, standoff=None, target=None, stablecontacts=False, forceclosure=False, transformrobot=True, onlycontacttarget=True, tightgrasp=False, graspingnoise=None, execute=None, translationstepmult=None, outputfinal=False, manipulatordirection=None, coarsestep=None, finestep=None, vintersectplane=None, chuckingdirection=None, ordereddofindices=None, avoidcontact=False, distanceguidedclosing=False, fastforceclosure=False):
         """See :ref:`module-grasper-grasp`
+
+        :param fastforceclosure: if True, computes mindist without convex hulls, volume is returned as 0. Whether the grasp is in force closure is exact, but mindist is an estimate that can only be larger than the convex hull value, usually by a few percent.
         """
         cmd = 'Grasp '
         if direction is not None:
@@ -97,6 +100,10 @@ class Grasper:
                 cmd += '%d '%value
         if avoidcontact:
             cmd += 'avoidcontact '
+        if distanceguidedclosing:
+            cmd += 'distanceguidedclosing 1 '
+        if fastforceclosure:
+            cmd += 'fastforceclosure 1 '
         res = self.prob.SendCommand(cmd)
         if res is None:
             raise PlanningError('Grasp failed')
@@ -119,8 +126,11 @@ class Grasper:
         contacts = reshape(array([float64(s) for s in resvalues],float64),(len(resvalues)/6,6))
         return contacts,finalconfig,mindist,volume
 
-    def GraspThreaded(self,approachrays,standoffs,preshapes,rolls,manipulatordirections=None,target=None,transformrobot=True,onlycontacttarget=True,tightgrasp=False,graspingnoise=None,forceclosurethreshold=None,collisionchecker=None,translationstepmult=None,numthreads=None,startindex=None,maxgrasps=None,finestep=None):
+    def GraspThreaded(self,approachrays,standoffs,preshapes,rolls,manipulatordirections=None,target=None,transformrobot=True,onlycontacttarget=True,tightgrasp=False,graspingnoise=None,forceclosurethreshold=None,collisionchecker=None,translationstepmult=None,numthreads=None,startindex=None,maxgrasps=None,finestep=None,distanceguidedclosing=False,outputfile=None,fastforceclosure=False):
         """See :ref:`module-grasper-graspthreaded`
+
+        :param outputfile: if set, the evaluated grasps are streamed to this binary file instead of being returned, and calling again with the same file resumes the evaluation.
+        :param fastforceclosure: if True, computes mindist without convex hulls, volume is returned as 0. The estimate can only be larger than the convex hull mindist, so it is used to reject grasps below forceclosurethreshold. If forceclosurethreshold is positive, the accepted grasps are recomputed with convex hulls and return the exact mindist, otherwise the returned mindist is the estimate.
         """
         cmd = 'GraspThreaded '
         if target is not None:
@@ -140,6 +150,10 @@ class Grasper:
             cmd += 'translationstepmult %.15e '%translationstepmult
         if finestep is not None:
             cmd += 'finestep %.15e '%finestep
+        if distanceguidedclosing:
+            cmd += 'distanceguidedclosing 1 '
+        if fastforceclosure:
+            cmd += 'fastforceclosure 1 '
         if numthreads is not None:
             cmd += 'numthreads %d '%numthreads
         cmd += 'approachrays %d '%len(approachrays)
@@ -157,6 +171,9 @@ class Grasper:
         cmd += 'manipulatordirections %d '%len(manipulatordirections)
         for f in manipulatordirections.flat:
             cmd += str(f) + ' '
+        if outputfile is not None:
+            # the file name is read until the end of the line
+            cmd += 'outputfile %s\n'%outputfile
         res = self.prob.SendCommand(cmd)
         if res is None:
             raise PlanningError('Grasp failed')
@@ -181,6 +198,75 @@ class Grasper:
             resvalues.append([position, direction, roll, standoff, manipulatordirection, mindist, volume, preshape,Tfinal,finalshape,contacts])
         return nextid, resvalues
 
+    @staticmethod
+    def LoadGraspThreadedOutput(outputfile):
+        """Reads the binary file written by GraspThreaded with outputfile. A record cut at the end of the file is ignored like when resuming.
+
+        :return: numgrasps, evaluatedids, successids, resvalues. evaluatedids are the ids of all the evaluated grasps, resvalues has the same format as the results of GraspThreaded and is ordered like successids
+        """
+        with open(outputfile,'rb') as f:
+            data = f.read()
+        headerformat = '=4s5IQ32s'
+        headersize = struct.calcsize(headerformat)
+        if len(data) < headersize:
+            raise PlanningError('grasp output file %s is too small'%outputfile)
+        magic, version, realsize, preshapedof, robotdof, reserved, numgrasps, inputhash = struct.unpack_from(headerformat,data,0)
+        if magic != b'ORGT' or version != 3:
+            raise PlanningError('grasp output file %s has an unknown format'%outputfile)
+        realformat = {4:'f',8:'d'}[realsize]
+        evaluatedids = []
+        successids = []
+        resvalues = []
+        offset = headersize
+        while offset+4 <= len(data):
+            recordsize, = struct.unpack_from('=I',data,offset)
+            if recordsize < 9 or offset+4+recordsize > len(data):
+                break
+            grasp_id, success = struct.unpack_from('=QB',data,offset+4)
+            evaluatedids.append(grasp_id)
+            if success:
+                numvalues = 20+preshapedof+robotdof
+                values = struct.unpack_from('=%d%s'%(numvalues,realformat),data,offset+13)
+                numcontacts, = struct.unpack_from('=I',data,offset+13+numvalues*realsize)
+                contacts = struct.unpack_from('=%d%s'%(6*numcontacts,realformat),data,offset+17+numvalues*realsize)
+                position = array(values[0:3])
+                direction = array(values[3:6])
+                roll = float64(values[6])
+                standoff = float64(values[7])
+                manipulatordirection = array(values[8:11])
+                mindist = float64(values[11])
+                volume = float64(values[12])
+                preshape = list(values[13:13+preshapedof])
+                Tfinal = matrixFromPose(values[13+preshapedof:20+preshapedof])
+                finalshape = array(values[20+preshapedof:20+preshapedof+robotdof])
+                successids.append(grasp_id)
+                resvalues.append([position, direction, roll, standoff, manipulatordirection, mindist, volume, preshape,Tfinal,finalshape,reshape(array(contacts),(numcontacts,6))])
+            offset += 4+recordsize
+        return numgrasps, array(evaluatedids,int), array(successids,int), resvalues
+
+    def ComputeGraspQualities(self,contactsets,conepoints=None,numthreads=None):
+        """Computes the force closure quality of many sets of contacts in parallel.
+
+        Whether a set is in force closure is exact. mindist is estimated without convex hulls and is an upper bound of the epsilon quality, usually within a few percent. Use Grasp with forceclosure to get the exact value of a set.
+
+        :param contactsets: list of Nx6 arrays of contact positions and normals
+        :return: array with the mindist estimate of every set, 0 if the set is not in force closure
+        """
+        cmd = 'ComputeGraspQualities '
+        if self.friction is not None:
+            cmd += 'friction %.15e '%self.friction
+        if conepoints is not None:
+            cmd += 'conepoints %d '%conepoints
+        if numthreads is not None:
+            cmd += 'numthreads %d '%numthreads
+        cmd += 'grasps %d '%len(contactsets)
+        for contacts in contactsets:
+            cmd += '%d '%len(contacts) + ' '.join('%.15e'%f for f in array(contacts).flat) + ' '
+        res = self.prob.SendCommand(cmd)
+        if res is None:
+            raise PlanningError('ComputeGraspQualities')
+        return array([float64(s) for s in res.split()])
+
     def ConvexHull(self,points,returnplanes=True,returnfaces=True,returntriangles=True):
         """See :ref:`module-grasper-convexhull`
         """
@@ -28,6 +28,10 @@
 #include <unordered_map>
 #include <mutex>
 #include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
 
 #include <pcrecpp.h>
 
@@ -133,6 +137,129 @@ protected:
     bool _lockAquired;
 };
 
+/// \brief calls SimulationStep of sensors in parallel on persistent worker threads
+///
+/// Only used for sensors whose SensorBase::IsSimulationStepReadOnly is true. The calling thread takes part in the work
+/// and Run returns once all the sensors have been stepped. Threads are started lazily and live until destruction.
+class SensorSimulationWorkers
+{
+public:
+    SensorSimulationWorkers() : _pvsensors(NULL), _fTimeStep(0), _nextsensor(0), _numactive(0), _jobid(0), _bQuit(false) {
+    }
+    ~SensorSimulationWorkers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _bQuit = true;
+        }
+        _condwork.notify_all();
+        for(std::thread& thread : _vthreads) {
+            thread.join();
+        }
+    }
+
+    /// \brief steps all the sensors, rethrows the first exception raised by any of them
+    void Run(const std::vector<SensorBasePtr>& vsensors, dReal fTimeStep)
+    {
+        size_t numthreads = std::min(vsensors.size(), (size_t)std::max(1u, std::thread::hardware_concurrency())) - 1;
+        if( vsensors.size() <= 1 || numthreads == 0 ) {
+            for(const SensorBasePtr& psensor : vsensors) {
+                psensor->SimulationStep(fTimeStep);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            while(_vthreads.size() < numthreads) {
+                _vthreads.emplace_back(&SensorSimulationWorkers::_WorkerThread, this, _jobid);
+            }
+            _pvsensors = &vsensors;
+            _fTimeStep = fTimeStep;
+            _nextsensor = 0;
+            _exception = std::exception_ptr();
+            _numactive = _vthreads.size();
+            ++_jobid;
+        }
+        _condwork.notify_all();
+        _StepSensors();
+
+        std::exception_ptr exception;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _conddone.wait(lock, [this]() {
+                return _numactive == 0;
+            });
+            _pvsensors = NULL;
+            exception = _exception;
+            _exception = std::exception_ptr();
+        }
+        if( !!exception ) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+protected:
+    void _WorkerThread(uint64_t lastjobid)
+    {
+        while(true) {
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _condwork.wait(lock, [this, lastjobid]() {
+                    return _bQuit || _jobid != lastjobid;
+                });
+                if( _bQuit ) {
+                    return;
+                }
+                lastjobid = _jobid;
+            }
+            _StepSensors();
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if( --_numactive == 0 ) {
+                    _conddone.notify_all();
+                }
+            }
+        }
+    }
+
+    void _StepSensors()
+    {
+        while(true) {
+            SensorBasePtr psensor;
+            dReal fTimeStep;
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if( !_pvsensors || _nextsensor >= _pvsensors->size() ) {
+                    return;
+                }
+                psensor = (*_pvsensors)[_nextsensor++];
+                fTimeStep = _fTimeStep;
+            }
+            try {
+                psensor->SimulationStep(fTimeStep);
+            }
+            catch(...) {
+                std::lock_guard<std::mutex> lock(_mutex);
+                if( !_exception ) {
+                    _exception = std::current_exception();
+                }
+            }
+        }
+    }
+
+    std::vector<std::thread> _vthreads;
+    std::mutex _mutex; ///< protects all the members below
+    std::condition_variable _condwork, _conddone;
+    const std::vector<SensorBasePtr>* _pvsensors; ///< sensors of the current job
+    dReal _fTimeStep;
+    size_t _nextsensor; ///< index of the next sensor to step in _pvsensors
+    size_t _numactive; ///< number of worker threads still working on the current job
+    uint64_t _jobid; ///< incremented for every job
+    std::exception_ptr _exception; ///< first exception of the current job
+    bool _bQuit;
+};
+
 class Environment : public EnvironmentBase
 {
     class GraphHandleMulti : public GraphHandle
@@ -359,7 +486,7 @@ public:
                 ExclusiveLock lock(_mutexInterfaces);
                 vecbodies.swap(_vecbodies);
                 listSensors.swap(_listSensors);
-                _vPublishedBodies.clear();
+                _ClearPublishedBodies();
                 _nBodiesModifiedStamp++;
                 _listModules.clear();
                 _listViewers.clear();
@@ -437,7 +564,7 @@ public:
             _mapBodyNameIndex.clear();
             _mapBodyIdIndex.clear();
 
-            _vPublishedBodies.clear();
+            _ClearPublishedBodies();
             _nBodiesModifiedStamp++;
 
             _environmentIndexRecyclePool.clear();
@@ -1385,6 +1512,13 @@ public:
         return _pCurrentChecker->CheckCollision(pbody,vbodyexcluded,vlinkexcluded,report);
     }
 
+    virtual bool CheckCollision(KinBodyConstPtr pbody, const LinkEnableStatesMaskOverrides& vLinkEnableStatesMaskOverrides, CollisionReportPtr report)
+    {
+        EnvironmentMutex::scoped_lock lockenv(GetMutex());
+        CHECK_COLLISION_BODY(pbody);
+        return _pCurrentChecker->CheckCollision(pbody,vLinkEnableStatesMaskOverrides,report);
+    }
+
     virtual bool CheckCollision(const RAY& ray, KinBody::LinkConstPtr plink, CollisionReportPtr report)
     {
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
@@ -1426,52 +1560,154 @@ public:
         // call the physics first to get forces
         _pPhysicsEngine->SimulateStep(fTimeStep);
 
-        // make a copy instead of locking the mutex pointer since will be calling into user functions
-        vector<KinBodyPtr> vecbodies;
-        list<SensorBasePtr> listSensors;
-        list< pair<ModuleBasePtr, std::string> > listModules;
+        // copy into buffers kept across steps instead of locking the mutex pointer since will be calling into user functions
         {
             SharedLock lock(_mutexInterfaces);
-            vecbodies = _vecbodies;
-            listSensors = _listSensors;
-            listModules = _listModules;
+            _vStepBodies.assign(_vecbodies.begin(), _vecbodies.end());
+            _vStepSensors.assign(_listSensors.begin(), _listSensors.end());
+            _vStepModules.resize(0);
+            FOREACHC(itmodule, _listModules) {
+                _vStepModules.push_back(itmodule->first);
+            }
         }
 
-        for (const KinBodyPtr& pBody : vecbodies) {
-            if (!pBody) {
-                continue;
+        try {
+            for (const KinBodyPtr& pBody : _vStepBodies) {
+                if (!pBody) {
+                    continue;
+                }
+                if( pBody->GetEnvironmentBodyIndex() ) {     // have to check if valid
+                    pBody->SimulationStep(fTimeStep);
+                }
+            }
+            for (const ModuleBasePtr& pmodule : _vStepModules) {
+                pmodule->SimulationStep(fTimeStep);
+            }
+
+            // simulate the sensors last (ie, they always reflect the most recent bodies
+            // sensors that only read the bodies are stepped in parallel once the others are done
+            _vStepReadOnlySensors.resize(0);
+            for (const SensorBasePtr& psensor : _vStepSensors) {
+                if( psensor->IsSimulationStepReadOnly() ) {
+                    _vStepReadOnlySensors.push_back(psensor);
+                }
+                else {
+                    psensor->SimulationStep(fTimeStep);
+                }
             }
-            if( pBody->GetEnvironmentBodyIndex() ) {     // have to check if valid
-                pBody->SimulationStep(fTimeStep);
+            for (const KinBodyPtr& pBody : _vStepBodies) {
+                if (!pBody) {
+                    continue;
+                }
+                if( !pBody->IsRobot() ) {
+                    continue;
+                }
+                const RobotBasePtr& probot = RaveInterfaceCast<RobotBase>(pBody);
+                FOREACHC(itsensor, probot->GetAttachedSensors()) {
+                    SensorBasePtr psensor = (*itsensor)->GetSensor();
+                    if( !!psensor ) {
+                        if( psensor->IsSimulationStepReadOnly() ) {
+                            _vStepReadOnlySensors.push_back(psensor);
+                        }
+                        else {
+                            psensor->SimulationStep(fTimeStep);
+                        }
+                    }
+                }
             }
+            _sensorworkers.Run(_vStepReadOnlySensors, fTimeStep);
         }
-        FOREACH(itmodule, listModules) {
-            itmodule->first->SimulationStep(fTimeStep);
+        catch(...) {
+            _ClearStepBuffers();
+            throw;
         }
+        _ClearStepBuffers();
+        _nCurSimTime += step;
+    }
+
+    virtual EnvironmentMutex& GetMutex() const {
+        return _mutexEnvironment;
+    }
 
-        // simulate the sensors last (ie, they always reflect the most recent bodies
-        FOREACH(itsensor, listSensors) {
-            (*itsensor)->SimulationStep(fTimeStep);
+    /// \brief creates and initializes in parallel the kinbodies of info that cannot match any body in vBodies
+    ///
+    /// Building a body from its info (geometry tessellation, link and joint setup) does not touch the environment until
+    /// the body is added, so it is safe to do on worker threads. Robots are left to the sequential path since their
+    /// sensors and controllers are created through the environment. Bodies that fail to build are left empty so that
+    /// the sequential path reports the error.
+    /// \param[out] vPrebuiltBodies indexed by info._vBodyInfos, empty entries have to be built by the caller
+    void _PrebuildNewKinBodies(const EnvironmentBaseInfo& info, const std::vector<KinBodyPtr>& vBodies, std::vector<KinBodyPtr>& vPrebuiltBodies)
+    {
+        vPrebuiltBodies.clear();
+        std::set<std::string> setExistingIds, setExistingNames;
+        FOREACHC(itbody, vBodies) {
+            if( !(*itbody)->_id.empty() ) {
+                setExistingIds.insert((*itbody)->_id);
+            }
+            if( !(*itbody)->_name.empty() ) {
+                setExistingNames.insert((*itbody)->_name);
+            }
         }
-        for (const KinBodyPtr& pBody : vecbodies) {
-            if (!pBody) {
+
+        std::vector<int> vNewBodyIndices;
+        for(int inputBodyIndex = 0; inputBodyIndex < (int)info._vBodyInfos.size(); ++inputBodyIndex) {
+            const KinBody::KinBodyInfo& kinBodyInfo = *info._vBodyInfos[inputBodyIndex];
+            if( kinBodyInfo._isRobot ) {
                 continue;
             }
-            if( !pBody->IsRobot() ) {
+            if( (!kinBodyInfo._id.empty() && setExistingIds.count(kinBodyInfo._id) > 0) || (!kinBodyInfo._name.empty() && setExistingNames.count(kinBodyInfo._name) > 0) ) {
                 continue;
             }
-            const RobotBasePtr& probot = RaveInterfaceCast<RobotBase>(pBody);
-            FOREACHC(itsensor, probot->GetAttachedSensors()) {
-                if( !!(*itsensor)->GetSensor() ) {
-                    (*itsensor)->GetSensor()->SimulationStep(fTimeStep);
+            vNewBodyIndices.push_back(inputBodyIndex);
+        }
+
+        int numthreads = std::min((int)std::thread::hardware_concurrency(), (int)vNewBodyIndices.size()/2);
+        if( numthreads <= 1 ) {
+            return; // not worth starting threads
+        }
+
+        vPrebuiltBodies.resize(info._vBodyInfos.size());
+        EnvironmentBasePtr penv = shared_from_this();
+        std::atomic<size_t> nextindex(0);
+        auto buildfn = [&]() {
+            for(size_t index = nextindex++; index < vNewBodyIndices.size(); index = nextindex++) {
+                int inputBodyIndex = vNewBodyIndices[index];
+                const KinBody::KinBodyInfo& kinBodyInfo = *info._vBodyInfos[inputBodyIndex];
+                try {
+                    KinBodyPtr pNewBody = RaveCreateKinBody(penv, kinBodyInfo._interfaceType);
+                    if( !pNewBody ) {
+                        pNewBody = RaveCreateKinBody(penv, "");
+                    }
+                    if( !!pNewBody && pNewBody->InitFromKinBodyInfo(kinBodyInfo) ) {
+                        vPrebuiltBodies[inputBodyIndex] = pNewBody;
+                    }
+                }
+                catch(const std::exception& ex) {
+                    RAVELOG_VERBOSE_FORMAT("env=%s, failed to prebuild body id='%s': %s", GetNameId()%kinBodyInfo._id%ex.what());
                 }
             }
+        };
+
+        uint64_t starttimeus = utils::GetMonotonicTime();
+        std::vector<std::thread> vthreads;
+        vthreads.reserve(numthreads-1);
+        for(int ithread = 1; ithread < numthreads; ++ithread) {
+            vthreads.emplace_back(buildfn);
         }
-        _nCurSimTime += step;
+        buildfn();
+        FOREACH(itthread, vthreads) {
+            itthread->join();
+        }
+        RAVELOG_DEBUG_FORMAT("env=%s, prebuilt %d new bodies on %d threads in %u[us]", GetNameId()%vNewBodyIndices.size()%numthreads%(utils::GetMonotonicTime()-starttimeus));
     }
 
-    virtual EnvironmentMutex& GetMutex() const {
-        return _mutexEnvironment;
+    /// \brief releases the interfaces referenced by the StepSimulation buffers while keeping their memory
+    void _ClearStepBuffers()
+    {
+        _vStepBodies.clear();
+        _vStepModules.clear();
+        _vStepSensors.clear();
+        _vStepReadOnlySensors.clear();
     }
 
     virtual void GetBodies(std::vector<KinBodyPtr>& bodies, uint64_t timeout) const
@@ -2506,22 +2742,29 @@ public:
 
     virtual void GetPublishedBodies(std::vector<KinBody::BodyState>& vbodies, uint64_t timeout)
     {
-        TimedSharedLock lock(_mutexInterfaces, timeout);
-        if (!lock) {
-            throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
+        PublishedBodiesConstPtr pbodies = GetPublishedBodiesSnapshot();
+        if( !!pbodies ) {
+            vbodies = *pbodies;
+        }
+        else {
+            vbodies.clear();
         }
-        vbodies = _vPublishedBodies;
+    }
+
+    virtual PublishedBodiesConstPtr GetPublishedBodiesSnapshot() const
+    {
+        return boost::atomic_load(&_pPublishedBodies);
     }
 
     virtual bool GetPublishedBody(const std::string &name, KinBody::BodyState& bodystate, uint64_t timeout=0)
     {
-        TimedSharedLock lock(_mutexInterfaces, timeout);
-        if (!lock) {
-            throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
+        PublishedBodiesConstPtr pbodies = GetPublishedBodiesSnapshot();
+        if( !pbodies ) {
+            return false;
         }
-        for ( size_t ibody = 0; ibody < _vPublishedBodies.size(); ++ibody) {
-            if ( _vPublishedBodies[ibody].strname == name) {
-                bodystate = _vPublishedBodies[ibody];
+        for ( size_t ibody = 0; ibody < pbodies->size(); ++ibody) {
+            if ( (*pbodies)[ibody].strname == name) {
+                bodystate = (*pbodies)[ibody];
                 return true;
             }
         }
@@ -2531,13 +2774,13 @@ public:
 
     virtual bool GetPublishedBodyJointValues(const std::string& name, std::vector<dReal> &jointValues, uint64_t timeout=0)
     {
-        TimedSharedLock lock(_mutexInterfaces, timeout);
-        if (!lock) {
-            throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
+        PublishedBodiesConstPtr pbodies = GetPublishedBodiesSnapshot();
+        if( !pbodies ) {
+            return false;
         }
-        for ( size_t ibody = 0; ibody < _vPublishedBodies.size(); ++ibody) {
-            if ( _vPublishedBodies[ibody].strname == name) {
-                jointValues = _vPublishedBodies[ibody].jointvalues;
+        for ( size_t ibody = 0; ibody < pbodies->size(); ++ibody) {
+            if ( (*pbodies)[ibody].strname == name) {
+                jointValues = (*pbodies)[ibody].jointvalues;
                 return true;
             }
         }
@@ -2547,18 +2790,17 @@ public:
 
     void GetPublishedBodyTransformsMatchingPrefix(const std::string& prefix, std::vector<std::pair<std::string, Transform> >& nameTransfPairs, uint64_t timeout = 0)
     {
-        TimedSharedLock lock(_mutexInterfaces, timeout);
-        if (!lock) {
-            throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
-        }
-
+        PublishedBodiesConstPtr pbodies = GetPublishedBodiesSnapshot();
         nameTransfPairs.resize(0);
-        if( nameTransfPairs.capacity() < _vPublishedBodies.size() ) {
-            nameTransfPairs.reserve(_vPublishedBodies.size());
+        if( !pbodies ) {
+            return;
+        }
+        if( nameTransfPairs.capacity() < pbodies->size() ) {
+            nameTransfPairs.reserve(pbodies->size());
         }
-        for ( size_t ibody = 0; ibody < _vPublishedBodies.size(); ++ibody) {
-            if ( strncmp(_vPublishedBodies[ibody].strname.c_str(), prefix.c_str(), prefix.size()) == 0 ) {
-                nameTransfPairs.emplace_back(_vPublishedBodies[ibody].strname,  _vPublishedBodies[ibody].vectrans.at(0));
+        for ( size_t ibody = 0; ibody < pbodies->size(); ++ibody) {
+            if ( strncmp((*pbodies)[ibody].strname.c_str(), prefix.c_str(), prefix.size()) == 0 ) {
+                nameTransfPairs.emplace_back((*pbodies)[ibody].strname,  (*pbodies)[ibody].vectrans.at(0));
             }
         }
     }
@@ -2566,20 +2808,53 @@ public:
     virtual void UpdatePublishedBodies(uint64_t timeout=0)
     {
         EnvironmentMutex::scoped_lock lockenv(GetMutex());
-        TimedExclusiveLock lock(_mutexInterfaces, timeout);
+        // bodies cannot be added or removed while the environment is locked, the shared lock only keeps out Destroy/Reset
+        TimedSharedLock lock(_mutexInterfaces, timeout);
         if (!lock) {
             throw OPENRAVE_EXCEPTION_FORMAT(_("timeout of %f s failed"),(1e-6*static_cast<double>(timeout)),ORE_Timeout);
         }
         _UpdatePublishedBodies();
     }
 
-    /// assumes GetMutex() and _mutexInterfaces are both exclusively locked
+    /// \brief writes a new snapshot of the bodies and publishes it
+    ///
+    /// The snapshot is written into a buffer of an older epoch that no reader holds anymore. Bodies whose update stamp
+    /// did not change since that epoch keep their link transforms and joint values, and the existing string and vector
+    /// storage is reused. The snapshot is only published once it is complete, so an exception leaves the previous one visible.
+    /// assumes GetMutex() is locked and _mutexInterfaces is at least shared locked
     virtual void _UpdatePublishedBodies()
     {
-        // updated the published bodies, resize dynamically in case an exception occurs
-        // when creating an item and bad data is left inside _vPublishedBodies
-        _vPublishedBodies.resize(_GetNumBodies());
-        int iwritten = 0;
+        PublishedBodiesConstPtr pcurrent = boost::atomic_load(&_pPublishedBodies);
+        PublishedBodiesPtr pbodies;
+        for(size_t ibuffer = 0; ibuffer < _vPublishedBodiesBuffers.size(); ++ibuffer) {
+            // readers only get to the current snapshot, so the count of older buffers can only go down
+            if( _vPublishedBodiesBuffers[ibuffer].use_count() == 1 ) {
+                pbodies = _vPublishedBodiesBuffers[ibuffer];
+                break;
+            }
+        }
+        if( !pbodies ) {
+            pbodies.reset(new std::vector<KinBody::BodyState>());
+            if( _vPublishedBodiesBuffers.size() >= 3 ) {
+                // all buffers are held by slow readers, stop tracking the ones that are not current and let the readers free them
+                std::vector<PublishedBodiesPtr>::iterator itbuffer = _vPublishedBodiesBuffers.begin();
+                while(itbuffer != _vPublishedBodiesBuffers.end()) {
+                    if( *itbuffer != pcurrent ) {
+                        itbuffer = _vPublishedBodiesBuffers.erase(itbuffer);
+                    }
+                    else {
+                        ++itbuffer;
+                    }
+                }
+            }
+            _vPublishedBodiesBuffers.push_back(pbodies);
+        }
+
+        std::vector<KinBody::BodyState>& vbodies = *pbodies;
+        if( vbodies.size() < _vecbodies.size() ) {
+            vbodies.resize(_vecbodies.size());
+        }
+        size_t iwritten = 0;
 
         std::vector<dReal> vdoflastsetvalues;
         for(const KinBodyPtr& pbody : _vecbodies) {
@@ -2591,17 +2866,23 @@ public:
                 continue;
             }
 
-            KinBody::BodyState& state = _vPublishedBodies.at(iwritten);
-            state.Reset();
-            state.pbody = pbody;
-            pbody->GetLinkTransformations(state.vectrans, vdoflastsetvalues);
+            KinBody::BodyState& state = vbodies[iwritten];
+            if( state.pbody != pbody || state.updatestamp != pbody->GetUpdateStamp() ) {
+                // link transforms and joint values only change with the update stamp. set pbody last so that an exception cannot leave a matching but stale state
+                state.pbody.reset();
+                pbody->GetLinkTransformations(state.vectrans, vdoflastsetvalues);
+                pbody->GetDOFValues(state.jointvalues);
+                state.updatestamp = pbody->GetUpdateStamp();
+                state.pbody = pbody;
+            }
             pbody->GetLinkEnableStates(state.vLinkEnableStates);
-            pbody->GetDOFValues(state.jointvalues);
             pbody->GetGrabbedInfo(state.vGrabbedInfos);
-            state.strname =pbody->GetName();
+            state.strname = pbody->GetName();
             state.uri = pbody->GetURI();
-            state.updatestamp = pbody->GetUpdateStamp();
             state.environmentid = pbody->GetEnvironmentBodyIndex();
+            state.activeManipulatorName.clear();
+            state.activeManipulatorTransform = Transform();
+            state.vConnectedBodyActiveStates.clear();
             if( pbody->IsRobot() ) {
                 RobotBasePtr probot = RaveInterfaceCast<RobotBase>(pbody);
                 if( !!probot ) {
@@ -2616,8 +2897,57 @@ public:
             ++iwritten;
         }
 
-        if( iwritten < (int)_vPublishedBodies.size() ) {
-            _vPublishedBodies.resize(iwritten);
+        if( iwritten < vbodies.size() ) {
+            vbodies.resize(iwritten);
+        }
+        boost::atomic_store(&_pPublishedBodies, PublishedBodiesConstPtr(pbodies));
+    }
+
+    /// \brief removes the published snapshot and all the buffers so that no body is referenced anymore
+    ///
+    /// assumes _mutexInterfaces is exclusively locked
+    void _ClearPublishedBodies()
+    {
+        boost::atomic_store(&_pPublishedBodies, PublishedBodiesConstPtr());
+        _vPublishedBodiesBuffers.clear();
+    }
+
+    /// \brief drops the references to a removed body from the published buffers of previous epochs
+    ///
+    /// Buffers that no reader holds are cleared in place. Buffers still held by readers cannot be modified, so they are
+    /// no longer tracked and are freed with their references once the readers let go of them. The current snapshot keeps
+    /// the body until the next update.
+    /// assumes _mutexInterfaces is exclusively locked
+    void _ReleasePublishedBody(const KinBody& body)
+    {
+        PublishedBodiesConstPtr pcurrent = boost::atomic_load(&_pPublishedBodies);
+        std::vector<PublishedBodiesPtr>::iterator itbuffer = _vPublishedBodiesBuffers.begin();
+        while(itbuffer != _vPublishedBodiesBuffers.end()) {
+            if( *itbuffer == pcurrent ) {
+                ++itbuffer;
+                continue;
+            }
+            if( itbuffer->use_count() > 1 ) {
+                bool bHasBody = false;
+                for(const KinBody::BodyState& state : **itbuffer) {
+                    if( state.pbody.get() == &body ) {
+                        bHasBody = true;
+                        break;
+                    }
+                }
+                if( bHasBody ) {
+                    itbuffer = _vPublishedBodiesBuffers.erase(itbuffer);
+                    continue;
+                }
+            }
+            else {
+                for(KinBody::BodyState& state : **itbuffer) {
+                    if( state.pbody.get() == &body ) {
+                        state.pbody.reset();
+                    }
+                }
+            }
+            ++itbuffer;
         }
     }
 
@@ -2718,6 +3048,10 @@ public:
         }
         std::vector<int> vUsedBodyIndices; // used indices of vBodies
 
+        // bodies that cannot match anything in the env are created and initialized in parallel, then added below in order
+        std::vector<KinBodyPtr> vPrebuiltBodies;
+        _PrebuildNewKinBodies(info, vBodies, vPrebuiltBodies);
+
         // internally manipulates _vecbodies using _AddKinBody/_AddRobot/_RemoveKinBodyFromIterator
         for(int inputBodyIndex = 0; inputBodyIndex < (int)info._vBodyInfos.size(); ++inputBodyIndex) {
             const KinBody::KinBodyInfoConstPtr& pKinBodyInfo = info._vBodyInfos[inputBodyIndex];
@@ -2929,11 +3263,16 @@ public:
                 }
                 else {
                     RAVELOG_VERBOSE_FORMAT("add new kinbody %s", pKinBodyInfo->_id);
-                    pNewBody = RaveCreateKinBody(shared_from_this(), pKinBodyInfo->_interfaceType);
-                    if( !pNewBody ) {
-                        pNewBody = RaveCreateKinBody(shared_from_this(), "");
+                    if( inputBodyIndex < (int)vPrebuiltBodies.size() && !!vPrebuiltBodies[inputBodyIndex] ) {
+                        pNewBody.swap(vPrebuiltBodies[inputBodyIndex]);
+                    }
+                    else {
+                        pNewBody = RaveCreateKinBody(shared_from_this(), pKinBodyInfo->_interfaceType);
+                        if( !pNewBody ) {
+                            pNewBody = RaveCreateKinBody(shared_from_this(), "");
+                        }
+                        pNewBody->InitFromKinBodyInfo(*pKinBodyInfo);
                     }
-                    pNewBody->InitFromKinBodyInfo(*pKinBodyInfo);
                     pInitBody = pNewBody;
                     _AddKinBody(pNewBody, IAM_AllowRenaming);
                 }
@@ -3204,6 +3543,7 @@ protected:
             _pPhysicsEngine->RemoveKinBody(pbodyref);
         }
         body._PostprocessChangedParameters(KinBody::Prop_BodyRemoved);
+        _ReleasePublishedBody(body);
 
         // invalidate cache
         if (_mapBodyNameIndex.erase(name) == 0) {
@@ -3295,7 +3635,7 @@ protected:
                 _mapBodyIdIndex.clear();
                 _environmentIndexRecyclePool.clear();
 
-                _vPublishedBodies.clear();
+                _ClearPublishedBodies();
             }
         }
 
@@ -4171,6 +4511,10 @@ protected:
 
     list< std::pair<ModuleBasePtr, std::string> > _listModules;     ///< modules loaded in the environment and the strings they were intialized with. Initialization strings are used for cloning. protectred by _mutexInterfaces
     list<SensorBasePtr> _listSensors;     ///< sensors loaded in the environment. protectred by _mutexInterfaces
+    std::vector<KinBodyPtr> _vStepBodies; ///< buffer of StepSimulation, protected by _mutexEnvironment
+    std::vector<ModuleBasePtr> _vStepModules; ///< buffer of StepSimulation, protected by _mutexEnvironment
+    std::vector<SensorBasePtr> _vStepSensors, _vStepReadOnlySensors; ///< buffers of StepSimulation, protected by _mutexEnvironment
+    SensorSimulationWorkers _sensorworkers; ///< steps the read-only sensors in parallel
     list<ViewerBasePtr> _listViewers;     ///< viewers loaded in the environment. protectred by _mutexInterfaces
 
     dReal _fDeltaSimTime;                    ///< delta time for simulate step
@@ -4191,7 +4535,9 @@ protected:
 
     mutable boost::mutex _mutexInit;     ///< lock for destroying the environment
 
-    vector<KinBody::BodyState> _vPublishedBodies; ///< protected by _mutexInterfaces
+    typedef boost::shared_ptr< std::vector<KinBody::BodyState> > PublishedBodiesPtr;
+    PublishedBodiesConstPtr _pPublishedBodies; ///< the latest published snapshot, immutable once published. only accessed through boost::atomic_load/atomic_store
+    std::vector<PublishedBodiesPtr> _vPublishedBodiesBuffers; ///< snapshots of the previous epochs, reused for writing once no reader holds them. see _UpdatePublishedBodies
     string _homedirectory;
     std::pair<std::string, dReal> _unit; ///< unit name mm, cm, inches, m and the conversion for meters
 
@@ -22,6 +22,10 @@
 #include <rapidjson/istreamwrapper.h>
 #include <string>
 #include <fstream>
+#include <list>
+
+#include <boost/function.hpp>
+#include <boost/thread/mutex.hpp>
 
 #ifdef HAVE_BOOST_FILESYSTEM
 #include <boost/filesystem/operations.hpp>
@@ -53,11 +57,12 @@ static bool _ReplaceFilenameSuffix(std::string& filename, const std::string& old
 }
 
 /// \brief open and cache a msgpack document
+///
+/// The file is decoded into a rapidjson document like json files, so the KinBodyInfo and EnvironmentBaseInfo structures are deserialized from the document afterwards.
 static void OpenMsgPackDocument(const std::string& filename, rapidjson::Document& doc)
 {
-    std::ifstream ifs(filename.c_str());
     try {
-        MsgPack::ParseMsgPack(doc, ifs);
+        MsgPack::ParseMsgPackFile(doc, filename);
     }
     catch(const std::exception& ex) {
         throw OPENRAVE_EXCEPTION_FORMAT("Failed to parse msgpack format for file '%s': %s", filename%ex.what(), ORE_Failed);
@@ -75,6 +80,233 @@ static void OpenRapidJsonDocument(const std::string& filename, rapidjson::Docume
     }
 }
 
+/// \brief copies the info and the infos it points to, so that deserializing into the copy does not change the original
+static KinBody::LinkInfoPtr _CloneLinkInfo(const KinBody::LinkInfo& info)
+{
+    KinBody::LinkInfoPtr pinfo(new KinBody::LinkInfo(info));
+    FOREACH(itgeometry, pinfo->_vgeometryinfos) {
+        if( !!*itgeometry ) {
+            itgeometry->reset(new KinBody::GeometryInfo(**itgeometry));
+        }
+    }
+    FOREACH(itextra, pinfo->_mapExtraGeometries) {
+        FOREACH(itgeometry, itextra->second) {
+            if( !!*itgeometry ) {
+                itgeometry->reset(new KinBody::GeometryInfo(**itgeometry));
+            }
+        }
+    }
+    return pinfo;
+}
+
+static KinBody::JointInfoPtr _CloneJointInfo(const KinBody::JointInfo& info)
+{
+    KinBody::JointInfoPtr pinfo(new KinBody::JointInfo(info));
+    if( !!pinfo->_infoElectricMotor ) {
+        pinfo->_infoElectricMotor.reset(new ElectricMotorActuatorInfo(*pinfo->_infoElectricMotor));
+    }
+    // Joint::SetMimicEquations writes the equations back into the mimic infos of the joint
+    FOREACH(itmimic, pinfo->_vmimic) {
+        if( !!*itmimic ) {
+            itmimic->reset(new KinBody::MimicInfo(**itmimic));
+        }
+    }
+    return pinfo;
+}
+
+template <typename T>
+static void _CloneInfos(std::vector< boost::shared_ptr<T> >& vinfos)
+{
+    FOREACH(itinfo, vinfos) {
+        if( !!*itinfo ) {
+            itinfo->reset(new T(**itinfo));
+        }
+    }
+}
+
+static void _CloneLinkJointInfos(std::vector<KinBody::LinkInfoPtr>& vLinkInfos, std::vector<KinBody::JointInfoPtr>& vJointInfos)
+{
+    FOREACH(itlink, vLinkInfos) {
+        if( !!*itlink ) {
+            *itlink = _CloneLinkInfo(**itlink);
+        }
+    }
+    FOREACH(itjoint, vJointInfos) {
+        if( !!*itjoint ) {
+            *itjoint = _CloneJointInfo(**itjoint);
+        }
+    }
+}
+
+/// \brief copies a KinBodyInfo or RobotBaseInfo together with all the infos it points to
+static KinBody::KinBodyInfoPtr _CloneKinBodyInfo(const KinBody::KinBodyInfo& info)
+{
+    KinBody::KinBodyInfoPtr pinfo;
+    const RobotBase::RobotBaseInfo* pRobotBaseInfo = dynamic_cast<const RobotBase::RobotBaseInfo*>(&info);
+    if( !!pRobotBaseInfo ) {
+        RobotBase::RobotBaseInfoPtr pNewRobotBaseInfo(new RobotBase::RobotBaseInfo(*pRobotBaseInfo));
+        _CloneInfos(pNewRobotBaseInfo->_vManipulatorInfos);
+        _CloneInfos(pNewRobotBaseInfo->_vAttachedSensorInfos);
+        _CloneInfos(pNewRobotBaseInfo->_vGripperInfos);
+        _CloneInfos(pNewRobotBaseInfo->_vConnectedBodyInfos);
+        FOREACH(itconnected, pNewRobotBaseInfo->_vConnectedBodyInfos) {
+            if( !!*itconnected ) {
+                _CloneLinkJointInfos((*itconnected)->_vLinkInfos, (*itconnected)->_vJointInfos);
+                _CloneInfos((*itconnected)->_vManipulatorInfos);
+                _CloneInfos((*itconnected)->_vAttachedSensorInfos);
+                _CloneInfos((*itconnected)->_vGripperInfos);
+            }
+        }
+        pinfo = pNewRobotBaseInfo;
+    }
+    else {
+        pinfo.reset(new KinBody::KinBodyInfo(info));
+    }
+    _CloneInfos(pinfo->_vGrabbedInfos);
+    _CloneLinkJointInfos(pinfo->_vLinkInfos, pinfo->_vJointInfos);
+    FOREACH(itreadable, pinfo->_mReadableInterfaces) {
+        if( !!itreadable->second ) {
+            itreadable->second = itreadable->second->CloneSelf();
+        }
+    }
+    return pinfo;
+}
+
+/// \brief process-wide cache of parsed referenced documents and the bodies expanded from them, shared by all JSONReader instances
+///
+/// Entries are validated against the file modification time and size, and the least recently used documents are
+/// dropped once the total size of the cached files exceeds the limit. The limit in megabytes can be changed with
+/// OPENRAVE_JSON_DOCUMENT_CACHE_SIZE, 0 disables the cache. Cached documents own their allocator and are never modified.
+/// Expanded bodies are stored with the document they were expanded from and dropped together with it.
+class JSONDocumentCache
+{
+public:
+    /// \brief a body expanded from a referenced document with all its nested references applied
+    struct ExpandedBodyInfo
+    {
+        KinBody::KinBodyInfoConstPtr pinfo; ///< never modified, has to be cloned with _CloneKinBodyInfo before use
+        std::vector< std::pair<std::string, boost::shared_ptr<const rapidjson::Document> > > vdependencies; ///< full filename and document of every document used for the expansion
+    };
+
+    static JSONDocumentCache& GetInstance()
+    {
+        static JSONDocumentCache s_cache;
+        return s_cache;
+    }
+
+    /// \brief returns the cached document of fullFilename if it is still up to date, otherwise parses it with fnOpen
+    boost::shared_ptr<const rapidjson::Document> Get(const std::string& fullFilename, const boost::function<void(const std::string&, rapidjson::Document&)>& fnOpen)
+    {
+        int64_t modifiedtime = 0;
+        uint64_t filesize = 0;
+        bool bCanCache = _maxbytes > 0;
+#ifdef HAVE_BOOST_FILESYSTEM
+        if( bCanCache ) {
+            try {
+                modifiedtime = boost::filesystem::last_write_time(fullFilename);
+                filesize = boost::filesystem::file_size(fullFilename);
+            }
+            catch(const boost::filesystem::filesystem_error&) {
+                bCanCache = false;
+            }
+        }
+#else
+        bCanCache = false; // cannot validate entries
+#endif
+        if( bCanCache ) {
+            boost::mutex::scoped_lock lock(_mutex);
+            std::map<std::string, CacheEntry>::iterator it = _mapEntries.find(fullFilename);
+            if( it != _mapEntries.end() ) {
+                if( it->second.modifiedtime == modifiedtime && it->second.filesize == filesize ) {
+                    _listRecentlyUsed.splice(_listRecentlyUsed.begin(), _listRecentlyUsed, it->second.itRecentlyUsed);
+                    return it->second.doc;
+                }
+                _Erase(it);
+            }
+        }
+
+        // parse outside the lock
+        boost::shared_ptr<rapidjson::Document> newDoc(new rapidjson::Document());
+        fnOpen(fullFilename, *newDoc);
+        if( !bCanCache || filesize > _maxbytes ) {
+            return newDoc;
+        }
+
+        boost::mutex::scoped_lock lock(_mutex);
+        std::map<std::string, CacheEntry>::iterator it = _mapEntries.find(fullFilename);
+        if( it != _mapEntries.end() ) {
+            _Erase(it); // another thread loaded it in the meantime
+        }
+        while( _totalbytes + filesize > _maxbytes && !_listRecentlyUsed.empty() ) {
+            _Erase(_mapEntries.find(_listRecentlyUsed.back()));
+        }
+        CacheEntry& entry = _mapEntries[fullFilename];
+        entry.doc = newDoc;
+        entry.modifiedtime = modifiedtime;
+        entry.filesize = filesize;
+        entry.itRecentlyUsed = _listRecentlyUsed.insert(_listRecentlyUsed.begin(), fullFilename);
+        _totalbytes += filesize;
+        return newDoc;
+    }
+
+    /// \brief returns the body expanded from doc with key. doc has to be the document of fullFilename returned by Get.
+    bool GetExpandedBodyInfo(const std::string& fullFilename, const boost::shared_ptr<const rapidjson::Document>& doc, const std::string& key, ExpandedBodyInfo& expanded)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        std::map<std::string, CacheEntry>::const_iterator it = _mapEntries.find(fullFilename);
+        if( it == _mapEntries.end() || it->second.doc != doc ) {
+            return false;
+        }
+        std::map<std::string, ExpandedBodyInfo>::const_iterator itexpanded = it->second.mapExpandedBodyInfos.find(key);
+        if( itexpanded == it->second.mapExpandedBodyInfos.end() ) {
+            return false;
+        }
+        expanded = itexpanded->second;
+        return true;
+    }
+
+    /// \brief stores a body expanded from doc, ignored if doc is not cached anymore
+    void SetExpandedBodyInfo(const std::string& fullFilename, const boost::shared_ptr<const rapidjson::Document>& doc, const std::string& key, const ExpandedBodyInfo& expanded)
+    {
+        boost::mutex::scoped_lock lock(_mutex);
+        std::map<std::string, CacheEntry>::iterator it = _mapEntries.find(fullFilename);
+        if( it != _mapEntries.end() && it->second.doc == doc ) {
+            it->second.mapExpandedBodyInfos[key] = expanded;
+        }
+    }
+
+private:
+    struct CacheEntry
+    {
+        boost::shared_ptr<const rapidjson::Document> doc;
+        int64_t modifiedtime = 0;
+        uint64_t filesize = 0;
+        std::list<std::string>::iterator itRecentlyUsed;
+        std::map<std::string, ExpandedBodyInfo> mapExpandedBodyInfos; ///< bodies expanded from doc, keyed by the referenced fragment and the scales
+    };
+
+    JSONDocumentCache()
+    {
+        const char* pcachesize = std::getenv("OPENRAVE_JSON_DOCUMENT_CACHE_SIZE");
+        if( !!pcachesize ) {
+            _maxbytes = (uint64_t)(std::max(0.0, std::atof(pcachesize))*1024*1024);
+        }
+    }
+
+    void _Erase(std::map<std::string, CacheEntry>::iterator it)
+    {
+        _totalbytes -= it->second.filesize;
+        _listRecentlyUsed.erase(it->second.itRecentlyUsed);
+        _mapEntries.erase(it);
+    }
+
+    boost::mutex _mutex;
+    std::map<std::string, CacheEntry> _mapEntries; ///< full filename -> parsed document
+    std::list<std::string> _listRecentlyUsed; ///< full filenames, most recently used first
+    uint64_t _totalbytes = 0; ///< sum of the file sizes of all entries
+    uint64_t _maxbytes = 256*1024*1024;
+};
+
 /// \brief get the scheme of the uri, e.g. file: or openrave:
 static void ParseURI(const std::string& uri, std::string& scheme, std::string& path, std::string& fragment)
 {
@@ -387,22 +619,19 @@ protected:
     boost::shared_ptr<const rapidjson::Document> _GetDocumentFromFilename(const std::string& fullFilename, rapidjson::Document::AllocatorType& alloc)
     {
         boost::shared_ptr<const rapidjson::Document> doc;
-        // TODO: optimize this. for the first time doc is cached, all the expandable object will never get cached, because we are not update document cache after expand any body
-        if (_rapidJSONDocuments.find(fullFilename) != _rapidJSONDocuments.end()) {
-            doc = _rapidJSONDocuments[fullFilename];
+        std::map<std::string, boost::shared_ptr<const rapidjson::Document> >::const_iterator itdoc = _rapidJSONDocuments.find(fullFilename);
+        if (itdoc != _rapidJSONDocuments.end()) {
+            doc = itdoc->second;
         }
         else {
-            boost::shared_ptr<rapidjson::Document> newDoc;
+            // referenced documents are shared across readers, so they use their own allocator rather than alloc
             if (_EndsWith(fullFilename, ".json")) {
-                newDoc.reset(new rapidjson::Document(&alloc));
-                OpenRapidJsonDocument(fullFilename, *newDoc);
+                doc = JSONDocumentCache::GetInstance().Get(fullFilename, OpenRapidJsonDocument);
             }
             else if (_EndsWith(fullFilename, ".msgpack")) {
-                newDoc.reset(new rapidjson::Document(&alloc));
-                OpenMsgPackDocument(fullFilename, *newDoc);
+                doc = JSONDocumentCache::GetInstance().Get(fullFilename, OpenMsgPackDocument);
             }
-            if (!!newDoc) {
-                doc = newDoc;
+            if (!!doc) {
                 _rapidJSONDocuments[fullFilename] = doc;
             }
         }
@@ -459,11 +688,121 @@ protected:
         }
     }
 
+    /// \brief resolves the path of a referenceUri with a scheme, relative paths are also searched next to currentFilename
+    std::string _ResolveReferenceFilename(const std::string& scheme, const std::string& path, const std::string& currentFilename)
+    {
+        std::string fullFilename = ResolveURI(scheme, path, std::string(), GetOpenRAVESchemeAliases());
+#ifdef HAVE_BOOST_FILESYSTEM
+        if (fullFilename.empty()) {
+            fullFilename = ResolveURI(scheme, path, boost::filesystem::path(currentFilename).parent_path().string(), GetOpenRAVESchemeAliases());
+        }
+#endif
+        return fullFilename;
+    }
+
+    /// \brief returns true if all the documents are still the ones the cache returns for their files
+    bool _AreDocumentsCurrent(const std::vector< std::pair<std::string, boost::shared_ptr<const rapidjson::Document> > >& vdocuments, rapidjson::Document::AllocatorType& alloc)
+    {
+        FOREACHC(itdocument, vdocuments) {
+            if( _GetDocumentFromFilename(itdocument->first, alloc) != itdocument->second ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
     /// \param originBodyId optional parameter to search into the current envInfo. If empty, then always create a new object
     /// \param rEnvInfo[in] used for resolving references pointing to the current environment
     ///
+    /// References to other files that create a new body are expanded once per process and copied from JSONDocumentCache afterwards.
+    ///
     /// \return the index into envInfo._vBodyInfos where the entry was edited. If failed, then return -1
     int _ExpandRapidJSON(EnvironmentBase::EnvironmentBaseInfo& envInfo, const std::string& originBodyId, const std::string& originBodyName, const rapidjson::Value& rEnvInfo, const std::string& referenceUri, std::set<std::string>& circularReference, dReal fUnitScale, rapidjson::Document::AllocatorType& alloc, const std::string& currentFilename) {
+        if( circularReference.empty() ) {
+            _vExpandDependencies.clear();
+        }
+        std::string scheme, path, fragment;
+        ParseURI(referenceUri, scheme, path, fragment);
+        if( scheme.empty() || path.empty() || circularReference.find(referenceUri) != circularReference.end() ) {
+            return _ExpandReferenceUri(envInfo, originBodyId, originBodyName, rEnvInfo, referenceUri, circularReference, fUnitScale, alloc, currentFilename);
+        }
+        // existing bodies are updated in place, so only new bodies come from the cache
+        if( !originBodyId.empty() ) {
+            FOREACHC(itBodyInfo, envInfo._vBodyInfos) {
+                if( (*itBodyInfo)->_id == originBodyId ) {
+                    return _ExpandReferenceUri(envInfo, originBodyId, originBodyName, rEnvInfo, referenceUri, circularReference, fUnitScale, alloc, currentFilename);
+                }
+            }
+        }
+        _ReplaceFilenameSuffix(path, ".dae", _defaultSuffix);
+        std::string fullFilename = _ResolveReferenceFilename(scheme, path, currentFilename);
+        boost::shared_ptr<const rapidjson::Document> referenceDoc;
+        if( !fullFilename.empty() ) {
+            referenceDoc = _GetDocumentFromFilename(fullFilename, alloc);
+        }
+        if( !referenceDoc ) {
+            return _ExpandReferenceUri(envInfo, originBodyId, originBodyName, rEnvInfo, referenceUri, circularReference, fUnitScale, alloc, currentFilename);
+        }
+
+        std::string key = str(boost::format("%s %.15e %.15e %.15e %d")%fragment%fUnitScale%_fGlobalScale%_fGeomScale%_deserializeOptions);
+        JSONDocumentCache::ExpandedBodyInfo expanded;
+        if( JSONDocumentCache::GetInstance().GetExpandedBodyInfo(fullFilename, referenceDoc, key, expanded) && _AreDocumentsCurrent(expanded.vdependencies, alloc) ) {
+            RAVELOG_VERBOSE_FORMAT("env=%d, using cached body expanded from '%s'. Scope is '%s'", _penv->GetId()%referenceUri%currentFilename);
+            _vExpandDependencies.insert(_vExpandDependencies.end(), expanded.vdependencies.begin(), expanded.vdependencies.end());
+            return _InsertNewBodyInfo(envInfo, _CloneKinBodyInfo(*expanded.pinfo), originBodyId, originBodyName, currentFilename);
+        }
+
+        size_t idependency = _vExpandDependencies.size();
+        EnvironmentBase::EnvironmentBaseInfo expandedEnvInfo;
+        int expandedIndex = _ExpandReferenceUri(expandedEnvInfo, std::string(), std::string(), rEnvInfo, referenceUri, circularReference, fUnitScale, alloc, currentFilename);
+        if( expandedIndex < 0 ) {
+            return -1;
+        }
+        KinBody::KinBodyInfoPtr pNewKinBodyInfo = expandedEnvInfo._vBodyInfos.at(expandedIndex);
+        expanded.pinfo = _CloneKinBodyInfo(*pNewKinBodyInfo);
+        expanded.vdependencies.assign(_vExpandDependencies.begin()+idependency, _vExpandDependencies.end());
+        JSONDocumentCache::GetInstance().SetExpandedBodyInfo(fullFilename, referenceDoc, key, expanded);
+        return _InsertNewBodyInfo(envInfo, pNewKinBodyInfo, originBodyId, originBodyName, currentFilename);
+    }
+
+    /// \brief inserts a newly expanded body, replacing the body with the same name if originBodyId is empty
+    ///
+    /// \return the index into envInfo._vBodyInfos
+    int _InsertNewBodyInfo(EnvironmentBase::EnvironmentBaseInfo& envInfo, KinBody::KinBodyInfoPtr pNewKinBodyInfo, const std::string& originBodyId, const std::string& originBodyName, const std::string& currentFilename)
+    {
+        if( !originBodyId.empty() ) {
+            pNewKinBodyInfo->_id = originBodyId;
+        }
+
+        if( pNewKinBodyInfo->_name.empty() ) {
+            RAVELOG_DEBUG_FORMAT("env=%d, kinbody id='%s' has empty name, coming from file '%s', perhaps it will get overwritten later.", _penv->GetId()%originBodyId%currentFilename);
+        }
+
+        int insertIndex = -1;
+        if( originBodyId.empty() ) {
+            // try matching with names
+            for(int ibody = 0; ibody < (int)envInfo._vBodyInfos.size(); ++ibody) {
+                KinBody::KinBodyInfoPtr& pExistingBodyInfo = envInfo._vBodyInfos[ibody];
+                if( !originBodyName.empty() && pExistingBodyInfo->_name == originBodyName ) {
+                    RAVELOG_VERBOSE_FORMAT("env=%d, found existing body with id='%s', name='%s', so overwriting it. Scope is '%s'", _penv->GetId()%originBodyId%pNewKinBodyInfo->_name%currentFilename);
+                    envInfo._vBodyInfos[ibody] = pNewKinBodyInfo;
+                    insertIndex = ibody;
+                    break;
+                }
+            }
+        }
+
+        if( insertIndex < 0 ) {
+            // might get overwritten later, so ok if name is empty
+            insertIndex = envInfo._vBodyInfos.size();
+            envInfo._vBodyInfos.push_back(pNewKinBodyInfo);
+            RAVELOG_DEBUG_FORMAT("env=%d, could not find existing body with id='%s', name='%s', so inserting it. Scope is '%s'", _penv->GetId()%originBodyId%pNewKinBodyInfo->_name%currentFilename);
+        }
+        return insertIndex;
+    }
+
+    /// \brief expands referenceUri without looking at the cache of expanded bodies, nested references go through _ExpandRapidJSON
+    int _ExpandReferenceUri(EnvironmentBase::EnvironmentBaseInfo& envInfo, const std::string& originBodyId, const std::string& originBodyName, const rapidjson::Value& rEnvInfo, const std::string& referenceUri, std::set<std::string>& circularReference, dReal fUnitScale, rapidjson::Document::AllocatorType& alloc, const std::string& currentFilename) {
         if (circularReference.find(referenceUri) != circularReference.end()) {
             RAVELOG_ERROR_FORMAT("failed to load scene, circular reference to '%s' found on body %s", referenceUri%originBodyId);
             return -1;
@@ -514,19 +853,14 @@ protected:
             if( _ReplaceFilenameSuffix(path, ".dae", _defaultSuffix) ) {
                 RAVELOG_WARN_FORMAT("env=%d, filename had '.dae' suffix, so changed to %s", _penv->GetId()%path);
             }
-            std::string fullFilename = ResolveURI(scheme, path, std::string(), GetOpenRAVESchemeAliases());
+            std::string fullFilename = _ResolveReferenceFilename(scheme, path, currentFilename);
             if (fullFilename.empty()) {
-#ifdef HAVE_BOOST_FILESYSTEM
-                fullFilename = ResolveURI(scheme, path, boost::filesystem::path(currentFilename).parent_path().string(), GetOpenRAVESchemeAliases());
-#endif
-                if (fullFilename.empty()) {
-                    RAVELOG_ERROR_FORMAT("env=%d, failed to resolve referenceUri '%s' into a file. Coming from bodyId='%s', bodyName='%s' in file '%s'", _penv->GetId()%referenceUri%originBodyId%originBodyName%currentFilename);
-                    if (_bMustResolveURI) {
-                        throw OPENRAVE_EXCEPTION_FORMAT("Failed to resolve referenceUri='%s' in body definition '%s' from file '%s'", referenceUri%originBodyId%currentFilename, ORE_InvalidURI);
-                    }
-
-                    return -1;
+                RAVELOG_ERROR_FORMAT("env=%d, failed to resolve referenceUri '%s' into a file. Coming from bodyId='%s', bodyName='%s' in file '%s'", _penv->GetId()%referenceUri%originBodyId%originBodyName%currentFilename);
+                if (_bMustResolveURI) {
+                    throw OPENRAVE_EXCEPTION_FORMAT("Failed to resolve referenceUri='%s' in body definition '%s' from file '%s'", referenceUri%originBodyId%currentFilename, ORE_InvalidURI);
                 }
+
+                return -1;
             }
 
             uint64_t beforeOpenStampUS = utils::GetMonotonicTime();
@@ -536,6 +870,7 @@ protected:
                 RAVELOG_ERROR_FORMAT("referenced document cannot be loaded, or has no bodies: %s", fullFilename);
                 return -1;
             }
+            _vExpandDependencies.emplace_back(fullFilename, referenceDoc);
 
             fRefUnitScale = _GetUnitScale(*referenceDoc, 1.0); // for now default has to be meters... fUnitScale);
 
@@ -613,34 +948,7 @@ protected:
                 pNewKinBodyInfo.reset(new KinBody::KinBodyInfo());
             }
             pNewKinBodyInfo->DeserializeJSON(rRefKinBodyInfo, fRefUnitScale, _deserializeOptions);
-
-            if( !originBodyId.empty() ) {
-                pNewKinBodyInfo->_id = originBodyId;
-            }
-
-            if( pNewKinBodyInfo->_name.empty() ) {
-                RAVELOG_DEBUG_FORMAT("env=%d, kinbody id='%s' has empty name, coming from file '%s', perhaps it will get overwritten later. Data is %s. Scope is '%s'", _penv->GetId()%originBodyId%currentFilename%orjson::DumpJson(rRefKinBodyInfo)%currentFilename);
-            }
-
-            if( originBodyId.empty() ) {
-                // try matching with names
-                for(int ibody = 0; ibody < (int)envInfo._vBodyInfos.size(); ++ibody) {
-                    KinBody::KinBodyInfoPtr& pExistingBodyInfo = envInfo._vBodyInfos[ibody];
-                    if( !originBodyName.empty() && pExistingBodyInfo->_name == originBodyName ) {
-                        RAVELOG_VERBOSE_FORMAT("env=%d, found existing body with id='%s', name='%s', so overwriting it. Scope is '%s'", _penv->GetId()%originBodyId%pNewKinBodyInfo->_name%currentFilename);
-                        envInfo._vBodyInfos[ibody] = pNewKinBodyInfo;
-                        insertIndex = ibody;
-                        break;
-                    }
-                }
-            }
-
-            if( insertIndex < 0 ) {
-                // might get overwritten later, so ok if name is empty
-                insertIndex = envInfo._vBodyInfos.size();
-                envInfo._vBodyInfos.push_back(pNewKinBodyInfo);
-                RAVELOG_DEBUG_FORMAT("env=%d, could not find existing body with id='%s', name='%s', so inserting it. Scope is '%s'", _penv->GetId()%originBodyId%pNewKinBodyInfo->_name%currentFilename);
-            }
+            insertIndex = _InsertNewBodyInfo(envInfo, pNewKinBodyInfo, originBodyId, originBodyName, currentFilename);
         }
         return insertIndex;
     }
@@ -902,6 +1210,7 @@ protected:
     bool _bIgnoreInvalidBodies = false; ///< if true, ignores any invalid bodies
 
     std::map<std::string, boost::shared_ptr<const rapidjson::Document> > _rapidJSONDocuments; ///< cache for opened rapidjson Documents
+    std::vector< std::pair<std::string, boost::shared_ptr<const rapidjson::Document> > > _vExpandDependencies; ///< documents opened while expanding the current top-level referenceUri
 };
 
 bool RaveParseJSON(EnvironmentBasePtr penv, const rapidjson::Value& rEnvInfo, UpdateFromInfoMode updateMode, std::vector<KinBodyPtr>& vCreatedBodies, std::vector<KinBodyPtr>& vModifiedBodies, std::vector<KinBodyPtr>& vRemovedBodies, const AttributesList& atts, rapidjson::Document::AllocatorType& alloc)
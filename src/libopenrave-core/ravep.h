@@ -298,6 +298,8 @@ BaseXMLReaderPtr CreateInterfaceReader(EnvironmentBasePtr penv, InterfaceType ty
 BaseXMLReaderPtr CreateInterfaceReader(EnvironmentBasePtr penv, const AttributesList& atts, bool bAddToEnvironment);
 
 /// \brief creates a trimesh from reading a file. tries to automatically determine the format by the filename extension
+///
+/// Imported meshes are cached process-wide by file path, modification time, and scale, and by file contents. If OPENRAVE_MESHCACHE_DIR is set, they are also persisted there across processes.
 bool CreateTriMeshFromFile(EnvironmentBasePtr, const std::string& filename, const Vector &vscale, TriMesh& trimesh, RaveVector<float>&diffuseColor, RaveVector<float>&ambientColor, float &ftransparency);
 
 /// \brief creates a trimesh from in-memory data. format is automatically determined from contents of data
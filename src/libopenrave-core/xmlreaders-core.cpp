@@ -373,8 +373,10 @@ static bool _ParseSpecialSTLFile(EnvironmentBasePtr penv, const std::string& fil
 
 #endif
 
-bool CreateTriMeshFromFile(EnvironmentBasePtr penv, const std::string& filename, const Vector& vscale, TriMesh& trimesh, RaveVector<float>& diffuseColor, RaveVector<float>& ambientColor, float& ftransparency)
+/// \param bSetColors set to true only if the importer read the colors from the file, otherwise the colors are left untouched
+static bool _CreateTriMeshFromFileUncached(EnvironmentBasePtr penv, const std::string& filename, const Vector& vscale, TriMesh& trimesh, RaveVector<float>& diffuseColor, RaveVector<float>& ambientColor, float& ftransparency, bool& bSetColors)
 {
+    bSetColors = false;
     string extension;
     if( filename.find_last_of('.') != string::npos ) {
         extension = filename.substr(filename.find_last_of('.')+1);
@@ -451,6 +453,7 @@ bool CreateTriMeshFromFile(EnvironmentBasePtr penv, const std::string& filename,
         if( ivmodelloader->SendCommand(sout,sin) ) {
             sout >> trimesh >> diffuseColor >> ambientColor >> ftransparency;
             if( !!sout ) {
+                bSetColors = true;
                 FOREACH(it,trimesh.vertices) {
                     it->x *= vscale.x;
                     it->y *= vscale.y;
@@ -475,6 +478,326 @@ bool CreateTriMeshFromFile(EnvironmentBasePtr penv, const std::string& filename,
     return false;
 }
 
+/// \brief post-processed mesh imported from a file, shared between all loads of the same content
+///
+/// GeometryInfo holds its TriMesh by value, so every load still copies the mesh out of the cache; the cache only saves the import.
+struct CachedTriMesh
+{
+    CachedTriMesh() : ftransparency(0), bSetColors(false) {
+    }
+    TriMesh trimesh;
+    RaveVector<float> diffuseColor, ambientColor;
+    float ftransparency;
+    bool bSetColors; ///< true if the importer read the colors from the file, otherwise the colors of the caller are kept
+};
+typedef boost::shared_ptr<CachedTriMesh const> CachedTriMeshConstPtr;
+
+/// \brief process-wide cache of imported meshes.
+///
+/// Entries are looked up first by (path, mtime, size, scale) so that repeated loads of an unchanged file do not touch its contents,
+/// and then by the md5 of the file contents and scale so identical files at different paths share one import.
+/// The least recently used meshes are dropped once the total size of the cached vertices and indices exceeds the limit. The limit
+/// in megabytes can be changed with OPENRAVE_MESHCACHE_SIZE, 0 disables the in-memory cache.
+/// If OPENRAVE_MESHCACHE_DIR is set, post-processed meshes are also persisted there in a binary format keyed by the content hash.
+class TriMeshCache
+{
+public:
+    static TriMeshCache& GetInstance()
+    {
+        static TriMeshCache s_cache;
+        return s_cache;
+    }
+
+    CachedTriMeshConstPtr Get(EnvironmentBasePtr penv, const std::string& filename, const Vector& vscale)
+    {
+        std::string filekey;
+#ifdef HAVE_BOOST_FILESYSTEM
+        if( _maxbytes > 0 ) {
+            try {
+                boost::filesystem::path p(filename);
+                std::stringstream ssfilekey;
+                ssfilekey << std::setprecision(std::numeric_limits<dReal>::digits10+1) << filename << "\n" << (int64_t)boost::filesystem::last_write_time(p) << " " << (uint64_t)boost::filesystem::file_size(p) << " " << vscale.x << " " << vscale.y << " " << vscale.z;
+                filekey = ssfilekey.str();
+            }
+            catch(const boost::filesystem::filesystem_error& ex) {
+                RAVELOG_VERBOSE_FORMAT("failed to stat mesh file %s: %s", filename%ex.what());
+            }
+        }
+        if( filekey.size() > 0 ) {
+            boost::mutex::scoped_lock lock(_mutex);
+            std::map<std::string, std::string>::const_iterator it = _mapFileKeyToContentKey.find(filekey);
+            if( it != _mapFileKeyToContentKey.end() ) {
+                return _Use(_mapEntries.find(it->second));
+            }
+        }
+#endif
+
+        std::string contentkey;
+        {
+            std::ifstream f(filename.c_str(), std::ios::in|std::ios::binary);
+            if( !f ) {
+                return CachedTriMeshConstPtr();
+            }
+            std::stringstream sscontents;
+            sscontents << std::setprecision(std::numeric_limits<dReal>::digits10+1) << vscale.x << " " << vscale.y << " " << vscale.z << "\n" << f.rdbuf();
+            contentkey = utils::GetMD5HashString(sscontents.str());
+        }
+
+        CachedTriMeshConstPtr pcached;
+        {
+            boost::mutex::scoped_lock lock(_mutex);
+            std::map<std::string, CacheEntry>::iterator it = _mapEntries.find(contentkey);
+            if( it != _mapEntries.end() ) {
+                pcached = _Use(it);
+            }
+        }
+
+        std::string cachefilename = _GetCacheFilename(contentkey);
+        if( !pcached && cachefilename.size() > 0 ) {
+            pcached = _ReadCacheFile(cachefilename);
+        }
+        if( !pcached ) {
+            // import outside of the lock, the importers can be slow
+            boost::shared_ptr<CachedTriMesh> pnewcached(new CachedTriMesh());
+            if( !_CreateTriMeshFromFileUncached(penv, filename, vscale, pnewcached->trimesh, pnewcached->diffuseColor, pnewcached->ambientColor, pnewcached->ftransparency, pnewcached->bSetColors) ) {
+                return CachedTriMeshConstPtr();
+            }
+            if( cachefilename.size() > 0 ) {
+                _WriteCacheFile(cachefilename, *pnewcached);
+            }
+            pcached = pnewcached;
+        }
+
+        const uint64_t nbytes = pcached->trimesh.vertices.size()*sizeof(Vector) + pcached->trimesh.indices.size()*sizeof(int32_t);
+        if( _maxbytes == 0 || nbytes > _maxbytes ) {
+            return pcached;
+        }
+
+        boost::mutex::scoped_lock lock(_mutex);
+        std::map<std::string, CacheEntry>::iterator it = _mapEntries.find(contentkey);
+        if( it == _mapEntries.end() ) {
+            while( _totalbytes + nbytes > _maxbytes && !_listRecentlyUsed.empty() ) {
+                _Erase(_mapEntries.find(_listRecentlyUsed.back()));
+            }
+            it = _mapEntries.insert(std::make_pair(contentkey, CacheEntry())).first;
+            it->second.pcached = pcached;
+            it->second.nbytes = nbytes;
+            it->second.itRecentlyUsed = _listRecentlyUsed.insert(_listRecentlyUsed.begin(), contentkey);
+            _totalbytes += nbytes;
+        }
+        if( filekey.size() > 0 ) {
+            // an older version of the same file is stale, drop its key so the keys stay bounded by the number of distinct files
+            std::map<std::string, std::string>::iterator itfile = _mapFilenameToFileKey.find(filename);
+            if( itfile != _mapFilenameToFileKey.end() && itfile->second != filekey ) {
+                _EraseFileKey(itfile->second);
+            }
+            _mapFilenameToFileKey[filename] = filekey;
+            if( _mapFileKeyToContentKey.insert(std::make_pair(filekey, contentkey)).second ) {
+                it->second.vfilekeys.push_back(filekey);
+            }
+        }
+        return it->second.pcached;
+    }
+
+private:
+    static const uint32_t s_cacheMagic = 0x4d54524f; // "ORTM"
+    static const uint32_t s_cacheVersion = 2;
+
+    struct CacheEntry
+    {
+        CachedTriMeshConstPtr pcached;
+        uint64_t nbytes = 0; ///< size of the vertices and indices
+        std::list<std::string>::iterator itRecentlyUsed;
+        std::vector<std::string> vfilekeys; ///< file keys referring to this entry
+    };
+
+    TriMeshCache()
+    {
+        const char* pcachesize = std::getenv("OPENRAVE_MESHCACHE_SIZE");
+        if( !!pcachesize ) {
+            _maxbytes = (uint64_t)(std::max(0.0, std::atof(pcachesize))*1024*1024);
+        }
+        const char* pcachedir = std::getenv("OPENRAVE_MESHCACHE_DIR");
+        if( !!pcachedir ) {
+            _cachedirectory = pcachedir;
+#ifdef HAVE_BOOST_FILESYSTEM
+            try {
+                boost::filesystem::create_directories(_cachedirectory);
+            }
+            catch(const boost::filesystem::filesystem_error& ex) {
+                RAVELOG_WARN_FORMAT("failed to create mesh cache directory %s, disabling on-disk mesh cache: %s", _cachedirectory%ex.what());
+                _cachedirectory.clear();
+            }
+#endif
+        }
+    }
+
+    /// \brief marks the entry as most recently used and returns its mesh
+    CachedTriMeshConstPtr _Use(std::map<std::string, CacheEntry>::iterator it)
+    {
+        _listRecentlyUsed.splice(_listRecentlyUsed.begin(), _listRecentlyUsed, it->second.itRecentlyUsed);
+        return it->second.pcached;
+    }
+
+    /// \brief removes the entry together with all the file keys referring to it
+    void _Erase(std::map<std::string, CacheEntry>::iterator it)
+    {
+        FOREACHC(itfilekey, it->second.vfilekeys) {
+            _mapFileKeyToContentKey.erase(*itfilekey);
+            // the file key starts with the filename
+            std::map<std::string, std::string>::iterator itfile = _mapFilenameToFileKey.find(itfilekey->substr(0, itfilekey->find('\n')));
+            if( itfile != _mapFilenameToFileKey.end() && itfile->second == *itfilekey ) {
+                _mapFilenameToFileKey.erase(itfile);
+            }
+        }
+        _totalbytes -= it->second.nbytes;
+        _listRecentlyUsed.erase(it->second.itRecentlyUsed);
+        _mapEntries.erase(it);
+    }
+
+    /// \brief removes a file key, the content entry stays until it is evicted
+    void _EraseFileKey(const std::string& filekey)
+    {
+        std::map<std::string, std::string>::iterator itfilekey = _mapFileKeyToContentKey.find(filekey);
+        if( itfilekey == _mapFileKeyToContentKey.end() ) {
+            return;
+        }
+        std::map<std::string, CacheEntry>::iterator it = _mapEntries.find(itfilekey->second);
+        if( it != _mapEntries.end() ) {
+            std::vector<std::string>& vfilekeys = it->second.vfilekeys;
+            vfilekeys.erase(std::remove(vfilekeys.begin(), vfilekeys.end(), filekey), vfilekeys.end());
+        }
+        _mapFileKeyToContentKey.erase(itfilekey);
+    }
+
+    std::string _GetCacheFilename(const std::string& contentkey) const
+    {
+        if( _cachedirectory.size() == 0 ) {
+            return std::string();
+        }
+#ifdef HAVE_BOOST_FILESYSTEM
+        return (boost::filesystem::path(_cachedirectory)/(contentkey + ".ortm")).string();
+#else
+        return _cachedirectory + s_filesep + contentkey + ".ortm";
+#endif
+    }
+
+    template <typename T>
+    static bool _ReadBinary(std::istream& f, std::vector<T>& v)
+    {
+        uint64_t num = 0;
+        f.read((char*)&num, sizeof(num));
+        if( !f ) {
+            return false;
+        }
+        v.resize(num);
+        if( num > 0 ) {
+            f.read((char*)&v[0], num*sizeof(T));
+        }
+        return !!f;
+    }
+
+    template <typename T>
+    static void _WriteBinary(std::ostream& f, const std::vector<T>& v)
+    {
+        uint64_t num = v.size();
+        f.write((const char*)&num, sizeof(num));
+        if( num > 0 ) {
+            f.write((const char*)&v[0], num*sizeof(T));
+        }
+    }
+
+    static CachedTriMeshConstPtr _ReadCacheFile(const std::string& cachefilename)
+    {
+        std::ifstream f(cachefilename.c_str(), std::ios::in|std::ios::binary);
+        if( !f ) {
+            return CachedTriMeshConstPtr();
+        }
+        uint32_t header[3] = {0, 0, 0};
+        f.read((char*)header, sizeof(header));
+        if( !f || header[0] != s_cacheMagic || header[1] != s_cacheVersion || header[2] != sizeof(dReal) ) {
+            RAVELOG_DEBUG_FORMAT("ignoring incompatible mesh cache file %s", cachefilename);
+            return CachedTriMeshConstPtr();
+        }
+        boost::shared_ptr<CachedTriMesh> pcached(new CachedTriMesh());
+        std::vector<dReal> vertices;
+        float colors[10];
+        if( !_ReadBinary(f, vertices) || !_ReadBinary(f, pcached->trimesh.indices) || !f.read((char*)colors, sizeof(colors)) || vertices.size()%3 != 0 ) {
+            RAVELOG_WARN_FORMAT("failed to read mesh cache file %s", cachefilename);
+            return CachedTriMeshConstPtr();
+        }
+        pcached->trimesh.vertices.resize(vertices.size()/3);
+        for(size_t i = 0; i < pcached->trimesh.vertices.size(); ++i) {
+            pcached->trimesh.vertices[i] = Vector(vertices[3*i], vertices[3*i+1], vertices[3*i+2]);
+        }
+        pcached->diffuseColor = RaveVector<float>(colors[0], colors[1], colors[2], colors[3]);
+        pcached->ambientColor = RaveVector<float>(colors[4], colors[5], colors[6], colors[7]);
+        pcached->ftransparency = colors[8];
+        pcached->bSetColors = colors[9] != 0;
+        return pcached;
+    }
+
+    static void _WriteCacheFile(const std::string& cachefilename, const CachedTriMesh& cached)
+    {
+        // write to a temporary file first so that concurrent readers never see a partial mesh
+        std::stringstream sstempfilename;
+        sstempfilename << cachefilename << "." << boost::this_thread::get_id() << ".tmp";
+        std::string tempfilename = sstempfilename.str();
+        {
+            std::ofstream f(tempfilename.c_str(), std::ios::out|std::ios::binary|std::ios::trunc);
+            if( !f ) {
+                RAVELOG_WARN_FORMAT("failed to open mesh cache file %s for writing", tempfilename);
+                return;
+            }
+            uint32_t header[3] = {s_cacheMagic, s_cacheVersion, (uint32_t)sizeof(dReal)};
+            f.write((const char*)header, sizeof(header));
+            std::vector<dReal> vertices(3*cached.trimesh.vertices.size());
+            for(size_t i = 0; i < cached.trimesh.vertices.size(); ++i) {
+                vertices[3*i] = cached.trimesh.vertices[i].x;
+                vertices[3*i+1] = cached.trimesh.vertices[i].y;
+                vertices[3*i+2] = cached.trimesh.vertices[i].z;
+            }
+            _WriteBinary(f, vertices);
+            _WriteBinary(f, cached.trimesh.indices);
+            float colors[10] = {cached.diffuseColor.x, cached.diffuseColor.y, cached.diffuseColor.z, cached.diffuseColor.w, cached.ambientColor.x, cached.ambientColor.y, cached.ambientColor.z, cached.ambientColor.w, cached.ftransparency, cached.bSetColors ? 1.0f : 0.0f};
+            f.write((const char*)colors, sizeof(colors));
+            if( !f ) {
+                RAVELOG_WARN_FORMAT("failed to write mesh cache file %s", tempfilename);
+                f.close();
+                std::remove(tempfilename.c_str());
+                return;
+            }
+        }
+        if( std::rename(tempfilename.c_str(), cachefilename.c_str()) != 0 ) {
+            std::remove(tempfilename.c_str());
+        }
+    }
+
+    boost::mutex _mutex;
+    std::string _cachedirectory; ///< if not empty, directory of the on-disk binary mesh cache
+    std::map<std::string, CacheEntry> _mapEntries; ///< md5(scale, contents) -> mesh
+    std::map<std::string, std::string> _mapFileKeyToContentKey; ///< (path, mtime, size, scale) -> md5(scale, contents)
+    std::map<std::string, std::string> _mapFilenameToFileKey; ///< path -> latest file key, used to drop stale keys
+    std::list<std::string> _listRecentlyUsed; ///< content keys, most recently used first
+    uint64_t _totalbytes = 0; ///< sum of the sizes of all entries
+    uint64_t _maxbytes = 256*1024*1024;
+};
+
+bool CreateTriMeshFromFile(EnvironmentBasePtr penv, const std::string& filename, const Vector& vscale, TriMesh& trimesh, RaveVector<float>& diffuseColor, RaveVector<float>& ambientColor, float& ftransparency)
+{
+    CachedTriMeshConstPtr pcached = TriMeshCache::GetInstance().Get(penv, filename, vscale);
+    if( !pcached ) {
+        return false;
+    }
+    trimesh = pcached->trimesh;
+    if( pcached->bSetColors ) {
+        diffuseColor = pcached->diffuseColor;
+        ambientColor = pcached->ambientColor;
+        ftransparency = pcached->ftransparency;
+    }
+    return true;
+}
+
 bool CreateTriMeshFromData(const std::string& data, const std::string& formathint, const Vector& vscale, TriMesh& trimesh, RaveVector<float>& diffuseColor, RaveVector<float>& ambientColor, float& ftransparency)
 {
 #ifdef OPENRAVE_ASSIMP
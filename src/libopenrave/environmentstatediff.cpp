@@ -0,0 +1,496 @@
+// -*- coding: utf-8 -*-
+// Copyright (C) 2026 OpenRAVE contributors
+//
+// This file is part of OpenRAVE.
+// OpenRAVE is free software: you can redistribute it and/or modify
+// it under the terms of the GNU Lesser General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU Lesser General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#include "libopenrave.h"
+
+#include <openrave/environmentstatediff.h>
+
+#include <cstring>
+
+namespace OpenRAVE {
+
+static const uint32_t s_nStateDiffMagic = 0x4453524f; // "ORSD"
+static const uint8_t s_nStateDiffVersion = 1;
+static const uint8_t s_nStateDiffFullFrame = 1;
+static const int32_t s_nStateDiffMaxBodyIndex = 0x100000; ///< bounds the body tables of the applier against corrupted indices
+
+/// \brief appends native byte order values to a buffer
+class StateDiffBufferWriter
+{
+public:
+    StateDiffBufferWriter(std::vector<uint8_t>& vdata) : _vdata(vdata) {
+    }
+
+    template <typename T>
+    inline void Write(const T& value) {
+        size_t offset = _vdata.size();
+        _vdata.resize(offset+sizeof(T));
+        std::memcpy(&_vdata[offset], &value, sizeof(T));
+    }
+
+    inline void WriteString(const std::string& s) {
+        Write<uint32_t>(s.size());
+        _vdata.insert(_vdata.end(), s.begin(), s.end());
+    }
+
+    inline void WriteTransform(const Transform& t) {
+        for(int i = 0; i < 4; ++i) {
+            Write<dReal>(t.rot[i]);
+        }
+        for(int i = 0; i < 3; ++i) {
+            Write<dReal>(t.trans[i]);
+        }
+    }
+
+    template <typename T>
+    inline void WriteVector(const std::vector<T>& v) {
+        Write<uint32_t>(v.size());
+        if( v.size() > 0 ) {
+            size_t offset = _vdata.size();
+            _vdata.resize(offset+v.size()*sizeof(T));
+            std::memcpy(&_vdata[offset], &v[0], v.size()*sizeof(T));
+        }
+    }
+
+private:
+    std::vector<uint8_t>& _vdata;
+};
+
+class EnvironmentStateDiffWriter::BodyTracker
+{
+public:
+    BodyTracker() : envBodyIndex(0), updatestamp(0), changedfields(ESDF_All), nLastSeenSequence(0), bSent(false) {
+    }
+
+    static void SetChangedFields(boost::weak_ptr<BodyTracker> wtracker, uint32_t fields) {
+        BodyTrackerPtr tracker = wtracker.lock();
+        if( !!tracker ) {
+            tracker->changedfields |= fields;
+        }
+    }
+
+    KinBodyWeakPtr pbody;
+    std::string name;
+    int envBodyIndex;
+    int updatestamp; ///< update stamp of the body when the state was last sent
+    uint32_t changedfields; ///< mask of EnvironmentStateDiffField reported by the change callbacks since the last frame
+    uint32_t nLastSeenSequence; ///< sequence of the last frame the body was in the environment
+    bool bSent; ///< true if the state below was sent to the mirror
+    std::list<UserDataPtr> listRegisteredCallbacks;
+
+    // last sent state
+    Transform t;
+    std::vector<dReal> vDOFValues;
+    std::vector<uint64_t> vLinkEnableStatesMasks;
+    std::vector<KinBody::GrabbedInfo> vGrabbedInfos;
+};
+
+EnvironmentStateDiffWriter::EnvironmentStateDiffWriter(EnvironmentBasePtr penv) : _penv(penv), _nSequence(0), _bFullFrame(true)
+{
+}
+
+EnvironmentStateDiffWriter::~EnvironmentStateDiffWriter()
+{
+}
+
+void EnvironmentStateDiffWriter::Reset()
+{
+    _bFullFrame = true;
+}
+
+bool EnvironmentStateDiffWriter::WriteDiff(std::vector<uint8_t>& vdata)
+{
+    EnvironmentLock lockenv(_penv->GetMutex());
+    const bool bFullFrame = _bFullFrame;
+    bool bChanged = bFullFrame;
+    StateDiffBufferWriter writer(vdata);
+    writer.Write<uint32_t>(s_nStateDiffMagic);
+    writer.Write<uint8_t>(s_nStateDiffVersion);
+    writer.Write<uint8_t>(sizeof(dReal));
+    writer.Write<uint8_t>(bFullFrame ? s_nStateDiffFullFrame : 0);
+    writer.Write<uint32_t>(_nSequence);
+
+    std::vector<dReal> vDOFValues;
+    _penv->GetBodies(_vBodiesCache);
+    FOREACHC(itbody, _vBodiesCache) {
+        const KinBodyPtr& pbody = *itbody;
+        const int envBodyIndex = pbody->GetEnvironmentBodyIndex();
+        if( envBodyIndex <= 0 ) {
+            continue;
+        }
+        if( envBodyIndex >= (int)_vTrackers.size() ) {
+            _vTrackers.resize(envBodyIndex+1);
+        }
+        BodyTrackerPtr& tracker = _vTrackers[envBodyIndex];
+        if( !tracker || tracker->pbody.lock() != pbody || tracker->name != pbody->GetName() ) {
+            tracker.reset(new BodyTracker());
+            tracker->pbody = pbody;
+            tracker->name = pbody->GetName();
+            tracker->envBodyIndex = envBodyIndex;
+            boost::weak_ptr<BodyTracker> wtracker(tracker);
+            tracker->listRegisteredCallbacks.push_back(pbody->RegisterChangeCallback(KinBody::Prop_LinkTransforms, boost::bind(&BodyTracker::SetChangedFields, wtracker, (uint32_t)(ESDF_Transform|ESDF_DOFValues))));
+            tracker->listRegisteredCallbacks.push_back(pbody->RegisterChangeCallback(KinBody::Prop_LinkEnable, boost::bind(&BodyTracker::SetChangedFields, wtracker, (uint32_t)ESDF_LinkEnableStates)));
+            tracker->listRegisteredCallbacks.push_back(pbody->RegisterChangeCallback(KinBody::Prop_RobotGrabbed, boost::bind(&BodyTracker::SetChangedFields, wtracker, (uint32_t)ESDF_Grabbed)));
+            if( !bFullFrame ) {
+                writer.Write<uint8_t>(ESDR_BodyAdded);
+                writer.Write<int32_t>(envBodyIndex);
+                writer.WriteString(tracker->name);
+                bChanged = true;
+            }
+        }
+        if( bFullFrame ) {
+            // the mirror might not know any names yet
+            writer.Write<uint8_t>(ESDR_BodyAdded);
+            writer.Write<int32_t>(envBodyIndex);
+            writer.WriteString(tracker->name);
+            tracker->bSent = false;
+        }
+        tracker->nLastSeenSequence = _nSequence;
+
+        const int updatestamp = pbody->GetUpdateStamp();
+        if( tracker->bSent && tracker->updatestamp == updatestamp && tracker->changedfields == 0 ) {
+            continue;
+        }
+
+        uint32_t checkfields = tracker->changedfields;
+        if( !tracker->bSent || checkfields == 0 ) {
+            // the stamp changed through a path without a change callback, so compare everything
+            checkfields = ESDF_All;
+        }
+
+        uint32_t fields = 0;
+        const Transform t = pbody->GetTransform();
+        if( (checkfields & ESDF_Transform) && (!tracker->bSent || t != tracker->t) ) {
+            tracker->t = t;
+            fields |= ESDF_Transform;
+        }
+        if( (checkfields & ESDF_DOFValues) && pbody->GetDOF() > 0 ) {
+            pbody->GetDOFValues(vDOFValues);
+            if( !tracker->bSent || vDOFValues != tracker->vDOFValues ) {
+                tracker->vDOFValues.swap(vDOFValues);
+                fields |= ESDF_DOFValues;
+            }
+        }
+        if( checkfields & ESDF_LinkEnableStates ) {
+            const std::vector<uint64_t>& vLinkEnableStatesMasks = pbody->GetLinkEnableStatesMasks();
+            if( !tracker->bSent || vLinkEnableStatesMasks != tracker->vLinkEnableStatesMasks ) {
+                tracker->vLinkEnableStatesMasks = vLinkEnableStatesMasks;
+                fields |= ESDF_LinkEnableStates;
+            }
+        }
+        if( checkfields & ESDF_Grabbed ) {
+            pbody->GetGrabbedInfo(_vGrabbedInfosCache);
+            if( !tracker->bSent || _vGrabbedInfosCache != tracker->vGrabbedInfos ) {
+                tracker->vGrabbedInfos.swap(_vGrabbedInfosCache);
+                fields |= ESDF_Grabbed;
+            }
+        }
+
+        tracker->updatestamp = updatestamp;
+        tracker->changedfields = 0;
+        tracker->bSent = true;
+        if( fields == 0 ) {
+            continue;
+        }
+
+        writer.Write<uint8_t>(ESDR_BodyState);
+        writer.Write<int32_t>(envBodyIndex);
+        writer.Write<uint8_t>(fields);
+        if( fields & ESDF_Transform ) {
+            writer.WriteTransform(tracker->t);
+        }
+        if( fields & ESDF_DOFValues ) {
+            writer.WriteVector(tracker->vDOFValues);
+        }
+        if( fields & ESDF_LinkEnableStates ) {
+            writer.Write<uint32_t>(pbody->GetLinks().size());
+            writer.WriteVector(tracker->vLinkEnableStatesMasks);
+        }
+        if( fields & ESDF_Grabbed ) {
+            writer.Write<uint32_t>(tracker->vGrabbedInfos.size());
+            FOREACHC(itgrabbed, tracker->vGrabbedInfos) {
+                writer.WriteString(itgrabbed->_grabbedname);
+                writer.WriteString(itgrabbed->_robotlinkname);
+                writer.WriteTransform(itgrabbed->_trelative);
+                writer.Write<uint32_t>(itgrabbed->_setIgnoreRobotLinkNames.size());
+                FOREACHC(itname, itgrabbed->_setIgnoreRobotLinkNames) {
+                    writer.WriteString(*itname);
+                }
+            }
+        }
+        bChanged = true;
+    }
+    _vBodiesCache.clear(); // do not hold references to the bodies
+
+    for(size_t envBodyIndex = 0; envBodyIndex < _vTrackers.size(); ++envBodyIndex) {
+        BodyTrackerPtr& tracker = _vTrackers[envBodyIndex];
+        if( !!tracker && tracker->nLastSeenSequence != _nSequence ) {
+            if( !bFullFrame ) {
+                writer.Write<uint8_t>(ESDR_BodyRemoved);
+                writer.Write<int32_t>(envBodyIndex);
+                bChanged = true;
+            }
+            tracker.reset();
+        }
+    }
+
+    writer.Write<uint8_t>(ESDR_End);
+    ++_nSequence;
+    _bFullFrame = false;
+    return bChanged;
+}
+
+/// \brief reads native byte order values from a buffer, throws if the buffer is too short
+class EnvironmentStateDiffApplier::Reader
+{
+public:
+    Reader(const uint8_t* pdata, size_t size) : _pcur(pdata), _pend(pdata+size) {
+    }
+
+    inline bool IsEnd() const {
+        return _pcur >= _pend;
+    }
+
+    template <typename T>
+    inline T Read() {
+        _Check(sizeof(T));
+        T value;
+        std::memcpy(&value, _pcur, sizeof(T));
+        _pcur += sizeof(T);
+        return value;
+    }
+
+    inline void ReadString(std::string& s) {
+        uint32_t size = Read<uint32_t>();
+        _Check(size);
+        s.assign(reinterpret_cast<const char*>(_pcur), size);
+        _pcur += size;
+    }
+
+    inline void ReadTransform(Transform& t) {
+        for(int i = 0; i < 4; ++i) {
+            t.rot[i] = Read<dReal>();
+        }
+        for(int i = 0; i < 3; ++i) {
+            t.trans[i] = Read<dReal>();
+        }
+    }
+
+    template <typename T>
+    inline void ReadVector(std::vector<T>& v) {
+        uint32_t size = Read<uint32_t>();
+        _Check((size_t)size*sizeof(T));
+        v.resize(size);
+        if( size > 0 ) {
+            std::memcpy(&v[0], _pcur, size*sizeof(T));
+            _pcur += size*sizeof(T);
+        }
+    }
+
+private:
+    inline void _Check(size_t size) const {
+        if( (size_t)(_pend - _pcur) < size ) {
+            throw OPENRAVE_EXCEPTION_FORMAT("environment state diff frame is truncated, need %d bytes but only %d are left", size%(_pend - _pcur), ORE_InvalidArguments);
+        }
+    }
+
+    const uint8_t* _pcur;
+    const uint8_t* _pend;
+};
+
+EnvironmentStateDiffApplier::EnvironmentStateDiffApplier(EnvironmentBasePtr penv) : _penv(penv), _nNextSequence(0), _bReceivedFullFrame(false)
+{
+}
+
+EnvironmentStateDiffApplier::~EnvironmentStateDiffApplier()
+{
+}
+
+int EnvironmentStateDiffApplier::ApplyDiff(const uint8_t* pdata, size_t size)
+{
+    EnvironmentLock lockenv(_penv->GetMutex());
+    Reader reader(pdata, size);
+    int numapplied = 0;
+    while( !reader.IsEnd() ) {
+        numapplied += _ApplyFrame(reader);
+    }
+    return numapplied;
+}
+
+int EnvironmentStateDiffApplier::_ApplyFrame(Reader& reader)
+{
+    const uint32_t magic = reader.Read<uint32_t>();
+    const uint8_t version = reader.Read<uint8_t>();
+    const uint8_t realsize = reader.Read<uint8_t>();
+    const uint8_t flags = reader.Read<uint8_t>();
+    const uint32_t sequence = reader.Read<uint32_t>();
+    if( magic != s_nStateDiffMagic || version != s_nStateDiffVersion ) {
+        throw OPENRAVE_EXCEPTION_FORMAT("invalid environment state diff frame header (magic=0x%x, version=%d)", magic%(int)version, ORE_InvalidArguments);
+    }
+    if( realsize != sizeof(dReal) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT("environment state diff frame has %d byte reals, but %d are expected", (int)realsize%sizeof(dReal), ORE_InvalidArguments);
+    }
+    const bool bFullFrame = !!(flags & s_nStateDiffFullFrame);
+    if( !bFullFrame && (!_bReceivedFullFrame || sequence != _nNextSequence) ) {
+        throw OPENRAVE_EXCEPTION_FORMAT("environment state diff frame %d does not follow the expected frame %d, need a full frame", sequence%_nNextSequence, ORE_InvalidState);
+    }
+
+    // parse the whole frame first so that a malformed frame does not leave the mirror half updated
+    _vRecords.resize(0);
+    std::string name;
+    while(true) {
+        const uint8_t recordtype = reader.Read<uint8_t>();
+        if( recordtype == ESDR_End ) {
+            break;
+        }
+        if( recordtype != ESDR_BodyAdded && recordtype != ESDR_BodyRemoved && recordtype != ESDR_BodyState ) {
+            throw OPENRAVE_EXCEPTION_FORMAT("unknown environment state diff record type %d", (int)recordtype, ORE_InvalidArguments);
+        }
+        const int envBodyIndex = reader.Read<int32_t>();
+        if( envBodyIndex <= 0 || envBodyIndex > s_nStateDiffMaxBodyIndex ) {
+            throw OPENRAVE_EXCEPTION_FORMAT("invalid environment body index %d in environment state diff frame", envBodyIndex, ORE_InvalidArguments);
+        }
+
+        _vRecords.push_back(Record());
+        Record& record = _vRecords.back();
+        record.recordtype = recordtype;
+        record.envBodyIndex = envBodyIndex;
+        if( recordtype == ESDR_BodyAdded ) {
+            reader.ReadString(record.name);
+        }
+        else if( recordtype == ESDR_BodyState ) {
+            record.fields = reader.Read<uint8_t>();
+            if( record.fields & ESDF_Transform ) {
+                reader.ReadTransform(record.t);
+            }
+            if( record.fields & ESDF_DOFValues ) {
+                reader.ReadVector(record.vDOFValues);
+            }
+            if( record.fields & ESDF_LinkEnableStates ) {
+                record.numlinks = reader.Read<uint32_t>();
+                reader.ReadVector(record.vLinkEnableStatesMasks);
+            }
+            if( record.fields & ESDF_Grabbed ) {
+                const uint32_t numgrabbed = reader.Read<uint32_t>();
+                for(uint32_t igrabbed = 0; igrabbed < numgrabbed; ++igrabbed) {
+                    KinBody::GrabbedInfoPtr pGrabbedInfo(new KinBody::GrabbedInfo());
+                    reader.ReadString(pGrabbedInfo->_grabbedname);
+                    reader.ReadString(pGrabbedInfo->_robotlinkname);
+                    reader.ReadTransform(pGrabbedInfo->_trelative);
+                    const uint32_t numignore = reader.Read<uint32_t>();
+                    for(uint32_t iignore = 0; iignore < numignore; ++iignore) {
+                        reader.ReadString(name);
+                        pGrabbedInfo->_setIgnoreRobotLinkNames.insert(name);
+                    }
+                    record.vGrabbedInfos.push_back(pGrabbedInfo);
+                }
+            }
+        }
+    }
+
+    if( bFullFrame ) {
+        _vBodyNames.clear();
+        _vMirrorBodies.clear();
+        _bReceivedFullFrame = true;
+    }
+
+    int numapplied = 0;
+    std::vector<uint8_t> vLinkEnableStates;
+    _vPendingGrabs.clear();
+    FOREACH(itrecord, _vRecords) {
+        const int envBodyIndex = itrecord->envBodyIndex;
+        if( itrecord->recordtype == ESDR_BodyAdded ) {
+            if( envBodyIndex >= (int)_vBodyNames.size() ) {
+                _vBodyNames.resize(envBodyIndex+1);
+                _vMirrorBodies.resize(envBodyIndex+1);
+            }
+            _vBodyNames[envBodyIndex].swap(itrecord->name);
+            _vMirrorBodies[envBodyIndex].reset();
+            continue;
+        }
+        if( envBodyIndex >= (int)_vBodyNames.size() ) {
+            // never added, so the body is not known to the mirror
+            continue;
+        }
+        if( itrecord->recordtype == ESDR_BodyRemoved ) {
+            _vBodyNames[envBodyIndex].clear();
+            _vMirrorBodies[envBodyIndex].reset();
+            continue;
+        }
+
+        KinBodyPtr pbody = _GetMirrorBody(envBodyIndex);
+        if( !pbody ) {
+            continue;
+        }
+        const uint8_t fields = itrecord->fields;
+        const std::vector<dReal>& vDOFValues = itrecord->vDOFValues;
+        bool bSetDOFValues = (fields & ESDF_DOFValues) && (int)vDOFValues.size() == pbody->GetDOF();
+        if( (fields & ESDF_DOFValues) && !bSetDOFValues ) {
+            RAVELOG_WARN_FORMAT("env=%s, body %s has %d dofs, but received %d dof values", _penv->GetNameId()%pbody->GetName()%pbody->GetDOF()%vDOFValues.size());
+        }
+        if( bSetDOFValues && (fields & ESDF_Transform) ) {
+            pbody->SetDOFValues(vDOFValues, itrecord->t, KinBody::CLA_Nothing);
+        }
+        else if( bSetDOFValues ) {
+            pbody->SetDOFValues(vDOFValues, KinBody::CLA_Nothing);
+        }
+        else if( fields & ESDF_Transform ) {
+            pbody->SetTransform(itrecord->t);
+        }
+        if( fields & ESDF_LinkEnableStates ) {
+            const uint32_t numlinks = itrecord->numlinks;
+            if( numlinks == pbody->GetLinks().size() && itrecord->vLinkEnableStatesMasks.size()*64 >= numlinks ) {
+                vLinkEnableStates.resize(numlinks);
+                for(uint32_t ilink = 0; ilink < numlinks; ++ilink) {
+                    vLinkEnableStates[ilink] = IsLinkStateBitEnabled(itrecord->vLinkEnableStatesMasks, ilink);
+                }
+                pbody->SetLinkEnableStates(vLinkEnableStates);
+            }
+            else {
+                RAVELOG_WARN_FORMAT("env=%s, body %s has %d links, but received enable states for %d links", _penv->GetNameId()%pbody->GetName()%pbody->GetLinks().size()%numlinks);
+            }
+        }
+        if( fields & ESDF_Grabbed ) {
+            _vPendingGrabs.push_back(std::make_pair(pbody, itrecord->vGrabbedInfos));
+        }
+        ++numapplied;
+    }
+
+    // grabbed bodies might have been moved in the same frame, so grab after all the states are set
+    FOREACH(itgrab, _vPendingGrabs) {
+        itgrab->first->ResetGrabbed(itgrab->second);
+    }
+    _vPendingGrabs.clear();
+    _vRecords.resize(0);
+    _nNextSequence = sequence+1;
+    return numapplied;
+}
+
+KinBodyPtr EnvironmentStateDiffApplier::_GetMirrorBody(int envBodyIndex)
+{
+    const std::string& name = _vBodyNames.at(envBodyIndex);
+    if( name.empty() ) {
+        return KinBodyPtr();
+    }
+    KinBodyPtr pbody = _vMirrorBodies.at(envBodyIndex).lock();
+    if( !pbody || pbody->GetEnvironmentBodyIndex() <= 0 || pbody->GetName() != name ) {
+        pbody = _penv->GetKinBody(name);
+        _vMirrorBodies[envBodyIndex] = pbody;
+    }
+    return pbody;
+}
+
+} // end namespace OpenRAVE
@@ -164,6 +164,26 @@ bool IkSolverBase::SolveAll(const IkParameterization& param, const std::vector<d
     return vsolutions.size() > 0;
 }
 
+bool IkSolverBase::SolveAllBatch(const std::vector<IkParameterization>& vparams, int filteroptions, std::vector<dReal>& vsolutions, std::vector<int>& vposesolutionoffsets)
+{
+    vsolutions.resize(0);
+    vposesolutionoffsets.resize(vparams.size()+1);
+    vposesolutionoffsets[0] = 0;
+    std::vector< std::vector<dReal> > vposesolutions;
+    int numsolutions = 0;
+    for(size_t iparam = 0; iparam < vparams.size(); ++iparam) {
+        vposesolutions.resize(0);
+        if( SolveAll(vparams[iparam],filteroptions,vposesolutions) ) {
+            FOREACHC(itsolution, vposesolutions) {
+                vsolutions.insert(vsolutions.end(), itsolution->begin(), itsolution->end());
+            }
+            numsolutions += (int)vposesolutions.size();
+        }
+        vposesolutionoffsets[iparam+1] = numsolutions;
+    }
+    return numsolutions > 0;
+}
+
 UserDataPtr IkSolverBase::RegisterCustomFilter(int32_t priority, const IkSolverBase::IkFilterCallbackFn &filterfn)
 {
     CustomIkSolverFilterDataPtr pdata(new CustomIkSolverFilterData(priority,filterfn,shared_iksolver()));
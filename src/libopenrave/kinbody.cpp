@@ -67,7 +67,7 @@ inline void _ResizeVectorFor2DTable(std::vector<int8_t>& vec, size_t vectorSize)
 class ChangeCallbackData : public UserData
 {
 public:
-    ChangeCallbackData(int properties, const boost::function<void()>& callback, KinBodyConstPtr pbody) : _properties(properties), _callback(callback), _pweakbody(pbody) {
+    ChangeCallbackData(int properties, const boost::function<void()>& callback, const KinBody::ChangeSetCallbackFn& changesetcallback, KinBodyConstPtr pbody) : _properties(properties), _callback(callback), _changesetcallback(changesetcallback), _pweakbody(pbody) {
     }
     virtual ~ChangeCallbackData() {
         KinBodyConstPtr pbody = _pweakbody.lock();
@@ -82,6 +82,7 @@ public:
     list< std::pair<uint32_t, list<UserDataWeakPtr>::iterator> > _iterators;
     int _properties;
     boost::function<void()> _callback;
+    KinBody::ChangeSetCallbackFn _changesetcallback; ///< if set, called instead of _callback
 protected:
     boost::weak_ptr<KinBody const> _pweakbody;
 };
@@ -453,6 +454,10 @@ KinBody::KinBody(InterfaceType type, EnvironmentBasePtr penv) : InterfaceBase(ty
     _environmentBodyIndex = 0;
     _nNonAdjacentLinkCache = 0x80000000;
     _nUpdateStampId = 0;
+    _nPartialUpdateStartStamp = _nPartialUpdateEndStamp = -1;
+    _bChangedLinksMarked = false;
+    _nChangeBatchDepth = 0;
+    _nBatchedParameters = 0;
     _bAreAllJoints1DOFAndNonCircular = false;
 }
 
@@ -486,6 +491,7 @@ void KinBody::Destroy()
     _vDOFOrderedJoints.clear();
     _vPassiveJoints.clear();
     _vJointsAffectingLinks.clear();
+    _vDOFDescendantLinkIndices.clear();
     _vDOFIndices.clear();
 
     _vAdjacentLinks.clear();
@@ -2030,6 +2036,7 @@ void KinBody::SetLinkEnableStates(const std::vector<uint8_t>& enablestates)
         if( _veclinks[ilink]->_info._bIsEnabled != bEnable ) {
             _veclinks[ilink]->_Enable(bEnable);
             _nNonAdjacentLinkCache &= ~AO_Enabled;
+            _MarkChangedLink(ilink);
             bchanged = true;
         }
     }
@@ -2213,9 +2220,30 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
         }
     }
 
+    // 0 if the link has to be computed, 1 if it was computed, 2 if it does not move
     std::vector<uint8_t>& vlinkscomputed = _vLinksVisitedCache;
     vlinkscomputed.resize(_veclinks.size());
-    std::fill(vlinkscomputed.begin(), vlinkscomputed.end(), 0);
+    bool bPartialUpdate = false;
+    if( dofindices.size() > 0 && (int)dofindices.size() < GetDOF() && (int)_vDOFDescendantLinkIndices.size() == GetDOF() ) {
+        // only the links downstream of the set dofs move
+        std::fill(vlinkscomputed.begin(), vlinkscomputed.end(), 2);
+        for(int dofindex : dofindices) {
+            for(int linkindex : _vDOFDescendantLinkIndices.at(dofindex)) {
+                vlinkscomputed[linkindex] = 0;
+            }
+        }
+        _vPartialUpdateLinkIndices.resize(0);
+        for(int linkindex = 0; linkindex < (int)vlinkscomputed.size(); ++linkindex) {
+            if( vlinkscomputed[linkindex] == 0 ) {
+                _vPartialUpdateLinkIndices.push_back(linkindex);
+            }
+        }
+        _nPartialUpdateStartStamp = _nUpdateStampId;
+        bPartialUpdate = true;
+    }
+    else {
+        std::fill(vlinkscomputed.begin(), vlinkscomputed.end(), 0);
+    }
     vlinkscomputed[0] = 1;
     boost::array<dReal,3> dummyvalues; // dummy values for a joint
     std::vector<dReal>& vtempvalues = _vTempMimicValues;
@@ -2228,6 +2256,9 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
         const LinkPtr& childlink = joint._attachedbodies[1];
 
         if( joint.IsStatic() ) {
+            if( vlinkscomputed[childlink->GetIndex()] == 2 ) {
+                continue;
+            }
             // if joint.IsStatic(), then joint._info._tRightNoOffset and tjoint are assigned identities
             const Transform t = (!!parentlink ? parentlink->GetTransform() : _veclinks.at(0)->GetTransform()) * joint.GetInternalHierarchyLeftTransform();
             childlink->SetTransform(t);
@@ -2419,6 +2450,13 @@ void KinBody::SetDOFValues(const std::vector<dReal>& vJointValues, uint32_t chec
     }
 
     _UpdateGrabbedBodies();
+    if( bPartialUpdate ) {
+        // _PostprocessChangedParameters increments the stamp once, any other change invalidates the partial update
+        _nPartialUpdateEndStamp = _nUpdateStampId+1;
+        for(int linkindex : _vPartialUpdateLinkIndices) {
+            _MarkChangedLink(linkindex);
+        }
+    }
     _PostprocessChangedParameters(Prop_LinkTransforms);
 }
 
@@ -4009,6 +4047,7 @@ void KinBody::_ComputeInternalInformation()
     _nHierarchyComputed = 1;
 
     _vLinkTransformPointers.clear();
+    _vDOFDescendantLinkIndices.clear();
     if( !!_pCurrentKinematicsFunctions ) {
         RAVELOG_DEBUG_FORMAT("env=%d, resetting custom kinematics functions for body %s", GetEnv()->GetId()%GetName());
         _pCurrentKinematicsFunctions.reset();
@@ -4835,6 +4874,7 @@ void KinBody::_ComputeInternalInformation()
     for(int ilink = 0; ilink < (int)_veclinks.size(); ++ilink) {
         _vLinkTransformPointers[ilink] = &_veclinks[ilink]->_info._t;
     }
+    _ComputeDOFDescendantLinks();
 
     InitializeLinkStateBitMasks(_vLinkEnableStatesMask, _veclinks.size());
     for (const LinkPtr& plink : _veclinks) {
@@ -4916,26 +4956,12 @@ void KinBody::_ComputeInternalInformation()
     }
 
     // notify any callbacks of the changes
-    std::list<UserDataWeakPtr> listRegisteredCallbacks;
-    uint32_t index = 0;
     uint32_t parameters = _nParametersChanged;
-    while(parameters && index < _vlistRegisteredCallbacks.size()) {
-        if( (parameters & 1) &&  _vlistRegisteredCallbacks.at(index).size() > 0 ) {
-            {
-                boost::shared_lock< boost::shared_mutex > lock(GetInterfaceMutex());
-                listRegisteredCallbacks = _vlistRegisteredCallbacks.at(index); // copy since it can be changed
-            }
-            FOREACH(it,listRegisteredCallbacks) {
-                ChangeCallbackDataPtr pdata = boost::dynamic_pointer_cast<ChangeCallbackData>(it->lock());
-                if( !!pdata ) {
-                    pdata->_callback();
-                }
-            }
-        }
-        parameters >>= 1;
-        index += 1;
-    }
     _nParametersChanged = 0;
+    _bChangedLinksMarked = false;
+    if( parameters ) {
+        _NotifyChangedParameters(parameters, NULL);
+    }
 
     if( !!_pKinematicsGenerator ) {
         _pCurrentKinematicsFunctions = _pKinematicsGenerator->GenerateKinematicsFunctions(*this);
@@ -4958,6 +4984,57 @@ void KinBody::_DeinitializeInternalInformation()
     _nHierarchyComputed = 0; // should reset to inform other elements that kinematics information might not be accurate
 }
 
+void KinBody::_ComputeDOFDescendantLinks()
+{
+    _vDOFDescendantLinkIndices.clear();
+    if( _vClosedLoops.size() > 0 ) {
+        // passive joints of closed loops are computed from the current link transforms, so always recompute everything
+        return;
+    }
+
+    // replay the order in which SetDOFValues computes the links. A link has to be recomputed if the joint that sets it depends on the dof
+    // or its parent link has to be recomputed. Static joints always set their child, all other joints only set it if it was not set before.
+    std::vector<uint8_t> vvisited(_veclinks.size()), vdescendant(_veclinks.size());
+    _vDOFDescendantLinkIndices.resize(GetDOF());
+    for(int dofindex = 0; dofindex < GetDOF(); ++dofindex) {
+        std::fill(vvisited.begin(), vvisited.end(), 0);
+        std::fill(vdescendant.begin(), vdescendant.end(), 0);
+        vvisited.at(0) = 1;
+        for(const JointPtr& pjoint : _vTopologicallySortedJointsAll) {
+            const Joint& joint = *pjoint;
+            const int parentindex = !!joint._attachedbodies[0] ? joint._attachedbodies[0]->GetIndex() : 0;
+            const int childindex = joint._attachedbodies[1]->GetIndex();
+            if( joint.IsStatic() ) {
+                vdescendant[childindex] |= vdescendant[parentindex];
+                vvisited[childindex] = 1;
+                continue;
+            }
+            if( vvisited[childindex] ) {
+                continue;
+            }
+            vvisited[childindex] = 1;
+            bool bDependsOnDOF = vdescendant[parentindex] || (joint.GetDOFIndex() >= 0 && dofindex >= joint.GetDOFIndex() && dofindex < joint.GetDOFIndex()+joint.GetDOF());
+            for(int iaxis = 0; iaxis < joint.GetDOF() && !bDependsOnDOF; ++iaxis) {
+                if( joint.IsMimic(iaxis) ) {
+                    for(const Mimic::DOFHierarchy& dofhierarchy : joint._vmimic[iaxis]->_vmimicdofs) {
+                        if( dofhierarchy.dofindex == dofindex ) {
+                            bDependsOnDOF = true;
+                            break;
+                        }
+                    }
+                }
+            }
+            vdescendant[childindex] = bDependsOnDOF;
+        }
+        std::vector<int>& vlinkindices = _vDOFDescendantLinkIndices[dofindex];
+        for(int ilink = 0; ilink < (int)_veclinks.size(); ++ilink) {
+            if( vdescendant[ilink] ) {
+                vlinkindices.push_back(ilink);
+            }
+        }
+    }
+}
+
 bool KinBody::IsAttached(const KinBody &body) const
 {
     // handle obvious cases without doing expensive operations
@@ -5245,6 +5322,7 @@ void KinBody::Enable(bool bEnable)
         if( link._info._bIsEnabled != bEnable ) {
             link._info._bIsEnabled = bEnable;
             _nNonAdjacentLinkCache &= ~AO_Enabled;
+            _MarkChangedLink(link.GetIndex());
             bchanged = true;
         }
     }
@@ -5569,6 +5647,7 @@ void KinBody::Clone(InterfaceBaseConstPtr preference, int cloningoptions)
     }
     _vDOFOrderedJoints = r->_vDOFOrderedJoints;
     _vJointsAffectingLinks = r->_vJointsAffectingLinks;
+    _vDOFDescendantLinkIndices = r->_vDOFDescendantLinkIndices;
     _vDOFIndices = r->_vDOFIndices;
 
     _vAdjacentLinks = r->_vAdjacentLinks;
@@ -5674,11 +5753,19 @@ void KinBody::Clone(InterfaceBaseConstPtr preference, int cloningoptions)
     SetKinematicsGenerator(r->_pKinematicsGenerator);
 
     _nUpdateStampId++; // update the stamp instead of copying
+    _ResetInfoHashes();
 }
 
 void KinBody::_PostprocessChangedParameters(uint32_t parameters)
 {
     _nUpdateStampId++;
+    // if links were marked with _MarkChangedLink only they changed, otherwise consider all links changed
+    bool bChangedLinksKnown = _bChangedLinksMarked;
+    _bChangedLinksMarked = false;
+    if( !!(parameters & ~(Prop_LinkTransforms|Prop_BodyAttached)) ) {
+        // the structure might not match the last applied infos anymore
+        _ResetInfoHashes();
+    }
     if( _nHierarchyComputed == 1 ) {
         _nParametersChanged |= parameters;
         return;
@@ -5689,6 +5776,7 @@ void KinBody::_PostprocessChangedParameters(uint32_t parameters)
         vector<dReal> vzeros(GetDOF(),0);
         SetDOFValues(vzeros,Transform(),true);
         _ComputeInternalInformation();
+        bChangedLinksKnown = false;
     }
     // do not change hash if geometry changed!
     if( !!(parameters & (Prop_LinkDynamics|Prop_LinkGeometry|Prop_JointMimic)) ) {
@@ -5697,77 +5785,152 @@ void KinBody::_PostprocessChangedParameters(uint32_t parameters)
 
     if( (parameters&Prop_LinkEnable) == Prop_LinkEnable ) {
         // check if any regrabbed bodies have the link in _listNonCollidingLinks and the link is enabled, or are missing the link in _listNonCollidingLinks and the link is disabled
-        std::map<GrabbedPtr, list<KinBody::LinkConstPtr> > mapcheckcollisions;
-        FOREACH(itlink,_veclinks) {
-            if( (*itlink)->IsEnabled() ) {
-                FOREACH(itgrabbed,_vGrabbedBodies) {
-                    GrabbedPtr pgrabbed = boost::dynamic_pointer_cast<Grabbed>(*itgrabbed);
-                    if( find(pgrabbed->GetRigidlyAttachedLinks().begin(),pgrabbed->GetRigidlyAttachedLinks().end(), *itlink) == pgrabbed->GetRigidlyAttachedLinks().end() ) {
-                        std::list<KinBody::LinkConstPtr>::iterator itnoncolliding = find(pgrabbed->_listNonCollidingLinks.begin(),pgrabbed->_listNonCollidingLinks.end(),*itlink);
-                        if( itnoncolliding != pgrabbed->_listNonCollidingLinks.end() ) {
-                            if( pgrabbed->WasLinkNonColliding(*itlink) == 0 ) {
-                                pgrabbed->_listNonCollidingLinks.erase(itnoncolliding);
-                            }
-                            mapcheckcollisions[pgrabbed].push_back(*itlink);
-                        }
-                        else {
-                            // try to restore
-                            if( pgrabbed->WasLinkNonColliding(*itlink) == 1 ) {
-                                pgrabbed->_listNonCollidingLinks.push_back(*itlink);
-                            }
+        for(const UserDataPtr& pGrabbedUserData : _vGrabbedBodies) {
+            Grabbed& grabbed = *boost::static_pointer_cast<Grabbed>(pGrabbedUserData);
+            std::list<KinBody::LinkConstPtr>& nonCollidingLinks = grabbed._listNonCollidingLinks;
+            for(int ilink = 0; ilink < (int)_veclinks.size(); ++ilink) {
+                if( (bChangedLinksKnown && !IsLinkStateBitEnabled(_vChangedLinksMask, ilink)) || grabbed.IsRobotLinkRigidlyAttached(ilink) ) {
+                    continue;
+                }
+                const LinkPtr& plink = _veclinks[ilink];
+                std::list<KinBody::LinkConstPtr>::iterator itnoncolliding = find(nonCollidingLinks.begin(), nonCollidingLinks.end(), plink);
+                if( plink->IsEnabled() ) {
+                    if( itnoncolliding != nonCollidingLinks.end() ) {
+                        if( grabbed.WasRobotLinkNonColliding(ilink) == 0 ) {
+                            nonCollidingLinks.erase(itnoncolliding);
                         }
                     }
+                    else if( grabbed.WasRobotLinkNonColliding(ilink) == 1 ) {
+                        // try to restore
+                        nonCollidingLinks.push_back(plink);
+                    }
+                }
+                else if( itnoncolliding == nonCollidingLinks.end() && grabbed.WasRobotLinkNonColliding(ilink) != 0 ) {
+                    // add since it is disabled?
+                    nonCollidingLinks.push_back(plink);
                 }
             }
-            else {
-                // add since it is disabled?
-                for ( const UserDataPtr& pGrabbedUserData : _vGrabbedBodies) {
-                    Grabbed& grabbed = *(boost::dynamic_pointer_cast<Grabbed>(pGrabbedUserData));
-                    const std::vector<KinBody::LinkPtr>& attachedLinks = grabbed.GetRigidlyAttachedLinks();
-                    if( find(attachedLinks.begin(),attachedLinks.end(), *itlink) == attachedLinks.end() ) {
-                        std::list<KinBody::LinkConstPtr>& nonCollidingLinks = grabbed._listNonCollidingLinks;
-                        if( find(nonCollidingLinks.begin(),nonCollidingLinks.end(),*itlink) == nonCollidingLinks.end() ) {
-                            if( grabbed.WasLinkNonColliding(*itlink) != 0 ) {
-                                nonCollidingLinks.push_back(*itlink);
+        }
+    }
+
+    _NotifyChangedParameters(parameters, bChangedLinksKnown ? &_vChangedLinksMask : NULL);
+}
+
+void KinBody::_NotifyChangedParameters(uint32_t parameters, const std::vector<uint64_t>* pChangedLinksMask)
+{
+    if( _nChangeBatchDepth == 0 ) {
+        _NotifyChangeCallbacks(parameters, pChangedLinksMask, true, true);
+        return;
+    }
+
+    _nBatchedParameters |= parameters;
+    ResizeLinkStateBitMasks(_vBatchedChangedLinksMask, _veclinks.size());
+    if( !!pChangedLinksMask ) {
+        for(size_t i = 0; i < pChangedLinksMask->size() && i < _vBatchedChangedLinksMask.size(); ++i) {
+            _vBatchedChangedLinksMask[i] |= (*pChangedLinksMask)[i];
+        }
+    }
+    else {
+        EnableAllLinkStateBitMasks(_vBatchedChangedLinksMask, _veclinks.size());
+    }
+    // collision checkers and grabbed bodies synchronize through the plain callbacks, so they cannot wait for the commit
+    _NotifyChangeCallbacks(parameters, pChangedLinksMask, true, false);
+}
+
+void KinBody::_NotifyChangeCallbacks(uint32_t parameters, const std::vector<uint64_t>* pChangedLinksMask, bool bChangeCallbacks, bool bChangeSetCallbacks)
+{
+    // every callback is called once even if it is registered for several of the changed parameters
+    std::vector< std::pair<const UserData*, UserDataWeakPtr> > vcallbacks;
+    {
+        boost::shared_lock< boost::shared_mutex > lock(GetInterfaceMutex());
+        uint32_t index = 0;
+        uint32_t remaining = parameters;
+        while(remaining && index < _vlistRegisteredCallbacks.size()) {
+            if( remaining & 1 ) {
+                for(const UserDataWeakPtr& pweakdata : _vlistRegisteredCallbacks[index]) {
+                    UserDataPtr pdata = pweakdata.lock();
+                    if( !!pdata ) {
+                        bool bAdded = false;
+                        for(const std::pair<const UserData*, UserDataWeakPtr>& callback : vcallbacks) {
+                            if( callback.first == pdata.get() ) {
+                                bAdded = true;
+                                break;
                             }
                         }
+                        if( !bAdded ) {
+                            vcallbacks.emplace_back(pdata.get(), pweakdata);
+                        }
                     }
                 }
             }
+            remaining >>= 1;
+            index += 1;
         }
+    }
 
-//        if( mapcheckcollisions.size() > 0 ) {
-//            CollisionOptionsStateSaver colsaver(GetEnv()->GetCollisionChecker(),0); // have to reset the collision options
-//            FOREACH(itgrabbed, mapcheckcollisions) {
-//                KinBodyPtr pgrabbedbody(itgrabbed->first->_pgrabbedbody);
-//                _RemoveAttachedBody(pgrabbedbody);
-//                CallOnDestruction destructionhook(boost::bind(&RobotBase::_AttachBody,this,pgrabbedbody));
-//                FOREACH(itlink, itgrabbed->second) {
-//                    if( pchecker->CheckCollision(*itlink, KinBodyConstPtr(pgrabbedbody)) ) {
-//                        itgrabbed->first->_listNonCollidingLinks.remove(*itlink);
-//                    }
-//                }
-//            }
-//        }
+    if( vcallbacks.size() == 0 ) {
+        return;
     }
 
-    std::list<UserDataWeakPtr> listRegisteredCallbacks;
-    uint32_t index = 0;
-    while(parameters && index < _vlistRegisteredCallbacks.size()) {
-        if( (parameters & 1) &&  _vlistRegisteredCallbacks.at(index).size() > 0 ) {
-            {
-                boost::shared_lock< boost::shared_mutex > lock(GetInterfaceMutex());
-                listRegisteredCallbacks = _vlistRegisteredCallbacks.at(index); // copy since it can be changed
-            }
-            FOREACH(it,listRegisteredCallbacks) {
-                ChangeCallbackDataPtr pdata = boost::dynamic_pointer_cast<ChangeCallbackData>(it->lock());
-                if( !!pdata ) {
-                    pdata->_callback();
+    // copy the mask since callbacks can change the body
+    std::vector<uint64_t> vChangedLinksMask;
+    if( !!pChangedLinksMask ) {
+        vChangedLinksMask = *pChangedLinksMask;
+    }
+    else {
+        InitializeLinkStateBitMasks(vChangedLinksMask, _veclinks.size());
+        EnableAllLinkStateBitMasks(vChangedLinksMask, _veclinks.size());
+    }
+
+    // callbacks can unregister other callbacks, so lock them one at a time
+    for(const std::pair<const UserData*, UserDataWeakPtr>& callback : vcallbacks) {
+        ChangeCallbackDataPtr pdata = boost::static_pointer_cast<ChangeCallbackData>(callback.second.lock());
+        if( !!pdata ) {
+            if( !!pdata->_changesetcallback ) {
+                if( bChangeSetCallbacks ) {
+                    pdata->_changesetcallback(parameters & pdata->_properties, vChangedLinksMask);
                 }
             }
+            else if( bChangeCallbacks ) {
+                pdata->_callback();
+            }
         }
-        parameters >>= 1;
-        index += 1;
+    }
+}
+
+void KinBody::BeginChangeBatch()
+{
+    if( _nChangeBatchDepth++ == 0 ) {
+        _nBatchedParameters = 0;
+        _vBatchedChangedLinksMask.clear();
+    }
+}
+
+void KinBody::CommitChangeBatch()
+{
+    OPENRAVE_ASSERT_OP_FORMAT(_nChangeBatchDepth, >, 0, "env=%s, body %s has no change batch to commit", GetEnv()->GetNameId()%GetName(), ORE_InvalidState);
+    if( --_nChangeBatchDepth > 0 || _nBatchedParameters == 0 ) {
+        return;
+    }
+    uint32_t parameters = _nBatchedParameters;
+    std::vector<uint64_t> vChangedLinksMask;
+    vChangedLinksMask.swap(_vBatchedChangedLinksMask);
+    _nBatchedParameters = 0;
+    _NotifyChangeCallbacks(parameters, &vChangedLinksMask, false, true);
+}
+
+KinBody::ChangeBatchScope::ChangeBatchScope(KinBodyPtr pbody) : _pbody(pbody)
+{
+    _pbody->BeginChangeBatch();
+}
+
+KinBody::ChangeBatchScope::~ChangeBatchScope()
+{
+    try {
+        _pbody->CommitChangeBatch();
+    }
+    catch(const std::exception& ex) {
+        RAVELOG_WARN_FORMAT("env=%s, failed to notify the changes of body %s: %s", _pbody->GetEnv()->GetNameId()%_pbody->GetName()%ex.what());
     }
 }
 
@@ -5869,7 +6032,17 @@ ConfigurationSpecification KinBody::GetConfigurationSpecificationIndices(const s
 
 UserDataPtr KinBody::RegisterChangeCallback(uint32_t properties, const boost::function<void()>&callback) const
 {
-    ChangeCallbackDataPtr pdata(new ChangeCallbackData(properties,callback,shared_kinbody_const()));
+    return _RegisterChangeCallback(properties, callback, ChangeSetCallbackFn());
+}
+
+UserDataPtr KinBody::RegisterChangeSetCallback(uint32_t properties, const ChangeSetCallbackFn& callback) const
+{
+    return _RegisterChangeCallback(properties, boost::function<void()>(), callback);
+}
+
+UserDataPtr KinBody::_RegisterChangeCallback(uint32_t properties, const boost::function<void()>& callback, const ChangeSetCallbackFn& changesetcallback) const
+{
+    ChangeCallbackDataPtr pdata(new ChangeCallbackData(properties,callback,changesetcallback,shared_kinbody_const()));
     boost::unique_lock< boost::shared_mutex > lock(GetInterfaceMutex());
 
     uint32_t index = 0;
@@ -6082,6 +6255,276 @@ void KinBody::ExtractInfo(KinBodyInfo& info)
     }
 }
 
+/// \brief 64-bit hash used for detecting unchanged link and joint infos in UpdateFromKinBodyInfo
+///
+/// Consumes the data 8 bytes at a time so that large meshes are hashed at memory speed.
+class InfoStructureHasher
+{
+public:
+    InfoStructureHasher() : _hash(14695981039346656037ULL), _bHashable(true) {
+    }
+
+    void HashBytes(const void* pdata, size_t size)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(pdata);
+        size_t i = 0;
+        for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+            uint64_t word;
+            memcpy(&word, p + i, sizeof(word));
+            _Mix(word);
+        }
+        if( i < size ) {
+            uint64_t word = 0;
+            memcpy(&word, p + i, size - i);
+            _Mix(word ^ ((uint64_t)(size - i) << 56));
+        }
+    }
+
+    template <typename T>
+    void Hash(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "can only hash plain data");
+        HashBytes(&value, sizeof(value));
+    }
+
+    void Hash(const std::string& value)
+    {
+        Hash(value.size());
+        HashBytes(value.data(), value.size());
+    }
+
+    template <typename T>
+    void Hash(const std::vector<T>& values)
+    {
+        Hash(values.size());
+        FOREACHC(it, values) {
+            Hash(*it);
+        }
+    }
+
+    template <typename T, size_t N>
+    void Hash(const boost::array<T, N>& values)
+    {
+        FOREACHC(it, values) {
+            Hash(*it);
+        }
+    }
+
+    template <typename T1, typename T2>
+    void Hash(const std::pair<T1, T2>& value)
+    {
+        Hash(value.first);
+        Hash(value.second);
+    }
+
+    template <typename K, typename V>
+    void Hash(const std::map<K, V>& values)
+    {
+        Hash(values.size());
+        FOREACHC(it, values) {
+            Hash(it->first);
+            Hash(it->second);
+        }
+    }
+
+    void Hash(const TriMesh& mesh)
+    {
+        Hash(mesh.vertices.size());
+        if( mesh.vertices.size() > 0 ) {
+            HashBytes(&mesh.vertices[0], mesh.vertices.size()*sizeof(mesh.vertices[0]));
+        }
+        Hash(mesh.indices.size());
+        if( mesh.indices.size() > 0 ) {
+            HashBytes(&mesh.indices[0], mesh.indices.size()*sizeof(mesh.indices[0]));
+        }
+    }
+
+    void Hash(const KinBody::GeometryInfo::SideWall& sidewall)
+    {
+        Hash(sidewall.transf);
+        Hash(sidewall.vExtents);
+        Hash(sidewall.type);
+    }
+
+    void Hash(const KinBody::GeometryInfo::CalibrationBoardParameters& params)
+    {
+        Hash(params.numDotsX);
+        Hash(params.numDotsY);
+        Hash(params.dotsDistanceX);
+        Hash(params.dotsDistanceY);
+        Hash(params.dotColor);
+        Hash(params.patternName);
+        Hash(params.dotDiameterDistanceRatio);
+        Hash(params.bigDotDiameterDistanceRatio);
+    }
+
+    void Hash(const KinBody::GeometryInfoPtr& pinfo)
+    {
+        Hash(!!pinfo);
+        if( !pinfo ) {
+            return;
+        }
+        const KinBody::GeometryInfo& info = *pinfo;
+        Hash(info.GetTransform());
+        Hash(info.IsModifiedField(KinBody::GeometryInfo::GIF_Transform));
+        Hash(info.IsModifiedField(KinBody::GeometryInfo::GIF_Mesh));
+        Hash(info._vGeomData);
+        Hash(info._vGeomData2);
+        Hash(info._vGeomData3);
+        Hash(info._vGeomData4);
+        Hash(info._vSideWalls);
+        Hash(info._vDiffuseColor);
+        Hash(info._vAmbientColor);
+        Hash(info._meshcollision);
+        Hash(info._id);
+        Hash(info._name);
+        Hash(info._type);
+        Hash(info._filenamerender);
+        Hash(info._filenamecollision);
+        Hash(info._vRenderScale);
+        Hash(info._vCollisionScale);
+        Hash(info._fTransparency);
+        Hash(info._bVisible);
+        Hash(info._bModifiable);
+        Hash(info._calibrationBoardParameters);
+    }
+
+    void Hash(const KinBody::LinkInfo& info)
+    {
+        Hash(info._id);
+        Hash(info._name);
+        Hash(info.GetTransform());
+        Hash(info.IsModifiedField(KinBody::LinkInfo::LIF_Transform));
+        Hash(info._tMassFrame);
+        Hash(info._mass);
+        Hash(info._vinertiamoments);
+        Hash(info._mapFloatParameters);
+        Hash(info._mapIntParameters);
+        Hash(info._mapStringParameters);
+        Hash(info._vForcedAdjacentLinks);
+        Hash(info._bStatic);
+        Hash(info._bIsEnabled);
+        Hash(info._vgeometryinfos);
+        Hash(info._mapExtraGeometries);
+    }
+
+    void Hash(const KinBody::MimicInfoPtr& pinfo)
+    {
+        Hash(!!pinfo);
+        if( !!pinfo ) {
+            Hash(pinfo->_equations);
+        }
+    }
+
+    void Hash(const ElectricMotorActuatorInfoPtr& pinfo)
+    {
+        Hash(!!pinfo);
+        if( !pinfo ) {
+            return;
+        }
+        const ElectricMotorActuatorInfo& info = *pinfo;
+        Hash(info.model_type);
+        Hash(info.assigned_power_rating);
+        Hash(info.max_speed);
+        Hash(info.no_load_speed);
+        Hash(info.stall_torque);
+        Hash(info.max_instantaneous_torque);
+        Hash(info.nominal_speed_torque_points);
+        Hash(info.max_speed_torque_points);
+        Hash(info.nominal_torque);
+        Hash(info.rotor_inertia);
+        Hash(info.torque_constant);
+        Hash(info.nominal_voltage);
+        Hash(info.speed_constant);
+        Hash(info.starting_current);
+        Hash(info.terminal_resistance);
+        Hash(info.gear_ratio);
+        Hash(info.coloumb_friction);
+        Hash(info.viscous_friction);
+    }
+
+    void Hash(const KinBody::JointInfo& info)
+    {
+        if( !!info._trajfollow || !!info._jci_robotcontroller || !!info._jci_io || !!info._jci_externaldevice ) {
+            _bHashable = false; // rarely used, always compare them
+        }
+        Hash(info._type);
+        Hash(info._id);
+        Hash(info._name);
+        Hash(info._linkname0);
+        Hash(info._linkname1);
+        Hash(info._vanchor);
+        Hash(info._vaxes);
+        Hash(info._vresolution);
+        Hash(info._vmaxvel);
+        Hash(info._vhardmaxvel);
+        Hash(info._vmaxaccel);
+        Hash(info._vhardmaxaccel);
+        Hash(info._vmaxjerk);
+        Hash(info._vhardmaxjerk);
+        Hash(info._vmaxtorque);
+        Hash(info._vmaxinertia);
+        Hash(info._vweights);
+        Hash(info._voffsets);
+        Hash(info._vlowerlimit);
+        Hash(info._vupperlimit);
+        Hash(info._vmimic);
+        Hash(info._mapFloatParameters);
+        Hash(info._mapIntParameters);
+        Hash(info._mapStringParameters);
+        Hash(info._infoElectricMotor);
+        Hash(info._bIsCircular);
+        Hash(info._bIsActive);
+        Hash(info._controlMode);
+    }
+
+    /// \brief returns the hash, or 0 if something could not be hashed
+    uint64_t GetHash() const
+    {
+        if( !_bHashable ) {
+            return 0;
+        }
+        return _hash != 0 ? _hash : 1;
+    }
+
+private:
+    inline void _Mix(uint64_t word)
+    {
+        _hash = (_hash ^ word) * 0x9e3779b97f4a7c15ULL;
+        _hash ^= _hash >> 32;
+    }
+
+    uint64_t _hash;
+    bool _bHashable;
+};
+
+uint64_t KinBody::_ComputeLinkInfoHash(const LinkInfo& info)
+{
+    InfoStructureHasher hasher;
+    hasher.Hash(info);
+    return hasher.GetHash();
+}
+
+uint64_t KinBody::_ComputeJointInfoHash(const JointInfo& info)
+{
+    InfoStructureHasher hasher;
+    hasher.Hash(info);
+    return hasher.GetHash();
+}
+
+void KinBody::_ResetInfoHashes()
+{
+    FOREACH(itlink, _veclinks) {
+        (*itlink)->_nInfoHash = 0;
+    }
+    FOREACH(itjoint, _vecjoints) {
+        (*itjoint)->_nInfoHash = 0;
+    }
+    FOREACH(itjoint, _vPassiveJoints) {
+        (*itjoint)->_nInfoHash = 0;
+    }
+}
+
 UpdateFromInfoResult KinBody::UpdateFromKinBodyInfo(const KinBodyInfo& info)
 {
     UpdateFromInfoResult updateFromInfoResult = UFIR_NoChange;
@@ -6100,6 +6543,70 @@ UpdateFromInfoResult KinBody::UpdateFromKinBodyInfo(const KinBodyInfo& info)
         updateFromInfoResult = UFIR_Success;
     }
 
+    if( !_UpdateLinksAndJointsFromInfo(info, updateFromInfoResult) ) {
+        return updateFromInfoResult;
+    }
+
+    // name
+    if (GetName() != info._name) {
+        OPENRAVE_ASSERT_OP(info._name.size(), >, 0);
+        SetName(info._name);
+        updateFromInfoResult = UFIR_Success;
+        RAVELOG_VERBOSE_FORMAT("body %s updated due to name change", _id);
+    }
+
+    // transform
+    if( info.IsModifiedField(KinBodyInfo::KBIF_Transform) && GetTransform().CompareTransform(info._transform, g_fEpsilon) ) {
+        SetTransform(info._transform);
+        updateFromInfoResult = UFIR_Success;
+        RAVELOG_VERBOSE_FORMAT("body %s updated due to transform change", _id);
+    }
+
+    // don't change the dof values here since body might not be added!
+    if( info.IsModifiedField(KinBodyInfo::KBIF_DOFValues) && _nHierarchyComputed == 2 ) {
+        // dof values
+        std::vector<dReal> dofValues;
+        GetDOFValues(dofValues);
+        bool bDOFChanged = false;
+        for(std::vector<std::pair<std::pair<std::string, int>, dReal> >::const_iterator it = info._dofValues.begin(); it != info._dofValues.end(); it++) {
+            // find the joint in the active chain
+            JointPtr joint;
+            FOREACHC(itJoint,_vecjoints) {
+                if ((*itJoint)->GetName() == it->first.first) {
+                    joint = *itJoint;
+                    break;
+                }
+            }
+            if (!joint) {
+                continue;
+            }
+            if (it->first.second >= joint->GetDOF()) {
+                continue;
+            }
+            int dofIndex = joint->GetDOFIndex()+it->first.second;
+            if (RaveFabs(dofValues.at(dofIndex) - it->second) > g_fEpsilon) {
+                dofValues[dofIndex] = it->second;
+                bDOFChanged = true;
+                //RAVELOG_VERBOSE_FORMAT("body %s dof %d value changed", _id%dofIndex);
+            }
+        }
+        if (bDOFChanged) {
+            SetDOFValues(dofValues);
+            updateFromInfoResult = UFIR_Success;
+            RAVELOG_VERBOSE_FORMAT("body %s updated due to dof values change", _id);
+        }
+    }
+
+    if( UpdateReadableInterfaces(info._mReadableInterfaces) ) {
+        updateFromInfoResult = UFIR_Success;
+        RAVELOG_VERBOSE_FORMAT("body %s updated due to readable interface change", _id);
+    }
+
+    return updateFromInfoResult;
+}
+
+bool KinBody::_UpdateLinksAndJointsFromInfo(const KinBodyInfo& info, UpdateFromInfoResult& updateFromInfoResult)
+{
     // need to avoid checking links and joints belonging to connected bodies
     std::vector<bool> isConnectedLink(_veclinks.size(), false);  // indicate which link comes from connectedbody
     std::vector<bool> isConnectedJoint(_vecjoints.size(), false); // indicate which joint comes from connectedbody
@@ -6153,13 +6660,32 @@ UpdateFromInfoResult KinBody::UpdateFromKinBodyInfo(const KinBodyInfo& info)
         }
     }
 
+    // links and joints whose info hashes the same as the info they were last updated from, and that did not change
+    // since, are up to date and do not have to be compared
+    std::vector<uint64_t> vLinkInfoHashes(info._vLinkInfos.size()), vJointInfoHashes(info._vJointInfos.size());
+    for(size_t iinfo = 0; iinfo < info._vLinkInfos.size(); ++iinfo) {
+        vLinkInfoHashes[iinfo] = !info._vLinkInfos[iinfo] ? 0 : _ComputeLinkInfoHash(*info._vLinkInfos[iinfo]);
+    }
+    for(size_t iinfo = 0; iinfo < info._vJointInfos.size(); ++iinfo) {
+        vJointInfoHashes[iinfo] = !info._vJointInfos[iinfo] ? 0 : _ComputeJointInfoHash(*info._vJointInfos[iinfo]);
+    }
+    auto isLinkUnchangedFn = [&vLinkInfoHashes](int index, const LinkPtr& plink) {
+        return vLinkInfoHashes[index] != 0 && plink->_nInfoHash == vLinkInfoHashes[index];
+    };
+    auto isJointUnchangedFn = [&vJointInfoHashes](int index, const JointPtr& pjoint) {
+        return vJointInfoHashes[index] != 0 && pjoint->_nInfoHash == vJointInfoHashes[index];
+    };
+
     {
         // in order for link transform comparision to make sense, have to change the kinbody to the identify.
-        // First check if any of the link infos have modified transforms
+        // First check if any of the link infos that have to be compared have modified transforms
         KinBody::KinBodyStateSaverPtr stateSaver;
-        FOREACHC(itLinkInfo, info._vLinkInfos) {
+        for(size_t iinfo = 0; iinfo < info._vLinkInfos.size(); ++iinfo) {
+            if( iinfo < vLinks.size() && isLinkUnchangedFn(iinfo, vLinks[iinfo]) ) {
+                continue;
+            }
             // if any link has its transform field set, we need to set zero configuration before comparison
-            if( (*itLinkInfo)->IsModifiedField(KinBody::LinkInfo::LIF_Transform) ) {
+            if( info._vLinkInfos[iinfo]->IsModifiedField(KinBody::LinkInfo::LIF_Transform) ) {
                 stateSaver.reset(new KinBody::KinBodyStateSaver(shared_kinbody(), Save_LinkTransformation));
                 SetTransform(Transform());
                 vector<dReal> vZeros(GetDOF(), 0);
@@ -6169,72 +6695,24 @@ UpdateFromInfoResult KinBody::UpdateFromKinBodyInfo(const KinBodyInfo& info)
         }
 
         // links
-        if (!UpdateChildrenFromInfo(info._vLinkInfos, vLinks, updateFromInfoResult)) {
-            return updateFromInfoResult;
+        if (!UpdateChildrenFromInfo(info._vLinkInfos, vLinks, updateFromInfoResult, isLinkUnchangedFn)) {
+            return false;
         }
     }
 
     // joints
-    if (!UpdateChildrenFromInfo(info._vJointInfos, vJoints, updateFromInfoResult)) {
-        return updateFromInfoResult;
-    }
-
-    // name
-    if (GetName() != info._name) {
-        OPENRAVE_ASSERT_OP(info._name.size(), >, 0);
-        SetName(info._name);
-        updateFromInfoResult = UFIR_Success;
-        RAVELOG_VERBOSE_FORMAT("body %s updated due to name change", _id);
-    }
-
-    // transform
-    if( info.IsModifiedField(KinBodyInfo::KBIF_Transform) && GetTransform().CompareTransform(info._transform, g_fEpsilon) ) {
-        SetTransform(info._transform);
-        updateFromInfoResult = UFIR_Success;
-        RAVELOG_VERBOSE_FORMAT("body %s updated due to transform change", _id);
+    if (!UpdateChildrenFromInfo(info._vJointInfos, vJoints, updateFromInfoResult, isJointUnchangedFn)) {
+        return false;
     }
 
-    // don't change the dof values here since body might not be added!
-    if( info.IsModifiedField(KinBodyInfo::KBIF_DOFValues) && _nHierarchyComputed == 2 ) {
-        // dof values
-        std::vector<dReal> dofValues;
-        GetDOFValues(dofValues);
-        bool bDOFChanged = false;
-        for(std::vector<std::pair<std::pair<std::string, int>, dReal> >::const_iterator it = info._dofValues.begin(); it != info._dofValues.end(); it++) {
-            // find the joint in the active chain
-            JointPtr joint;
-            FOREACHC(itJoint,_vecjoints) {
-                if ((*itJoint)->GetName() == it->first.first) {
-                    joint = *itJoint;
-                    break;
-                }
-            }
-            if (!joint) {
-                continue;
-            }
-            if (it->first.second >= joint->GetDOF()) {
-                continue;
-            }
-            int dofIndex = joint->GetDOFIndex()+it->first.second;
-            if (RaveFabs(dofValues.at(dofIndex) - it->second) > g_fEpsilon) {
-                dofValues[dofIndex] = it->second;
-                bDOFChanged = true;
-                //RAVELOG_VERBOSE_FORMAT("body %s dof %d value changed", _id%dofIndex);
-            }
-        }
-        if (bDOFChanged) {
-            SetDOFValues(dofValues);
-            updateFromInfoResult = UFIR_Success;
-            RAVELOG_VERBOSE_FORMAT("body %s updated due to dof values change", _id);
-        }
+    // vLinks and vJoints are now ordered like the infos. set the hashes last since applying changes resets them
+    for(size_t iinfo = 0; iinfo < info._vLinkInfos.size(); ++iinfo) {
+        vLinks[iinfo]->_nInfoHash = vLinkInfoHashes[iinfo];
     }
-
-    if( UpdateReadableInterfaces(info._mReadableInterfaces) ) {
-        updateFromInfoResult = UFIR_Success;
-        RAVELOG_VERBOSE_FORMAT("body %s updated due to readable interface change", _id);
+    for(size_t iinfo = 0; iinfo < info._vJointInfos.size(); ++iinfo) {
+        vJoints[iinfo]->_nInfoHash = vJointInfoHashes[iinfo];
     }
-
-    return updateFromInfoResult;
+    return true;
 }
 
 void KinBody::SetKinematicsGenerator(KinematicsGeneratorPtr pGenerator)
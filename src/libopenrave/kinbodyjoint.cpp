@@ -510,6 +510,7 @@ KinBody::Joint::Joint(KinBodyPtr parent, KinBody::JointType type)
     }
     jointindex=-1;
     dofindex = -1; // invalid index
+    _nInfoHash = 0;
     _bInitialized = false;
     _nIsStatic = -1;
     _info._type = type;
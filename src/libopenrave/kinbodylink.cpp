@@ -352,6 +352,7 @@ KinBody::Link::Link(KinBodyPtr parent)
 {
     _parent = parent;
     _index = -1;
+    _nInfoHash = 0;
 }
 
 KinBody::Link::~Link()
@@ -364,7 +365,8 @@ void KinBody::Link::Enable(bool bEnable)
         KinBodyPtr parent = GetParent();
         parent->_nNonAdjacentLinkCache &= ~AO_Enabled;
         _Enable(bEnable);
-        GetParent()->_PostprocessChangedParameters(Prop_LinkEnable);
+        parent->_MarkChangedLink(GetIndex());
+        parent->_PostprocessChangedParameters(Prop_LinkEnable);
     }
 }
 
@@ -18,38 +18,96 @@
 
 namespace OpenRAVE {
 
-KinBody::KinBodyStateSaver::KinBodyStateSaver(KinBodyPtr pbody, int options) : _pbody(pbody), _options(options), _bRestoreOnDestructor(true)
+void KinBody::StateSnapshot::Save(const KinBody& body, int options)
 {
+    _options = options;
+    _nUpdateStamp = body.GetUpdateStamp();
     if( _options & Save_LinkTransformation ) {
-        _pbody->GetLinkTransformations(_vLinkTransforms, _vdoflastsetvalues);
+        body.GetLinkTransformations(_vLinkTransforms, _vdoflastsetvalues);
     }
     if( _options & Save_LinkEnable ) {
-        _vEnabledLinks.resize(_pbody->GetLinks().size());
+        _vEnabledLinks.resize(body.GetLinks().size());
         for(size_t i = 0; i < _vEnabledLinks.size(); ++i) {
-            _vEnabledLinks[i] = _pbody->GetLinks().at(i)->IsEnabled();
+            _vEnabledLinks[i] = body.GetLinks()[i]->IsEnabled();
         }
     }
     if( _options & Save_LinkVelocities ) {
-        _pbody->GetLinkVelocities(_vLinkVelocities);
+        body.GetLinkVelocities(_vLinkVelocities);
     }
     if( _options & Save_JointMaxVelocityAndAcceleration ) {
-        _pbody->GetDOFVelocityLimits(_vMaxVelocities);
-        _pbody->GetDOFAccelerationLimits(_vMaxAccelerations);
-        _pbody->GetDOFJerkLimits(_vMaxJerks);
+        body.GetDOFVelocityLimits(_vMaxVelocities);
+        body.GetDOFAccelerationLimits(_vMaxAccelerations);
+        body.GetDOFJerkLimits(_vMaxJerks);
     }
     if( _options & Save_JointWeights ) {
-        _pbody->GetDOFWeights(_vDOFWeights);
+        body.GetDOFWeights(_vDOFWeights);
     }
     if( _options & Save_JointLimits ) {
-        _pbody->GetDOFLimits(_vDOFLimits[0], _vDOFLimits[1]);
+        body.GetDOFLimits(_vDOFLimits[0], _vDOFLimits[1]);
     }
     if( _options & Save_JointResolutions ) {
-        _pbody->GetDOFResolutions(_vDOFResolutions);
+        body.GetDOFResolutions(_vDOFResolutions);
     }
     if( _options & Save_GrabbedBodies ) {
-        _vGrabbedBodies = _pbody->_vGrabbedBodies;
+        _vGrabbedBodies = body._vGrabbedBodies;
+    }
+    else {
+        _vGrabbedBodies.clear();
+    }
+
+    // grabbed bodies can be moved without changing the stamp of the grabbing body, so have to remember their stamps too
+    _vGrabbedUpdateStamps.resize(body._vGrabbedBodies.size());
+    for(size_t igrabbed = 0; igrabbed < body._vGrabbedBodies.size(); ++igrabbed) {
+        KinBodyPtr pgrabbedbody = boost::static_pointer_cast<Grabbed>(body._vGrabbedBodies[igrabbed])->_pgrabbedbody.lock();
+        _vGrabbedUpdateStamps[igrabbed] = !!pgrabbedbody ? pgrabbedbody->GetUpdateStamp() : -1;
+    }
+}
+
+bool KinBody::StateSnapshot::IsUnchanged(const KinBody& body) const
+{
+    // every change of the transforms, enable states, grabbed bodies, and joint properties increments the update stamp
+    if( _nUpdateStamp != body.GetUpdateStamp() || _vGrabbedUpdateStamps.size() != body._vGrabbedBodies.size() ) {
+        return false;
+    }
+    for(size_t igrabbed = 0; igrabbed < body._vGrabbedBodies.size(); ++igrabbed) {
+        KinBodyPtr pgrabbedbody = boost::static_pointer_cast<Grabbed>(body._vGrabbedBodies[igrabbed])->_pgrabbedbody.lock();
+        if( !pgrabbedbody || pgrabbedbody->GetUpdateStamp() != _vGrabbedUpdateStamps[igrabbed] ) {
+            return false;
+        }
     }
+    return true;
+}
 
+KinBody::StateSnapshotPtr KinBody::_AcquireStateSnapshot() const
+{
+    {
+        boost::mutex::scoped_lock lock(_mutexStateSnapshotPool);
+        if( _vStateSnapshotPool.size() > 0 ) {
+            StateSnapshotPtr psnapshot;
+            psnapshot.swap(_vStateSnapshotPool.back());
+            _vStateSnapshotPool.pop_back();
+            return psnapshot;
+        }
+    }
+    return StateSnapshotPtr(new StateSnapshot());
+}
+
+void KinBody::_ReleaseStateSnapshot(StateSnapshotPtr& psnapshot) const
+{
+    if( !psnapshot ) {
+        return;
+    }
+    // do not keep the grabbed bodies alive while in the pool
+    psnapshot->_vGrabbedBodies.clear();
+    boost::mutex::scoped_lock lock(_mutexStateSnapshotPool);
+    _vStateSnapshotPool.push_back(StateSnapshotPtr());
+    _vStateSnapshotPool.back().swap(psnapshot);
+}
+
+KinBody::KinBodyStateSaver::KinBodyStateSaver(KinBodyPtr pbody, int options) : _pbody(pbody), _options(options), _pSnapshotOwner(pbody), _bRestoreOnDestructor(true)
+{
+    _psnapshot = _pbody->_AcquireStateSnapshot();
+    _psnapshot->Save(*_pbody, _options);
 }
 
 KinBody::KinBodyStateSaver::~KinBodyStateSaver()
@@ -57,6 +115,10 @@ KinBody::KinBodyStateSaver::~KinBodyStateSaver()
     if( _bRestoreOnDestructor && !!_pbody && _pbody->GetEnvironmentBodyIndex() != 0 ) {
         _RestoreKinBody(_pbody);
     }
+    KinBodyPtr powner = !!_pbody ? _pbody : _pSnapshotOwner.lock();
+    if( !!powner ) {
+        powner->_ReleaseStateSnapshot(_psnapshot);
+    }
 }
 
 void KinBody::KinBodyStateSaver::Restore(boost::shared_ptr<KinBody> body)
@@ -83,19 +145,27 @@ void KinBody::KinBodyStateSaver::_RestoreKinBody(boost::shared_ptr<KinBody> pbod
         RAVELOG_WARN_FORMAT("env=%d, body %s not added to environment, skipping restore", pbody->GetEnv()->GetId()%pbody->GetName());
         return;
     }
+    const StateSnapshot& snapshot = *_psnapshot;
+    if( pbody == _pbody && snapshot.IsUnchanged(*pbody) ) {
+        // nothing that is tracked by the update stamp changed, so only have to restore the velocities
+        if( _options & Save_LinkVelocities ) {
+            pbody->SetLinkVelocities(snapshot._vLinkVelocities);
+        }
+        return;
+    }
     if( _options & Save_JointLimits ) {
-        pbody->SetDOFLimits(_vDOFLimits[0], _vDOFLimits[1]);
+        pbody->SetDOFLimits(snapshot._vDOFLimits[0], snapshot._vDOFLimits[1]);
     }
     // restoring grabbed bodies has to happen first before link transforms can be restored since _UpdateGrabbedBodies can be called with the old grabbed bodies.
     if( _options & Save_GrabbedBodies ) {
         // have to release all grabbed first
         pbody->ReleaseAllGrabbed();
         OPENRAVE_ASSERT_OP(pbody->_vGrabbedBodies.size(),==,0);
-        FOREACH(itgrabbed, _vGrabbedBodies) {
+        FOREACH(itgrabbed, snapshot._vGrabbedBodies) {
             GrabbedPtr pgrabbed = boost::dynamic_pointer_cast<Grabbed>(*itgrabbed);
             KinBodyPtr pbodygrab = pgrabbed->_pgrabbedbody.lock();
             if( !!pbodygrab ) {
-                if( pbody->GetEnv() == _pbody->GetEnv() ) {
+                if( pbody->GetEnv() == pbodygrab->GetEnv() ) {
                     pbody->_AttachBody(pbodygrab);
                     pbody->_vGrabbedBodies.push_back(*itgrabbed);
                 }
@@ -130,7 +200,7 @@ void KinBody::KinBodyStateSaver::_RestoreKinBody(boost::shared_ptr<KinBody> pbod
         }
     }
     if( _options & Save_LinkTransformation ) {
-        pbody->SetLinkTransformations(_vLinkTransforms, _vdoflastsetvalues);
+        pbody->SetLinkTransformations(snapshot._vLinkTransforms, snapshot._vdoflastsetvalues);
 //        if( IS_DEBUGLEVEL(Level_Warn) ) {
 //            stringstream ss; ss << std::setprecision(std::numeric_limits<dReal>::digits10+1);
 //            ss << "restoring kinbody " << pbody->GetName() << " to values=[";
@@ -146,9 +216,9 @@ void KinBody::KinBodyStateSaver::_RestoreKinBody(boost::shared_ptr<KinBody> pbod
     if( _options & Save_LinkEnable ) {
         // should first enable before calling the parameter callbacks
         bool bchanged = false;
-        for(size_t i = 0; i < _vEnabledLinks.size(); ++i) {
-            if( pbody->GetLinks().at(i)->IsEnabled() != !!_vEnabledLinks[i] ) {
-                pbody->GetLinks().at(i)->_Enable(!!_vEnabledLinks[i]);
+        for(size_t i = 0; i < snapshot._vEnabledLinks.size(); ++i) {
+            if( pbody->GetLinks().at(i)->IsEnabled() != !!snapshot._vEnabledLinks[i] ) {
+                pbody->GetLinks().at(i)->_Enable(!!snapshot._vEnabledLinks[i]);
                 bchanged = true;
             }
         }
@@ -158,53 +228,26 @@ void KinBody::KinBodyStateSaver::_RestoreKinBody(boost::shared_ptr<KinBody> pbod
         }
     }
     if( _options & Save_JointMaxVelocityAndAcceleration ) {
-        pbody->SetDOFVelocityLimits(_vMaxVelocities);
-        pbody->SetDOFAccelerationLimits(_vMaxAccelerations);
-        pbody->SetDOFJerkLimits(_vMaxJerks);
+        pbody->SetDOFVelocityLimits(snapshot._vMaxVelocities);
+        pbody->SetDOFAccelerationLimits(snapshot._vMaxAccelerations);
+        pbody->SetDOFJerkLimits(snapshot._vMaxJerks);
     }
     if( _options & Save_LinkVelocities ) {
-        pbody->SetLinkVelocities(_vLinkVelocities);
+        pbody->SetLinkVelocities(snapshot._vLinkVelocities);
     }
     if( _options & Save_JointWeights ) {
-        pbody->SetDOFWeights(_vDOFWeights);
+        pbody->SetDOFWeights(snapshot._vDOFWeights);
     }
     if( _options & Save_JointResolutions ) {
-        pbody->SetDOFResolutions(_vDOFResolutions);
+        pbody->SetDOFResolutions(snapshot._vDOFResolutions);
     }
 }
 
 
 KinBody::KinBodyStateSaverRef::KinBodyStateSaverRef(KinBody& body, int options) : _body(body), _options(options), _bRestoreOnDestructor(true), _bReleased(false)
 {
-    if( _options & Save_LinkTransformation ) {
-        body.GetLinkTransformations(_vLinkTransforms, _vdoflastsetvalues);
-    }
-    if( _options & Save_LinkEnable ) {
-        _vEnabledLinks.resize(body.GetLinks().size());
-        for(size_t i = 0; i < _vEnabledLinks.size(); ++i) {
-            _vEnabledLinks[i] = body.GetLinks().at(i)->IsEnabled();
-        }
-    }
-    if( _options & Save_LinkVelocities ) {
-        body.GetLinkVelocities(_vLinkVelocities);
-    }
-    if( _options & Save_JointMaxVelocityAndAcceleration ) {
-        body.GetDOFVelocityLimits(_vMaxVelocities);
-        body.GetDOFAccelerationLimits(_vMaxAccelerations);
-        body.GetDOFJerkLimits(_vMaxJerks);
-    }
-    if( _options & Save_JointWeights ) {
-        body.GetDOFWeights(_vDOFWeights);
-    }
-    if( _options & Save_JointLimits ) {
-        body.GetDOFLimits(_vDOFLimits[0], _vDOFLimits[1]);
-    }
-    if( _options & Save_GrabbedBodies ) {
-        _vGrabbedBodies = body._vGrabbedBodies;
-    }
-    if( _options & Save_JointResolutions ) {
-        body.GetDOFResolutions(_vDOFResolutions);
-    }
+    _psnapshot = body._AcquireStateSnapshot();
+    _psnapshot->Save(body, _options);
 }
 
 KinBody::KinBodyStateSaverRef::~KinBodyStateSaverRef()
@@ -212,6 +255,7 @@ KinBody::KinBodyStateSaverRef::~KinBodyStateSaverRef()
     if( _bRestoreOnDestructor && !_bReleased && _body.GetEnvironmentBodyIndex() != 0 ) {
         _RestoreKinBody(_body);
     }
+    _body._ReleaseStateSnapshot(_psnapshot);
 }
 
 void KinBody::KinBodyStateSaverRef::Restore()
@@ -242,15 +286,23 @@ void KinBody::KinBodyStateSaverRef::_RestoreKinBody(KinBody& body)
         RAVELOG_WARN(str(boost::format("body %s not added to environment, skipping restore")%body.GetName()));
         return;
     }
+    const StateSnapshot& snapshot = *_psnapshot;
+    if( &body == &_body && snapshot.IsUnchanged(body) ) {
+        // nothing that is tracked by the update stamp changed, so only have to restore the velocities
+        if( _options & Save_LinkVelocities ) {
+            body.SetLinkVelocities(snapshot._vLinkVelocities);
+        }
+        return;
+    }
     if( _options & Save_JointLimits ) {
-        body.SetDOFLimits(_vDOFLimits[0], _vDOFLimits[1]);
+        body.SetDOFLimits(snapshot._vDOFLimits[0], snapshot._vDOFLimits[1]);
     }
     // restoring grabbed bodies has to happen first before link transforms can be restored since _UpdateGrabbedBodies can be called with the old grabbed bodies.
     if( _options & Save_GrabbedBodies ) {
         // have to release all grabbed first
         body.ReleaseAllGrabbed();
         OPENRAVE_ASSERT_OP(body._vGrabbedBodies.size(),==,0);
-        FOREACH(itgrabbed, _vGrabbedBodies) {
+        FOREACH(itgrabbed, snapshot._vGrabbedBodies) {
             GrabbedPtr pgrabbed = boost::dynamic_pointer_cast<Grabbed>(*itgrabbed);
             KinBodyPtr pbodygrab = pgrabbed->_pgrabbedbody.lock();
             if( !!pbodygrab ) {
@@ -284,7 +336,7 @@ void KinBody::KinBodyStateSaverRef::_RestoreKinBody(KinBody& body)
         }
     }
     if( _options & Save_LinkTransformation ) {
-        body.SetLinkTransformations(_vLinkTransforms, _vdoflastsetvalues);
+        body.SetLinkTransformations(snapshot._vLinkTransforms, snapshot._vdoflastsetvalues);
 //        if( IS_DEBUGLEVEL(Level_Warn) ) {
 //            stringstream ss; ss << std::setprecision(std::numeric_limits<dReal>::digits10+1);
 //            ss << "restoring kinbody " << body.GetName() << " to values=[";
@@ -300,9 +352,9 @@ void KinBody::KinBodyStateSaverRef::_RestoreKinBody(KinBody& body)
     if( _options & Save_LinkEnable ) {
         // should first enable before calling the parameter callbacks
         bool bchanged = false;
-        for(size_t i = 0; i < _vEnabledLinks.size(); ++i) {
-            if( body.GetLinks().at(i)->IsEnabled() != !!_vEnabledLinks[i] ) {
-                body.GetLinks().at(i)->_Enable(!!_vEnabledLinks[i]);
+        for(size_t i = 0; i < snapshot._vEnabledLinks.size(); ++i) {
+            if( body.GetLinks().at(i)->IsEnabled() != !!snapshot._vEnabledLinks[i] ) {
+                body.GetLinks().at(i)->_Enable(!!snapshot._vEnabledLinks[i]);
                 bchanged = true;
             }
         }
@@ -312,18 +364,18 @@ void KinBody::KinBodyStateSaverRef::_RestoreKinBody(KinBody& body)
         }
     }
     if( _options & Save_JointMaxVelocityAndAcceleration ) {
-        body.SetDOFVelocityLimits(_vMaxVelocities);
-        body.SetDOFAccelerationLimits(_vMaxAccelerations);
-        body.SetDOFJerkLimits(_vMaxJerks);
+        body.SetDOFVelocityLimits(snapshot._vMaxVelocities);
+        body.SetDOFAccelerationLimits(snapshot._vMaxAccelerations);
+        body.SetDOFJerkLimits(snapshot._vMaxJerks);
     }
     if( _options & Save_LinkVelocities ) {
-        body.SetLinkVelocities(_vLinkVelocities);
+        body.SetLinkVelocities(snapshot._vLinkVelocities);
     }
     if( _options & Save_JointWeights ) {
-        body.SetDOFWeights(_vDOFWeights);
+        body.SetDOFWeights(snapshot._vDOFWeights);
     }
     if( _options & Save_JointResolutions ) {
-        body.SetDOFResolutions(_vDOFResolutions);
+        body.SetDOFResolutions(snapshot._vDOFResolutions);
     }
 }
 
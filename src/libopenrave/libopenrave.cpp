@@ -2245,6 +2245,8 @@ void Grabbed::ProcessCollidingLinks(const std::set<int>& setRobotLinksToIgnore)
     _mapLinkIsNonColliding.clear();
     KinBodyPtr pgrabbedbody(_pgrabbedbody);
     KinBodyPtr pbody = RaveInterfaceCast<KinBody>(_plinkrobot->GetParent());
+    InitializeLinkStateBitMasks(_vRobotLinksKnownMask, pbody->GetLinks().size());
+    InitializeLinkStateBitMasks(_vRobotLinksNonCollidingMask, pbody->GetLinks().size());
     EnvironmentBasePtr penv = pbody->GetEnv();
     CollisionCheckerBasePtr pchecker = pbody->GetSelfCollisionChecker();
     if( !pchecker ) {
@@ -2274,7 +2276,7 @@ void Grabbed::ProcessCollidingLinks(const std::set<int>& setRobotLinksToIgnore)
                     //RAVELOG_DEBUG_FORMAT("check %s col %s %s %fs", pchecker->GetXMLId()%(*itlink)->GetName()%pgrabbedbody->GetName()%(1e-6*(utils::GetMicroTime()-localstarttime)));
                 }
             }
-            _mapLinkIsNonColliding[*itlink] = noncolliding;
+            _SetRobotLinkNonColliding(*itlink, noncolliding);
         }
 
         //uint64_t starttime1 = utils::GetMicroTime();
@@ -2330,11 +2332,25 @@ void Grabbed::AddMoreIgnoreLinks(const std::set<int>& setRobotLinksToIgnore)
     FOREACHC(itignoreindex, setRobotLinksToIgnore) {
         _setRobotLinksToIgnore.insert(*itignoreindex);
         KinBody::LinkPtr plink = pbody->GetLinks().at(*itignoreindex);
-        _mapLinkIsNonColliding[plink] = 0;
+        _SetRobotLinkNonColliding(plink, 0);
         _listNonCollidingLinks.remove(plink);
     }
 }
 
+void Grabbed::_SetRobotLinkNonColliding(KinBody::LinkConstPtr plink, int noncolliding)
+{
+    _mapLinkIsNonColliding[plink] = noncolliding;
+    ResizeLinkStateBitMasks(_vRobotLinksKnownMask, plink->GetIndex()+1);
+    ResizeLinkStateBitMasks(_vRobotLinksNonCollidingMask, plink->GetIndex()+1);
+    EnableLinkStateBit(_vRobotLinksKnownMask, plink->GetIndex());
+    if( noncolliding ) {
+        EnableLinkStateBit(_vRobotLinksNonCollidingMask, plink->GetIndex());
+    }
+    else {
+        DisableLinkStateBit(_vRobotLinksNonCollidingMask, plink->GetIndex());
+    }
+}
+
 /// return -1 for unknown, 0 for no, 1 for yes
 int Grabbed::WasLinkNonColliding(KinBody::LinkConstPtr plink) const
 {
@@ -2743,6 +2759,33 @@ int SpaceSamplerBase::_CallStatusFunctions(int sampleiteration)
     return ret;
 }
 
+bool CollisionCheckerBase::CheckCollision(KinBodyConstPtr pbody, const LinkEnableStatesMaskOverrides& vLinkEnableStatesMaskOverrides, CollisionReportPtr report)
+{
+    std::vector<KinBodyConstPtr> vbodyexcluded;
+    std::vector<KinBody::LinkConstPtr> vlinkexcluded;
+    FOREACHC(itoverride, vLinkEnableStatesMaskOverrides) {
+        const std::vector<KinBody::LinkPtr>& vlinks = itoverride->first->GetLinks();
+        const std::vector<uint64_t>& vmask = itoverride->second;
+        size_t numexcluded = 0;
+        for(size_t ilink = 0; ilink < vlinks.size(); ++ilink) {
+            if( (ilink >> 6) >= vmask.size() || !IsLinkStateBitEnabled(vmask, ilink) ) {
+                ++numexcluded;
+            }
+        }
+        if( numexcluded == vlinks.size() ) {
+            vbodyexcluded.push_back(itoverride->first);
+        }
+        else if( numexcluded > 0 ) {
+            for(size_t ilink = 0; ilink < vlinks.size(); ++ilink) {
+                if( (ilink >> 6) >= vmask.size() || !IsLinkStateBitEnabled(vmask, ilink) ) {
+                    vlinkexcluded.push_back(vlinks[ilink]);
+                }
+            }
+        }
+    }
+    return CheckCollision(pbody, vbodyexcluded, vlinkexcluded, report);
+}
+
 CollisionOptionsStateSaver::CollisionOptionsStateSaver(CollisionCheckerBasePtr p, int newoptions, bool required)
 {
     _oldoptions = p->GetCollisionOptions();
@@ -313,6 +313,10 @@ public:
     Grabbed(KinBodyPtr pgrabbedbody, KinBody::LinkPtr plinkrobot) : _pgrabbedbody(pgrabbedbody), _plinkrobot(plinkrobot) {
         _enablecallback = pgrabbedbody->RegisterChangeCallback(KinBody::Prop_LinkEnable, boost::bind(&Grabbed::UpdateCollidingLinks, this));
         _plinkrobot->GetRigidlyAttachedLinks(_vattachedlinks);
+        InitializeLinkStateBitMasks(_vAttachedLinksMask, _plinkrobot->GetParent()->GetLinks().size());
+        FOREACHC(itlink, _vattachedlinks) {
+            EnableLinkStateBit(_vAttachedLinksMask, (*itlink)->GetIndex());
+        }
     }
     virtual ~Grabbed() {
     }
@@ -338,6 +342,19 @@ public:
     /// return -1 for unknown, 0 for no, 1 for yes
     int WasLinkNonColliding(KinBody::LinkConstPtr plink) const;
 
+    /// \brief same as WasLinkNonColliding for the link of the grabbing body with index linkindex
+    inline int WasRobotLinkNonColliding(int linkindex) const {
+        if( (linkindex >> 6) >= (int)_vRobotLinksKnownMask.size() || !IsLinkStateBitEnabled(_vRobotLinksKnownMask, linkindex) ) {
+            return -1;
+        }
+        return IsLinkStateBitEnabled(_vRobotLinksNonCollidingMask, linkindex) ? 1 : 0;
+    }
+
+    /// \brief true if the link of the grabbing body with index linkindex is one of GetRigidlyAttachedLinks
+    inline bool IsRobotLinkRigidlyAttached(int linkindex) const {
+        return (linkindex >> 6) < (int)_vAttachedLinksMask.size() && IsLinkStateBitEnabled(_vAttachedLinksMask, linkindex);
+    }
+
     /// \brief updates the non-colliding info while reusing the cache data from _ProcessCollidingLinks
     ///
     /// note that Regrab here is *very* dangerous since the robot could be a in a bad self-colliding state with the body. therefore, update the non-colliding state based on _mapLinkIsNonColliding
@@ -347,7 +364,12 @@ private:
     std::vector<KinBody::LinkPtr> _vattachedlinks;
     UserDataPtr _enablecallback; ///< callback for grabbed body when it is enabled/disabled
 
+    /// \brief sets the collision state of a link of the grabbing body in _mapLinkIsNonColliding and the masks
+    void _SetRobotLinkNonColliding(KinBody::LinkConstPtr plink, int noncolliding);
+
     std::map<KinBody::LinkConstPtr, int> _mapLinkIsNonColliding; // the collision state for each link at the time the body was grabbed.
+    std::vector<uint64_t> _vAttachedLinksMask; ///< indices of _vattachedlinks
+    std::vector<uint64_t> _vRobotLinksKnownMask, _vRobotLinksNonCollidingMask; ///< _mapLinkIsNonColliding of the links of the grabbing body by link index
 };
 
 typedef boost::shared_ptr<Grabbed> GrabbedPtr;
@@ -578,8 +600,10 @@ void UpdateOrCreateInfoWithNameCheck(const rapidjson::Value& value, std::vector<
 }
 
 /// \brief Recursively call UpdateFromInfo on children. If children need to be added or removed, require re-init. Returns false if update fails and caller should not continue with other parts of the update.
-template<typename InfoPtrType, typename PtrType>
-bool UpdateChildrenFromInfo(const std::vector<InfoPtrType>& vInfos, std::vector<PtrType>& vPointers, UpdateFromInfoResult& result)
+///
+/// \param isUnchangedFn called as isUnchangedFn(index, pointer) with the child matched to vInfos[index]. If it returns true, UpdateFromInfo is not called for that child.
+template<typename InfoPtrType, typename PtrType, typename IsUnchangedFn>
+bool UpdateChildrenFromInfo(const std::vector<InfoPtrType>& vInfos, std::vector<PtrType>& vPointers, UpdateFromInfoResult& result, const IsUnchangedFn& isUnchangedFn)
 {
     int index = 0;
     for (typename std::vector<InfoPtrType>::const_iterator itInfo = vInfos.begin(); itInfo != vInfos.end(); ++itInfo, ++index) {
@@ -647,6 +671,10 @@ bool UpdateChildrenFromInfo(const std::vector<InfoPtrType>& vInfos, std::vector<
             return false;
         }
 
+        if( isUnchangedFn(index, pMatchExistingPointer) ) {
+            continue;
+        }
+
         UpdateFromInfoResult updateFromInfoResult = pMatchExistingPointer->UpdateFromInfo(*pInfo);
         if (updateFromInfoResult == UFIR_NoChange) {
             // no change
@@ -674,6 +702,14 @@ bool UpdateChildrenFromInfo(const std::vector<InfoPtrType>& vInfos, std::vector<
     return true;
 }
 
+template<typename InfoPtrType, typename PtrType>
+bool UpdateChildrenFromInfo(const std::vector<InfoPtrType>& vInfos, std::vector<PtrType>& vPointers, UpdateFromInfoResult& result)
+{
+    return UpdateChildrenFromInfo(vInfos, vPointers, result, [](int, const PtrType&) {
+        return false;
+    });
+}
+
 template<typename T>
 bool AreVectorsDeepEqual(const std::vector<boost::shared_ptr<T> >& vFirst, const std::vector<boost::shared_ptr<T> >& vSecond) {
     if (vFirst.size() != vSecond.size()) {
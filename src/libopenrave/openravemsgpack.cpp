@@ -22,6 +22,17 @@
 #include <msgpack.hpp>
 #include <rapidjson/document.h>
 
+#include <fstream>
+#include <cstring>
+#include <type_traits>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace msgpack {
 
 MSGPACK_API_VERSION_NAMESPACE(MSGPACK_DEFAULT_API_NS) {
@@ -293,11 +304,189 @@ void OpenRAVE::MsgPack::DumpMsgPack(const rapidjson::Value& value, std::vector<c
     msgpack::pack(&buf, value);
 }
 
+namespace OpenRAVE {
+
+namespace MsgPack {
+
+/// \brief decodes msgpack bytes directly into SAX events of a rapidjson handler
+///
+/// Used instead of msgpack::unpack so that no intermediate msgpack::object tree is built. The conversion rules are the
+/// same as the msgpack::object adaptor above: bin is treated as str, ext as null, and map keys have to be strings.
+/// The events still populate a full rapidjson::Document, decoding straight into the info structures is not supported.
+class MsgPackSAXGenerator
+{
+public:
+    MsgPackSAXGenerator(const char* data, size_t size) : _p(reinterpret_cast<const uint8_t*>(data)), _end(reinterpret_cast<const uint8_t*>(data)+size) {
+    }
+
+    template <typename Handler>
+    bool operator()(Handler& handler)
+    {
+        _Parse(handler, 0);
+        return true;
+    }
+
+private:
+    static const int s_maxDepth = 1024;
+
+    void _Require(size_t num) const
+    {
+        if( (size_t)(_end - _p) < num ) {
+            throw OPENRAVE_EXCEPTION_FORMAT0("msgpack data is truncated", ORE_InvalidArguments);
+        }
+    }
+
+    template <typename T>
+    T _ReadBigEndian()
+    {
+        _Require(sizeof(T));
+        uint64_t value = 0;
+        for(size_t i = 0; i < sizeof(T); ++i) {
+            value = (value << 8) | _p[i];
+        }
+        _p += sizeof(T);
+        T ret;
+        if( sizeof(T) == 8 ) {
+            std::memcpy(&ret, &value, sizeof(T));
+        }
+        else {
+            typename std::conditional<sizeof(T) == 4, uint32_t, typename std::conditional<sizeof(T) == 2, uint16_t, uint8_t>::type>::type narrow = value;
+            std::memcpy(&ret, &narrow, sizeof(T));
+        }
+        return ret;
+    }
+
+    const char* _ReadBytes(size_t num)
+    {
+        _Require(num);
+        const char* ptr = reinterpret_cast<const char*>(_p);
+        _p += num;
+        return ptr;
+    }
+
+    /// \brief non-negative signed values are reported as unsigned, same as msgpack::type::POSITIVE_INTEGER
+    template <typename Handler>
+    void _Int(Handler& handler, int64_t value)
+    {
+        if( value >= 0 ) {
+            handler.Uint64(value);
+        }
+        else {
+            handler.Int64(value);
+        }
+    }
+
+    template <typename Handler>
+    void _String(Handler& handler, size_t len, bool bKey)
+    {
+        const char* ptr = _ReadBytes(len);
+        if( bKey ) {
+            handler.Key(ptr, len, true);
+        }
+        else {
+            handler.String(ptr, len, true);
+        }
+    }
+
+    template <typename Handler>
+    void _Array(Handler& handler, size_t num, int depth)
+    {
+        handler.StartArray();
+        for(size_t i = 0; i < num; ++i) {
+            _Parse(handler, depth+1);
+        }
+        handler.EndArray(num);
+    }
+
+    template <typename Handler>
+    void _Map(Handler& handler, size_t num, int depth)
+    {
+        handler.StartObject();
+        for(size_t i = 0; i < num; ++i) {
+            _Parse(handler, depth+1, true);
+            _Parse(handler, depth+1);
+        }
+        handler.EndObject(num);
+    }
+
+    template <typename Handler>
+    void _Parse(Handler& handler, int depth, bool bKey=false)
+    {
+        if( depth > s_maxDepth ) {
+            throw OPENRAVE_EXCEPTION_FORMAT("msgpack data is nested deeper than %d", depth, ORE_InvalidArguments);
+        }
+        uint8_t tag = _ReadBigEndian<uint8_t>();
+        if( bKey && !((tag >= 0xa0 && tag <= 0xbf) || (tag >= 0xd9 && tag <= 0xdb) || (tag >= 0xc4 && tag <= 0xc6)) ) {
+            throw OPENRAVE_EXCEPTION_FORMAT("msgpack map key has to be a string, got tag 0x%x", (int)tag, ORE_InvalidArguments);
+        }
+        if( tag <= 0x7f ) {
+            handler.Uint64(tag);
+        }
+        else if( tag <= 0x8f ) {
+            _Map(handler, tag & 0x0f, depth);
+        }
+        else if( tag <= 0x9f ) {
+            _Array(handler, tag & 0x0f, depth);
+        }
+        else if( tag <= 0xbf ) {
+            _String(handler, tag & 0x1f, bKey);
+        }
+        else if( tag >= 0xe0 ) {
+            handler.Int64((int8_t)tag);
+        }
+        else {
+            switch(tag) {
+            case 0xc0: handler.Null(); break;
+            case 0xc2: handler.Bool(false); break;
+            case 0xc3: handler.Bool(true); break;
+            case 0xc4: case 0xd9: _String(handler, _ReadBigEndian<uint8_t>(), bKey); break;
+            case 0xc5: case 0xda: _String(handler, _ReadBigEndian<uint16_t>(), bKey); break;
+            case 0xc6: case 0xdb: _String(handler, _ReadBigEndian<uint32_t>(), bKey); break;
+            case 0xc7: _ReadBytes(1 + _ReadBigEndian<uint8_t>()); handler.Null(); break;
+            case 0xc8: _ReadBytes(1 + _ReadBigEndian<uint16_t>()); handler.Null(); break;
+            case 0xc9: _ReadBytes(1 + (size_t)_ReadBigEndian<uint32_t>()); handler.Null(); break;
+            case 0xca: handler.Double(_ReadBigEndian<float>()); break;
+            case 0xcb: handler.Double(_ReadBigEndian<double>()); break;
+            case 0xcc: handler.Uint64(_ReadBigEndian<uint8_t>()); break;
+            case 0xcd: handler.Uint64(_ReadBigEndian<uint16_t>()); break;
+            case 0xce: handler.Uint64(_ReadBigEndian<uint32_t>()); break;
+            case 0xcf: handler.Uint64(_ReadBigEndian<uint64_t>()); break;
+            case 0xd0: _Int(handler, _ReadBigEndian<int8_t>()); break;
+            case 0xd1: _Int(handler, _ReadBigEndian<int16_t>()); break;
+            case 0xd2: _Int(handler, _ReadBigEndian<int32_t>()); break;
+            case 0xd3: _Int(handler, _ReadBigEndian<int64_t>()); break;
+            case 0xd4: _ReadBytes(2); handler.Null(); break;
+            case 0xd5: _ReadBytes(3); handler.Null(); break;
+            case 0xd6: _ReadBytes(5); handler.Null(); break;
+            case 0xd7: _ReadBytes(9); handler.Null(); break;
+            case 0xd8: _ReadBytes(17); handler.Null(); break;
+            case 0xdc: _Array(handler, _ReadBigEndian<uint16_t>(), depth); break;
+            case 0xdd: _Array(handler, _ReadBigEndian<uint32_t>(), depth); break;
+            case 0xde: _Map(handler, _ReadBigEndian<uint16_t>(), depth); break;
+            case 0xdf: _Map(handler, _ReadBigEndian<uint32_t>(), depth); break;
+            default:
+                throw OPENRAVE_EXCEPTION_FORMAT("invalid msgpack tag 0x%x", (int)tag, ORE_InvalidArguments);
+            }
+        }
+    }
+
+    const uint8_t* _p;
+    const uint8_t* _end;
+};
+
+} // namespace MsgPack
+
+} // namespace OpenRAVE
+
+void OpenRAVE::MsgPack::ParseMsgPack(rapidjson::Document& d, const char* data, size_t size)
+{
+    MsgPackSAXGenerator generator(data, size);
+    d.Populate(generator);
+}
+
 void OpenRAVE::MsgPack::ParseMsgPack(rapidjson::Document& d, const std::string& str)
 {
-    msgpack::unpacked unpacked;
-    msgpack::unpack(&unpacked, str.data(), str.size());
-    unpacked.get().convert(d);
+    OpenRAVE::MsgPack::ParseMsgPack(d, str.data(), str.size());
 }
 
 void OpenRAVE::MsgPack::ParseMsgPack(rapidjson::Document& d, std::istream& is)
@@ -307,6 +496,46 @@ void OpenRAVE::MsgPack::ParseMsgPack(rapidjson::Document& d, std::istream& is)
     OpenRAVE::MsgPack::ParseMsgPack(d, str);
 }
 
+void OpenRAVE::MsgPack::ParseMsgPackFile(rapidjson::Document& d, const std::string& filename)
+{
+#ifndef _WIN32
+    int fd = open(filename.c_str(), O_RDONLY);
+    if( fd < 0 ) {
+        throw OPENRAVE_EXCEPTION_FORMAT("failed to open msgpack file '%s'", filename, ORE_InvalidArguments);
+    }
+    struct stat st;
+    if( fstat(fd, &st) != 0 ) {
+        close(fd);
+        throw OPENRAVE_EXCEPTION_FORMAT("failed to stat msgpack file '%s'", filename, ORE_InvalidArguments);
+    }
+    if( st.st_size == 0 ) {
+        close(fd);
+        OpenRAVE::MsgPack::ParseMsgPack(d, NULL, 0);
+        return;
+    }
+    void* pdata = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if( pdata == MAP_FAILED ) {
+        throw OPENRAVE_EXCEPTION_FORMAT("failed to map msgpack file '%s'", filename, ORE_InvalidArguments);
+    }
+    madvise(pdata, st.st_size, MADV_SEQUENTIAL);
+    try {
+        OpenRAVE::MsgPack::ParseMsgPack(d, static_cast<const char*>(pdata), st.st_size);
+    }
+    catch(...) {
+        munmap(pdata, st.st_size);
+        throw;
+    }
+    munmap(pdata, st.st_size);
+#else
+    std::ifstream ifs(filename.c_str(), std::ios::in|std::ios::binary);
+    if( !ifs ) {
+        throw OPENRAVE_EXCEPTION_FORMAT("failed to open msgpack file '%s'", filename, ORE_InvalidArguments);
+    }
+    OpenRAVE::MsgPack::ParseMsgPack(d, ifs);
+#endif
+}
+
 #else
 
 void OpenRAVE::MsgPack::DumpMsgPack(const rapidjson::Value& value, std::ostream& os)
@@ -329,4 +558,14 @@ void OpenRAVE::MsgPack::ParseMsgPack(rapidjson::Document& d, std::istream& is)
     throw OPENRAVE_EXCEPTION_FORMAT0("MsgPack support is not enabled", ORE_NotImplemented);
 }
 
+void OpenRAVE::MsgPack::ParseMsgPack(rapidjson::Document& d, const char* data, size_t size)
+{
+    throw OPENRAVE_EXCEPTION_FORMAT0("MsgPack support is not enabled", ORE_NotImplemented);
+}
+
+void OpenRAVE::MsgPack::ParseMsgPackFile(rapidjson::Document& d, const std::string& filename)
+{
+    throw OPENRAVE_EXCEPTION_FORMAT0("MsgPack support is not enabled", ORE_NotImplemented);
+}
+
 #endif
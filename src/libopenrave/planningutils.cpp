@@ -3382,6 +3382,150 @@ bool SimpleNeighborhoodSampler::Sample(std::vector<dReal>& samples)
     return samples.size()>0;
 }
 
+ManipulatorIKGoalSamplerCache::ManipulatorIKGoalSamplerCache(int maxentries) : _maxentries(maxentries), _bBodyChanged(false)
+{
+}
+
+bool ManipulatorIKGoalSamplerCache::Find(RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikparam, const std::vector<dReal>& vfree, int filteroptions, std::vector<IkReturnPtr>& vikreturns)
+{
+    _Validate(pmanip);
+    _GetKey(pmanip, ikparam, vfree, filteroptions, _keycache);
+    std::map<std::string, std::vector<IkReturnPtr> >::const_iterator itentry = _mapentries.find(_keycache);
+    if( itentry == _mapentries.end() ) {
+        return false;
+    }
+    // callers are allowed to modify the returned solutions
+    vikreturns.resize(itentry->second.size());
+    for(size_t i = 0; i < vikreturns.size(); ++i) {
+        vikreturns[i].reset(new IkReturn(*itentry->second[i]));
+    }
+    return true;
+}
+
+void ManipulatorIKGoalSamplerCache::Insert(RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikparam, const std::vector<dReal>& vfree, int filteroptions, const std::vector<IkReturnPtr>& vikreturns)
+{
+    if( vikreturns.size() == 0 ) {
+        return;
+    }
+    _Validate(pmanip);
+    if( (int)_mapentries.size() >= _maxentries ) {
+        _mapentries.clear();
+    }
+    _GetKey(pmanip, ikparam, vfree, filteroptions, _keycache);
+    std::vector<IkReturnPtr>& vcachedreturns = _mapentries[_keycache];
+    vcachedreturns.resize(vikreturns.size());
+    for(size_t i = 0; i < vikreturns.size(); ++i) {
+        vcachedreturns[i].reset(new IkReturn(*vikreturns[i]));
+    }
+}
+
+void ManipulatorIKGoalSamplerCache::Clear()
+{
+    _mapentries.clear();
+    _robotname.clear();
+    _vrobotstate.clear();
+    _vbodystamps.clear();
+    _vchangecallbacks.clear();
+    _bBodyChanged = false;
+}
+
+void ManipulatorIKGoalSamplerCache::_Validate(RobotBase::ManipulatorConstPtr pmanip)
+{
+    RobotBasePtr probot = pmanip->GetRobot();
+    _GetState(pmanip, _vrobotstatecache, _vbodystampscache);
+    if( _bBodyChanged || _robotname != probot->GetName() || _vrobotstate != _vrobotstatecache || _vbodystamps != _vbodystampscache ) {
+        if( _mapentries.size() > 0 ) {
+            RAVELOG_VERBOSE_FORMAT("env=%d, state changed, dropping %d cached ik goals", probot->GetEnv()->GetId()%_mapentries.size());
+        }
+        _mapentries.clear();
+        _robotname = probot->GetName();
+        _vrobotstate.swap(_vrobotstatecache);
+        _vbodystamps.swap(_vbodystampscache);
+        _RegisterChangeCallbacks(probot);
+    }
+}
+
+void ManipulatorIKGoalSamplerCache::_RegisterChangeCallbacks(RobotBasePtr probot)
+{
+    _vchangecallbacks.resize(0);
+    _bBodyChanged = false;
+    // collision checks of the ik filters depend on these, the transforms are tracked with the update stamps
+    const uint32_t properties = KinBody::Prop_JointLimits|KinBody::Prop_LinkDraw|KinBody::Prop_LinkGeometry|KinBody::Prop_LinkGeometryGroup|KinBody::Prop_LinkEnable|KinBody::Prop_LinkStatic|KinBody::Prop_BodyAttached|KinBody::Prop_RobotManipulators|KinBody::Prop_RobotGrabbed|KinBody::Prop_BodyRemoved;
+    probot->GetEnv()->GetBodies(_vbodiescache);
+    FOREACHC(itbody, _vbodiescache) {
+        _vchangecallbacks.push_back((*itbody)->RegisterChangeCallback(properties, boost::bind(&ManipulatorIKGoalSamplerCache::_OnBodyChanged, this)));
+    }
+    _vbodiescache.clear();
+}
+
+void ManipulatorIKGoalSamplerCache::_OnBodyChanged()
+{
+    _bBodyChanged = true;
+}
+
+void ManipulatorIKGoalSamplerCache::_GetState(RobotBase::ManipulatorConstPtr pmanip, std::vector<dReal>& vrobotstate, std::vector< std::pair<int, int> >& vbodystamps)
+{
+    RobotBasePtr probot = pmanip->GetRobot();
+    Transform t = probot->GetTransform();
+    probot->GetDOFValues(vrobotstate);
+    // the arm moves while planning, the ik solutions do not depend on its values
+    FOREACHC(itindex, pmanip->GetArmIndices()) {
+        vrobotstate.at(*itindex) = 0;
+    }
+    vrobotstate.push_back(t.rot.x); vrobotstate.push_back(t.rot.y); vrobotstate.push_back(t.rot.z); vrobotstate.push_back(t.rot.w);
+    vrobotstate.push_back(t.trans.x); vrobotstate.push_back(t.trans.y); vrobotstate.push_back(t.trans.z);
+    FOREACHC(itmask, probot->GetLinkEnableStatesMasks()) {
+        vrobotstate.push_back((dReal)(*itmask & 0xffffffff));
+        vrobotstate.push_back((dReal)(*itmask >> 32));
+    }
+    probot->GetDOFLimits(_vlowercache, _vuppercache, pmanip->GetArmIndices());
+    vrobotstate.insert(vrobotstate.end(), _vlowercache.begin(), _vlowercache.end());
+    vrobotstate.insert(vrobotstate.end(), _vuppercache.begin(), _vuppercache.end());
+
+    // grabbed bodies move with the arm, so only track which bodies are grabbed and where
+    probot->GetGrabbedInfo(_vgrabbedinfocache);
+    FOREACHC(itinfo, _vgrabbedinfocache) {
+        KinBody::LinkPtr plink = probot->GetLink(itinfo->_robotlinkname);
+        vrobotstate.push_back(!!plink ? plink->GetIndex() : -1);
+        const Transform& trelative = itinfo->_trelative;
+        vrobotstate.push_back(trelative.rot.x); vrobotstate.push_back(trelative.rot.y); vrobotstate.push_back(trelative.rot.z); vrobotstate.push_back(trelative.rot.w);
+        vrobotstate.push_back(trelative.trans.x); vrobotstate.push_back(trelative.trans.y); vrobotstate.push_back(trelative.trans.z);
+    }
+    _vgrabbedinfocache.clear();
+    probot->GetGrabbed(_vgrabbedcache);
+    vbodystamps.resize(0);
+    FOREACHC(itgrabbed, _vgrabbedcache) {
+        vbodystamps.emplace_back(-(*itgrabbed)->GetEnvironmentBodyIndex(), 0);
+    }
+    probot->GetEnv()->GetBodies(_vbodiescache);
+    FOREACHC(itbody, _vbodiescache) {
+        if( *itbody == probot || std::find(_vgrabbedcache.begin(), _vgrabbedcache.end(), *itbody) != _vgrabbedcache.end() ) {
+            continue;
+        }
+        vbodystamps.emplace_back((*itbody)->GetEnvironmentBodyIndex(), (*itbody)->GetUpdateStamp());
+    }
+    _vbodiescache.clear(); // do not keep the bodies alive
+    _vgrabbedcache.clear();
+}
+
+void ManipulatorIKGoalSamplerCache::_GetKey(RobotBase::ManipulatorConstPtr pmanip, const IkParameterization& ikparam, const std::vector<dReal>& vfree, int filteroptions, std::string& key)
+{
+    // raw bytes of the values so that only exactly the same queries match
+    _vikvaluescache.resize(ikparam.GetNumberOfValues());
+    ikparam.GetValues(_vikvaluescache.begin());
+    IkParameterizationType iktype = ikparam.GetType();
+    key = pmanip->GetName();
+    key.push_back(0);
+    key.append((const char*)&iktype, sizeof(iktype));
+    key.append((const char*)&filteroptions, sizeof(filteroptions));
+    if( _vikvaluescache.size() > 0 ) {
+        key.append((const char*)&_vikvaluescache[0], _vikvaluescache.size()*sizeof(dReal));
+    }
+    if( vfree.size() > 0 ) {
+        key.append((const char*)&vfree[0], vfree.size()*sizeof(dReal));
+    }
+}
+
 ManipulatorIKGoalSampler::ManipulatorIKGoalSampler(RobotBase::ManipulatorConstPtr pmanip, const std::list<IkParameterization>& listparameterizations, int nummaxsamples, int nummaxtries, dReal fsampleprob, bool searchfreeparameters, int ikfilteroptions, const std::vector<dReal>& freevalues) : _pmanip(pmanip), _nummaxsamples(nummaxsamples), _nummaxtries(nummaxtries), _fsampleprob(fsampleprob), _ikfilteroptions(ikfilteroptions), _searchfreeparameters(searchfreeparameters), _vfreegoalvalues(freevalues)
 {
     _tempikindex = -1;
@@ -3649,7 +3793,17 @@ IkReturnPtr ManipulatorIKGoalSampler::Sample()
             ss << "]";
             RAVELOG_VERBOSE(ss.str());
         }
-        bool bsuccess = _pmanip->FindIKSolutions(ikparam, vfree, _ikfilteroptions|(bFullEndEffectorKnown&&bCheckEndEffector ? IKFO_IgnoreEndEffectorEnvCollisions : 0), _vikreturns);
+        int filteroptions = _ikfilteroptions|(bFullEndEffectorKnown&&bCheckEndEffector ? IKFO_IgnoreEndEffectorEnvCollisions : 0);
+        bool bsuccess;
+        if( !!_pcache && _pcache->Find(_pmanip, ikparam, vfree, filteroptions, _vikreturns) ) {
+            bsuccess = _vikreturns.size() > 0;
+        }
+        else {
+            bsuccess = _pmanip->FindIKSolutions(ikparam, vfree, filteroptions, _vikreturns);
+            if( !!_pcache && bsuccess ) {
+                _pcache->Insert(_pmanip, ikparam, vfree, filteroptions, _vikreturns);
+            }
+        }
         if( --sampleinfo._numleft <= 0 || vfree.size() == 0 || !_searchfreeparameters ) {
             _listsamples.erase(itsample);
         }
@@ -3709,5 +3863,304 @@ void ManipulatorIKGoalSampler::SetJitter(dReal maxdist)
     _fjittermaxdist = maxdist;
 }
 
+void ManipulatorIKGoalSampler::SetCache(ManipulatorIKGoalSamplerCachePtr pcache)
+{
+    _pcache = pcache;
+}
+
+PlannerFuture::PlannerFuture(SharedStatePtr pstate, const std::string& plannername, const std::string& robotname, PlannerParametersPtr parameters, int planningoptions, const ProgressFn& progressfn) : _pstate(pstate), _plannername(plannername), _robotname(robotname), _parameters(parameters), _planningoptions(planningoptions), _progressfn(progressfn), _action(PA_None), _iteration(0), _bStarted(false), _bDone(false)
+{
+}
+
+PlannerFuture::~PlannerFuture()
+{
+}
+
+void PlannerFuture::Cancel(bool bReturnWithAnySolution)
+{
+    boost::mutex::scoped_lock lock(_pstate->_mutex);
+    if( !_bDone ) {
+        _action = bReturnWithAnySolution ? PA_ReturnWithAnySolution : PA_Interrupt;
+    }
+}
+
+bool PlannerFuture::IsDone() const
+{
+    boost::mutex::scoped_lock lock(_pstate->_mutex);
+    return _bDone;
+}
+
+bool PlannerFuture::Wait(uint32_t timeoutms)
+{
+    boost::mutex::scoped_lock lock(_pstate->_mutex);
+    if( timeoutms == 0 ) {
+        while( !_bDone ) {
+            _pstate->_condition.wait(lock);
+        }
+        return true;
+    }
+    boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(timeoutms);
+    while( !_bDone ) {
+        if( !_pstate->_condition.timed_wait(lock, deadline) ) {
+            break;
+        }
+    }
+    return _bDone;
+}
+
+PlannerStatus PlannerFuture::GetStatus()
+{
+    Wait();
+    boost::mutex::scoped_lock lock(_pstate->_mutex);
+    return _status;
+}
+
+TrajectoryBasePtr PlannerFuture::GetTrajectory()
+{
+    Wait();
+    boost::mutex::scoped_lock lock(_pstate->_mutex);
+    return _ptraj;
+}
+
+int PlannerFuture::GetIteration() const
+{
+    boost::mutex::scoped_lock lock(_pstate->_mutex);
+    return _iteration;
+}
+
+PlannerAction PlannerFuture::_PlanCallback(const PlannerBase::PlannerProgress& progress)
+{
+    PlannerAction action;
+    {
+        boost::mutex::scoped_lock lock(_pstate->_mutex);
+        _iteration = progress._iteration;
+        action = _action;
+    }
+    if( !!_progressfn ) {
+        _progressfn(progress);
+    }
+    return action;
+}
+
+void PlannerFuture::_SetDone(const PlannerStatus& status, TrajectoryBasePtr ptraj)
+{
+    boost::mutex::scoped_lock lock(_pstate->_mutex);
+    _status = status;
+    _ptraj = ptraj;
+    _bDone = true;
+    _pstate->_condition.notify_all();
+}
+
+PlannerExecutor::PlannerExecutor(EnvironmentBasePtr penv, int numthreads, int cloningoptions) : _penv(penv), _cloningoptions(cloningoptions), _bShutdown(false)
+{
+    OPENRAVE_ASSERT_OP(numthreads,>,0);
+    _pstate.reset(new PlannerFuture::SharedState());
+    _vthreads.resize(numthreads);
+    for(size_t ithread = 0; ithread < _vthreads.size(); ++ithread) {
+        EnvironmentBasePtr pworkerenv = penv->CloneSelf(cloningoptions);
+        _vthreads[ithread].reset(new boost::thread(boost::bind(&PlannerExecutor::_WorkerThread, this, pworkerenv)));
+    }
+}
+
+PlannerExecutor::~PlannerExecutor()
+{
+    CancelAll();
+    {
+        boost::mutex::scoped_lock lock(_mutexQueue);
+        _bShutdown = true;
+        _conditionQueue.notify_all();
+    }
+    FOREACH(itthread, _vthreads) {
+        (*itthread)->join();
+    }
+    _vthreads.clear();
+}
+
+PlannerFuturePtr PlannerExecutor::Submit(const std::string& plannername, const std::string& robotname, PlannerParametersConstPtr parameters, int planningoptions, const PlannerFuture::ProgressFn& progressfn)
+{
+    // copying through the base class keeps the data of derived parameters in _sExtraParameters
+    PlannerParametersPtr pcopy(new PlannerParameters());
+    pcopy->copy(parameters);
+    if( !!pcopy->_samplegoalfn || !!pcopy->_sampleinitialfn || !!pcopy->_goalfn || !!pcopy->_costfn ) {
+        RAVELOG_WARN_FORMAT("env=%s, custom sample, goal, and cost functions of the planner parameters are bound to the source environment, ignoring them", _penv->GetNameId());
+    }
+    pcopy->_samplegoalfn.clear();
+    pcopy->_sampleinitialfn.clear();
+    pcopy->_goalfn.clear();
+    pcopy->_costfn.clear();
+
+    PlannerFuturePtr pfuture(new PlannerFuture(_pstate, plannername, robotname, pcopy, planningoptions, progressfn));
+    boost::mutex::scoped_lock lock(_mutexQueue);
+    if( _bShutdown ) {
+        throw OPENRAVE_EXCEPTION_FORMAT0(_("planner executor is shutting down"), ORE_InvalidState);
+    }
+    _listQueue.push_back(pfuture);
+    _conditionQueue.notify_one();
+    return pfuture;
+}
+
+int PlannerExecutor::WaitForAny(const std::vector<PlannerFuturePtr>& vfutures, uint32_t timeoutms, bool bCancelOthers)
+{
+    FOREACHC(itfuture, vfutures) {
+        if( (*itfuture)->_pstate != _pstate ) {
+            throw OPENRAVE_EXCEPTION_FORMAT0(_("future was not submitted to this executor"), ORE_InvalidArguments);
+        }
+    }
+
+    int ifound = -1;
+    {
+        boost::mutex::scoped_lock lock(_pstate->_mutex);
+        boost::system_time deadline = boost::get_system_time() + boost::posix_time::milliseconds(timeoutms);
+        bool bTimedOut = false;
+        while(1) {
+            bool bAllDone = true;
+            for(size_t ifuture = 0; ifuture < vfutures.size(); ++ifuture) {
+                if( !vfutures[ifuture]->_bDone ) {
+                    bAllDone = false;
+                }
+                else if( vfutures[ifuture]->_status.HasSolution() ) {
+                    ifound = ifuture;
+                    break;
+                }
+            }
+            if( ifound >= 0 || bAllDone || bTimedOut ) {
+                break;
+            }
+            if( timeoutms > 0 ) {
+                bTimedOut = !_pstate->_condition.timed_wait(lock, deadline);
+            }
+            else {
+                _pstate->_condition.wait(lock);
+            }
+        }
+    }
+
+    if( ifound >= 0 && bCancelOthers ) {
+        for(size_t ifuture = 0; ifuture < vfutures.size(); ++ifuture) {
+            if( (int)ifuture != ifound ) {
+                vfutures[ifuture]->Cancel();
+            }
+        }
+    }
+    return ifound;
+}
+
+void PlannerExecutor::CancelAll()
+{
+    std::list<PlannerFuturePtr> listqueued, listrunning;
+    {
+        boost::mutex::scoped_lock lock(_mutexQueue);
+        listqueued.swap(_listQueue);
+        listrunning = _listRunning;
+    }
+    FOREACH(itfuture, listqueued) {
+        (*itfuture)->_SetDone(PlannerStatus("plan was cancelled before it started", PS_Interrupted), TrajectoryBasePtr());
+    }
+    FOREACH(itfuture, listrunning) {
+        (*itfuture)->Cancel();
+    }
+}
+
+void PlannerExecutor::_WorkerThread(EnvironmentBasePtr pworkerenv)
+{
+    while(1) {
+        PlannerFuturePtr pfuture;
+        {
+            boost::mutex::scoped_lock lock(_mutexQueue);
+            while( !_bShutdown && _listQueue.empty() ) {
+                _conditionQueue.wait(lock);
+            }
+            if( _bShutdown ) {
+                break;
+            }
+            pfuture = _listQueue.front();
+            _listQueue.pop_front();
+            _listRunning.push_back(pfuture);
+        }
+        _RunPlan(pworkerenv, pfuture);
+        {
+            boost::mutex::scoped_lock lock(_mutexQueue);
+            _listRunning.remove(pfuture);
+        }
+    }
+    pworkerenv->Destroy();
+}
+
+void PlannerExecutor::_RunPlan(EnvironmentBasePtr pworkerenv, PlannerFuturePtr pfuture)
+{
+    bool bCancelled;
+    {
+        boost::mutex::scoped_lock lock(_pstate->_mutex);
+        bCancelled = pfuture->_action != PA_None;
+        pfuture->_bStarted = !bCancelled;
+    }
+    if( bCancelled ) {
+        pfuture->_SetDone(PlannerStatus("plan was cancelled before it started", PS_Interrupted), TrajectoryBasePtr());
+        return;
+    }
+
+    PlannerStatus status;
+    TrajectoryBasePtr ptraj;
+    try {
+        {
+            EnvironmentLock locksource(_penv->GetMutex());
+            pworkerenv->Clone(_penv, _cloningoptions);
+        }
+
+        EnvironmentLock lockworker(pworkerenv->GetMutex());
+        RobotBasePtr probot = pworkerenv->GetRobot(pfuture->_robotname);
+        PlannerBasePtr planner = RaveCreatePlanner(pworkerenv, pfuture->_plannername);
+        if( !probot ) {
+            status = PlannerStatus(str(boost::format("robot %s does not exist")%pfuture->_robotname), PS_Failed);
+        }
+        else if( !planner ) {
+            status = PlannerStatus(str(boost::format("failed to create planner %s")%pfuture->_plannername), PS_Failed);
+        }
+        else {
+            // bind the functions to the worker environment, keeping the limits and initial configuration that were submitted
+            PlannerParametersPtr parameters = pfuture->_parameters;
+            std::vector<dReal> vinitialconfig = parameters->vinitialconfig, vlowerlimit = parameters->_vConfigLowerLimit, vupperlimit = parameters->_vConfigUpperLimit;
+            std::vector<dReal> vvelocitylimit = parameters->_vConfigVelocityLimit, vaccelerationlimit = parameters->_vConfigAccelerationLimit, vresolution = parameters->_vConfigResolution;
+            parameters->SetConfigurationSpecification(pworkerenv, ConfigurationSpecification(parameters->_configurationspecification));
+            size_t dof = parameters->GetDOF();
+            if( vinitialconfig.size() > 0 ) {
+                parameters->vinitialconfig.swap(vinitialconfig);
+            }
+            if( vlowerlimit.size() == dof && vupperlimit.size() == dof ) {
+                parameters->_vConfigLowerLimit.swap(vlowerlimit);
+                parameters->_vConfigUpperLimit.swap(vupperlimit);
+            }
+            if( vvelocitylimit.size() == dof ) {
+                parameters->_vConfigVelocityLimit.swap(vvelocitylimit);
+            }
+            if( vaccelerationlimit.size() == dof ) {
+                parameters->_vConfigAccelerationLimit.swap(vaccelerationlimit);
+            }
+            if( vresolution.size() == dof ) {
+                parameters->_vConfigResolution.swap(vresolution);
+            }
+
+            UserDataPtr pcallbackhandle = planner->RegisterPlanCallback(boost::bind(&PlannerFuture::_PlanCallback, pfuture.get(), _1));
+            if( !planner->InitPlan(probot, parameters) ) {
+                status = PlannerStatus(str(boost::format("failed to initialize planner %s")%pfuture->_plannername), PS_Failed);
+            }
+            else {
+                TrajectoryBasePtr pworkertraj = RaveCreateTrajectory(pworkerenv, "");
+                status = planner->PlanPath(pworkertraj, pfuture->_planningoptions);
+                if( status.HasSolution() ) {
+                    ptraj = RaveCreateTrajectory(_penv, pworkertraj->GetXMLId());
+                    ptraj->Clone(pworkertraj, 0);
+                }
+            }
+        }
+    }
+    catch(const std::exception& ex) {
+        RAVELOG_WARN_FORMAT("env=%s, planner %s failed: %s", _penv->GetNameId()%pfuture->_plannername%ex.what());
+        status = PlannerStatus(ex.what(), PS_Failed);
+        ptraj.reset();
+    }
+    pfuture->_SetDone(status, ptraj);
+}
+
 } // planningutils
 } // OpenRAVE
@@ -1107,15 +1107,16 @@ void RobotBase::SetActiveDOFValues(const std::vector<dReal>& values, uint32_t bC
     }
 
     if( _vActiveDOFIndices.size() > 0 ) {
-        GetDOFValues(_vTempRobotJoints);
-        for(size_t i = 0; i < _vActiveDOFIndices.size(); ++i) {
-            _vTempRobotJoints[_vActiveDOFIndices[i]] = values[i];
-        }
         if( (int)_vActiveDOFIndices.size() < _nActiveDOF ) {
+            GetDOFValues(_vTempRobotJoints);
+            for(size_t i = 0; i < _vActiveDOFIndices.size(); ++i) {
+                _vTempRobotJoints[_vActiveDOFIndices[i]] = values[i];
+            }
             SetDOFValues(_vTempRobotJoints, t, bCheckLimits);
         }
         else {
-            SetDOFValues(_vTempRobotJoints, bCheckLimits);
+            // pass the active indices so that only the links downstream of the active dofs are recomputed
+            SetDOFValues(values, bCheckLimits, _vActiveDOFIndices);
         }
     }
 }
@@ -406,6 +406,22 @@ bool RobotBase::Manipulator::FindIKSolutions(const IkParameterization& goal, con
     return vFreeParameters.size() == 0 ? pIkSolver->SolveAll(localgoal,filteroptions,vikreturns) : pIkSolver->SolveAll(localgoal,vFreeParameters,filteroptions,vikreturns);
 }
 
+bool RobotBase::Manipulator::FindIKSolutionsBatch(const std::vector<IkParameterization>& vgoals, int filteroptions, std::vector<dReal>& vsolutions, std::vector<int>& vposesolutionoffsets) const
+{
+    IkSolverBasePtr pIkSolver = GetIkSolver();
+    OPENRAVE_ASSERT_FORMAT(!!pIkSolver, "manipulator %s:%s does not have an IK solver set",RobotBasePtr(__probot)->GetName()%GetName(),ORE_Failed);
+    BOOST_ASSERT(pIkSolver->GetManipulator() == shared_from_this() );
+    if( !__pBase ) {
+        return pIkSolver->SolveAllBatch(vgoals,filteroptions,vsolutions,vposesolutionoffsets);
+    }
+    std::vector<IkParameterization> vlocalgoals(vgoals.size());
+    Transform tbaseinv = __pBase->GetTransform().inverse();
+    for(size_t igoal = 0; igoal < vgoals.size(); ++igoal) {
+        vlocalgoals[igoal] = tbaseinv*vgoals[igoal];
+    }
+    return pIkSolver->SolveAllBatch(vlocalgoals,filteroptions,vsolutions,vposesolutionoffsets);
+}
+
 IkParameterization RobotBase::Manipulator::GetIkParameterization(IkParameterizationType iktype, bool inworld) const
 {
     IkParameterization ikp;
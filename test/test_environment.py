@@ -14,6 +14,8 @@
 from common_test_openrave import *
 from subprocess import Popen, PIPE
 import shutil
+import struct
+import sys
 import threading
 
 class TestEnvironment(EnvironmentSetup):
@@ -190,7 +192,145 @@ class TestEnvironment(EnvironmentSetup):
             self.log.info('new clone time: %fs',endtime)
             assert(endtime <= 0.05)
             misc.CompareEnvironments(env,clonedenv,epsilon=g_epsilon)
-            
+
+    def test_statediff(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        clonedenv = Environment()
+        try:
+            clonedenv.Clone(env, CloningOptions.Bodies)
+            clonedrobot = clonedenv.GetRobot(robot.GetName())
+            writer = EnvironmentStateDiffWriter(env)
+            applier = EnvironmentStateDiffApplier(clonedenv)
+            assert(applier.ApplyDiff(writer.WriteDiff()) == len(env.GetBodies()))
+
+            with env:
+                lower,upper = robot.GetDOFLimits()
+                robot.SetDOFValues(lower+0.3*(upper-lower))
+                Trobot=robot.GetTransform()
+                Trobot[0,3] += 0.5
+                robot.SetTransform(Trobot)
+            frame = writer.WriteDiff()
+            # a truncated frame is rejected as a whole and does not change the mirror
+            try:
+                applier.ApplyDiff(frame[:-3])
+                assert(False)
+            except openrave_exception as e:
+                assert(e.GetCode() == 'InvalidArguments')
+            assert(transdist(clonedrobot.GetTransform(),Trobot) > 0.4)
+            # the rejected frame did not advance the sequence, so the complete frame still applies
+            assert(applier.ApplyDiff(frame) == 1)
+            assert(transdist(clonedrobot.GetTransform(),Trobot) <= g_epsilon)
+            assert(transdist(clonedrobot.GetDOFValues(),robot.GetDOFValues()) <= g_epsilon)
+
+            # an out of range body index in a full frame is rejected without resizing the body tables
+            writer.Reset()
+            frame = writer.WriteDiff()
+            corrupted = frame[:12] + struct.pack('=i',0x7fffffff) + frame[16:]
+            try:
+                applier.ApplyDiff(corrupted)
+                assert(False)
+            except openrave_exception as e:
+                assert(e.GetCode() == 'InvalidArguments')
+            assert(applier.ApplyDiff(frame) == len(env.GetBodies()))
+        finally:
+            clonedenv.Destroy()
+
+    def test_jsondocumentcache(self):
+        import json, tempfile
+        env=self.env
+        hand = env.ReadKinBodyURI('robots/barretthand.kinbody.xml')
+        handinfo = hand.ExtractInfo().SerializeJSON()
+        handinfo['id'] = 'hand'
+        ijoint = [joint['name'] for joint in handinfo['joints']].index('JF1')
+        tempdir = tempfile.mkdtemp()
+        try:
+            def WriteHand(filename, upperlimit, mtime=None):
+                # the upper limits are chosen so that the file size does not change
+                handinfo['joints'][ijoint]['upperLimit'] = [upperlimit]
+                with open(filename,'w') as f:
+                    json.dump({'bodies':[handinfo]}, f)
+                if mtime is not None:
+                    os.utime(filename, (mtime, mtime))
+                return os.stat(filename).st_mtime
+
+            def WriteScene(filename, handfilename):
+                with open(filename,'w') as f:
+                    json.dump({'bodies':[{'id':'hand0', 'name':'hand0', 'referenceUri':'file:%s#hand'%handfilename}]}, f)
+
+            def LoadUpperLimit(scenefilename):
+                newenv = Environment()
+                try:
+                    assert(newenv.Load(scenefilename))
+                    return newenv.GetKinBody('hand0').GetJoint('JF1').GetLimits()[1][0]
+                finally:
+                    newenv.Destroy()
+
+            handfilename = os.path.join(tempdir, 'hand.json')
+            scenefilename = os.path.join(tempdir, 'scene.json')
+            mtime = WriteHand(handfilename, 1.25)
+            WriteScene(scenefilename, handfilename)
+
+            # every load gets its own infos, a joint changing its mimic equations does not change the cached body
+            assert(env.Load(scenefilename))
+            mimicjoint = env.GetKinBody('hand0').GetJoint('JF1mimic')
+            poseq = mimicjoint.GetMimicEquation(0)
+            mimicjoint.SetMimicEquations(0, 'JF1/2', '|JF1 0.5', '|JF1 0')
+            env2 = Environment()
+            try:
+                assert(env2.Load(scenefilename))
+                assert(env2.GetKinBody('hand0').GetJoint('JF1mimic').GetMimicEquation(0) == poseq)
+            finally:
+                env2.Destroy()
+            assert(abs(LoadUpperLimit(scenefilename)-1.25) <= g_epsilon)
+
+            # the cached document is validated only by the modification time and size, so an edit that keeps both is not seen
+            WriteHand(handfilename, 1.75, mtime)
+            assert(abs(LoadUpperLimit(scenefilename)-1.25) <= g_epsilon)
+
+            # the modification time has a resolution of 1s, so move it explicitly instead of waiting
+            WriteHand(handfilename, 1.75, mtime+2)
+            assert(abs(LoadUpperLimit(scenefilename)-1.75) <= g_epsilon)
+
+            # with room for only one document, loading another one evicts the first, so the same unseen edit is read this time
+            otherhandfilename = os.path.join(tempdir, 'otherhand.json')
+            otherscenefilename = os.path.join(tempdir, 'otherscene.json')
+            WriteHand(otherhandfilename, 1.25)
+            WriteScene(otherscenefilename, otherhandfilename)
+            mtime = WriteHand(handfilename, 1.25)
+            script = '''
+import json, os, sys
+from openravepy import *
+handinfo = json.load(open(sys.argv[1]))
+ijoint = [joint['name'] for joint in handinfo['bodies'][0]['joints']].index('JF1')
+def LoadUpperLimit(scenefilename):
+    env = Environment()
+    try:
+        assert(env.Load(scenefilename))
+        return env.GetKinBody('hand0').GetJoint('JF1').GetLimits()[1][0]
+    finally:
+        env.Destroy()
+assert(abs(LoadUpperLimit(sys.argv[2])-1.25) <= 1e-7)
+assert(abs(LoadUpperLimit(sys.argv[3])-1.25) <= 1e-7)
+mtime = os.stat(sys.argv[1]).st_mtime
+handinfo['bodies'][0]['joints'][ijoint]['upperLimit'] = [1.75]
+with open(sys.argv[1],'w') as f:
+    json.dump(handinfo, f)
+os.utime(sys.argv[1], (mtime, mtime))
+sys.stdout.write('%f'%LoadUpperLimit(sys.argv[2]))
+RaveDestroy()
+'''
+            cachesizemb = 1.5*os.stat(handfilename).st_size/(1024.0*1024.0)
+            childenv = dict(os.environ)
+            childenv['OPENRAVE_JSON_DOCUMENT_CACHE_SIZE'] = '%f'%cachesizemb
+            child = Popen([sys.executable, '-c', script, handfilename, scenefilename, otherscenefilename], stdout=PIPE, env=childenv)
+            output = child.communicate()[0]
+            assert(child.returncode == 0)
+            assert(abs(float(output)-1.75) <= 1e-5)
+        finally:
+            shutil.rmtree(tempdir)
+
     def test_multithread(self):
         self.log.info('test multiple threads accessing same resource')
         def mythread(env,threadid):
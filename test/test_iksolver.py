@@ -285,6 +285,48 @@ class TestIkSolver(EnvironmentSetup):
                     f += 1.0/numCloseSolutions
                     assert(numCloseSolutions==1)
     
+    def test_solveallbatch(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot=env.GetRobots()[0]
+        ikmodel = databases.inversekinematics.InverseKinematicsModel(robot,IkParameterization.Type.Transform6D)
+        if not ikmodel.load():
+            ikmodel.autogenerate()
+
+        with env:
+            manip = ikmodel.manip
+            lower,upper = robot.GetDOFLimits(manip.GetArmIndices())
+            Tposes = []
+            with robot:
+                for i in range(30):
+                    robot.SetDOFValues(lower+random.rand(len(lower))*(upper-lower),manip.GetArmIndices())
+                    Tposes.append(manip.GetTransform())
+            # unreachable pose
+            Tfar = eye(4)
+            Tfar[0:3,3] = manip.GetBase().GetTransform()[0:3,3]+array([10.0,0,0])
+            Tposes.append(Tfar)
+
+            def checksolutions(batchsolutions, solutions):
+                assert(len(batchsolutions) == len(solutions))
+                for solution in solutions:
+                    assert(min(sum((batchsolutions-tile(solution,(len(batchsolutions),1)))**2,axis=1)) <= g_epsilon)
+
+            for filteroptions in [0, IkFilterOptions.CheckEnvCollisions]:
+                batchsolutions, offsets = manip.FindIKSolutionsBatch(Tposes,filteroptions)
+                assert(len(offsets) == len(Tposes)+1 and offsets[0] == 0 and offsets[-1] == len(batchsolutions))
+                assert(offsets[-1]-offsets[-2] == 0)
+                for ipose,T in enumerate(Tposes):
+                    checksolutions(batchsolutions[offsets[ipose]:offsets[ipose+1]], manip.FindIKSolutions(T,filteroptions))
+
+            # the solver takes the poses in the manipulator base frame
+            Tbaseinv = linalg.inv(manip.GetBase().GetTransform())
+            ikparams = [IkParameterization(dot(Tbaseinv,T),IkParameterization.Type.Transform6D) for T in Tposes]
+            solversolutions, solveroffsets = manip.GetIkSolver().SolveAllBatch(ikparams,IkFilterOptions.CheckEnvCollisions)
+            batchsolutions, offsets = manip.FindIKSolutionsBatch(Tposes,IkFilterOptions.CheckEnvCollisions)
+            assert(all(solveroffsets == offsets))
+            for ipose in range(len(Tposes)):
+                checksolutions(solversolutions[solveroffsets[ipose]:solveroffsets[ipose+1]], batchsolutions[offsets[ipose]:offsets[ipose+1]])
+
     def test_circularfree(self):
         # test when free joint is circular and IK doesn't succeed (thanks to Chris Dellin)
         robotxmldata = '''<Robot name="BarrettWAM">
@@ -1123,3 +1123,100 @@ class TestKinematics(EnvironmentSetup):
         assert(robot.CheckSelfCollision())
         robot.SetNonCollidingConfiguration()
         assert(not robot.CheckSelfCollision())
+
+    def test_updatefrominfo(self):
+        self.log.info('check that UpdateFromInfo restores bodies changed through the api, also when their infos were applied before')
+        env=self.env
+        with env:
+            robot=self.LoadRobot('robots/barrettwam.robot.xml')
+            lower,upper = robot.GetDOFLimits()
+            robot.SetDOFValues(0.5*(lower+upper))
+            valuesorg = robot.GetDOFValues()
+            transformsorg = robot.GetLinkTransformations()
+            envinfo = env.ExtractInfo()
+            for i in range(2):
+                created,modified,removed = env.UpdateFromInfo(envinfo,UpdateFromInfoMode.Exact)
+                assert(len(created)==0 and len(removed)==0)
+            # applying the same info again does not change anything
+            created,modified,removed = env.UpdateFromInfo(envinfo,UpdateFromInfoMode.Exact)
+            assert(len(created)==0 and len(modified)==0 and len(removed)==0)
+
+            # moving the joints does not change the structure, only the dof values are restored
+            robot.SetDOFValues(lower+0.1*(upper-lower))
+            created,modified,removed = env.UpdateFromInfo(envinfo,UpdateFromInfoMode.Exact)
+            assert(len(created)==0 and len(removed)==0)
+            assert(transdist(robot.GetDOFValues(),valuesorg) <= g_epsilon)
+            assert(transdist(robot.GetLinkTransformations(),transformsorg) <= g_epsilon)
+
+            # structural changes through the api have to be reverted by the same info
+            link = robot.GetLinks()[-1]
+            staticorg = link.IsStatic()
+            link.SetStatic(not staticorg)
+            robot.SetDOFLimits(lower+0.25*(upper-lower),upper-0.25*(upper-lower))
+            created,modified,removed = env.UpdateFromInfo(envinfo,UpdateFromInfoMode.Exact)
+            assert(len(created)==0 and len(removed)==0)
+            assert(robot in modified)
+            assert(link.IsStatic()==staticorg)
+            assert(transdist(robot.GetDOFLimits()[0],lower) <= g_epsilon)
+            assert(transdist(robot.GetDOFLimits()[1],upper) <= g_epsilon)
+            assert(transdist(robot.GetDOFValues(),valuesorg) <= g_epsilon)
+
+    def test_partialdofupdates(self):
+        self.log.info('check that setting a subset of the dofs gives the same links as setting all of them, including mimic joints')
+        env=self.env
+        with env:
+            robot = self.LoadRobot('robots/barrettwam.robot.xml')
+            fullrobot = self.LoadRobot('robots/barrettwam.robot.xml')
+            assert(len(robot.GetPassiveJoints()) > 0)
+            fullrobot.SetTransform(robot.GetTransform())
+            lower,upper = robot.GetDOFLimits()
+            for i in range(20):
+                # several partial updates in a row, each on random dofs including the hand dofs that drive the mimic joints
+                for j in range(3):
+                    indices = [index for index in range(robot.GetDOF()) if random.rand() < 0.3]
+                    if len(indices) == 0:
+                        indices = [robot.GetDOF()-1]
+                    values = lower[indices]+random.rand(len(indices))*(upper[indices]-lower[indices])
+                    robot.SetDOFValues(values,indices)
+                fullrobot.SetDOFValues(robot.GetDOFValues())
+                assert(transdist(robot.GetLinkTransformations(),fullrobot.GetLinkTransformations()) <= g_epsilon)
+                for joint,fulljoint in zip(robot.GetPassiveJoints(),fullrobot.GetPassiveJoints()):
+                    assert(transdist(joint.GetValues(),fulljoint.GetValues()) <= g_epsilon)
+
+    def test_partialdofupdatescollision(self):
+        self.log.info('check that the collision checker synchronizes the links of partial updates, also when another change follows')
+        env=self.env
+        with env:
+            env.SetCollisionChecker(RaveCreateCollisionChecker(env,'fcl_'))
+            robot = self.LoadRobot('robots/barrettwam.robot.xml')
+            robot.SetDOFValues(zeros(robot.GetDOF()))
+            # put a box where the forearm is when the elbow is bent
+            ielbow = 3
+            forearm = robot.GetJoints()[ielbow].GetHierarchyChildLink()
+            robot.SetDOFValues([2.0],[ielbow])
+            ab = forearm.ComputeAABB()
+            robot.SetDOFValues([0.0],[ielbow])
+            box = RaveCreateKinBody(env,'')
+            box.InitFromBoxes(array([r_[ab.pos(),0.5*ab.extents()]]),True)
+            box.SetName('box')
+            env.Add(box)
+            assert(not env.CheckCollision(robot,box))
+
+            # partial update followed by another partial update of a dof that does not move the forearm
+            robot.SetDOFValues([2.0],[ielbow])
+            robot.SetDOFValues([0.5],[7])
+            assert(env.CheckCollision(robot,box))
+
+            # single partial update since the last check
+            robot.SetDOFValues([0.0],[ielbow])
+            assert(not env.CheckCollision(robot,box))
+
+            # partial update followed by a change of the body transform
+            robot.SetDOFValues([2.0],[ielbow])
+            robot.SetTransform(robot.GetTransform())
+            assert(env.CheckCollision(robot,box))
+
+            # partial update followed by a full update
+            robot.SetDOFValues([0.0],[ielbow])
+            robot.SetDOFValues(robot.GetDOFValues())
+            assert(not env.CheckCollision(robot,box))
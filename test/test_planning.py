@@ -82,6 +82,65 @@ class RunPlanning(EnvironmentSetup):
             self.log.info('Tee dist=%f',transdist(Tee,ikmodel.manip.GetEndEffectorTransform()))
             assert(transdist(Tee,ikmodel.manip.GetEndEffectorTransform()) <= g_epsilon)
             
+    def test_ikgoalcache(self):
+        env = self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot = env.GetRobots()[0]
+        ikmodel = databases.inversekinematics.InverseKinematicsModel(robot, iktype=IkParameterization.Type.Transform6D)
+        if not ikmodel.load():
+            ikmodel.autogenerate()
+
+        with env:
+            manip = ikmodel.manip
+            Tee = manip.GetEndEffectorTransform()
+            Tee[0:3,3] -= 0.4
+            obstacle = RaveCreateKinBody(env,'')
+            obstacle.SetName('obstacle')
+            obstacle.InitFromBoxes(array([[Tee[0,3],Tee[1,3],Tee[2,3],0.05,0.05,0.05]]),True)
+            env.Add(obstacle)
+            obstacle.Enable(False)
+            basemanip = interfaces.BaseManipulation(robot)
+            # counts the solutions the ik solver validates, cache hits do not call the solver
+            numikcalls = [0]
+            def countingfilter(sol,manip,ikparam):
+                numikcalls[0] += 1
+                return IkReturnAction.Success
+            handle = manip.GetIkSolver().RegisterCustomFilter(0,countingfilter)
+
+            def plan(cacheikgoals):
+                numikcalls[0] = 0
+                try:
+                    traj = basemanip.MoveToHandPosition(matrices=[Tee],maxiter=3000,execute=False,outputtrajobj=True,cacheikgoals=cacheikgoals)
+                except planning_error:
+                    return False
+                lastvalues = traj.GetConfigurationSpecification().ExtractJointValues(traj.GetWaypoint(-1), robot, manip.GetArmIndices(), 0)
+                with robot:
+                    robot.SetDOFValues(lastvalues,manip.GetArmIndices())
+                    assert(transdist(Tee,manip.GetEndEffectorTransform()) <= g_epsilon)
+                    assert(not env.CheckCollision(robot))
+                return True
+
+            # the second cached call reuses the ik solutions of the first
+            assert(plan(False))
+            assert(numikcalls[0] > 0)
+            assert(plan(True))
+            numfirstikcalls = numikcalls[0]
+            assert(numfirstikcalls > 0)
+            assert(plan(True))
+            self.log.info('ik solutions validated without the cache %d, with a cache hit %d', numfirstikcalls, numikcalls[0])
+            assert(numikcalls[0] < numfirstikcalls)
+
+            # changes of the other bodies have to invalidate the cached solutions
+            obstacle.Enable(True)
+            assert(not plan(False))
+            assert(not plan(True))
+            obstacle.Enable(False)
+            assert(plan(True))
+            assert(numikcalls[0] > 0)
+            obstacle.Enable(True)
+            assert(not plan(True))
+            handle.close()
+
     def test_constraintpr2(self):
         env = self.env
         robot = self.LoadRobot('robots/pr2-beta-static.zae')
@@ -607,6 +666,56 @@ class RunPlanning(EnvironmentSetup):
             self.RunTrajectory(robot,traj1)
             self.RunTrajectory(robot,traj2)
 
+    def test_plannerexecutor(self):
+        env=self.env
+        self.LoadEnv('data/lab1.env.xml')
+        robot = env.GetRobots()[0]
+        with env:
+            manip = robot.GetActiveManipulator()
+            robot.SetActiveDOFs(manip.GetArmIndices())
+            startvalues = robot.GetActiveDOFValues()
+            goal = array(startvalues)
+            goal[0] += 0.8
+            goal[3] -= 0.5
+            with robot:
+                robot.SetActiveDOFValues(goal)
+                assert(not env.CheckCollision(robot) and not robot.CheckSelfCollision())
+            params = Planner.PlannerParameters()
+            params.SetRobotActiveJoints(robot)
+            params.SetGoalConfig(goal)
+            params.SetMaxIterations(5000)
+
+            # plan directly in the environment as the reference
+            planner = RaveCreatePlanner(env,'BiRRT')
+            assert(planner.InitPlan(robot,params))
+            directtraj = RaveCreateTrajectory(env,'')
+            assert(planner.PlanPath(directtraj).statusCode==PlannerStatusCode.HasSolution)
+
+        # the workers lock the environment to sync their clones, so the env lock cannot be held while waiting
+        executor = planningutils.PlannerExecutor(env,2)
+        assert(executor.GetNumThreads()==2)
+        future = executor.Submit('BiRRT',robot.GetName(),params)
+        assert(future.Wait())
+        assert(future.IsDone())
+        assert(future.GetStatus().statusCode==PlannerStatusCode.HasSolution)
+        traj = future.GetTrajectory()
+        assert(traj is not None)
+        with env:
+            for waypointindex in [0,-1]:
+                values = traj.GetConfigurationSpecification().ExtractJointValues(traj.GetWaypoint(waypointindex),robot,manip.GetArmIndices(),0)
+                directvalues = directtraj.GetConfigurationSpecification().ExtractJointValues(directtraj.GetWaypoint(waypointindex),robot,manip.GetArmIndices(),0)
+                assert(transdist(values,directvalues) <= g_epsilon)
+            assert(transdist(robot.GetActiveDOFValues(),startvalues) <= g_epsilon)
+
+        # the first finished request wins and the others are cancelled
+        futures = [executor.Submit('BiRRT',robot.GetName(),params) for i in range(3)]
+        index = executor.WaitForAny(futures)
+        assert(index >= 0 and index < len(futures))
+        assert(futures[index].GetStatus().statusCode==PlannerStatusCode.HasSolution)
+        for future in futures:
+            assert(future.Wait())
+        executor.CancelAll()
+
     def test_jittertransform(self):
         env=self.env
         self.LoadEnv('data/lab1.env.xml')
@@ -621,6 +730,163 @@ class RunPlanning(EnvironmentSetup):
             assert(success)
             assert(not env.CheckCollision(collisionbody))
 
+    def test_distanceguidedclosing(self):
+        env=self.env
+        with env:
+            # guided steps need distance queries
+            env.SetCollisionChecker(RaveCreateCollisionChecker(env,'fcl_'))
+            robot = self.LoadRobot('robots/barretthand.robot.xml')
+            target = env.ReadKinBodyURI('data/mug1.kinbody.xml')
+            env.Add(target)
+            target.SetTransform(eye(4))
+            grasper = interfaces.Grasper(robot)
+            manip = robot.GetActiveManipulator()
+            results = []
+            for distanceguidedclosing in [False,True]:
+                robot.SetDOFValues(zeros(robot.GetDOF()))
+                contacts,finalconfig,mindist,volume = grasper.Grasp(direction=[0,0,-1],roll=0,position=[0,0,0.3],standoff=0,target=target,outputfinal=True,manipulatordirection=manip.GetLocalToolDirection(),coarsestep=0.04,finestep=0.002,distanceguidedclosing=distanceguidedclosing)
+                numchecks = int(grasper.prob.SendCommand('GetNumCollisionChecks'))
+                results.append((contacts,finalconfig,numchecks))
+            (contacts0,finalconfig0,numchecks0),(contacts1,finalconfig1,numchecks1) = results
+            self.log.info('collision checks without guided closing %d, with %d', numchecks0, numchecks1)
+            assert(len(contacts0) > 0 and len(contacts1) > 0)
+            # both close on the same contacts up to the fine step
+            assert(transdist(finalconfig0[0],finalconfig1[0]) <= 0.01)
+            assert(transdist(finalconfig0[1],finalconfig1[1]) <= 0.01)
+            assert(numchecks1 < numchecks0)
+
+    def test_graspthreadedoutput(self):
+        import tempfile, shutil
+        from openravepy.interfaces.Grasper import Grasper
+        env=self.env
+        with env:
+            robot = self.LoadRobot('robots/barretthand.robot.xml')
+            target = env.ReadKinBodyURI('data/mug1.kinbody.xml')
+            env.Add(target)
+            manip = robot.GetActiveManipulator()
+            gmodel = databases.grasping.GraspingModel(robot=robot,target=target)
+            approachrays = gmodel.computeBoxApproachRays(delta=0.04)[0:8]
+            grasper = interfaces.Grasper(robot)
+            graspspace = dict(approachrays=approachrays, standoffs=array([0,0.025]), preshapes=array([robot.GetDOFValues(manip.GetGripperIndices())]), rolls=arange(0,2*pi,pi/2), manipulatordirections=array([manip.GetLocalToolDirection()]), target=target, forceclosurethreshold=0, numthreads=2)
+            numgrasps = len(approachrays)*2*4
+
+        def GetKey(grasp):
+            # position, direction, roll and standoff identify the grasp
+            return tuple(round(f,6) for f in r_[grasp[0],grasp[1],grasp[2],grasp[3]])
+
+        nextid, allgrasps = grasper.GraspThreaded(**graspspace)
+        assert(nextid == numgrasps)
+        assert(len(allgrasps) > 1)
+        tempdir = tempfile.mkdtemp()
+        try:
+            outputfile = os.path.join(tempdir,'grasps.bin')
+            # stop after the first successful grasp, the results are only in the file
+            nextid, grasps = grasper.GraspThreaded(maxgrasps=1, outputfile=outputfile, **graspspace)
+            assert(len(grasps) == 0)
+            filenumgrasps, evaluatedids, successids, resvalues = Grasper.LoadGraspThreadedOutput(outputfile)
+            assert(filenumgrasps == numgrasps)
+            assert(len(successids) == 1) # in-flight workers do not add more than maxgrasps
+            assert(len(evaluatedids) < numgrasps)
+
+            # resume the run
+            nextid, grasps = grasper.GraspThreaded(outputfile=outputfile, **graspspace)
+            assert(nextid == numgrasps)
+            filenumgrasps, evaluatedids, successids, resvalues = Grasper.LoadGraspThreadedOutput(outputfile)
+            assert(sorted(evaluatedids) == list(range(numgrasps)))
+            assert(len(resvalues) == len(allgrasps))
+            streamedgrasps = dict((GetKey(grasp),grasp) for grasp in resvalues)
+            for grasp in allgrasps:
+                streamedgrasp = streamedgrasps[GetKey(grasp)]
+                assert(transdist(grasp[8],streamedgrasp[8]) <= g_epsilon)
+                assert(transdist(grasp[9],streamedgrasp[9]) <= g_epsilon)
+                assert(abs(grasp[5]-streamedgrasp[5]) <= g_epsilon)
+                assert(len(grasp[10]) == len(streamedgrasp[10]))
+
+            # results computed with other parameters cannot be mixed in
+            grasper.friction = 0.5
+            try:
+                grasper.GraspThreaded(outputfile=outputfile, **graspspace)
+                assert(False)
+            except PlanningError:
+                pass
+        finally:
+            shutil.rmtree(tempdir)
+
+    def test_fastforceclosure(self):
+        env=self.env
+        with env:
+            robot = self.LoadRobot('robots/barretthand.robot.xml')
+            target = env.ReadKinBodyURI('data/mug1.kinbody.xml')
+            env.Add(target)
+            manip = robot.GetActiveManipulator()
+            gmodel = databases.grasping.GraspingModel(robot=robot,target=target)
+            approachrays = gmodel.computeBoxApproachRays(delta=0.04)
+            grasper = interfaces.Grasper(robot)
+            numforceclosure = 0
+            for ray in approachrays[::max(1,len(approachrays)//20)]:
+                robot.SetDOFValues(zeros(robot.GetDOF()))
+                try:
+                    contacts,finalconfig,mindist,volume = grasper.Grasp(direction=ray[3:6],roll=0,position=ray[0:3],standoff=0,target=target,forceclosure=True,manipulatordirection=manip.GetLocalToolDirection())
+                    robot.SetDOFValues(zeros(robot.GetDOF()))
+                    fastcontacts,finalconfig,fastmindist,volume = grasper.Grasp(direction=ray[3:6],roll=0,position=ray[0:3],standoff=0,target=target,forceclosure=True,manipulatordirection=manip.GetLocalToolDirection(),fastforceclosure=True)
+                except PlanningError:
+                    continue
+                assert(len(contacts) == len(fastcontacts))
+                # the contacts are returned as text, so the batch result is only close
+                batchmindist = grasper.ComputeGraspQualities([contacts])[0]
+                assert(abs(batchmindist-fastmindist) <= 1e-3*fastmindist+1e-9)
+                # force closure agrees with the convex hull, the epsilon quality is an upper bound close to it
+                assert((mindist > 1e-9) == (fastmindist > 1e-9))
+                if mindist > 1e-9:
+                    numforceclosure += 1
+                    assert(fastmindist >= mindist*(1-1e-6))
+                    assert(fastmindist <= mindist*1.1)
+            assert(numforceclosure > 0)
+
+    def test_workspacetrackerwarmstart(self):
+        self.log.info('track a straight line with and without warm started local ik')
+        env=self.env
+        with env:
+            robot = self.LoadRobot('robots/barrettwam.robot.xml')
+            manip = robot.GetActiveManipulator()
+            ikmodel = databases.inversekinematics.InverseKinematicsModel(robot=robot,iktype=IkParameterization.Type.Transform6D)
+            if not ikmodel.load():
+                ikmodel.autogenerate()
+            robot.SetDOFValues([0,0.8,0,1.2,0,0.5,0],manip.GetArmIndices())
+            assert(not env.CheckCollision(robot) and not robot.CheckSelfCollision())
+            robot.SetActiveDOFs(manip.GetArmIndices())
+            Tstart = manip.GetTransform()
+            workspacetraj = RaveCreateTrajectory(env,'')
+            workspacetraj.Init(IkParameterization.GetConfigurationSpecificationFromType(IkParameterizationType.Transform6D,'linear'))
+            for f in arange(0,1.0001,0.05):
+                T = array(Tstart)
+                T[0:3,3] += f*array([0.1,0,-0.15])
+                workspacetraj.Insert(workspacetraj.GetNumWaypoints(),poseFromMatrix(T))
+            planningutils.RetimeAffineTrajectory(workspacetraj,maxvelocities=ones(7),maxaccelerations=5*ones(7))
+            startvalues = robot.GetActiveDOFValues()
+            finalvalues = []
+            for warmstart in [False,True]:
+                robot.SetActiveDOFValues(startvalues)
+                planner = RaveCreatePlanner(env,'workspacetrajectorytracker')
+                assert(planner.SendCommand('SetWarmStart %d'%warmstart) is not None)
+                params = Planner.PlannerParameters()
+                params.SetRobotActiveJoints(robot)
+                params.SetExtraParameters('<workspacetrajectory>%s</workspacetrajectory>'%workspacetraj.serialize(0))
+                assert(planner.InitPlan(robot,params))
+                traj = RaveCreateTrajectory(env,'')
+                assert(planner.PlanPath(traj)==PlannerStatusCode.HasSolution)
+                spec = robot.GetActiveConfigurationSpecification()
+                values = [traj.GetWaypoint(i,spec) for i in range(traj.GetNumWaypoints())]
+                assert(transdist(values[0],startvalues) <= 0.01)
+                # the solutions stay on one ik branch, so consecutive waypoints are close
+                for i in range(1,len(values)):
+                    assert(max(abs(values[i]-values[i-1])) <= 0.2)
+                robot.SetActiveDOFValues(values[-1])
+                Tend = manip.GetTransform()
+                assert(transdist(Tend[0:3,3],Tstart[0:3,3]+array([0.1,0,-0.15])) <= 1e-4)
+                finalvalues.append(values[-1])
+            assert(transdist(finalvalues[0],finalvalues[1]) <= 0.01)
+
 #generate_classes(RunPlanning, globals(), [('ode','ode'),('bullet','bullet')])
 
 class test_ode(RunPlanning):
@@ -63,6 +63,37 @@ class RunRobot(EnvironmentSetup):
             robot=self.LoadRobot('robots/collisionmap.robot.xml')
             assert(robot.GetXMLId().lower()=='collisionmaprobot')
 
+    def test_collisionmaprobot_selfcollisiontables(self):
+        env=self.env
+        env.SetCollisionChecker(RaveCreateCollisionChecker(env,'fcl_'))
+        xml = """<robot type="CollisionMapRobot" name="wam">
+  <robot file="robots/barrettwam.robot.xml"/>
+</robot>
+"""
+        robot=self.LoadRobotData(xml)
+        with env:
+            assert(robot.GetXMLId().lower()=='collisionmaprobot')
+            checker = env.GetCollisionChecker()
+            lower,upper = robot.GetDOFLimits()
+            configs = [randlimits(lower,upper) for i in range(300)]
+            expected = []
+            for config in configs:
+                robot.SetDOFValues(config)
+                expected.append(checker.CheckSelfCollision(robot))
+                assert(robot.CheckSelfCollision() == expected[-1])
+            assert(any(expected) and not all(expected))
+
+            assert(int(robot.SendCommand('GenerateSelfCollisionTables cells 16')) > 0)
+            report = CollisionReport()
+            for config,bcollision in zip(configs,expected):
+                robot.SetDOFValues(config)
+                assert(robot.CheckSelfCollision() == bcollision)
+                assert(robot.CheckSelfCollision(report) == bcollision)
+                if bcollision:
+                    # the colliding links come from the collision checker
+                    assert(report.plink1 is not None and report.plink2 is not None)
+                    assert(report.plink1.GetParent() == robot and report.plink2.GetParent() == robot)
+
     def test_grabcollision(self):
         env=self.env
         self.LoadEnv('robots/man1.zae') # load a simple scene
@@ -732,6 +763,174 @@ class RunRobot(EnvironmentSetup):
                 #for inworld in [True, False]:
                 #    print(manip.GetIkParameterization(ikp, inworld=inworld))
     
+    def test_changebatch(self):
+        self.log.info('change batches coalesce the change set callbacks while the collision checker and grabbed bodies stay synchronized')
+        env=self.env
+        PROP_LINKTRANSFORMS = 0x100 # KinBody::Prop_LinkTransforms
+        PROP_LINKENABLE = 0x800 # KinBody::Prop_LinkEnable
+        with env:
+            env.SetCollisionChecker(RaveCreateCollisionChecker(env,'fcl_'))
+            robot = self.LoadRobot('robots/barrettwam.robot.xml')
+            manip = robot.GetActiveManipulator()
+            obstacle = RaveCreateKinBody(env,'')
+            ab = robot.GetLinks()[1].ComputeAABB()
+            obstacle.InitFromBoxes(array([r_[ab.pos(),0.5*ab.extents()]]),True)
+            obstacle.SetName('obstacle')
+            env.Add(obstacle)
+            # grab a box that touches the palm, so the touching links are ignored by the self collision
+            box = RaveCreateKinBody(env,'')
+            box.InitFromBoxes(array([[0,0,0,0.03,0.03,0.03]]),True)
+            box.SetName('box')
+            env.Add(box)
+            box.SetTransform(manip.GetTransform())
+            robot.Grab(box)
+            assert(env.CheckCollision(robot,obstacle))
+            assert(not robot.CheckSelfCollision())
+
+            numchanges = [0]
+            changesets = []
+            def OnChange():
+                numchanges[0] += 1
+            def OnChangeSet(properties,linkindices):
+                changesets.append((properties,linkindices))
+            handles = [robot.RegisterChangeCallback(PROP_LINKTRANSFORMS|PROP_LINKENABLE,OnChange), robot.RegisterChangeSetCallback(PROP_LINKTRANSFORMS|PROP_LINKENABLE,OnChangeSet)]
+
+            robot.BeginChangeBatch()
+            robot.Enable(False)
+            # plain callbacks keep firing, so the checker sees the disabled links inside the batch
+            assert(numchanges[0] == 1 and len(changesets) == 0)
+            assert(not env.CheckCollision(robot,obstacle))
+            robot.Enable(True)
+            assert(env.CheckCollision(robot,obstacle))
+            assert(not robot.CheckSelfCollision())
+            robot.SetDOFValues([0.3],[8])
+            assert(numchanges[0] == 3 and len(changesets) == 0)
+            robot.CommitChangeBatch()
+            assert(len(changesets) == 1)
+            assert(changesets[0][0] == PROP_LINKTRANSFORMS|PROP_LINKENABLE)
+            assert(len(changesets[0][1]) == len(robot.GetLinks()))
+
+            # nested batches only notify at the outermost commit
+            del changesets[:]
+            robot.BeginChangeBatch()
+            robot.BeginChangeBatch()
+            robot.SetDOFValues([0.2],[8])
+            robot.CommitChangeBatch()
+            assert(len(changesets) == 0)
+            robot.SetDOFValues([0.1],[8])
+            robot.CommitChangeBatch()
+            assert(len(changesets) == 1)
+            assert(changesets[0][0] == PROP_LINKTRANSFORMS)
+            assert(robot.GetJointFromDOFIndex(8).GetHierarchyChildLink().GetIndex() in changesets[0][1])
+            assert(len(changesets[0][1]) < len(robot.GetLinks()))
+
+            # a batch left with an exception still notifies at the commit and leaves no batch open
+            del changesets[:]
+            try:
+                robot.BeginChangeBatch()
+                try:
+                    robot.SetDOFValues([0.3],[8])
+                    raise ValueError('stop the batch')
+                finally:
+                    robot.CommitChangeBatch()
+            except ValueError:
+                pass
+            assert(len(changesets) == 1)
+            robot.SetDOFValues([0.2],[8])
+            assert(len(changesets) == 2)
+            try:
+                robot.CommitChangeBatch()
+                assert(False)
+            except openrave_exception as e:
+                assert(e.GetCode()=='InvalidState')
+
+    def test_statesaverrestore(self):
+        self.log.info('state savers restore every change that bypasses the dof values and skip the restore when nothing changed')
+        env=self.env
+        PROP_LINKTRANSFORMS = 0x100 # KinBody::Prop_LinkTransforms
+        PROP_LINKENABLE = 0x800 # KinBody::Prop_LinkEnable
+        with env:
+            robot = self.LoadRobot('robots/barrettwam.robot.xml')
+            manip = robot.GetActiveManipulator()
+            box = RaveCreateKinBody(env,'')
+            box.InitFromBoxes(array([[0,0,0,0.03,0.03,0.03]]),True)
+            box.SetName('box')
+            env.Add(box)
+            box.SetTransform(manip.GetTransform())
+            options = KinBody.SaveParameters.LinkTransformation|KinBody.SaveParameters.LinkEnable|KinBody.SaveParameters.GrabbedBodies
+            robot.SetDOFValues([0.5,0.3],[1,3])
+            linktransforms = robot.GetLinkTransformations()
+            link = robot.GetLinks()[4]
+
+            with robot.CreateKinBodyStateSaver(options):
+                T = link.GetTransform()
+                T[0:3,3] += [0.1,0,0]
+                link.SetTransform(T)
+                assert(transdist(link.GetTransform(),T) <= g_epsilon)
+            assert(transdist(robot.GetLinkTransformations(),linktransforms) <= g_epsilon)
+
+            with robot.CreateKinBodyStateSaver(options):
+                link.Enable(False)
+            assert(link.IsEnabled())
+
+            with robot.CreateKinBodyStateSaver(options):
+                robot.Grab(box)
+                assert(len(robot.GetGrabbed()) == 1)
+            assert(len(robot.GetGrabbed()) == 0)
+
+            robot.Grab(box)
+            Tbox = box.GetTransform()
+            with robot.CreateKinBodyStateSaver(options):
+                robot.Release(box)
+                assert(len(robot.GetGrabbed()) == 0)
+            assert(robot.GetGrabbed()[0] == box)
+
+            with robot.CreateKinBodyStateSaver(options):
+                T = box.GetTransform()
+                T[0:3,3] += [0,0,0.1]
+                box.SetTransform(T)
+            assert(transdist(box.GetTransform(),Tbox) <= g_epsilon)
+
+            # released savers do not restore on destruction, but can still restore explicitly from their pooled snapshot
+            saver = KinBody.KinBodyStateSaver(robot,options)
+            saver.Release()
+            robot.SetDOFValues([0.1],[1])
+            robot.ReleaseAllGrabbed()
+            link.Enable(False)
+            saver.Restore(robot)
+            assert(transdist(robot.GetLinkTransformations(),linktransforms) <= g_epsilon)
+            assert(link.IsEnabled())
+            assert(robot.GetGrabbed()[0] == box)
+            assert(transdist(box.GetTransform(),Tbox) <= g_epsilon)
+            robot.SetDOFValues([0.1],[1])
+            del saver
+            assert(abs(robot.GetDOFValues([1])[0]-0.1) <= g_epsilon)
+            robot.SetDOFValues([0.5],[1])
+
+            # a saver reusing a pooled snapshot does not restore the state of the previous saver
+            with robot.CreateKinBodyStateSaver(options):
+                robot.SetDOFValues([0.2],[1])
+                linktransforms2 = robot.GetLinkTransformations()
+                with robot.CreateKinBodyStateSaver(options):
+                    robot.SetDOFValues([0.7],[1])
+                assert(transdist(robot.GetLinkTransformations(),linktransforms2) <= g_epsilon)
+            assert(transdist(robot.GetLinkTransformations(),linktransforms) <= g_epsilon)
+
+            numchanges = [0]
+            def OnChange():
+                numchanges[0] += 1
+            handle = robot.RegisterChangeCallback(PROP_LINKTRANSFORMS|PROP_LINKENABLE,OnChange)
+            with robot.CreateKinBodyStateSaver(options):
+                pass
+            with robot.CreateKinBodyStateSaver(options):
+                robot.GetDOFValues()
+                robot.GetLinkTransformations()
+            assert(numchanges[0] == 0)
+            with robot.CreateKinBodyStateSaver(options):
+                robot.SetDOFValues([0.2],[1])
+            assert(numchanges[0] >= 2)
+            assert(transdist(robot.GetLinkTransformations(),linktransforms) <= g_epsilon)
+
 #generate_classes(RunRobot, globals(), [('ode','ode'),('bullet','bullet')])
 
 class test_ode(RunRobot):
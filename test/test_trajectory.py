@@ -398,6 +398,116 @@ class TestTrajectory(EnvironmentSetup):
         self.RunTrajectory(robot, traj)
         assert( abs(traj.GetDuration()-1.01688888888873) < g_epsilon)
         
+    def test_topparetiming(self):
+        env=self.env
+        robot=self.LoadRobot('robots/barrettwam.robot.xml')
+        with env:
+            robot.SetActiveDOFs(range(7))
+            parameters = Planner.PlannerParameters()
+            parameters.SetRobotActiveJoints(robot)
+            lower,upper = robot.GetActiveDOFLimits()
+            startvalues = lower+0.2*(upper-lower)
+            finalvalues = lower+0.7*(upper-lower)
+            traj = RaveCreateTrajectory(env,'')
+            traj.Init(robot.GetActiveConfigurationSpecification())
+            traj.Insert(0,startvalues)
+            traj.Insert(1,finalvalues)
+            toppratraj = RaveClone(traj,0)
+
+            # on a straight line with only velocity and acceleration limits the parabolic retimer is time-optimal too
+            ret=planningutils.RetimeActiveDOFTrajectory(traj,robot,False,maxvelmult=1,maxaccelmult=1,plannername='ParabolicTrajectoryRetimer')
+            assert(ret.statusCode==PlannerStatusCode.HasSolution)
+
+            planner = RaveCreatePlanner(env,'TOPPRATrajectoryRetimer')
+            planner.SendCommand('SetTorqueLimitMode ignore')
+            planner.SendCommand('SetNumGridPoints 400')
+            assert(planner.InitPlan(robot,parameters))
+            assert(planner.PlanPath(toppratraj)==PlannerStatusCode.HasSolution)
+            self.log.info('parabolic duration %f, toppra duration %f',traj.GetDuration(),toppratraj.GetDuration())
+            assert(abs(toppratraj.GetDuration()-traj.GetDuration()) <= 0.05*traj.GetDuration())
+            planningutils.VerifyTrajectory(parameters,toppratraj,samplingstep=0.002)
+            self.RunTrajectory(robot,toppratraj)
+            assert(transdist(robot.GetActiveDOFValues(),finalvalues) <= g_epsilon)
+
+            # a segment that is much shorter than the grid spacing and has a corner at both ends has to stop at both of them
+            cornervalues = lower+0.45*(upper-lower)
+            shortvalues = array(cornervalues)
+            shortvalues[0] += 1e-4*(upper[0]-lower[0])
+            toppratraj.Init(robot.GetActiveConfigurationSpecification())
+            toppratraj.Insert(0,r_[startvalues,cornervalues,shortvalues,finalvalues])
+            assert(planner.InitPlan(robot,parameters))
+            assert(planner.PlanPath(toppratraj)==PlannerStatusCode.HasSolution)
+            planningutils.VerifyTrajectory(parameters,toppratraj,samplingstep=0.002)
+            self.RunTrajectory(robot,toppratraj)
+            assert(transdist(robot.GetActiveDOFValues(),finalvalues) <= g_epsilon)
+
+            # a single grid interval on a segment that stops at both ends
+            planner.SendCommand('SetNumGridPoints 1')
+            toppratraj.Init(robot.GetActiveConfigurationSpecification())
+            toppratraj.Insert(0,r_[startvalues,finalvalues])
+            assert(planner.InitPlan(robot,parameters))
+            assert(planner.PlanPath(toppratraj)==PlannerStatusCode.HasSolution)
+            assert(toppratraj.GetDuration() > 0)
+
+    def test_distancesweepsmoothing(self):
+        self.log.info('smoothing with the distance sweep gives collision-free results comparable to the discretized checks')
+        env=self.env
+        with env:
+            # the sweep needs distance queries
+            env.SetCollisionChecker(RaveCreateCollisionChecker(env,'fcl_'))
+            robot=self.LoadRobot('robots/barrettwam.robot.xml')
+            robot.SetActiveDOFs(range(7))
+            startvalues = array([0,0.8,0,1.2,0,0,0])
+            midvalues = array([0.75,0.8,0,1.2,0,0,0])
+            goalvalues = array([1.5,0.8,0,1.2,0,0,0])
+            robot.SetActiveDOFValues(midvalues)
+            ab = robot.GetLinks()[4].ComputeAABB()
+            obstacle = RaveCreateKinBody(env,'')
+            obstacle.InitFromBoxes(array([r_[ab.pos(),0.05,0.05,0.05]]),True)
+            obstacle.SetName('obstacle')
+            env.Add(obstacle)
+            for values in [startvalues,goalvalues]:
+                robot.SetActiveDOFValues(values)
+                assert(not env.CheckCollision(robot) and not robot.CheckSelfCollision())
+            robot.SetActiveDOFValues(startvalues)
+
+            # raw path around the obstacle
+            parameters = Planner.PlannerParameters()
+            parameters.SetRobotActiveJoints(robot)
+            parameters.SetGoalConfig(goalvalues)
+            parameters.SetPostProcessing('','')
+            parameters.SetExtraParameters('<_nmaxiterations>4000</_nmaxiterations><_nrandomgeneratorseed>1</_nrandomgeneratorseed>')
+            planner = RaveCreatePlanner(env,'BiRRT')
+            assert(planner.InitPlan(robot,parameters))
+            pathtraj = RaveCreateTrajectory(env,'')
+            assert(planner.PlanPath(pathtraj)==PlannerStatusCode.HasSolution)
+            retimedtraj = RaveClone(pathtraj,0)
+            ret=planningutils.RetimeActiveDOFTrajectory(retimedtraj,robot,False,maxvelmult=1,maxaccelmult=1,plannername='ParabolicTrajectoryRetimer')
+            assert(ret.statusCode==PlannerStatusCode.HasSolution)
+
+            # 0 uses the discretized checks, 1 falls back to them after every first distance query
+            durations = []
+            for maxiter in [0,20,1]:
+                smoother = RaveCreatePlanner(env,'ParabolicSmoother2')
+                if maxiter > 0:
+                    smoother.SendCommand('SetDistanceSweep %d'%maxiter)
+                parameters = Planner.PlannerParameters()
+                parameters.SetRobotActiveJoints(robot)
+                parameters.SetExtraParameters('<_nmaxiterations>40</_nmaxiterations><_nrandomgeneratorseed>1</_nrandomgeneratorseed>')
+                assert(smoother.InitPlan(robot,parameters))
+                traj = RaveClone(pathtraj,0)
+                assert(smoother.PlanPath(traj)==PlannerStatusCode.HasSolution)
+                planningutils.VerifyTrajectory(parameters,traj,samplingstep=0.002)
+                with robot:
+                    for t in arange(0,traj.GetDuration(),0.002):
+                        robot.SetActiveDOFValues(traj.Sample(t,robot.GetActiveConfigurationSpecification()))
+                        assert(not env.CheckCollision(robot) and not robot.CheckSelfCollision())
+                assert(transdist(traj.GetWaypoint(traj.GetNumWaypoints()-1,robot.GetActiveConfigurationSpecification()),goalvalues) <= g_epsilon)
+                durations.append(traj.GetDuration())
+            self.log.info('retimed duration %f, smoothed durations discretized %f, sweep %f, sweep with fallback %f',retimedtraj.GetDuration(),durations[0],durations[1],durations[2])
+            for duration in durations:
+                assert(duration <= 1.01*retimedtraj.GetDuration())
+
     def test_ikparamretiming(self):
         self.log.info('retime workspace ikparam')
         env=self.env